@@ -0,0 +1,421 @@
+#include <Shaders/ShaderCooker.h>
+#include <Backend/Vulkan/VulkanBackend.h>
+#include <Engine/Threading/JobSystem.h>
+#include <Engine/Utils/Hash.h>
+#include <fstream>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <Windows.h>
+#endif
+#include <dxc/dxcapi.h>
+
+namespace Spikey {
+
+	// bump when the compile arguments change, invalidates every cooked permutation
+	constexpr uint32 SHADER_COOKER_VERSION = 1;
+
+	// releases the interface when leaving the scope
+	template<typename T>
+	struct DxcRef
+	{
+		T* Ptr = nullptr;
+
+		~DxcRef() { if (Ptr) Ptr->Release(); }
+
+		T*  operator->() const { return Ptr; }
+		T** operator&() { return &Ptr; }
+	};
+
+	// loads includes like the default handler and remembers which files the shader depends on
+	class RecordingIncludeHandler : public IDxcIncludeHandler
+	{
+	public:
+		RecordingIncludeHandler(IDxcUtils* utils) : m_Utils(utils) {}
+
+		HRESULT STDMETHODCALLTYPE LoadSource(LPCWSTR filename, IDxcBlob** outSource) override
+		{
+			IDxcBlobEncoding* blob = nullptr;
+
+			// dxc tries every include directory, only the candidate that exists is a dependency
+			HRESULT hr = m_Utils->LoadFile(filename, nullptr, &blob);
+			if (SUCCEEDED(hr))
+			{
+				Files.push_back(std::filesystem::path(filename).lexically_normal().string());
+				*outSource = blob;
+			}
+
+			return hr;
+		}
+
+		HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** object) override
+		{
+			if (riid == __uuidof(IDxcIncludeHandler) || riid == __uuidof(IUnknown))
+			{
+				*object = this;
+				return S_OK;
+			}
+
+			return E_NOINTERFACE;
+		}
+
+		// lives on the stack of a single compile
+		ULONG STDMETHODCALLTYPE AddRef() override { return 1; }
+		ULONG STDMETHODCALLTYPE Release() override { return 1; }
+
+		std::vector<std::string> Files;
+
+	private:
+		IDxcUtils* m_Utils;
+	};
+
+	static uint64 HashString(const std::string& str, uint64 hash)
+	{
+		uint64 size = str.size();
+		hash = HashBytes(&size, sizeof(size), hash);
+
+		return HashBytes(str.data(), str.size(), hash);
+	}
+
+	static bool ReadTextFile(const std::filesystem::path& path, std::string& outText)
+	{
+		std::ifstream file(path, std::ios::binary);
+		if (!file.is_open())
+			return false;
+
+		outText.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+		return true;
+	}
+
+	static const wchar_t* ShaderProfile(EShaderType type)
+	{
+		switch (type)
+		{
+		case EShaderType::Vertex:
+			return L"vs_6_6";
+		case EShaderType::Pixel:
+			return L"ps_6_6";
+		case EShaderType::Compute:
+			return L"cs_6_6";
+		default:
+			assert(0);
+			return L"";
+		}
+	}
+
+	ShaderCooker::ShaderCooker(const std::vector<std::filesystem::path>& includeDirs)
+		: m_IncludeDirs(includeDirs)
+	{
+	}
+
+	uint64 ShaderCooker::HashDependencies(const ShaderPermutationDesc& desc, ShaderPermutationKey key, const std::vector<std::string>& dependencies)
+	{
+		uint64 hash = HashBytes(&SHADER_COOKER_VERSION, sizeof(SHADER_COOKER_VERSION));
+		hash = HashBytes(&key, sizeof(key), hash);
+		hash = HashBytes(&desc.Type, sizeof(desc.Type), hash);
+		hash = HashString(desc.EntryPoint, hash);
+
+		for (const std::string& define : desc.Defines)
+			hash = HashString(define, hash);
+
+		for (const std::string& dependency : dependencies)
+		{
+			uint64 fileHash = 0;
+			bool   cached = false;
+			{
+				std::lock_guard lock(m_FileHashLock);
+
+				auto it = m_FileHashes.find(dependency);
+				if (it != m_FileHashes.end())
+				{
+					fileHash = it->second;
+					cached = true;
+				}
+			}
+
+			if (!cached)
+			{
+				// a missing file hashes to a value no content does, so the permutation is rebuilt
+				std::string content;
+				fileHash = ReadTextFile(dependency, content) ? HashBytes(content.data(), content.size()) : ~0ull;
+
+				std::lock_guard lock(m_FileHashLock);
+				m_FileHashes.emplace(dependency, fileHash);
+			}
+
+			hash = HashString(dependency, hash);
+			hash = HashBytes(&fileHash, sizeof(uint64), hash);
+		}
+
+		return hash;
+	}
+
+	ShaderCooker::CompileResult ShaderCooker::Compile(const ShaderPermutationDesc& desc, ShaderPermutationKey key, const std::string& source)
+	{
+		PROFILE_SCOPED;
+
+		CompileResult result{};
+		result.Succeeded = false;
+
+		// compiler instances are not thread safe, every job creates its own
+		DxcRef<IDxcUtils>     utils;
+		DxcRef<IDxcCompiler3> compiler;
+
+		if (FAILED(DxcCreateInstance(CLSID_DxcUtils, IID_PPV_ARGS(&utils)))
+			|| FAILED(DxcCreateInstance(CLSID_DxcCompiler, IID_PPV_ARGS(&compiler))))
+		{
+			result.Errors = "Failed to create the dxc compiler";
+			return result;
+		}
+
+		std::vector<std::wstring> args = {
+			desc.Source.wstring(),
+			L"-E", std::filesystem::path(desc.EntryPoint).wstring(),
+			L"-T", ShaderProfile(desc.Type),
+			L"-HV", L"2021",
+			L"-O3",
+			L"-spirv",
+			L"-fspv-target-env=vulkan1.3",
+
+			// register spaces of the binding shifts VulkanShader expects
+			L"-fvk-b-shift", std::to_wstring(VK_BINDING_SHIFT_B), L"all",
+			L"-fvk-t-shift", std::to_wstring(VK_BINDING_SHIFT_T), L"all",
+			L"-fvk-u-shift", std::to_wstring(VK_BINDING_SHIFT_U), L"all",
+			L"-fvk-s-shift", std::to_wstring(VK_BINDING_SHIFT_S), L"all",
+
+			L"-I", desc.Source.parent_path().wstring()
+		};
+
+		for (const std::filesystem::path& dir : m_IncludeDirs)
+		{
+			args.push_back(L"-I");
+			args.push_back(dir.wstring());
+		}
+
+		for (uint32 i = 0; i < (uint32)desc.Defines.size(); i++)
+		{
+			if (key & (1ull << i))
+			{
+				args.push_back(L"-D");
+				args.push_back(std::filesystem::path(desc.Defines[i] + "=1").wstring());
+			}
+		}
+
+		std::vector<LPCWSTR> argPtrs;
+		for (const std::wstring& arg : args)
+			argPtrs.push_back(arg.c_str());
+
+		DxcBuffer buffer{};
+		buffer.Ptr = source.data();
+		buffer.Size = source.size();
+		buffer.Encoding = DXC_CP_UTF8;
+
+		RecordingIncludeHandler includes(utils.Ptr);
+		DxcRef<IDxcResult>      dxcResult;
+
+		HRESULT status = compiler->Compile(&buffer, argPtrs.data(), (uint32)argPtrs.size(), &includes, IID_PPV_ARGS(&dxcResult));
+		if (FAILED(status))
+		{
+			result.Errors = "Failed to run the dxc compiler";
+			return result;
+		}
+
+		dxcResult->GetStatus(&status);
+
+		DxcRef<IDxcBlobUtf8> errors;
+		dxcResult->GetOutput(DXC_OUT_ERRORS, IID_PPV_ARGS(&errors), nullptr);
+		if (errors.Ptr && errors->GetStringLength() > 0)
+			result.Errors = errors->GetStringPointer();
+
+		if (FAILED(status))
+			return result;
+
+		DxcRef<IDxcBlob> object;
+		dxcResult->GetOutput(DXC_OUT_OBJECT, IID_PPV_ARGS(&object), nullptr);
+		if (!object.Ptr)
+			return result;
+
+		const uint8* bytecode = (const uint8*)object->GetBufferPointer();
+		result.Bytecode.assign(bytecode, bytecode + object->GetBufferSize());
+
+		result.Dependencies.push_back(desc.Source.lexically_normal().string());
+		result.Dependencies.insert(result.Dependencies.end(), includes.Files.begin(), includes.Files.end());
+
+		// sorted so the hash does not depend on the include order
+		std::sort(result.Dependencies.begin() + 1, result.Dependencies.end());
+		result.Dependencies.erase(std::unique(result.Dependencies.begin() + 1, result.Dependencies.end()), result.Dependencies.end());
+
+		result.Succeeded = true;
+		return result;
+	}
+
+	bool ShaderCooker::Cook(const ShaderPermutationDesc& desc, const std::filesystem::path& archivePath, ShaderCookStats* outStats)
+	{
+		PROFILE_SCOPED;
+
+		ShaderCookStats stats{};
+
+		std::string source;
+		if (!ReadTextFile(desc.Source, source))
+		{
+			ENGINE_ERROR("Failed to read shader source {}", desc.Source.string());
+			return false;
+		}
+
+		std::vector<ShaderPermutationKey> keys = desc.Keys;
+		if (keys.empty())
+		{
+			CHECK(desc.Defines.size() <= 16);
+
+			for (ShaderPermutationKey key = 0; key < (1ull << desc.Defines.size()); key++)
+				keys.push_back(key);
+		}
+
+		std::sort(keys.begin(), keys.end());
+		keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+		ShaderArchive previous{};
+		{
+			BinaryReadStream stream(archivePath);
+			if (stream.IsOpen() && !previous.Read(stream))
+			{
+				ENGINE_WARN("Shader archive {} is outdated, cooking every permutation", archivePath.string());
+				previous = {};
+			}
+		}
+
+		struct Permutation
+		{
+			ShaderPermutationKey        Key;
+			const ShaderArchive::Entry* UpToDate;
+			CompileResult               Result;
+			uint64                      DependencyHash;
+		};
+
+		std::vector<Permutation> permutations(keys.size());
+		m_FileHashes.clear();
+
+		for (uint32 i = 0; i < (uint32)keys.size(); i++)
+		{
+			Permutation& p = permutations[i];
+			p.Key = keys[i];
+			p.UpToDate = previous.FindEntry(keys[i]);
+
+			if (p.UpToDate && HashDependencies(desc, p.Key, p.UpToDate->Dependencies) != p.UpToDate->DependencyHash)
+				p.UpToDate = nullptr;
+		}
+
+		JobSystem::Counter counter;
+		for (uint32 i = 0; i < (uint32)permutations.size(); i++)
+		{
+			if (permutations[i].UpToDate)
+				continue;
+
+			JobSystem::Execute(counter, [this, &desc, &source, &permutations, i]() {
+				Permutation& p = permutations[i];
+
+				p.Result = Compile(desc, p.Key, source);
+				if (p.Result.Succeeded)
+					p.DependencyHash = HashDependencies(desc, p.Key, p.Result.Dependencies);
+				});
+		}
+		JobSystem::Wait(counter);
+
+		// identical bytecode is stored once, permutations whose defines do not change the output share it
+		ShaderArchive archive{};
+		std::unordered_map<uint64, uint32> blobsByHash;
+
+		auto addBlob = [&](ShaderFile&& file) -> uint32 {
+			uint64 hash = HashShaderBytecode(file.Bytecode);
+
+			auto it = blobsByHash.find(hash);
+			if (it != blobsByHash.end() && archive.Blobs[it->second].Bytecode == file.Bytecode)
+				return it->second;
+
+			uint32 index = (uint32)archive.Blobs.size();
+			archive.Blobs.push_back(std::move(file));
+			blobsByHash.emplace(hash, index);
+
+			return index;
+			};
+
+		bool succeeded = true;
+
+		for (Permutation& p : permutations)
+		{
+			stats.NumPermutations++;
+
+			ShaderArchive::Entry entry{};
+			entry.Key = p.Key;
+
+			if (p.UpToDate)
+			{
+				stats.NumUpToDate++;
+
+				ShaderFile file = previous.Blobs[p.UpToDate->Blob];
+				entry.Blob = addBlob(std::move(file));
+				entry.DependencyHash = p.UpToDate->DependencyHash;
+				entry.Dependencies = p.UpToDate->Dependencies;
+
+				archive.Entries.push_back(std::move(entry));
+				continue;
+			}
+
+			ShaderFile file{};
+			file.Type = desc.Type;
+
+			if (!p.Result.Succeeded || !ReflectSpirv(p.Result.Bytecode, file.Reflection))
+			{
+				ENGINE_ERROR("Failed to compile {} ({}) permutation {:#x}:\n{}", desc.Source.string(), desc.EntryPoint, p.Key, p.Result.Errors);
+
+				stats.NumFailed++;
+				succeeded = false;
+				continue;
+			}
+
+			if (!p.Result.Errors.empty())
+				ENGINE_WARN("{} ({}) permutation {:#x}:\n{}", desc.Source.string(), desc.EntryPoint, p.Key, p.Result.Errors);
+
+			stats.NumCompiled++;
+
+			file.Bytecode = std::move(p.Result.Bytecode);
+			entry.Blob = addBlob(std::move(file));
+			entry.DependencyHash = p.DependencyHash;
+			entry.Dependencies = std::move(p.Result.Dependencies);
+
+			archive.Entries.push_back(std::move(entry));
+		}
+
+		stats.NumBlobs = (uint32)archive.Blobs.size();
+
+		// written next to the archive and renamed over it, a failed cook never leaves half an archive
+		std::filesystem::path tempPath = archivePath;
+		tempPath += ".tmp";
+		{
+			BinaryWriteStream stream(tempPath);
+			if (!stream.IsOpen())
+			{
+				ENGINE_ERROR("Failed to write shader archive {}", archivePath.string());
+				return false;
+			}
+
+			archive.Write(stream);
+		}
+
+		std::error_code error;
+		std::filesystem::rename(tempPath, archivePath, error);
+		if (error)
+		{
+			ENGINE_ERROR("Failed to write shader archive {}: {}", archivePath.string(), error.message());
+			return false;
+		}
+
+		ENGINE_INFO("Cooked {} ({}): {} permutations, {} up to date, {} compiled, {} failed, {} unique",
+			desc.Source.string(), desc.EntryPoint, stats.NumPermutations, stats.NumUpToDate, stats.NumCompiled, stats.NumFailed, stats.NumBlobs);
+
+		if (outStats)
+			*outStats = stats;
+
+		return succeeded;
+	}
+}
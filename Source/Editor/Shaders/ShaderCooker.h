@@ -0,0 +1,57 @@
+#pragma once
+#include <Engine/Graphics/ShaderArchive.h>
+
+namespace Spikey {
+
+	// one entry point of an hlsl file and the define combinations it is cooked with
+	struct ShaderPermutationDesc
+	{
+		std::filesystem::path    Source;
+		std::string              EntryPoint;
+		EShaderType              Type = EShaderType::None;
+		std::vector<std::string> Defines; // bit i of a permutation key defines Defines[i] to 1
+
+		// permutations used by the engine, every combination of Defines when empty
+		std::vector<ShaderPermutationKey> Keys;
+	};
+
+	struct ShaderCookStats
+	{
+		uint32 NumPermutations;
+		uint32 NumUpToDate; // reused from the previous archive
+		uint32 NumCompiled;
+		uint32 NumFailed;
+		uint32 NumBlobs;    // unique bytecode after de-duplication
+	};
+
+	// compiles shader permutations to spir-v with dxc into a variant archive. permutations whose source,
+	// includes and options did not change since the previous cook are taken over without compiling, the
+	// others compile in parallel on the job system
+	class ShaderCooker
+	{
+	public:
+		ShaderCooker(const std::vector<std::filesystem::path>& includeDirs = {});
+
+		// false when any permutation failed, the archive then keeps the ones that compiled
+		bool Cook(const ShaderPermutationDesc& desc, const std::filesystem::path& archivePath, ShaderCookStats* outStats = nullptr);
+
+	private:
+		struct CompileResult
+		{
+			bool                     Succeeded;
+			std::vector<uint8>       Bytecode;
+			std::vector<std::string> Dependencies;
+			std::string              Errors;
+		};
+
+		CompileResult Compile(const ShaderPermutationDesc& desc, ShaderPermutationKey key, const std::string& source);
+		uint64        HashDependencies(const ShaderPermutationDesc& desc, ShaderPermutationKey key, const std::vector<std::string>& dependencies);
+
+	private:
+		std::vector<std::filesystem::path> m_IncludeDirs;
+
+		// content hashes of the files read during a cook
+		std::mutex                              m_FileHashLock;
+		std::unordered_map<std::string, uint64> m_FileHashes;
+	};
+}
@@ -0,0 +1,518 @@
+#include <Backend/Null/NullBackend.h>
+
+namespace Spikey {
+
+	// errors past this are only counted
+	constexpr uint64 NULL_MAX_LOGGED_VALIDATION_ERRORS = 64;
+
+	NullTexture::NullTexture(const TextureDesc& desc, NullDevice& device, uint32 id)
+		: RHITexture(desc), m_Device(device), m_ID(id)
+	{
+		// the shadow state always tracks per subresource, partial transitions are what goes wrong
+		ValidatedState.Initialize(desc.MipLevels, desc.ArraySize, ERHIAccess::None, true);
+
+		m_Device.m_TexturesCreated.fetch_add(1, std::memory_order_relaxed);
+		m_Device.m_LiveTextures.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	NullTexture::~NullTexture()
+	{
+		m_Device.m_LiveTextures.fetch_sub(1, std::memory_order_relaxed);
+	}
+
+	NullBuffer::NullBuffer(uint64 size, EBufferFlags flags, NullDevice& device, uint32 id)
+		: RHIBuffer(size, flags), m_Device(device), m_ID(id)
+	{
+		m_Address = 0;
+		if (EnumHasAnyFlags(flags, EBufferFlags::GPUAddress))
+		{
+			m_Address = m_Device.m_NextAddress.fetch_add((size + 255) & ~255ull, std::memory_order_relaxed);
+		}
+
+		// host visible buffers are written and read by the engine, they need real memory
+		if (EnumHasAnyFlags(flags, EBufferFlags::Upload | EBufferFlags::ReadBack))
+		{
+			m_HostMemory = std::make_unique<uint8[]>(size);
+			m_Device.m_BufferBytes.fetch_add((int64)size, std::memory_order_relaxed);
+		}
+
+		m_Device.m_BuffersCreated.fetch_add(1, std::memory_order_relaxed);
+		m_Device.m_LiveBuffers.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	NullBuffer::~NullBuffer()
+	{
+		if (m_HostMemory)
+		{
+			m_Device.m_BufferBytes.fetch_sub((int64)GetSize(), std::memory_order_relaxed);
+		}
+		m_Device.m_LiveBuffers.fetch_sub(1, std::memory_order_relaxed);
+	}
+
+	NullCommandList::NullCommandList(NullDevice& device)
+		: m_Device(device)
+	{
+	}
+
+	void NullCommandList::Reset()
+	{
+		CHECK(m_OpenZones == 0 && !m_InPassStatistics);
+
+		m_Stream.clear();
+		memset(m_Commands, 0, sizeof(m_Commands));
+		m_PendingBarriers = 0;
+		ResetStats();
+	}
+
+	void NullCommandList::BeginRecord(ENullCommand command, uint16 payloadSize)
+	{
+		m_Commands[(size_t)command]++;
+
+		Write((uint8)command);
+		Write(payloadSize);
+	}
+
+	void NullCommandList::ValidateTextureState(NullTexture* texture, const TextureSubresourceSet& range, ERHIAccess expected, const char* what, bool read)
+	{
+		TextureSubresourceSet resolved = texture->ValidatedState.Resolve(range);
+
+		for (uint32 layer = resolved.BaseLayer; layer < resolved.BaseLayer + resolved.NumLayers; layer++)
+		{
+			for (uint32 mip = resolved.BaseMip; mip < resolved.BaseMip + resolved.NumMips; mip++)
+			{
+				ERHIAccess state = texture->ValidatedState.GetSubresourceState(mip, layer);
+				if (state == expected)
+					continue;
+
+				// a combined read state serves each of its reads, barriers still have to name it exactly
+				if (read && EnumHasAllFlags(state, ERHIAccess::General) && EnumHasAllFlags(state, expected))
+					continue;
+
+				char message[256];
+				snprintf(message, sizeof(message), "%s: texture %u mip %u layer %u is in state 0x%x, expected 0x%x", what,
+					texture->GetID(), mip, layer, (uint32)state, (uint32)expected);
+
+				m_Device.ReportValidationError(message);
+				return;
+			}
+		}
+	}
+
+	void NullCommandList::FlushBarriers()
+	{
+		if (m_PendingBarriers == 0)
+			return;
+
+		BeginRecord(ENullCommand::FlushBarriers, sizeof(uint32));
+		Write(m_PendingBarriers);
+
+		m_Stats.BarrierBatches++;
+		m_PendingBarriers = 0;
+	}
+
+	void NullCommandList::BarrierTexture(RHITexture* texture, const TextureBarrierRegion* regions, uint32 numRegions)
+	{
+		NullTexture* nullTexture = (NullTexture*)texture;
+
+		struct Region
+		{
+			TextureSubresourceSet Range;
+			ERHIAccess            LastAccess;
+			ERHIAccess            NewAccess;
+		};
+
+		BeginRecord(ENullCommand::BarrierTexture, (uint16)(sizeof(uint32) * 2 + sizeof(Region) * numRegions));
+		Write(nullTexture->GetID());
+		Write(numRegions);
+
+		for (uint32 i = 0; i < numRegions; i++)
+		{
+			const TextureBarrierRegion& region = regions[i];
+			TextureSubresourceSet range = region.EntireTexture ? TextureSubresourceSet::AllTexture() : region.Range;
+			Write(Region{ range, region.LastAccess, region.NewAccess });
+
+			if (m_Device.IsValidating())
+			{
+				std::lock_guard lock(nullTexture->ValidationLock);
+
+				ValidateTextureState(nullTexture, range, region.LastAccess, "BarrierTexture");
+				nullTexture->ValidatedState.SetSubresourcesState(range, region.NewAccess);
+			}
+		}
+
+		m_Stats.BarriersRequested += numRegions;
+		m_Stats.BarriersEmitted += numRegions;
+		m_PendingBarriers += numRegions;
+	}
+
+	void NullCommandList::BarrierBuffer(RHIBuffer* buffer, uint64 size, uint64 offset, ERHIAccess lastAccess, ERHIAccess newAccess)
+	{
+		NullBuffer* nullBuffer = (NullBuffer*)buffer;
+
+		BeginRecord(ENullCommand::BarrierBuffer, sizeof(uint32) + sizeof(uint64) * 2 + sizeof(ERHIAccess) * 2);
+		Write(nullBuffer->GetID());
+		Write(size);
+		Write(offset);
+		Write(lastAccess);
+		Write(newAccess);
+
+		if (m_Device.IsValidating())
+		{
+			// a buffer never barriered before may be in any state
+			ERHIAccess validated = nullBuffer->ValidatedAccess.exchange(newAccess, std::memory_order_relaxed);
+			if (validated != ERHIAccess::None && validated != lastAccess)
+			{
+				char message[256];
+				snprintf(message, sizeof(message), "BarrierBuffer: buffer %u is in state 0x%x, the barrier expects 0x%x",
+					nullBuffer->GetID(), (uint32)validated, (uint32)lastAccess);
+
+				m_Device.ReportValidationError(message);
+			}
+		}
+
+		m_Stats.BarriersRequested++;
+		m_Stats.BarriersEmitted++;
+		m_PendingBarriers++;
+	}
+
+	void NullCommandList::CopyTexture(RHITexture* src, const TextureSlice& srcSlice, RHITexture* dst, const TextureSlice& dstSlice)
+	{
+		FlushBarriers();
+
+		NullTexture* nullSrc = (NullTexture*)src;
+		NullTexture* nullDst = (NullTexture*)dst;
+
+		BeginRecord(ENullCommand::CopyTexture, sizeof(uint32) * 2 + sizeof(TextureSlice) * 2);
+		Write(nullSrc->GetID());
+		Write(srcSlice);
+		Write(nullDst->GetID());
+		Write(dstSlice);
+
+		if (m_Device.IsValidating())
+		{
+			TextureSubresourceSet srcRange{ srcSlice.MipLevel, 1, srcSlice.ArraySlice, 1 };
+			TextureSubresourceSet dstRange{ dstSlice.MipLevel, 1, dstSlice.ArraySlice, 1 };
+			{
+				std::lock_guard lock(nullSrc->ValidationLock);
+				ValidateTextureState(nullSrc, srcRange, ERHIAccess::CopySrc, "CopyTexture source", true);
+			}
+			{
+				std::lock_guard lock(nullDst->ValidationLock);
+				ValidateTextureState(nullDst, dstRange, ERHIAccess::CopyDst, "CopyTexture destination");
+			}
+		}
+	}
+
+	void NullCommandList::CopyTextureToBuffer(RHITexture* src, const TextureSlice& srcSlice, RHIBuffer* dst, uint64 dstOffset)
+	{
+		FlushBarriers();
+
+		NullTexture* nullSrc = (NullTexture*)src;
+		NullBuffer*  nullDst = (NullBuffer*)dst;
+		TextureSlice slice = ResolveTextureSlice(src->GetDesc(), srcSlice);
+
+		BeginRecord(ENullCommand::CopyTextureToBuffer, sizeof(uint32) * 2 + sizeof(TextureSlice) + sizeof(uint64));
+		Write(nullSrc->GetID());
+		Write(slice);
+		Write(nullDst->GetID());
+		Write(dstOffset);
+
+		if (m_Device.IsValidating())
+		{
+			if (dstOffset + TextureSliceSizeInBytes(src->GetFormat(), slice) > dst->GetSize())
+			{
+				char message[256];
+				snprintf(message, sizeof(message), "CopyTextureToBuffer: texture %u slice does not fit buffer %u", nullSrc->GetID(), nullDst->GetID());
+
+				m_Device.ReportValidationError(message);
+			}
+
+			std::lock_guard lock(nullSrc->ValidationLock);
+			ValidateTextureState(nullSrc, TextureSubresourceSet{ slice.MipLevel, 1, slice.ArraySlice, 1 }, ERHIAccess::CopySrc, "CopyTextureToBuffer source", true);
+		}
+	}
+
+	void NullCommandList::CopyBuffer(RHIBuffer* srcBuffer, RHIBuffer* dstBuffer, uint64 srcOffset, uint64 dstOffset, uint64 size)
+	{
+		FlushBarriers();
+
+		NullBuffer* nullSrc = (NullBuffer*)srcBuffer;
+		NullBuffer* nullDst = (NullBuffer*)dstBuffer;
+
+		BeginRecord(ENullCommand::CopyBuffer, sizeof(uint32) * 2 + sizeof(uint64) * 3);
+		Write(nullSrc->GetID());
+		Write(nullDst->GetID());
+		Write(srcOffset);
+		Write(dstOffset);
+		Write(size);
+
+		if (m_Device.IsValidating() && (srcOffset + size > srcBuffer->GetSize() || dstOffset + size > dstBuffer->GetSize()))
+		{
+			char message[256];
+			snprintf(message, sizeof(message), "CopyBuffer: %llu bytes from buffer %u to buffer %u are out of range", (unsigned long long)size,
+				nullSrc->GetID(), nullDst->GetID());
+
+			m_Device.ReportValidationError(message);
+		}
+	}
+
+	void NullCommandList::BeginGPUZone(const GPUZoneSource* source)
+	{
+		FlushBarriers();
+
+		uint16 length = (uint16)strlen(source->Name);
+		BeginRecord(ENullCommand::BeginGPUZone, sizeof(uint16) + length);
+		Write(length);
+		m_Stream.insert(m_Stream.end(), source->Name, source->Name + length);
+
+		m_OpenZones++;
+	}
+
+	void NullCommandList::EndGPUZone()
+	{
+		CHECK(m_OpenZones > 0);
+		FlushBarriers();
+
+		BeginRecord(ENullCommand::EndGPUZone, 0);
+		m_OpenZones--;
+	}
+
+	void NullCommandList::BeginPassStatistics(const char* name)
+	{
+		// same rule the gpu backends have
+		CHECK(!m_InPassStatistics);
+		FlushBarriers();
+
+		uint16 length = (uint16)strlen(name);
+		BeginRecord(ENullCommand::BeginPassStatistics, sizeof(uint16) + length);
+		Write(length);
+		m_Stream.insert(m_Stream.end(), name, name + length);
+
+		m_InPassStatistics = true;
+	}
+
+	void NullCommandList::EndPassStatistics()
+	{
+		CHECK(m_InPassStatistics);
+		FlushBarriers();
+
+		BeginRecord(ENullCommand::EndPassStatistics, 0);
+		m_InPassStatistics = false;
+	}
+
+	NullDevice::NullDevice(bool validateStates)
+		: m_ValidateStates(validateStates)
+	{
+		ENGINE_INFO("created null rhi device{}", validateStates ? " with state validation" : "");
+	}
+
+	NullDevice::~NullDevice()
+	{
+		if (m_ValidationErrors.load() > 0)
+		{
+			ENGINE_WARN("null rhi device recorded {} resource state errors", m_ValidationErrors.load());
+		}
+	}
+
+	TextureRHIRef NullDevice::CreateTexture(const TextureDesc& desc)
+	{
+		return new NullTexture(desc, *this, m_NextResourceID.fetch_add(1, std::memory_order_relaxed));
+	}
+
+	BufferRHIRef NullDevice::CreateBuffer(uint64 size, EBufferFlags flags)
+	{
+		return new NullBuffer(size, flags, *this, m_NextResourceID.fetch_add(1, std::memory_order_relaxed));
+	}
+
+	SamplerStateRHIRef NullDevice::CreateSamplerState(const SamplerStateDesc& desc)
+	{
+		m_SamplersCreated.fetch_add(1, std::memory_order_relaxed);
+		return new NullSamplerState(desc);
+	}
+
+	ShaderRHIRef NullDevice::CreateVertexShader(const std::span<uint8>& bytecode, const ShaderReflection* reflection)
+	{
+		m_ShadersCreated.fetch_add(1, std::memory_order_relaxed);
+		return new NullShader();
+	}
+
+	ShaderRHIRef NullDevice::CreatePixelShader(const std::span<uint8>& bytecode, const ShaderReflection* reflection)
+	{
+		m_ShadersCreated.fetch_add(1, std::memory_order_relaxed);
+		return new NullShader();
+	}
+
+	ShaderRHIRef NullDevice::CreateComputeShader(const std::span<uint8>& bytecode, const ShaderReflection* reflection)
+	{
+		m_ShadersCreated.fetch_add(1, std::memory_order_relaxed);
+		return new NullShader();
+	}
+
+	PipelineStateRHIRef NullDevice::CreatePipelineState(const PipelineStateDesc& desc)
+	{
+		m_PipelinesCreated.fetch_add(1, std::memory_order_relaxed);
+		return new NullPipelineState();
+	}
+
+	PipelineStateRHIRef NullDevice::CreatePipelineStateAsync(const PipelineStateDesc& desc)
+	{
+		// nothing to compile, ready at once
+		return CreatePipelineState(desc);
+	}
+
+	PipelineStateCacheStats NullDevice::GetPipelineStateCacheStats() const
+	{
+		PipelineStateCacheStats stats{};
+		stats.Misses = m_PipelinesCreated.load(std::memory_order_relaxed);
+
+		return stats;
+	}
+
+	RHICommandList* NullDevice::BeginCommandList()
+	{
+		std::lock_guard lock(m_ListLock);
+
+		if (m_FreeLists.empty())
+		{
+			m_Lists.push_back(std::make_unique<NullCommandList>(*this));
+			return m_Lists.back().get();
+		}
+
+		NullCommandList* list = m_FreeLists.back();
+		m_FreeLists.pop_back();
+
+		return list;
+	}
+
+	void NullDevice::SubmitCommandList(RHICommandList* cmd)
+	{
+		PROFILE_SCOPED;
+
+		NullCommandList* list = (NullCommandList*)cmd;
+		list->FlushBarriers();
+
+		std::lock_guard lock(m_ListLock);
+
+		const uint64* commands = list->GetCommandCounts();
+		for (uint32 i = 0; i < (uint32)ENullCommand::Count; i++)
+		{
+			m_SubmittedStats.Commands[i] += commands[i];
+		}
+
+		const CommandListStats& stats = list->GetStats();
+		m_SubmittedStats.BarriersRequested += stats.BarriersRequested;
+		m_SubmittedStats.BarriersEmitted += stats.BarriersEmitted;
+		m_SubmittedStats.BarrierBatches += stats.BarrierBatches;
+		m_SubmittedStats.StreamBytes += list->GetStream().size();
+		m_SubmittedStats.CommandListsSubmitted++;
+
+		if (m_CaptureEnabled)
+		{
+			m_Capture.insert(m_Capture.end(), list->GetStream().begin(), list->GetStream().end());
+		}
+
+		// nothing runs, the list can be recorded again right away
+		list->Reset();
+		m_FreeLists.push_back(list);
+	}
+
+	void NullDevice::ReadTexture(RHITexture* texture, const TextureSlice& slice, std::vector<uint8>& outData)
+	{
+		TextureSlice resolved = ResolveTextureSlice(texture->GetDesc(), slice);
+
+		// recorded like the gpu backends do it, so the stream and the barrier checks match
+		RHICommandList* cmd = BeginCommandList();
+		BufferRHIRef staging = CreateBuffer(TextureSliceSizeInBytes(texture->GetFormat(), resolved), EBufferFlags::ReadBack);
+
+		texture->Barrier(cmd, TextureSubresourceSet{ resolved.MipLevel, 1, resolved.ArraySlice, 1 }, ERHIAccess::CopySrc);
+		cmd->CopyTextureToBuffer(texture, resolved, staging, 0);
+		SubmitCommandList(cmd);
+
+		outData.assign(staging->GetSize(), 0);
+	}
+
+	std::future<std::vector<uint8>> NullDevice::ReadTextureAsync(RHICommandList* cmd, RHITexture* texture, const TextureSlice& slice)
+	{
+		TextureSlice resolved = ResolveTextureSlice(texture->GetDesc(), slice);
+		BufferRHIRef staging = CreateBuffer(TextureSliceSizeInBytes(texture->GetFormat(), resolved), EBufferFlags::ReadBack);
+
+		texture->Barrier(cmd, TextureSubresourceSet{ resolved.MipLevel, 1, resolved.ArraySlice, 1 }, ERHIAccess::CopySrc);
+		cmd->CopyTextureToBuffer(texture, resolved, staging, 0);
+
+		// nothing runs, the data is ready at once
+		std::promise<std::vector<uint8>> promise;
+		promise.set_value(std::vector<uint8>(staging->GetSize(), 0));
+
+		return promise.get_future();
+	}
+
+	std::future<std::vector<uint8>> NullDevice::ReadBufferAsync(RHICommandList* cmd, RHIBuffer* buffer, uint64 offset, uint64 size,
+		ERHIAccess access)
+	{
+		BufferRHIRef staging = CreateBuffer(size, EBufferFlags::ReadBack);
+
+		cmd->BarrierBuffer(buffer, size, offset, access, ERHIAccess::CopySrc);
+		cmd->CopyBuffer(buffer, staging, offset, 0, size);
+		cmd->BarrierBuffer(buffer, size, offset, ERHIAccess::CopySrc, access);
+
+		std::promise<std::vector<uint8>> promise;
+		promise.set_value(std::vector<uint8>(size, 0));
+
+		return promise.get_future();
+	}
+
+	void NullDevice::SetCaptureEnabled(bool enabled)
+	{
+		std::lock_guard lock(m_ListLock);
+		m_CaptureEnabled = enabled;
+	}
+
+	std::vector<uint8> NullDevice::TakeCapture()
+	{
+		std::lock_guard lock(m_ListLock);
+		return std::move(m_Capture);
+	}
+
+	void NullDevice::ReportValidationError(const char* message)
+	{
+		uint64 count = m_ValidationErrors.fetch_add(1, std::memory_order_relaxed);
+		if (count < NULL_MAX_LOGGED_VALIDATION_ERRORS)
+		{
+			ENGINE_ERROR("rhi state validation: {}", message);
+		}
+	}
+
+	NullDeviceStats NullDevice::GetStats() const
+	{
+		NullDeviceStats stats{};
+		{
+			std::lock_guard lock(m_ListLock);
+			stats = m_SubmittedStats;
+		}
+
+		stats.TexturesCreated = m_TexturesCreated.load(std::memory_order_relaxed);
+		stats.BuffersCreated = m_BuffersCreated.load(std::memory_order_relaxed);
+		stats.SamplersCreated = m_SamplersCreated.load(std::memory_order_relaxed);
+		stats.ShadersCreated = m_ShadersCreated.load(std::memory_order_relaxed);
+		stats.PipelinesCreated = m_PipelinesCreated.load(std::memory_order_relaxed);
+		stats.LiveTextures = (uint64)m_LiveTextures.load(std::memory_order_relaxed);
+		stats.LiveBuffers = (uint64)m_LiveBuffers.load(std::memory_order_relaxed);
+		stats.BufferBytes = (uint64)m_BufferBytes.load(std::memory_order_relaxed);
+		stats.ValidationErrors = m_ValidationErrors.load(std::memory_order_relaxed);
+
+		return stats;
+	}
+
+	void NullDevice::ResetStats()
+	{
+		std::lock_guard lock(m_ListLock);
+		m_SubmittedStats = {};
+
+		m_TexturesCreated.store(0, std::memory_order_relaxed);
+		m_BuffersCreated.store(0, std::memory_order_relaxed);
+		m_SamplersCreated.store(0, std::memory_order_relaxed);
+		m_ShadersCreated.store(0, std::memory_order_relaxed);
+		m_PipelinesCreated.store(0, std::memory_order_relaxed);
+		m_ValidationErrors.store(0, std::memory_order_relaxed);
+	}
+}
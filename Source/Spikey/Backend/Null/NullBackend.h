@@ -0,0 +1,248 @@
+#pragma once
+
+#include <Engine/Graphics/GraphicsCore.h>
+
+namespace Spikey {
+
+	// every RHICommandList call the null backend records
+	enum class ENullCommand : uint8
+	{
+		CopyTexture,
+		CopyTextureToBuffer,
+		CopyBuffer,
+		BarrierTexture,
+		BarrierBuffer,
+		FlushBarriers,
+		BeginGPUZone,
+		EndGPUZone,
+		BeginPassStatistics,
+		EndPassStatistics,
+
+		Count
+	};
+
+	struct NullDeviceStats
+	{
+		uint64 Commands[(size_t)ENullCommand::Count];
+		uint64 StreamBytes;
+		uint64 CommandListsSubmitted;
+
+		uint64 BarriersRequested;
+		uint64 BarriersEmitted;
+		uint64 BarrierBatches;
+
+		uint64 TexturesCreated;
+		uint64 BuffersCreated;
+		uint64 SamplersCreated;
+		uint64 ShadersCreated;
+		uint64 PipelinesCreated;
+		uint64 LiveTextures;
+		uint64 LiveBuffers;
+		uint64 BufferBytes; // host memory behind upload and readback buffers
+
+		uint64 ValidationErrors;
+	};
+
+	class NullDevice;
+
+	class NullTexture : public RHITexture
+	{
+	public:
+		NullTexture(const TextureDesc& desc, NullDevice& device, uint32 id);
+		virtual ~NullTexture() override;
+
+		uint32 GetID() const { return m_ID; }
+
+		// state the recorded barriers left the texture in, independent of the state the engine tracks
+		std::mutex   ValidationLock;
+		TextureState ValidatedState;
+
+	private:
+		NullDevice& m_Device;
+		uint32      m_ID;
+	};
+
+	class NullBuffer : public RHIBuffer
+	{
+	public:
+		NullBuffer(uint64 size, EBufferFlags flags, NullDevice& device, uint32 id);
+		virtual ~NullBuffer() override;
+
+		virtual void*  GetMappedData() const override { return m_HostMemory.get(); }
+		virtual uint64 GetGPUAddress() const override { return m_Address; }
+		uint32         GetID() const { return m_ID; }
+
+		std::atomic<ERHIAccess> ValidatedAccess{ ERHIAccess::None };
+
+	private:
+		NullDevice&             m_Device;
+		uint32                  m_ID;
+		uint64                  m_Address;
+		std::unique_ptr<uint8[]> m_HostMemory;
+	};
+
+	class NullSamplerState : public RHISamplerState
+	{
+	public:
+		NullSamplerState(const SamplerStateDesc& desc) : RHISamplerState(desc) {}
+
+		virtual void* GetNative() const override { return nullptr; }
+	};
+
+	class NullShader : public IRHIShader
+	{
+	public:
+		virtual void* GetNative() const override { return nullptr; }
+	};
+
+	class NullPipelineState : public RHIPipelineState
+	{
+	};
+
+	// records every call into a compact stream instead of a gpu command buffer. a record is the command byte,
+	// a uint16 payload size and the payload. resources are written as the ids the device gave them, so the
+	// stream of a scripted scene is the same every run
+	class NullCommandList : public RHICommandList
+	{
+	public:
+		NullCommandList(NullDevice& device);
+
+		virtual void* GetNative() const override { return nullptr; }
+
+		virtual void CopyTexture(RHITexture* src, const TextureSlice& srcSlice, RHITexture* dst, const TextureSlice& dstSlice) override;
+		virtual void CopyTextureToBuffer(RHITexture* src, const TextureSlice& srcSlice, RHIBuffer* dst, uint64 dstOffset) override;
+		virtual void CopyBuffer(RHIBuffer* srcBuffer, RHIBuffer* dstBuffer, uint64 srcOffset, uint64 dstOffset, uint64 size) override;
+		virtual void FlushBarriers() override;
+		virtual void BarrierTexture(RHITexture* texture, const TextureBarrierRegion* regions, uint32 numRegions) override;
+		virtual void BarrierBuffer(RHIBuffer* buffer, uint64 size, uint64 offset, ERHIAccess lastAccess, ERHIAccess newAccess) override;
+		virtual void BeginGPUZone(const GPUZoneSource* source) override;
+		virtual void EndGPUZone() override;
+		virtual void BeginPassStatistics(const char* name) override;
+		virtual void EndPassStatistics() override;
+
+		void Reset();
+
+		const std::vector<uint8>& GetStream() const { return m_Stream; }
+		const uint64*             GetCommandCounts() const { return m_Commands; }
+
+	private:
+		template<typename T>
+		void Write(const T& value)
+		{
+			const uint8* bytes = (const uint8*)&value;
+			m_Stream.insert(m_Stream.end(), bytes, bytes + sizeof(T));
+		}
+
+		void BeginRecord(ENullCommand command, uint16 payloadSize);
+
+		void ValidateTextureState(NullTexture* texture, const TextureSubresourceSet& range, ERHIAccess expected, const char* what, bool read = false);
+
+	private:
+		NullDevice&        m_Device;
+		std::vector<uint8> m_Stream;
+		uint64             m_Commands[(size_t)ENullCommand::Count] = {};
+		uint32             m_PendingBarriers = 0;
+		uint32             m_OpenZones = 0;
+		bool               m_InPassStatistics = false;
+	};
+
+	// IRHIDevice that creates no gpu objects, for measuring the cpu side of the renderer and checking its
+	// barriers on machines without a gpu. command lists are recorded and dropped at submit, waits return at
+	// once. with validation the recorded barriers are checked against a shadow state of every resource, which
+	// follows recording order, so dependent lists have to be recorded in the order they are submitted
+	class NullDevice : public IRHIDevice
+	{
+	public:
+		NullDevice(bool validateStates = false);
+		virtual ~NullDevice() override;
+
+		virtual TextureRHIRef CreateTexture(const TextureDesc& desc) override;
+		virtual BufferRHIRef CreateBuffer(uint64 size, EBufferFlags flags) override;
+		virtual SamplerStateRHIRef CreateSamplerState(const SamplerStateDesc& desc) override;
+
+		virtual ShaderRHIRef CreateVertexShader(const std::span<uint8>& bytecode, const ShaderReflection* reflection = nullptr) override;
+		virtual ShaderRHIRef CreatePixelShader(const std::span<uint8>& bytecode, const ShaderReflection* reflection = nullptr) override;
+		virtual ShaderRHIRef CreateComputeShader(const std::span<uint8>& bytecode, const ShaderReflection* reflection = nullptr) override;
+		virtual PipelineStateRHIRef CreatePipelineState(const PipelineStateDesc& desc) override;
+		virtual PipelineStateCacheStats GetPipelineStateCacheStats() const override;
+		virtual PipelineStateRHIRef CreatePipelineStateAsync(const PipelineStateDesc& desc) override;
+		virtual void SetFallbackPipelineState(RHIPipelineState* pipeline) override {}
+		virtual RHIPipelineState* ResolvePipelineState(RHIPipelineState* pipeline) override { return pipeline; }
+		virtual void   PrecompilePipelines() override {}
+		virtual uint32 GetNumPendingPipelinePrecompiles() const override { return 0; }
+
+		virtual GPUFrameTimings GetGPUFrameTimings(ERHIQueue queue) const override { return {}; }
+		virtual GPUPassStatisticsFrame GetGPUPassStatistics() const override { return {}; }
+
+		// nothing is rendered, the data is zeros of the size the gpu backends return
+		virtual void ReadTexture(RHITexture* texture, const TextureSlice& slice, std::vector<uint8>& outData) override;
+		virtual std::future<std::vector<uint8>> ReadTextureAsync(RHICommandList* cmd, RHITexture* texture, const TextureSlice& slice) override;
+		virtual std::future<std::vector<uint8>> ReadBufferAsync(RHICommandList* cmd, RHIBuffer* buffer, uint64 offset, uint64 size,
+			ERHIAccess access) override;
+
+		virtual RHICommandList* BeginCommandList() override;
+		virtual void SubmitCommandList(RHICommandList* cmd) override;
+		virtual void WaitCommandList(RHICommandList* cmd) override {}
+
+		// entry points of the old command buffer api, nothing renders through them on this backend
+		virtual void RunGarbageCollection() override {}
+		virtual void CopyDataToTexture(void* src, uint64 srcOffset, IRHITexture* dst, EGPUAccess lastAccess, EGPUAccess newAccess,
+			const std::vector<SubResourceCopyRegion>& regions, uint64 copySize) override {}
+		virtual TextureCubeRHIRef CreateTextureCube(uint32 size, uint32 numMips, ETextureFormat format, ETextureUsage usage) override { return nullptr; }
+		virtual TextureViewRHIRef CreateTextureView(uint32 baseMip, uint32 numMips, uint32 baseLayer, uint32 numLayers, IRHITexture* tex) override { return nullptr; }
+		virtual RHIData CreateSamplerRHI(const SamplerDesc& desc) override { return {}; }
+		virtual void DestroySamplerRHI(RHIData data) override {}
+		virtual RHIData CreateCommandBufferRHI() override { return {}; }
+		virtual void DestroyCommandBufferRHI(RHIData data) override {}
+		virtual void BeginFrameCommandBuffer(RHICommandBuffer* cmd) override {}
+		virtual void WaitForFrameCommandBuffer(RHICommandBuffer* cmd) override {}
+		virtual void ImmediateSubmit(std::function<void(RHICommandBuffer*)>&& func) override {}
+		virtual void WaitGPUIdle() override {}
+		virtual void BeginRendering(RHICommandBuffer* cmd, const RenderInfo& info) override {}
+		virtual void EndRendering(RHICommandBuffer* cmd) override {}
+		virtual void DrawIndirectCount(RHICommandBuffer* cmd, RHIBuffer* commBuffer, uint64 offset, RHIBuffer* countBuffer,
+			uint64 countBufferOffset, uint32 maxDrawCount, uint32 commStride) override {}
+		virtual void Draw(RHICommandBuffer* cmd, uint32 vertexCount, uint32 instanceCount, uint32 firstVertex, uint32 firstInstance) override {}
+		virtual void DrawSwapchain(RHICommandBuffer* cmd, uint32 width, uint32 height, ImGuiRTState* guiState = nullptr, RHITexture2D* fillTexture = nullptr) override {}
+
+		bool IsValidating() const { return m_ValidateStates; }
+
+		// appends the streams of submitted lists in submission order, for comparing runs
+		void SetCaptureEnabled(bool enabled);
+		std::vector<uint8> TakeCapture();
+
+		NullDeviceStats GetStats() const;
+		void            ResetStats();
+
+	private:
+		friend class NullTexture;
+		friend class NullBuffer;
+		friend class NullCommandList;
+
+		void ReportValidationError(const char* message);
+
+	private:
+		bool m_ValidateStates;
+
+		std::atomic<uint32> m_NextResourceID{ 1 };
+		std::atomic<uint64> m_NextAddress{ 0x10000 };
+
+		std::atomic<uint64> m_TexturesCreated{ 0 };
+		std::atomic<uint64> m_BuffersCreated{ 0 };
+		std::atomic<uint64> m_SamplersCreated{ 0 };
+		std::atomic<uint64> m_ShadersCreated{ 0 };
+		std::atomic<uint64> m_PipelinesCreated{ 0 };
+		std::atomic<int64>  m_LiveTextures{ 0 };
+		std::atomic<int64>  m_LiveBuffers{ 0 };
+		std::atomic<int64>  m_BufferBytes{ 0 };
+		std::atomic<uint64> m_ValidationErrors{ 0 };
+
+		// guarded by m_ListLock
+		mutable std::mutex                            m_ListLock;
+		std::vector<std::unique_ptr<NullCommandList>> m_Lists;
+		std::vector<NullCommandList*>                 m_FreeLists;
+		NullDeviceStats                               m_SubmittedStats = {};
+		bool                                          m_CaptureEnabled = false;
+		std::vector<uint8>                            m_Capture;
+	};
+}
@@ -1,5 +1,11 @@
 #include <Backend/Vulkan/VulkanBackend.h>
 #include <spirv_reflect.h>
+#include <chrono>
+#include <thread>
+
+#if BUILD_SDL_BACKEND
+#include <SDL3/SDL_vulkan.h>
+#endif
 
 namespace Spikey {
 
@@ -42,42 +48,42 @@ namespace Spikey {
 		}
 	}
 
-	constexpr VkImageLayout ConvertVkImageLayout(EGPUAccess flags) 
+	constexpr VkImageLayout ConvertVkImageLayout(ERHIAccess flags) 
 	{
-		if (EnumHasAnyFlags(flags, EGPUAccess::UAVCompute | EGPUAccess::UAVGraphics))      return VK_IMAGE_LAYOUT_GENERAL;
-		else if (EnumHasAnyFlags(flags, EGPUAccess::SRVCompute | EGPUAccess::SRVGraphics)) return VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-		else if (EnumHasAllFlags(flags, EGPUAccess::CopySrc))                              return VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-		else if (EnumHasAllFlags(flags, EGPUAccess::CopyDst))                              return VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-		else if (EnumHasAllFlags(flags, EGPUAccess::ColorTarget))                          return VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-		else if (EnumHasAllFlags(flags, EGPUAccess::DepthTarget))                          return VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL;
+		if (EnumHasAnyFlags(flags, ERHIAccess::UAV | ERHIAccess::General))                 return VK_IMAGE_LAYOUT_GENERAL;
+		else if (EnumHasAnyFlags(flags, ERHIAccess::SRVCompute | ERHIAccess::SRVGraphics)) return VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		else if (EnumHasAllFlags(flags, ERHIAccess::CopySrc))                              return VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		else if (EnumHasAllFlags(flags, ERHIAccess::CopyDst))                              return VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		else if (EnumHasAllFlags(flags, ERHIAccess::ColorTarget))                          return VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+		else if (EnumHasAllFlags(flags, ERHIAccess::DepthTarget))                          return VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL;
 		else                                                                               return VK_IMAGE_LAYOUT_UNDEFINED;
 	}
 
-	constexpr VkAccessFlags2 ConvertVkResourceState(EGPUAccess flags) 
+	constexpr VkAccessFlags2 ConvertVkResourceState(ERHIAccess flags) 
 	{
 		VkAccessFlags2 outFlags = 0;
 
-		if (EnumHasAnyFlags(flags, EGPUAccess::UAVCompute | EGPUAccess::UAVGraphics)) outFlags |= VK_ACCESS_2_SHADER_WRITE_BIT;
-		if (EnumHasAnyFlags(flags, EGPUAccess::SRVCompute | EGPUAccess::SRVGraphics)) outFlags |= VK_ACCESS_2_SHADER_READ_BIT;
-		if (EnumHasAllFlags(flags, EGPUAccess::CopySrc))                              outFlags |= VK_ACCESS_2_TRANSFER_READ_BIT;
-		if (EnumHasAllFlags(flags, EGPUAccess::CopyDst))                              outFlags |= VK_ACCESS_2_TRANSFER_WRITE_BIT;
-		if (EnumHasAllFlags(flags, EGPUAccess::ColorTarget))                          outFlags |= VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT;
-		if (EnumHasAllFlags(flags, EGPUAccess::DepthTarget))                          outFlags |= VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT;
-		if (EnumHasAllFlags(flags, EGPUAccess::IndirectArgs))                         outFlags |= VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT;
+		if (EnumHasAnyFlags(flags, ERHIAccess::UAVCompute | ERHIAccess::UAVGraphics)) outFlags |= VK_ACCESS_2_SHADER_WRITE_BIT;
+		if (EnumHasAnyFlags(flags, ERHIAccess::SRVCompute | ERHIAccess::SRVGraphics)) outFlags |= VK_ACCESS_2_SHADER_READ_BIT;
+		if (EnumHasAllFlags(flags, ERHIAccess::CopySrc))                              outFlags |= VK_ACCESS_2_TRANSFER_READ_BIT;
+		if (EnumHasAllFlags(flags, ERHIAccess::CopyDst))                              outFlags |= VK_ACCESS_2_TRANSFER_WRITE_BIT;
+		if (EnumHasAllFlags(flags, ERHIAccess::ColorTarget))                          outFlags |= VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT;
+		if (EnumHasAllFlags(flags, ERHIAccess::DepthTarget))                          outFlags |= VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT;
+		if (EnumHasAllFlags(flags, ERHIAccess::IndirectArgs))                         outFlags |= VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT;
 
 		return outFlags;
 	}
 
-	constexpr VkPipelineStageFlags2 ConvertVkPipelineStage(EGPUAccess flags) 
+	constexpr VkPipelineStageFlags2 ConvertVkPipelineStage(ERHIAccess flags) 
 	{
 		VkPipelineStageFlags2 outFlags = 0;
 
-		if (EnumHasAnyFlags(flags, EGPUAccess::SRVCompute | EGPUAccess::UAVCompute))   outFlags |= VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
-		if (EnumHasAnyFlags(flags, EGPUAccess::SRVGraphics | EGPUAccess::UAVGraphics)) outFlags |= VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;
-		if (EnumHasAllFlags(flags, EGPUAccess::IndirectArgs))                          outFlags |= VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT;
-		if (EnumHasAnyFlags(flags, EGPUAccess::CopySrc | EGPUAccess::CopyDst))         outFlags |= VK_PIPELINE_STAGE_2_TRANSFER_BIT;
-		if (EnumHasAllFlags(flags, EGPUAccess::ColorTarget))                           outFlags |= VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT;
-		if (EnumHasAllFlags(flags, EGPUAccess::DepthTarget))                           outFlags |= VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT;
+		if (EnumHasAnyFlags(flags, ERHIAccess::SRVCompute | ERHIAccess::UAVCompute))   outFlags |= VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+		if (EnumHasAnyFlags(flags, ERHIAccess::SRVGraphics | ERHIAccess::UAVGraphics)) outFlags |= VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;
+		if (EnumHasAllFlags(flags, ERHIAccess::IndirectArgs))                          outFlags |= VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT;
+		if (EnumHasAnyFlags(flags, ERHIAccess::CopySrc | ERHIAccess::CopyDst))         outFlags |= VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+		if (EnumHasAllFlags(flags, ERHIAccess::ColorTarget))                           outFlags |= VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT;
+		if (EnumHasAllFlags(flags, ERHIAccess::DepthTarget))                           outFlags |= VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT;
 
 		return outFlags;
 	}
@@ -312,6 +318,7 @@ namespace Spikey {
 
 	VulkanCommandList::VulkanCommandList(VulkanQueue* queue, VulkanDevice& device) 
 		: m_Device(device)
+		, m_Queue(queue)
 	{
 		VkCommandPoolCreateInfo poolInfo{ .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO };
 		poolInfo.queueFamilyIndex = queue->GetFamilyIndex();
@@ -325,6 +332,9 @@ namespace Spikey {
 		cmdInfo.commandBufferCount = 1;
 
 		VK_CHECK(vkAllocateCommandBuffers(m_Device.GetDeviceHandle(), &cmdInfo, &m_CmdBuffer));
+
+		m_PendingMemoryBarrier = { .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2 };
+		m_HasPendingMemoryBarrier = false;
 	}
 
 	VulkanCommandList::~VulkanCommandList() 
@@ -332,6 +342,300 @@ namespace Spikey {
 		vkDestroyCommandPool(m_Device.GetDeviceHandle(), m_Pool, nullptr);
 	}
 
+	void VulkanCommandList::Begin()
+	{
+		CHECK(m_GPUZoneStack.empty() && !m_InPassStatistics);
+
+		VkCommandBufferBeginInfo beginInfo{ .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+		VK_CHECK(vkResetCommandPool(m_Device.GetDeviceHandle(), m_Pool, 0));
+		VK_CHECK(vkBeginCommandBuffer(m_CmdBuffer, &beginInfo));
+
+		ResetStats();
+	}
+
+	void VulkanCommandList::End()
+	{
+		CHECK(m_GPUZoneStack.empty() && !m_InPassStatistics);
+
+		FlushBarriers();
+		VK_CHECK(vkEndCommandBuffer(m_CmdBuffer));
+	}
+
+	constexpr bool HasVkWriteAccess(VkAccessFlags2 flags)
+	{
+		return (flags & (VK_ACCESS_2_SHADER_WRITE_BIT | VK_ACCESS_2_TRANSFER_WRITE_BIT | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT
+			| VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT)) != 0;
+	}
+
+	// a barrier between two reads in the same layout orders nothing
+	constexpr bool IsVkBarrierRedundant(const VkImageMemoryBarrier2& barrier)
+	{
+		return barrier.oldLayout == barrier.newLayout && !HasVkWriteAccess(barrier.srcAccessMask) && !HasVkWriteAccess(barrier.dstAccessMask);
+	}
+
+	// counts of VK_REMAINING_MIP_LEVELS / VK_REMAINING_ARRAY_LAYERS run to the end of the image
+	static bool VkSubresourceIntervalsOverlap(uint32 baseA, uint32 countA, uint32 baseB, uint32 countB)
+	{
+		uint64 endA = countA == ~0u ? UINT64_MAX : (uint64)baseA + countA;
+		uint64 endB = countB == ~0u ? UINT64_MAX : (uint64)baseB + countB;
+
+		return baseA < endB && baseB < endA;
+	}
+
+	static bool VkSubresourceRangesOverlap(const VkImageSubresourceRange& a, const VkImageSubresourceRange& b)
+	{
+		return (a.aspectMask & b.aspectMask) != 0
+			&& VkSubresourceIntervalsOverlap(a.baseMipLevel, a.levelCount, b.baseMipLevel, b.levelCount)
+			&& VkSubresourceIntervalsOverlap(a.baseArrayLayer, a.layerCount, b.baseArrayLayer, b.layerCount);
+	}
+
+	void VulkanCommandList::QueueImageBarrier(const VkImageMemoryBarrier2& barrier)
+	{
+		// nothing was recorded since the pending barrier was queued, so a second transition of the same
+		// subresources chains into it, A -> B then B -> C becomes A -> C
+		for (uint32 i = 0; i < (uint32)m_PendingImageBarriers.size(); i++)
+		{
+			VkImageMemoryBarrier2& pending = m_PendingImageBarriers[i];
+			const VkImageSubresourceRange& a = pending.subresourceRange;
+			const VkImageSubresourceRange& b = barrier.subresourceRange;
+
+			if (pending.image != barrier.image || !VkSubresourceRangesOverlap(a, b))
+				continue;
+
+			if (a.baseMipLevel == b.baseMipLevel && a.levelCount == b.levelCount
+				&& a.baseArrayLayer == b.baseArrayLayer && a.layerCount == b.layerCount)
+			{
+				pending.dstStageMask = barrier.dstStageMask;
+				pending.dstAccessMask = barrier.dstAccessMask;
+				pending.newLayout = barrier.newLayout;
+
+				if (IsVkBarrierRedundant(pending))
+				{
+					m_PendingImageBarriers[i] = m_PendingImageBarriers.back();
+					m_PendingImageBarriers.pop_back();
+				}
+				return;
+			}
+
+			// partly overlapping ranges cannot chain, and one batch must not transition a subresource twice.
+			// the pending ones are recorded first, so the new barrier sees the layout they leave behind
+			if (!IsVkBarrierRedundant(barrier))
+				FlushBarriers();
+			break;
+		}
+
+		if (!IsVkBarrierRedundant(barrier))
+			m_PendingImageBarriers.push_back(barrier);
+	}
+
+	void VulkanCommandList::BarrierTexture(RHITexture* texture, const TextureBarrierRegion* regions, uint32 numRegions)
+	{
+		VkImage image = ((VulkanTexture*)texture)->GetImageHandle();
+		VkImageAspectFlags aspect = ConvertVkImageAspect(texture->GetFormat());
+
+		m_Stats.BarriersRequested += numRegions;
+
+		for (uint32 i = 0; i < numRegions; i++)
+		{
+			const TextureBarrierRegion& region = regions[i];
+
+			VkImageMemoryBarrier2 barrier{ .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2 };
+			barrier.srcStageMask = ConvertVkPipelineStage(region.LastAccess);
+			barrier.srcAccessMask = ConvertVkResourceState(region.LastAccess);
+			barrier.oldLayout = ConvertVkImageLayout(region.LastAccess);
+			barrier.dstStageMask = ConvertVkPipelineStage(region.NewAccess);
+			barrier.dstAccessMask = ConvertVkResourceState(region.NewAccess);
+			barrier.newLayout = ConvertVkImageLayout(region.NewAccess);
+			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.image = image;
+			barrier.subresourceRange.aspectMask = aspect;
+			barrier.subresourceRange.baseMipLevel = region.Range.BaseMip;
+			barrier.subresourceRange.levelCount = region.Range.NumMips;
+			barrier.subresourceRange.baseArrayLayer = region.Range.BaseLayer;
+			barrier.subresourceRange.layerCount = region.Range.NumLayers;
+
+			QueueImageBarrier(barrier);
+		}
+	}
+
+	void VulkanCommandList::BarrierBuffer(RHIBuffer* buffer, uint64 size, uint64 offset, ERHIAccess lastAccess, ERHIAccess newAccess)
+	{
+		m_Stats.BarriersRequested++;
+
+		VkAccessFlags2 srcAccess = ConvertVkResourceState(lastAccess);
+		VkAccessFlags2 dstAccess = ConvertVkResourceState(newAccess);
+		if (!HasVkWriteAccess(srcAccess) && !HasVkWriteAccess(dstAccess))
+			return;
+
+		// buffers have no layout and drivers execute buffer ranges as global memory barriers,
+		// so every buffer barrier of a batch merges into one by its stage and access masks
+		m_PendingMemoryBarrier.srcStageMask |= ConvertVkPipelineStage(lastAccess);
+		m_PendingMemoryBarrier.srcAccessMask |= srcAccess;
+		m_PendingMemoryBarrier.dstStageMask |= ConvertVkPipelineStage(newAccess);
+		m_PendingMemoryBarrier.dstAccessMask |= dstAccess;
+		m_HasPendingMemoryBarrier = true;
+	}
+
+	void VulkanCommandList::FlushBarriers()
+	{
+		if (m_PendingImageBarriers.empty() && !m_HasPendingMemoryBarrier)
+			return;
+
+		VkDependencyInfo depInfo{ .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO };
+		depInfo.imageMemoryBarrierCount = (uint32)m_PendingImageBarriers.size();
+		depInfo.pImageMemoryBarriers = m_PendingImageBarriers.data();
+		depInfo.memoryBarrierCount = m_HasPendingMemoryBarrier ? 1 : 0;
+		depInfo.pMemoryBarriers = &m_PendingMemoryBarrier;
+
+		vkCmdPipelineBarrier2(m_CmdBuffer, &depInfo);
+
+		m_Stats.BarriersEmitted += depInfo.imageMemoryBarrierCount + depInfo.memoryBarrierCount;
+		m_Stats.BarrierBatches++;
+
+		m_PendingImageBarriers.clear();
+		m_PendingMemoryBarrier = { .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2 };
+		m_HasPendingMemoryBarrier = false;
+	}
+
+	void VulkanCommandList::BeginGPUZone(const GPUZoneSource* source)
+	{
+		// barriers queued before the zone are not timed by it, the ones queued inside are
+		FlushBarriers();
+
+		VulkanGPUProfiler& profiler = m_Device.GetGPUProfiler(m_Queue->GetQueueID());
+		m_GPUZoneStack.push_back(profiler.BeginZone(m_CmdBuffer, source, (uint32)m_GPUZoneStack.size()));
+	}
+
+	void VulkanCommandList::EndGPUZone()
+	{
+		CHECK(!m_GPUZoneStack.empty());
+		FlushBarriers();
+
+		VulkanGPUProfiler& profiler = m_Device.GetGPUProfiler(m_Queue->GetQueueID());
+		profiler.EndZone(m_CmdBuffer, m_GPUZoneStack.back());
+		m_GPUZoneStack.pop_back();
+	}
+
+	void VulkanCommandList::BeginPassStatistics(const char* name)
+	{
+		// queries of one type can not be active twice in a command buffer
+		CHECK(!m_InPassStatistics);
+		m_InPassStatistics = true;
+
+		// graphics statistics can not be counted on the other queue families
+		if (m_Queue->GetQueueID() != ERHIQueue::Graphics)
+			return;
+
+		FlushBarriers();
+		m_PassStatistics = m_Device.GetPassStatistics().BeginPass(m_CmdBuffer, name);
+	}
+
+	void VulkanCommandList::EndPassStatistics()
+	{
+		CHECK(m_InPassStatistics);
+		m_InPassStatistics = false;
+
+		FlushBarriers();
+		m_Device.GetPassStatistics().EndPass(m_CmdBuffer, m_PassStatistics);
+		m_PassStatistics = VK_PASS_STATISTICS_INVALID;
+	}
+
+	void VulkanCommandList::CopyTexture(RHITexture* src, const TextureSlice& srcSlice, RHITexture* dst, const TextureSlice& dstSlice)
+	{
+		FlushBarriers();
+
+		// -1 extents copy the rest of the source mip
+		TextureSlice extent = ResolveTextureSlice(src->GetDesc(), srcSlice);
+
+		VkImageCopy2 region{ .sType = VK_STRUCTURE_TYPE_IMAGE_COPY_2 };
+		region.srcSubresource.aspectMask = ConvertVkImageAspect(src->GetFormat());
+		region.srcSubresource.mipLevel = srcSlice.MipLevel;
+		region.srcSubresource.baseArrayLayer = srcSlice.ArraySlice;
+		region.srcSubresource.layerCount = 1;
+		region.srcOffset = { (int32)srcSlice.X, (int32)srcSlice.Y, (int32)srcSlice.Z };
+		region.dstSubresource.aspectMask = ConvertVkImageAspect(dst->GetFormat());
+		region.dstSubresource.mipLevel = dstSlice.MipLevel;
+		region.dstSubresource.baseArrayLayer = dstSlice.ArraySlice;
+		region.dstSubresource.layerCount = 1;
+		region.dstOffset = { (int32)dstSlice.X, (int32)dstSlice.Y, (int32)dstSlice.Z };
+		region.extent = { extent.Width, extent.Height, extent.Depth };
+
+		VkCopyImageInfo2 copyInfo{ .sType = VK_STRUCTURE_TYPE_COPY_IMAGE_INFO_2 };
+		copyInfo.srcImage = ((VulkanTexture*)src)->GetImageHandle();
+		copyInfo.srcImageLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		copyInfo.dstImage = ((VulkanTexture*)dst)->GetImageHandle();
+		copyInfo.dstImageLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		copyInfo.regionCount = 1;
+		copyInfo.pRegions = &region;
+
+		vkCmdCopyImage2(m_CmdBuffer, &copyInfo);
+	}
+
+	void VulkanCommandList::CopyTextureToBuffer(RHITexture* src, const TextureSlice& srcSlice, RHIBuffer* dst, uint64 dstOffset)
+	{
+		FlushBarriers();
+
+		TextureSlice slice = ResolveTextureSlice(src->GetDesc(), srcSlice);
+
+		// zero row length and image height pack the rows tightly
+		VkBufferImageCopy2 region{ .sType = VK_STRUCTURE_TYPE_BUFFER_IMAGE_COPY_2 };
+		region.bufferOffset = dstOffset;
+		region.bufferRowLength = 0;
+		region.bufferImageHeight = 0;
+		region.imageSubresource.aspectMask = ConvertVkImageAspect(src->GetFormat());
+		region.imageSubresource.mipLevel = slice.MipLevel;
+		region.imageSubresource.baseArrayLayer = slice.ArraySlice;
+		region.imageSubresource.layerCount = 1;
+		region.imageOffset = { (int32)slice.X, (int32)slice.Y, (int32)slice.Z };
+		region.imageExtent = { slice.Width, slice.Height, slice.Depth };
+
+		VkCopyImageToBufferInfo2 copyInfo{ .sType = VK_STRUCTURE_TYPE_COPY_IMAGE_TO_BUFFER_INFO_2 };
+		copyInfo.srcImage = ((VulkanTexture*)src)->GetImageHandle();
+		copyInfo.srcImageLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		copyInfo.dstBuffer = ((VulkanBuffer*)dst)->GetBufferHandle();
+		copyInfo.regionCount = 1;
+		copyInfo.pRegions = &region;
+
+		vkCmdCopyImageToBuffer2(m_CmdBuffer, &copyInfo);
+		QueueHostReadBarrier(dst);
+	}
+
+	void VulkanCommandList::CopyBuffer(RHIBuffer* srcBuffer, RHIBuffer* dstBuffer, uint64 srcOffset, uint64 dstOffset, uint64 size)
+	{
+		FlushBarriers();
+
+		VkBufferCopy2 region{ .sType = VK_STRUCTURE_TYPE_BUFFER_COPY_2 };
+		region.srcOffset = srcOffset;
+		region.dstOffset = dstOffset;
+		region.size = size;
+
+		VkCopyBufferInfo2 copyInfo{ .sType = VK_STRUCTURE_TYPE_COPY_BUFFER_INFO_2 };
+		copyInfo.srcBuffer = ((VulkanBuffer*)srcBuffer)->GetBufferHandle();
+		copyInfo.dstBuffer = ((VulkanBuffer*)dstBuffer)->GetBufferHandle();
+		copyInfo.regionCount = 1;
+		copyInfo.pRegions = &region;
+
+		vkCmdCopyBuffer2(m_CmdBuffer, &copyInfo);
+		QueueHostReadBarrier(dstBuffer);
+	}
+
+	void VulkanCommandList::QueueHostReadBarrier(RHIBuffer* dst)
+	{
+		if (!EnumHasAllFlags(dst->GetUsage(), EBufferFlags::ReadBack))
+			return;
+
+		// waiting on the timeline only makes the copy available to the device, the host read needs a barrier.
+		// queued with the others and recorded at the latest by End
+		m_PendingMemoryBarrier.srcStageMask |= VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+		m_PendingMemoryBarrier.srcAccessMask |= VK_ACCESS_2_TRANSFER_WRITE_BIT;
+		m_PendingMemoryBarrier.dstStageMask |= VK_PIPELINE_STAGE_2_HOST_BIT;
+		m_PendingMemoryBarrier.dstAccessMask |= VK_ACCESS_2_HOST_READ_BIT;
+		m_HasPendingMemoryBarrier = true;
+	}
+
 	VulkanQueue::VulkanQueue(ERHIQueue queueID, VkQueue queue, uint32 familyIndex, VulkanDevice& device)
 		: m_QueueID(queueID)
 		, m_Queue(queue)
@@ -377,8 +681,13 @@ namespace Spikey {
 		if (!wait)
 			return;
 
-		m_WaitSemaphores.push_back(wait);
-		m_WaitSemaphoreValues.push_back(value);
+		VkSemaphoreSubmitInfo info{ .sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO };
+		info.semaphore = wait;
+		info.value = value;
+		info.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+
+		std::lock_guard lock(m_Mutex);
+		m_ExternalWaits.push_back(info);
 	}
 
 	void VulkanQueue::AddSignalSemaphore(VkSemaphore signal, uint64 value)
@@ -386,83 +695,179 @@ namespace Spikey {
 		if (!signal)
 			return;
 
-		m_SignalSemaphores.push_back(signal);
-		m_SignalSemaphoreValues.push_back(value);
+		VkSemaphoreSubmitInfo info{ .sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO };
+		info.semaphore = signal;
+		info.value = value;
+		info.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+
+		std::lock_guard lock(m_Mutex);
+		m_ExternalSignals.push_back(info);
 	}
 
-	// TODO: Maybe make thread-safe
-	void VulkanQueue::Submit(const VulkanCommandList** cmds, uint64 numCmd)
+	SyncPoint VulkanQueue::Submit(const VulkanCommandList* const* cmds, uint32 numCmd, std::span<const SyncPoint> waits)
 	{
-		std::vector<VkCommandBuffer> cmdBuffers(numCmd);
-		std::vector<VkPipelineStageFlags> waitStages(m_WaitSemaphores.size());
+		PROFILE_SCOPED;
 
-		for (int32 i = 0; i < m_WaitSemaphores.size(); i++)
+		// a wait on work that never reached the gpu would block this queue forever. flushed before taking our own
+		// lock so two queues waiting on each other can not deadlock
+		for (const SyncPoint& wait : waits)
 		{
-			waitStages[i] = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+			if (!wait.IsValid() || wait.Queue == m_QueueID)
+				continue;
+
+			VulkanQueue& other = m_Device.GetQueue(wait.Queue);
+			if (other.m_LastFlushedID.load(std::memory_order_acquire) < wait.Value)
+				other.Flush();
 		}
-		m_LastSubmitID++;
 
-		for (uint64 i = 0; i < numCmd; i++)
+		std::lock_guard lock(m_Mutex);
+
+		PendingSubmit submit{};
+		submit.FirstCmd = (uint32)m_PendingCmds.size();
+		submit.NumCmds = numCmd;
+		submit.FirstWait = (uint32)m_PendingWaits.size();
+		submit.Value = m_LastSubmitID.load(std::memory_order_relaxed) + 1;
+
+		for (uint32 i = 0; i < numCmd; i++)
 		{
 			VulkanCommandList* list = (VulkanCommandList*)cmds[i];
-			cmdBuffers[i] = list->GetCmdHandle();
+			list->SubmissionID = submit.Value;
+
+			VkCommandBufferSubmitInfo cmdInfo{ .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO };
+			cmdInfo.commandBuffer = list->GetCmdHandle();
+			m_PendingCmds.push_back(cmdInfo);
+
 			m_ListsInFlight.push_back(list);
 		}
 
-		m_SignalSemaphores.push_back(m_TrackingSemaphore);
-		m_SignalSemaphoreValues.push_back(m_LastSubmitID);
+		for (const SyncPoint& wait : waits)
+		{
+			// submissions of one queue already execute in order
+			if (!wait.IsValid() || wait.Value == 0 || wait.Queue == m_QueueID)
+				continue;
+
+			VkSemaphoreSubmitInfo waitInfo{ .sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO };
+			waitInfo.semaphore = m_Device.GetQueue(wait.Queue).m_TrackingSemaphore;
+			waitInfo.value = wait.Value;
+			waitInfo.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+			m_PendingWaits.push_back(waitInfo);
+		}
+		submit.NumWaits = (uint32)m_PendingWaits.size() - submit.FirstWait;
+
+		m_PendingSubmits.push_back(submit);
+		m_LastSubmitID.store(submit.Value, std::memory_order_release);
+
+		return SyncPoint{ m_QueueID, submit.Value };
+	}
+
+	void VulkanQueue::Flush()
+	{
+		std::lock_guard lock(m_Mutex);
+
+		if (m_PendingSubmits.empty())
+		{
+			// a present still has to signal its semaphore
+			if (m_ExternalWaits.empty() && m_ExternalSignals.empty())
+				return;
+
+			PendingSubmit empty{};
+			empty.FirstCmd = (uint32)m_PendingCmds.size();
+			empty.FirstWait = (uint32)m_PendingWaits.size();
+			empty.Value = m_LastSubmitID.load(std::memory_order_relaxed) + 1;
+
+			m_PendingSubmits.push_back(empty);
+			m_LastSubmitID.store(empty.Value, std::memory_order_release);
+		}
+
+		PROFILE_SCOPED;
 
-		VkTimelineSemaphoreSubmitInfo semaphoreInfo{ .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO };
-		semaphoreInfo.signalSemaphoreValueCount = m_SignalSemaphoreValues.size();
-		semaphoreInfo.pSignalSemaphoreValues = m_SignalSemaphoreValues.data();
+		uint32 numSubmits = (uint32)m_PendingSubmits.size();
 
-		if (!m_WaitSemaphoreValues.empty())
+		m_SubmitInfos.resize(numSubmits);
+		m_SignalInfos.resize(numSubmits);
+
+		// external semaphores join the wait list of the first and the signal list of the last submission
+		std::vector<VkSemaphoreSubmitInfo> firstWaits;
+		if (!m_ExternalWaits.empty())
 		{
-			semaphoreInfo.waitSemaphoreValueCount = m_WaitSemaphoreValues.size();
-			semaphoreInfo.pWaitSemaphoreValues = m_WaitSemaphoreValues.data();
+			const PendingSubmit& first = m_PendingSubmits.front();
+			firstWaits.assign(m_PendingWaits.begin() + first.FirstWait, m_PendingWaits.begin() + first.FirstWait + first.NumWaits);
+			firstWaits.insert(firstWaits.end(), m_ExternalWaits.begin(), m_ExternalWaits.end());
 		}
 
-		VkSubmitInfo submitInfo{ .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO };
-		submitInfo.pNext = &semaphoreInfo;
-		submitInfo.commandBufferCount = numCmd;
-		submitInfo.pCommandBuffers = cmdBuffers.data();
-		submitInfo.waitSemaphoreCount = m_WaitSemaphores.size();
-		submitInfo.pWaitSemaphores = m_WaitSemaphores.data();
-		submitInfo.pWaitDstStageMask = waitStages.data();
-		submitInfo.signalSemaphoreCount = m_SignalSemaphores.size();
-		submitInfo.pSignalSemaphores = m_SignalSemaphores.data();
+		std::vector<VkSemaphoreSubmitInfo> lastSignals;
+		if (!m_ExternalSignals.empty())
+		{
+			lastSignals = m_ExternalSignals;
+			lastSignals.push_back({});
+		}
 
-		VK_CHECK(vkQueueSubmit(m_Queue, 1, &submitInfo, nullptr));
+		for (uint32 i = 0; i < numSubmits; i++)
+		{
+			const PendingSubmit& submit = m_PendingSubmits[i];
+
+			VkSemaphoreSubmitInfo& signal = m_SignalInfos[i];
+			signal = { .sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO };
+			signal.semaphore = m_TrackingSemaphore;
+			signal.value = submit.Value;
+			signal.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+
+			VkSubmitInfo2& info = m_SubmitInfos[i];
+			info = { .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2 };
+			info.commandBufferInfoCount = submit.NumCmds;
+			info.pCommandBufferInfos = submit.NumCmds ? &m_PendingCmds[submit.FirstCmd] : nullptr;
+			info.waitSemaphoreInfoCount = submit.NumWaits;
+			info.pWaitSemaphoreInfos = submit.NumWaits ? &m_PendingWaits[submit.FirstWait] : nullptr;
+			info.signalSemaphoreInfoCount = 1;
+			info.pSignalSemaphoreInfos = &signal;
+
+			if (i == 0 && !firstWaits.empty())
+			{
+				info.waitSemaphoreInfoCount = (uint32)firstWaits.size();
+				info.pWaitSemaphoreInfos = firstWaits.data();
+			}
 
-		m_WaitSemaphores.clear();
-		m_WaitSemaphoreValues.clear();
-		m_SignalSemaphores.clear();
-		m_SignalSemaphoreValues.clear();
+			if (i == numSubmits - 1 && !lastSignals.empty())
+			{
+				lastSignals.back() = signal;
 
-		//return m_LastSubmitID;
-	}
+				info.signalSemaphoreInfoCount = (uint32)lastSignals.size();
+				info.pSignalSemaphoreInfos = lastSignals.data();
+			}
+		}
 
-	//void VulkanQueue::WaitCommandList(VulkanCommandList* cmd, uint64 timeout)
-	//{
-    //
-	//}
+		VK_CHECK(vkQueueSubmit2(m_Queue, numSubmits, m_SubmitInfos.data(), VK_NULL_HANDLE));
+
+		m_LastFlushedID.store(m_PendingSubmits.back().Value, std::memory_order_release);
+
+		m_PendingSubmits.clear();
+		m_PendingCmds.clear();
+		m_PendingWaits.clear();
+		m_ExternalWaits.clear();
+		m_ExternalSignals.clear();
+	}
 
 	uint64 VulkanQueue::UpdateLastFinishedID() 
 	{
-		VK_CHECK(vkGetSemaphoreCounterValue(m_Device.GetDeviceHandle(), m_TrackingSemaphore, &m_LastFinishedID));
-		return m_LastFinishedID;
+		uint64 value = 0;
+		VK_CHECK(vkGetSemaphoreCounterValue(m_Device.GetDeviceHandle(), m_TrackingSemaphore, &value));
+
+		m_LastFinishedID.store(value, std::memory_order_release);
+		return value;
 	}
 
 	void VulkanQueue::RetireCommandLists()
 	{
+		std::lock_guard lock(m_Mutex);
+
 		std::vector<TRefCountPtr<VulkanCommandList>> submissions{};
 		std::swap(submissions, m_ListsInFlight);
 
-		UpdateLastFinishedID();
+		uint64 finishedID = UpdateLastFinishedID();
 
 		for (auto& cmd : submissions)
 		{
-			if (cmd->SubmissionID <= m_LastFinishedID)
+			if (cmd->SubmissionID <= finishedID)
 			{
 				cmd->SubmissionID = 0;
 				m_ListsPool.push_back(cmd);
@@ -474,34 +879,50 @@ namespace Spikey {
 		}
 	}
 
-	bool VulkanQueue::PollCommandList(uint64 cmdID)
+	bool VulkanQueue::IsComplete(uint64 value)
 	{
-		if (cmdID > m_LastSubmitID || cmdID == 0)
+		if (value == 0)
+			return true;
+
+		if (value > m_LastSubmitID.load(std::memory_order_acquire))
 			return false;
 
-		bool completed = m_LastFinishedID >= cmdID;
-		if (completed)
+		if (m_LastFinishedID.load(std::memory_order_acquire) >= value)
 			return true;
 
-		completed = UpdateLastFinishedID() >= cmdID;
-		return completed;
+		return UpdateLastFinishedID() >= value;
 	}
 
-	bool VulkanQueue::WaitCommandList(VulkanCommandList* cmd, uint64 timeout)
+	bool VulkanQueue::Wait(uint64 value, uint64 timeout)
 	{
-		if (cmd->SubmissionID > m_LastSubmitID || cmd->SubmissionID == 0)
+		if (value > m_LastSubmitID.load(std::memory_order_acquire))
 			return false;
 
-		if (PollCommandList(cmd->SubmissionID))
+		if (IsComplete(value))
 			return true;
 
+		if (m_LastFlushedID.load(std::memory_order_acquire) < value)
+			Flush();
+
 		VkSemaphoreWaitInfo info{ .sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO };
 		info.pSemaphores = &m_TrackingSemaphore;
-		info.pValues = &cmd->SubmissionID;
+		info.pValues = &value;
 		info.semaphoreCount = 1;
 
 		VkResult result = vkWaitSemaphores(m_Device.GetDeviceHandle(), &info, timeout);
-		return result == VK_SUCCESS;
+		if (result != VK_SUCCESS)
+			return false;
+
+		UpdateLastFinishedID();
+		return true;
+	}
+
+	bool VulkanQueue::WaitCommandList(VulkanCommandList* cmd, uint64 timeout)
+	{
+		if (cmd->SubmissionID == 0)
+			return false;
+
+		return Wait(cmd->SubmissionID, timeout);
 	}
 
 	/*
@@ -683,8 +1104,8 @@ namespace Spikey {
 	}
 	*/
 
-	VulkanBuffer::VulkanBuffer(uint64 size, EBufferFlags flags, VulkanRHIDevice& device)
-		: RHIBuffer(size, flags), m_Device(device), m_MappedData(nullptr)
+	VulkanBuffer::VulkanBuffer(uint64 size, EBufferFlags flags, VulkanDevice& device)
+		: RHIBuffer(size, flags), m_Device(device), m_MappedData(nullptr), m_Address(0)
 	{
 		VkBufferCreateInfo bufferInfo = { .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
 		bufferInfo.pNext = nullptr;
@@ -735,21 +1156,36 @@ namespace Spikey {
 		VK_CHECK(vmaCreateBuffer(m_Device.GetAllocatorHandle(), &bufferInfo, &allocInfo, &m_Buffer,
 			&m_Allocation, nullptr));
 
+		if (EnumHasAllFlags(flags, EBufferFlags::Storage))
+		{
+			m_BindlessIndex = m_Device.GetBindlessHeap().AllocateStorageBuffer(m_Buffer, size);
+		}
+
 		if (EnumHasAnyFlags(flags, EBufferFlags::Upload | EBufferFlags::ReadBack)) 
 		{
 			vmaMapMemory(m_Device.GetAllocatorHandle(), m_Allocation, &m_MappedData);
 		}
+
+		if (EnumHasAllFlags(flags, EBufferFlags::GPUAddress))
+		{
+			VkBufferDeviceAddressInfo addressInfo{ .sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO };
+			addressInfo.buffer = m_Buffer;
+
+			m_Address = vkGetBufferDeviceAddress(m_Device.GetDeviceHandle(), &addressInfo);
+		}
 	}
 
 	VulkanBuffer::~VulkanBuffer() 
 	{
+		m_Device.GetBindlessHeap().Release(EBindlessTable::StorageBuffers, m_BindlessIndex);
+
 		m_Device.DestroyResource({ 
 			.Buffer = m_Buffer, 
 			.Allocation = m_Allocation
 			});
 	}
 
-	VulkanTexture::VulkanTexture(const TextureDesc& desc, VulkanRHIDevice& device) 
+	VulkanTexture::VulkanTexture(const TextureDesc& desc, VulkanDevice& device) 
 		: RHITexture(desc), m_Device(device)
 	{
 		VkImageCreateInfo imgInfo{ .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO };
@@ -769,15 +1205,19 @@ namespace Spikey {
 		case ETextureDimension::Texture1D:
 		case ETextureDimension::Texture1DArray:
 			imgInfo.imageType = VK_IMAGE_TYPE_1D;
+			break;
 		case ETextureDimension::Texture2D:
 		case ETextureDimension::Texture2DArray:
 			imgInfo.imageType = VK_IMAGE_TYPE_2D;
+			break;
 		case ETextureDimension::TextureCube:
 		case ETextureDimension::TextureCubeArray:
 			imgInfo.imageType = VK_IMAGE_TYPE_2D;
 			imgInfo.flags |= VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT;
+			break;
 		case ETextureDimension::Texture3D:
 			imgInfo.imageType = VK_IMAGE_TYPE_3D;
+			break;
 		default:
 			assert(0);
 			break;
@@ -813,27 +1253,52 @@ namespace Spikey {
 		allocInfo.requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
 
 		VK_CHECK(vmaCreateImage(m_Device.GetAllocatorHandle(), &imgInfo, &allocInfo, &m_Image, &m_Allocation, nullptr));
+
+		if (EnumHasAllFlags(desc.Flags, ETextureFlags::Sampled))
+		{
+			// a sampled view may only have one aspect, depth stencil formats are sampled as depth
+			ESubresourceViewType viewType = (ConvertVkImageAspect(desc.Format) & VK_IMAGE_ASPECT_DEPTH_BIT)
+				? ESubresourceViewType::DepthOnly : ESubresourceViewType::AllAspects;
+
+			VkImageView view = GetSubresourceView(TextureSubresourceSet::AllTexture(), ETextureDimension::None,
+				ETextureFormat::None, viewType);
+
+			m_SRVIndex = m_Device.GetBindlessHeap().AllocateSampledImage(view);
+		}
+		if (EnumHasAllFlags(desc.Flags, ETextureFlags::Storage))
+		{
+			// storage views can only see a single mip and cubes are written as arrays
+			TextureSubresourceSet firstMip = TextureSubresourceSet::AllTexture();
+			firstMip.NumMips = 1;
+
+			ETextureDimension dimension = ETextureDimension::None;
+			if (desc.Dimension == ETextureDimension::TextureCube || desc.Dimension == ETextureDimension::TextureCubeArray)
+				dimension = ETextureDimension::Texture2DArray;
+
+			VkImageView view = GetSubresourceView(firstMip, dimension, ETextureFormat::None, ESubresourceViewType::AllAspects);
+			m_UAVIndex = m_Device.GetBindlessHeap().AllocateStorageImage(view);
+		}
 	}
 
 	VulkanTexture::~VulkanTexture() 
 	{
+		m_Device.GetBindlessHeap().Release(EBindlessTable::SampledImages, m_SRVIndex);
+		m_Device.GetBindlessHeap().Release(EBindlessTable::StorageImages, m_UAVIndex);
+
 		m_Device.DestroyResource({ 
 			.Image = m_Image, 
 			.Allocation = m_Allocation 
 			});
 
-		for (auto& [k, v] : m_ViewsMap) 
-		{
-			m_Device.DestroyResource({ .View = v });
-		}
-		m_ViewsMap.clear();
+		m_ViewsMap.ForEach([&](const SubresourceViewKey&, VkImageView view) {
+			m_Device.DestroyResource({ .View = view });
+			});
+		m_ViewsMap.Clear();
 	}
 
 	VkImageView VulkanTexture::GetSubresourceView(const TextureSubresourceSet& subresource, ETextureDimension dimension,
 		ETextureFormat format, ESubresourceViewType viewType)
 	{
-		std::lock_guard lock(m_Mutex);
-
 		if (dimension == ETextureDimension::None)
 			dimension = m_Desc.Dimension;
 
@@ -846,10 +1311,15 @@ namespace Spikey {
 		key.Subresources = subresource;
 		key.ViewType = viewType;
 
-		auto it = m_ViewsMap.find(key);
-		if (it != m_ViewsMap.end()) {
-			return it->second;
-		}
+		return m_ViewsMap.FindOrAdd(key, [&]() { return CreateSubresourceView(key); });
+	}
+
+	VkImageView VulkanTexture::CreateSubresourceView(const SubresourceViewKey& key)
+	{
+		const TextureSubresourceSet& subresource = key.Subresources;
+		ETextureDimension            dimension = key.Dimension;
+		ETextureFormat               format = key.Format;
+		ESubresourceViewType         viewType = key.ViewType;
 
 		VkImageViewCreateInfo viewInfo{ .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO };
 		viewInfo.image = m_Image;
@@ -901,13 +1371,13 @@ namespace Spikey {
 			break;
 		}
 
-		VkImageView& view = m_ViewsMap[key];
+		VkImageView view;
 		VK_CHECK(vkCreateImageView(m_Device.GetDeviceHandle(), &viewInfo, nullptr, &view));
 
 		return view;
 	}
 
-	VulkanSamplerState::VulkanSamplerState(const SamplerStateDesc& desc, VulkanRHIDevice& device) 
+	VulkanSamplerState::VulkanSamplerState(const SamplerStateDesc& desc, VulkanDevice& device) 
 		: RHISamplerState(desc), m_Device(device)
 	{
 		VkSamplerCreateInfo info{ .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO };
@@ -950,103 +1420,991 @@ namespace Spikey {
 		}
 
 		VK_CHECK(vkCreateSampler(m_Device.GetDeviceHandle(), &info, nullptr, &m_Sampler));
+		m_BindlessIndex = m_Device.GetBindlessHeap().AllocateSampler(m_Sampler);
 	}
 
 	VulkanSamplerState::~VulkanSamplerState() 
 	{
-		// FIXME
-		vkDestroySampler(m_Device.GetDeviceHandle(), m_Sampler, nullptr);
+		m_Device.GetBindlessHeap().Release(EBindlessTable::Samplers, m_BindlessIndex);
+
+		m_Device.DestroyResource({ .Sampler = m_Sampler });
 	}
 
-	VulkanShader::VulkanShader(const std::span<uint8>& bytecode, VkShaderStageFlags stage, VulkanRHIDevice& device)
-		: m_Device(device) 
+	static VKAPI_ATTR VkBool32 VKAPI_CALL VulkanDebugCallback(VkDebugUtilsMessageSeverityFlagBitsEXT severity,
+		VkDebugUtilsMessageTypeFlagsEXT types, const VkDebugUtilsMessengerCallbackDataEXT* data, void* userData)
 	{
-		VkShaderModuleCreateInfo info{ .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO };
-		info.codeSize = bytecode.size();
-		info.pCode = (uint32*)bytecode.data();
-
-		VK_CHECK(vkCreateShaderModule(m_Device.GetDeviceHandle(), &info, nullptr, &m_Module));
-
-		// reflection
+		if (severity >= VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT)
+		{
+			ENGINE_ERROR("{}", data->pMessage);
+		}
+		else
 		{
-			SpvReflectShaderModule module;
-			SpvReflectResult result = spvReflectCreateShaderModule(bytecode.size(), bytecode.data(), &module);
-			assert(result == SPV_REFLECT_RESULT_SUCCESS);
+			ENGINE_WARN("{}", data->pMessage);
+		}
 
-			uint32 bindingCount = 0;
-			result = spvReflectEnumerateDescriptorBindings(&module, &bindingCount, nullptr);
-			assert(result == SPV_REFLECT_RESULT_SUCCESS);
+		return VK_FALSE;
+	}
 
-			std::vector<SpvReflectDescriptorBinding*> bindings(bindingCount);
-			result = spvReflectEnumerateDescriptorBindings(&module, &bindingCount, bindings.data());
-			assert(result == SPV_REFLECT_RESULT_SUCCESS);
+	// software rasterizers report a cpu device and only win when nothing else is there
+	constexpr uint32 GetVkDeviceTypeScore(VkPhysicalDeviceType type)
+	{
+		switch (type)
+		{
+		case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:
+			return 4;
+		case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:
+			return 3;
+		case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:
+			return 2;
+		case VK_PHYSICAL_DEVICE_TYPE_CPU:
+			return 1;
+		default:
+			return 0;
+		}
+	}
 
-			uint32 pushCount = 0;
-			result = spvReflectEnumeratePushConstantBlocks(&module, &pushCount, nullptr);
-			assert(result == SPV_REFLECT_RESULT_SUCCESS);
+	static std::vector<VkQueueFamilyProperties> GetVkQueueFamilies(VkPhysicalDevice device)
+	{
+		uint32 numFamilies = 0;
+		vkGetPhysicalDeviceQueueFamilyProperties(device, &numFamilies, nullptr);
 
-			std::vector<SpvReflectBlockVariable*> pushConstants(pushCount);
-			result = spvReflectEnumeratePushConstantBlocks(&module, &pushCount, pushConstants.data());
-			assert(result == SPV_REFLECT_RESULT_SUCCESS);
+		std::vector<VkQueueFamilyProperties> families(numFamilies);
+		vkGetPhysicalDeviceQueueFamilyProperties(device, &numFamilies, families.data());
 
-			for (auto x : pushConstants) {
-				m_PushConstants.stageFlags = stage;
-				m_PushConstants.size = x->size;
-				m_PushConstants.offset = x->offset;
-			}
+		return families;
+	}
 
-			for (auto x : bindings) {
-				auto& b = m_Bindings.emplace_back();
+	// first family with every required and none of the excluded bits, VK_QUEUE_FAMILY_IGNORED when there is none.
+	// with a surface the family also has to present to it
+	static uint32 FindVkQueueFamily(VkPhysicalDevice device, const std::vector<VkQueueFamilyProperties>& families, VkQueueFlags required,
+		VkQueueFlags excluded, VkSurfaceKHR surface = VK_NULL_HANDLE)
+	{
+		for (uint32 i = 0; i < (uint32)families.size(); i++)
+		{
+			if ((families[i].queueFlags & required) != required || (families[i].queueFlags & excluded) != 0)
+				continue;
 
-				b.stageFlags = stage;
-				b.binding = x->binding;
-				b.descriptorCount = x->count;
-				b.descriptorType = (VkDescriptorType)x->descriptor_type;
+			if (surface)
+			{
+				VkBool32 present = VK_FALSE;
+				vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &present);
 
-				if (x->descriptor_type == SPV_REFLECT_DESCRIPTOR_TYPE_SAMPLER
-					&& x->binding >= VK_BINDING_SHIFT_S - VK_IMMUTABLE_SAMPLER_FIRST_SLOT) 
-				{
-					b.pImmutableSamplers = m_Device.GetImmutableSamplers() + (x->binding - VK_BINDING_SHIFT_S - VK_IMMUTABLE_SAMPLER_FIRST_SLOT);
-				}
+				if (!present)
+					continue;
 			}
 
-			spvReflectDestroyShaderModule(&module);
+			return i;
 		}
+
+		return VK_QUEUE_FAMILY_IGNORED;
 	}
 
-	VulkanShader::~VulkanShader() {
-		vkDestroyShaderModule(m_Device.GetDeviceHandle(), m_Module, nullptr);
+	static bool HasVkDeviceExtension(const std::vector<VkExtensionProperties>& extensions, const char* name)
+	{
+		for (const VkExtensionProperties& extension : extensions)
+		{
+			if (strcmp(extension.extensionName, name) == 0)
+				return true;
+		}
+
+		return false;
 	}
 
-	VulkanPipelineState::VulkanPipelineState(const PipelineStateDesc& desc, VulkanRHIDevice& device) 
-		: m_Device(device), m_PushConstants{}
+	// the first feature the backend can not run without that the device lacks, nullptr when it has them all
+	static const char* FindMissingVkFeature(VkPhysicalDevice device)
 	{
-		// based of wicked engine pso creation
+		VkPhysicalDeviceVulkan13Features features13{ .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES };
+		VkPhysicalDeviceVulkan12Features features12{ .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES };
+		features12.pNext = &features13;
+
+		VkPhysicalDeviceFeatures2 features{ .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2 };
+		features.pNext = &features12;
+		vkGetPhysicalDeviceFeatures2(device, &features);
+
+		const std::pair<VkBool32, const char*> required[] = {
+			{ features12.timelineSemaphore, "timelineSemaphore" },
+			{ features12.hostQueryReset, "hostQueryReset" },
+			{ features12.bufferDeviceAddress, "bufferDeviceAddress" },
+			{ features12.runtimeDescriptorArray, "runtimeDescriptorArray" },
+			{ features12.descriptorBindingPartiallyBound, "descriptorBindingPartiallyBound" },
+			{ features12.descriptorBindingUpdateUnusedWhilePending, "descriptorBindingUpdateUnusedWhilePending" },
+			{ features12.descriptorBindingSampledImageUpdateAfterBind, "descriptorBindingSampledImageUpdateAfterBind" },
+			{ features12.descriptorBindingStorageImageUpdateAfterBind, "descriptorBindingStorageImageUpdateAfterBind" },
+			{ features12.descriptorBindingStorageBufferUpdateAfterBind, "descriptorBindingStorageBufferUpdateAfterBind" },
+			{ features13.synchronization2, "synchronization2" },
+			{ features13.dynamicRendering, "dynamicRendering" },
+		};
+
+		for (const auto& [supported, name] : required)
 		{
-			auto insertShader = [&, this](IRHIShader* shader) {
-				if (!shader)
-					return;
+			if (!supported)
+				return name;
+		}
 
-				VulkanShader* vkShader = (VulkanShader*)vkShader;
-				auto& shaderBindings = vkShader->GetBindings();
+		return nullptr;
+	}
 
-				for (auto& x : shaderBindings) 
-				{
-					bool found = false;
+	VulkanDevice::VulkanDevice(IWindow* window, bool validationLayers)
+		: m_DebugMessenger(VK_NULL_HANDLE)
+		, m_Surface(VK_NULL_HANDLE)
+		, m_Queues{}
+	{
+		PROFILE_SCOPED;
 
-					for (auto& y : m_LayoutBindings) 
-					{
-						if (x.binding == y.binding) 
-						{
-							// check for overlapping descriptors
-							assert(x.descriptorCount == y.descriptorCount
-								&& x.descriptorType == y.descriptorType);
+		// instance
 
-							y.stageFlags |= x.stageFlags;
-							found = true;
-							break;
-						}
-					}
+		std::vector<const char*> instanceExtensions{};
+		std::vector<const char*> layers{};
+
+		if (window)
+		{
+#if BUILD_SDL_BACKEND
+			uint32 numExtensions = 0;
+			const char* const* extensions = SDL_Vulkan_GetInstanceExtensions(&numExtensions);
+			instanceExtensions.insert(instanceExtensions.end(), extensions, extensions + numExtensions);
+#endif
+		}
+
+		if (validationLayers)
+		{
+			uint32 numLayers = 0;
+			vkEnumerateInstanceLayerProperties(&numLayers, nullptr);
+
+			std::vector<VkLayerProperties> availableLayers(numLayers);
+			vkEnumerateInstanceLayerProperties(&numLayers, availableLayers.data());
+
+			// build machines often run without the sdk installed
+			validationLayers = std::any_of(availableLayers.begin(), availableLayers.end(), [](const VkLayerProperties& layer) {
+				return strcmp(layer.layerName, "VK_LAYER_KHRONOS_validation") == 0;
+				});
+
+			if (validationLayers)
+			{
+				layers.push_back("VK_LAYER_KHRONOS_validation");
+				instanceExtensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+			}
+			else
+			{
+				ENGINE_WARN("VK_LAYER_KHRONOS_validation is not installed, running without validation");
+			}
+		}
+
+		VkApplicationInfo appInfo{ .sType = VK_STRUCTURE_TYPE_APPLICATION_INFO };
+		appInfo.pApplicationName = window ? window->GetName() : "Spikey";
+		appInfo.pEngineName = "Spikey";
+		appInfo.apiVersion = VK_API_VERSION_1_3;
+
+		VkInstanceCreateInfo instanceInfo{ .sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO };
+		instanceInfo.pApplicationInfo = &appInfo;
+		instanceInfo.enabledExtensionCount = (uint32)instanceExtensions.size();
+		instanceInfo.ppEnabledExtensionNames = instanceExtensions.data();
+		instanceInfo.enabledLayerCount = (uint32)layers.size();
+		instanceInfo.ppEnabledLayerNames = layers.data();
+
+		VK_CHECK(vkCreateInstance(&instanceInfo, nullptr, &m_Instance));
+
+		if (validationLayers)
+		{
+			VkDebugUtilsMessengerCreateInfoEXT messengerInfo{ .sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CREATE_INFO_EXT };
+			messengerInfo.messageSeverity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT;
+			messengerInfo.messageType = VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT
+				| VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT;
+			messengerInfo.pfnUserCallback = VulkanDebugCallback;
+
+			auto createMessenger = (PFN_vkCreateDebugUtilsMessengerEXT)vkGetInstanceProcAddr(m_Instance, "vkCreateDebugUtilsMessengerEXT");
+			VK_CHECK(createMessenger(m_Instance, &messengerInfo, nullptr, &m_DebugMessenger));
+		}
+
+		if (window)
+		{
+#if BUILD_SDL_BACKEND
+			if (!SDL_Vulkan_CreateSurface((SDL_Window*)window->GetNativeWindow(), m_Instance, nullptr, &m_Surface))
+			{
+				ENGINE_ERROR("Failed to create a Vulkan surface: {}", SDL_GetError());
+				abort();
+			}
+#else
+			ENGINE_WARN("no window backend to create a surface with, the device runs headless");
+#endif
+		}
+
+		// physical device
+
+		uint32 numDevices = 0;
+		vkEnumeratePhysicalDevices(m_Instance, &numDevices, nullptr);
+
+		std::vector<VkPhysicalDevice> devices(numDevices);
+		vkEnumeratePhysicalDevices(m_Instance, &numDevices, devices.data());
+
+		m_PhysicalDevice = VK_NULL_HANDLE;
+		uint32 bestScore = 0;
+
+		for (VkPhysicalDevice device : devices)
+		{
+			VkPhysicalDeviceProperties props;
+			vkGetPhysicalDeviceProperties(device, &props);
+
+			uint32 numExtensions = 0;
+			vkEnumerateDeviceExtensionProperties(device, nullptr, &numExtensions, nullptr);
+
+			std::vector<VkExtensionProperties> extensions(numExtensions);
+			vkEnumerateDeviceExtensionProperties(device, nullptr, &numExtensions, extensions.data());
+
+			const char* missing = nullptr;
+			if (props.apiVersion < VK_API_VERSION_1_3)
+				missing = "Vulkan 1.3";
+			else if (m_Surface && !HasVkDeviceExtension(extensions, VK_KHR_SWAPCHAIN_EXTENSION_NAME))
+				missing = VK_KHR_SWAPCHAIN_EXTENSION_NAME;
+			else if (FindVkQueueFamily(device, GetVkQueueFamilies(device), VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT, 0, m_Surface) == VK_QUEUE_FAMILY_IGNORED)
+				missing = m_Surface ? "a graphics queue presenting to the window" : "a graphics queue";
+			else
+				missing = FindMissingVkFeature(device);
+
+			if (missing)
+			{
+				ENGINE_INFO("Skipping {}, it lacks {}", props.deviceName, missing);
+				continue;
+			}
+
+			uint32 score = GetVkDeviceTypeScore(props.deviceType);
+			if (score > bestScore)
+			{
+				bestScore = score;
+				m_PhysicalDevice = device;
+			}
+		}
+
+		if (!m_PhysicalDevice)
+		{
+			ENGINE_ERROR("No Vulkan device can run the renderer");
+			abort();
+		}
+
+		vkGetPhysicalDeviceProperties(m_PhysicalDevice, &m_Properties);
+		m_Limits = m_Properties.limits;
+
+		ENGINE_INFO("Vulkan device: {}{}{}", m_Properties.deviceName,
+			m_Properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_CPU ? " (software)" : "", m_Surface ? "" : ", headless");
+
+		// queues, compute and transfer get their own families when the device has them
+
+		std::vector<VkQueueFamilyProperties> families = GetVkQueueFamilies(m_PhysicalDevice);
+
+		uint32 familyIndices[(size_t)ERHIQueue::Count];
+		familyIndices[(size_t)ERHIQueue::Graphics] = FindVkQueueFamily(m_PhysicalDevice, families, VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT, 0, m_Surface);
+		familyIndices[(size_t)ERHIQueue::Compute] = FindVkQueueFamily(m_PhysicalDevice, families, VK_QUEUE_COMPUTE_BIT, VK_QUEUE_GRAPHICS_BIT);
+		familyIndices[(size_t)ERHIQueue::Transfer] = FindVkQueueFamily(m_PhysicalDevice, families, VK_QUEUE_TRANSFER_BIT,
+			VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT);
+
+		float priority = 1.0f;
+		std::vector<VkDeviceQueueCreateInfo> queueInfos{};
+
+		for (uint32 family : familyIndices)
+		{
+			if (family == VK_QUEUE_FAMILY_IGNORED)
+				continue;
+
+			VkDeviceQueueCreateInfo queueInfo{ .sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO };
+			queueInfo.queueFamilyIndex = family;
+			queueInfo.queueCount = 1;
+			queueInfo.pQueuePriorities = &priority;
+			queueInfos.push_back(queueInfo);
+		}
+
+		// device
+
+		uint32 numExtensions = 0;
+		vkEnumerateDeviceExtensionProperties(m_PhysicalDevice, nullptr, &numExtensions, nullptr);
+
+		std::vector<VkExtensionProperties> availableExtensions(numExtensions);
+		vkEnumerateDeviceExtensionProperties(m_PhysicalDevice, nullptr, &numExtensions, availableExtensions.data());
+
+		std::vector<const char*> deviceExtensions{};
+		if (m_Surface)
+		{
+			deviceExtensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+		}
+		if (HasVkDeviceExtension(availableExtensions, VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME))
+		{
+			deviceExtensions.push_back(VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME);
+		}
+
+		// everything the device supports is enabled, so optional features like pipeline statistics and precise
+		// occlusion turn on where they exist. robust buffer access only costs
+		VkPhysicalDeviceVulkan13Features features13{ .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES };
+		VkPhysicalDeviceVulkan12Features features12{ .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES };
+		features12.pNext = &features13;
+		VkPhysicalDeviceVulkan11Features features11{ .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_1_FEATURES };
+		features11.pNext = &features12;
+
+		VkPhysicalDeviceFeatures2 features{ .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2 };
+		features.pNext = &features11;
+		vkGetPhysicalDeviceFeatures2(m_PhysicalDevice, &features);
+
+		features.features.robustBufferAccess = VK_FALSE;
+		features12.bufferDeviceAddressCaptureReplay = VK_FALSE;
+		features12.bufferDeviceAddressMultiDevice = VK_FALSE;
+
+		VkDeviceCreateInfo deviceInfo{ .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO };
+		deviceInfo.pNext = &features;
+		deviceInfo.queueCreateInfoCount = (uint32)queueInfos.size();
+		deviceInfo.pQueueCreateInfos = queueInfos.data();
+		deviceInfo.enabledExtensionCount = (uint32)deviceExtensions.size();
+		deviceInfo.ppEnabledExtensionNames = deviceExtensions.data();
+
+		VK_CHECK(vkCreateDevice(m_PhysicalDevice, &deviceInfo, nullptr, &m_Device));
+
+		for (uint32 i = 0; i < (uint32)ERHIQueue::Count; i++)
+		{
+			if (familyIndices[i] == VK_QUEUE_FAMILY_IGNORED)
+				continue;
+
+			VkQueue queue;
+			vkGetDeviceQueue(m_Device, familyIndices[i], 0, &queue);
+
+			m_Queues[i] = new VulkanQueue((ERHIQueue)i, queue, familyIndices[i], *this);
+		}
+
+		// software implementations expose a single family, everything runs in order on the graphics queue
+		for (uint32 i = 0; i < (uint32)ERHIQueue::Count; i++)
+		{
+			if (!m_Queues[i])
+				m_Queues[i] = m_Queues[(size_t)ERHIQueue::Graphics];
+		}
+
+		VmaAllocatorCreateInfo allocatorInfo{};
+		allocatorInfo.flags = VMA_ALLOCATOR_CREATE_BUFFER_DEVICE_ADDRESS_BIT;
+		allocatorInfo.vulkanApiVersion = VK_API_VERSION_1_3;
+		allocatorInfo.instance = m_Instance;
+		allocatorInfo.physicalDevice = m_PhysicalDevice;
+		allocatorInfo.device = m_Device;
+
+		VK_CHECK(vmaCreateAllocator(&allocatorInfo, &m_Allocator));
+
+		m_PipelineCache.Init(*this, "Cache/Vulkan");
+		m_BindlessHeap.Init(*this);
+		m_FrameDescriptorAllocator.Init(*this);
+		m_PassStatistics.Init(*this);
+		m_ReadbackRing.Init(*this);
+
+		for (uint32 i = 0; i < (uint32)ERHIQueue::Count; i++)
+		{
+			m_GPUProfilers[i].Init(*this, (ERHIQueue)i);
+		}
+	}
+
+	VulkanDevice::~VulkanDevice()
+	{
+		// async compiles use the pipeline cache, the layouts and the device below
+		for (auto& [desc, cached] : m_PipelineStateCache)
+		{
+			JobSystem::Wait(cached.Compile);
+		}
+
+		vkDeviceWaitIdle(m_Device);
+
+		for (uint32 i = 0; i < (uint32)ERHIQueue::Count; i++)
+		{
+			m_GPUProfilers[i].Shutdown();
+		}
+
+		m_PassStatistics.Shutdown();
+		m_ReadbackRing.Shutdown();
+		m_FrameDescriptorAllocator.Shutdown();
+
+		m_FallbackPipeline = nullptr;
+		m_PipelineStateCache.clear();
+		m_SamplerCache.Clear();
+
+		for (auto& [hash, layout] : m_PSOLayoutCache)
+		{
+			vkDestroyPipelineLayout(m_Device, layout.Layout, nullptr);
+			vkDestroyDescriptorSetLayout(m_Device, layout.SetLayout, nullptr);
+		}
+		m_PSOLayoutCache.clear();
+
+		ReleaseDestroyedResources(true);
+
+		m_BindlessHeap.Shutdown();
+		m_PipelineCache.Shutdown();
+
+		for (uint32 i = 0; i < (uint32)ERHIQueue::Count; i++)
+		{
+			if (m_Queues[i] != m_Queues[(size_t)ERHIQueue::Graphics])
+				delete m_Queues[i];
+		}
+		delete m_Queues[(size_t)ERHIQueue::Graphics];
+
+		vmaDestroyAllocator(m_Allocator);
+		vkDestroyDevice(m_Device, nullptr);
+
+		if (m_Surface)
+		{
+			vkDestroySurfaceKHR(m_Instance, m_Surface, nullptr);
+		}
+		if (m_DebugMessenger)
+		{
+			auto destroyMessenger = (PFN_vkDestroyDebugUtilsMessengerEXT)vkGetInstanceProcAddr(m_Instance, "vkDestroyDebugUtilsMessengerEXT");
+			destroyMessenger(m_Instance, m_DebugMessenger, nullptr);
+		}
+
+		vkDestroyInstance(m_Instance, nullptr);
+	}
+
+	void VulkanDevice::ReadTexture(RHITexture* texture, const TextureSlice& slice, std::vector<uint8>& outData)
+	{
+		PROFILE_SCOPED;
+
+		TextureSlice resolved = ResolveTextureSlice(texture->GetDesc(), slice);
+		uint64 size = TextureSliceSizeInBytes(texture->GetFormat(), resolved);
+
+		BufferRHIRef staging = new VulkanBuffer(size, EBufferFlags::ReadBack, *this);
+
+		VulkanQueue& queue = GetQueue(ERHIQueue::Graphics);
+		TRefCountPtr<VulkanCommandList> cmd = queue.CreateCommandList();
+
+		cmd->Begin();
+		texture->Barrier(cmd.Get(), TextureSubresourceSet{ resolved.MipLevel, 1, resolved.ArraySlice, 1 }, ERHIAccess::CopySrc);
+		cmd->CopyTextureToBuffer(texture, resolved, staging.Get(), 0);
+		cmd->End();
+
+		const VulkanCommandList* cmds[] = { cmd.Get() };
+		SyncPoint done = queue.Submit(cmds, 1);
+		queue.Flush();
+		queue.Wait(done.Value, UINT64_MAX);
+
+		// readback memory is not always coherent
+		VulkanBuffer* buffer = (VulkanBuffer*)staging.Get();
+		VK_CHECK(vmaInvalidateAllocation(m_Allocator, buffer->GetAllocationHandle(), 0, VK_WHOLE_SIZE));
+
+		outData.resize(size);
+		memcpy(outData.data(), buffer->GetMappedData(), size);
+
+		queue.RetireCommandLists();
+	}
+
+	TextureRHIRef VulkanDevice::CreateTexture(const TextureDesc& desc)
+	{
+		return new VulkanTexture(desc, *this);
+	}
+
+	BufferRHIRef VulkanDevice::CreateBuffer(uint64 size, EBufferFlags flags)
+	{
+		return new VulkanBuffer(size, flags, *this);
+	}
+
+	ShaderRHIRef VulkanDevice::CreateVertexShader(const std::span<uint8>& bytecode, const ShaderReflection* reflection)
+	{
+		return new VulkanShader(bytecode, VK_SHADER_STAGE_VERTEX_BIT, *this, reflection);
+	}
+
+	ShaderRHIRef VulkanDevice::CreatePixelShader(const std::span<uint8>& bytecode, const ShaderReflection* reflection)
+	{
+		return new VulkanShader(bytecode, VK_SHADER_STAGE_FRAGMENT_BIT, *this, reflection);
+	}
+
+	ShaderRHIRef VulkanDevice::CreateComputeShader(const std::span<uint8>& bytecode, const ShaderReflection* reflection)
+	{
+		return new VulkanShader(bytecode, VK_SHADER_STAGE_COMPUTE_BIT, *this, reflection);
+	}
+
+	RHICommandList* VulkanDevice::BeginCommandList()
+	{
+		TRefCountPtr<VulkanCommandList> cmd = GetQueue(ERHIQueue::Graphics).CreateCommandList();
+		cmd->Begin();
+
+		// released by SubmitCommandList, the queue keeps it in flight from there
+		cmd->AddRef();
+		return cmd.Get();
+	}
+
+	void VulkanDevice::SubmitCommandList(RHICommandList* cmd)
+	{
+		VulkanCommandList* list = (VulkanCommandList*)cmd;
+		list->End();
+
+		const VulkanCommandList* cmds[] = { list };
+		GetQueue(ERHIQueue::Graphics).Submit(cmds, 1);
+
+		list->Release();
+	}
+
+	void VulkanDevice::WaitCommandList(RHICommandList* cmd)
+	{
+		VulkanQueue& queue = GetQueue(ERHIQueue::Graphics);
+
+		// the submission waits for the next flush otherwise
+		queue.Flush();
+		queue.WaitCommandList((VulkanCommandList*)cmd, UINT64_MAX);
+	}
+
+	void VulkanDevice::DestroyResource(const ResourceDestroyer& destroyer)
+	{
+		static thread_local uint32 shardIndex = (uint32)(std::hash<std::thread::id>{}(std::this_thread::get_id()) % VK_DESTRUCTION_SHARDS);
+		DestructionShard& shard = m_DestructionShards[shardIndex];
+
+		std::lock_guard lock(shard.Lock);
+
+		uint64 submitIDs[(size_t)ERHIQueue::Count];
+		for (uint32 q = 0; q < (uint32)ERHIQueue::Count; q++)
+		{
+			submitIDs[q] = GetQueue((ERHIQueue)q).GetLastSubmitID();
+		}
+
+		// nothing was submitted since the last release of this shard, it retires with the same batch
+		if (shard.Batches.empty() || memcmp(shard.Batches.back().SubmitIDs, submitIDs, sizeof(submitIDs)) != 0)
+		{
+			DestructionBatch& batch = shard.Batches.emplace_back();
+			memcpy(batch.SubmitIDs, submitIDs, sizeof(submitIDs));
+		}
+
+		shard.Batches.back().Destroyers.push_back(destroyer);
+	}
+
+	uint32 VulkanDevice::GetNumPendingDestructions() const
+	{
+		uint32 count = 0;
+
+		for (const DestructionShard& shard : m_DestructionShards)
+		{
+			std::lock_guard lock(shard.Lock);
+
+			for (const DestructionBatch& batch : shard.Batches)
+			{
+				count += (uint32)batch.Destroyers.size();
+			}
+		}
+
+		return count;
+	}
+
+	void VulkanDevice::ReleaseDestroyedResources(bool all)
+	{
+		PROFILE_SCOPED;
+
+		uint64 finishedIDs[(size_t)ERHIQueue::Count];
+		for (uint32 q = 0; q < (uint32)ERHIQueue::Count; q++)
+		{
+			finishedIDs[q] = all ? UINT64_MAX : GetQueue((ERHIQueue)q).UpdateLastFinishedID();
+		}
+
+		std::vector<ResourceDestroyer> retired{};
+
+		for (DestructionShard& shard : m_DestructionShards)
+		{
+			std::lock_guard lock(shard.Lock);
+
+			while (!shard.Batches.empty())
+			{
+				DestructionBatch& batch = shard.Batches.front();
+
+				bool finished = true;
+				for (uint32 q = 0; q < (uint32)ERHIQueue::Count; q++)
+				{
+					finished &= batch.SubmitIDs[q] <= finishedIDs[q];
+				}
+
+				if (!finished)
+					break;
+
+				retired.insert(retired.end(), batch.Destroyers.begin(), batch.Destroyers.end());
+				shard.Batches.pop_front();
+			}
+		}
+
+		// destroyed outside the shard locks, threads releasing resources meanwhile do not wait on the driver
+		for (const ResourceDestroyer& destroyer : retired)
+		{
+			if (destroyer.View)
+				vkDestroyImageView(m_Device, destroyer.View, nullptr);
+			if (destroyer.Sampler)
+				vkDestroySampler(m_Device, destroyer.Sampler, nullptr);
+
+			if (destroyer.Image)
+				vmaDestroyImage(m_Allocator, destroyer.Image, destroyer.Allocation);
+			else if (destroyer.Buffer)
+				vmaDestroyBuffer(m_Allocator, destroyer.Buffer, destroyer.Allocation);
+		}
+	}
+
+	std::future<std::vector<uint8>> VulkanDevice::ReadTextureAsync(RHICommandList* cmd, RHITexture* texture, const TextureSlice& slice)
+	{
+		return m_ReadbackRing.ReadTexture(cmd, texture, slice);
+	}
+
+	std::future<std::vector<uint8>> VulkanDevice::ReadBufferAsync(RHICommandList* cmd, RHIBuffer* buffer, uint64 offset, uint64 size,
+		ERHIAccess access)
+	{
+		return m_ReadbackRing.ReadBuffer(cmd, buffer, offset, size, access);
+	}
+
+	void VulkanDevice::BeginFrame()
+	{
+		PROFILE_SCOPED;
+
+		for (uint32 i = 0; i < (uint32)ERHIQueue::Count; i++)
+		{
+			// shared queues are retired once
+			if (i == (uint32)ERHIQueue::Graphics || m_Queues[i] != m_Queues[(size_t)ERHIQueue::Graphics])
+				m_Queues[i]->RetireCommandLists();
+		}
+
+		ReleaseDestroyedResources();
+		m_BindlessHeap.RecycleReleased();
+
+		m_FrameDescriptorAllocator.BeginFrame();
+		m_PassStatistics.BeginFrame();
+		m_ReadbackRing.BeginFrame();
+
+		for (uint32 i = 0; i < (uint32)ERHIQueue::Count; i++)
+		{
+			m_GPUProfilers[i].BeginFrame();
+		}
+	}
+
+	void VulkanDevice::EndFrame()
+	{
+		PROFILE_SCOPED;
+
+		m_FrameDescriptorAllocator.EndFrame();
+		m_PassStatistics.EndFrame();
+		m_ReadbackRing.EndFrame();
+
+		for (uint32 i = 0; i < (uint32)ERHIQueue::Count; i++)
+		{
+			m_GPUProfilers[i].EndFrame();
+		}
+
+		// the stamped values only retire once their work reached the gpu
+		for (uint32 i = 0; i < (uint32)ERHIQueue::Count; i++)
+		{
+			if (i == (uint32)ERHIQueue::Graphics || m_Queues[i] != m_Queues[(size_t)ERHIQueue::Graphics])
+				m_Queues[i]->Flush();
+		}
+	}
+
+	SamplerStateRHIRef VulkanDevice::CreateSamplerState(const SamplerStateDesc& desc)
+	{
+		return m_SamplerCache.FindOrAdd(desc, [&]() { return SamplerStateRHIRef(new VulkanSamplerState(desc, *this)); });
+	}
+
+	PipelineStateRHIRef VulkanDevice::CreatePipelineState(const PipelineStateDesc& desc)
+	{
+		PipelineStateRHIRef hit;
+		JobSystem::Counter* hitCompile = nullptr;
+		{
+			std::shared_lock lock(m_PipelineStateCacheLock);
+
+			auto it = m_PipelineStateCache.find(desc);
+			if (it != m_PipelineStateCache.end()) 
+			{
+				m_PipelineStateCacheHits.fetch_add(1, std::memory_order_relaxed);
+				hit = it->second.Pipeline;
+				hitCompile = &it->second.Compile;
+			}
+		}
+
+		if (hit) 
+		{
+			// requested async before, the synchronous caller expects it ready but does not wait on other compiles
+			if (!hit->IsReady())
+				JobSystem::Wait(*hitCompile);
+
+			return hit;
+		}
+
+		// compiled outside the lock, two threads racing on the same desc both compile and the first insert wins
+		PipelineStateRHIRef pipeline = new VulkanPipelineState(desc, *this);
+
+		std::unique_lock lock(m_PipelineStateCacheLock);
+
+		auto [it, inserted] = m_PipelineStateCache.try_emplace(desc);
+		if (inserted) 
+		{
+			m_PipelineStateCacheMisses.fetch_add(1, std::memory_order_relaxed);
+
+			it->second.Pipeline = pipeline;
+			it->second.Shaders[0] = desc.VertexShader;
+			it->second.Shaders[1] = desc.PixelShader;
+			it->second.Shaders[2] = desc.ComputeShader;
+		}
+		else if (!it->second.Pipeline->IsReady()) 
+		{
+			// an async request for the same desc is still compiling, ours is ready now
+			return pipeline;
+		}
+		else 
+		{
+			m_PipelineStateCacheHits.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		return it->second.Pipeline;
+	}
+
+	PipelineStateRHIRef VulkanDevice::CreatePipelineStateAsync(const PipelineStateDesc& desc)
+	{
+		{
+			std::shared_lock lock(m_PipelineStateCacheLock);
+
+			auto it = m_PipelineStateCache.find(desc);
+			if (it != m_PipelineStateCache.end()) 
+			{
+				m_PipelineStateCacheHits.fetch_add(1, std::memory_order_relaxed);
+				return it->second.Pipeline;
+			}
+		}
+
+		// only the layout is built here, inserting before compiling lets later requests share the pending pipeline
+		TRefCountPtr<VulkanPipelineState> pipeline = new VulkanPipelineState(desc, *this, VK_NULL_HANDLE, true);
+		JobSystem::Counter* compile = nullptr;
+		{
+			std::unique_lock lock(m_PipelineStateCacheLock);
+
+			auto [it, inserted] = m_PipelineStateCache.try_emplace(desc);
+			if (!inserted) 
+			{
+				m_PipelineStateCacheHits.fetch_add(1, std::memory_order_relaxed);
+				return it->second.Pipeline;
+			}
+
+			m_PipelineStateCacheMisses.fetch_add(1, std::memory_order_relaxed);
+
+			it->second.Pipeline = pipeline.Get();
+			it->second.Shaders[0] = desc.VertexShader;
+			it->second.Shaders[1] = desc.PixelShader;
+			it->second.Shaders[2] = desc.ComputeShader;
+			compile = &it->second.Compile;
+		}
+
+		auto start = std::chrono::steady_clock::now();
+
+		m_PendingAsyncPipelines.fetch_add(1, std::memory_order_relaxed);
+		JobSystem::Execute(*compile, [this, pipeline, start]() {
+			PROFILE_SCOPED_NAMED("CompilePipelineAsync");
+
+			pipeline->Compile();
+			m_PendingAsyncPipelines.fetch_sub(1, std::memory_order_relaxed);
+
+			uint64 us = (uint64)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+			m_AsyncPipelineCompiles.fetch_add(1, std::memory_order_relaxed);
+			m_AsyncPipelineTimeUs.fetch_add(us, std::memory_order_relaxed);
+
+			uint64 maxUs = m_AsyncPipelineMaxTimeUs.load(std::memory_order_relaxed);
+			while (us > maxUs && !m_AsyncPipelineMaxTimeUs.compare_exchange_weak(maxUs, us, std::memory_order_relaxed)) {}
+			});
+
+		return pipeline.Get();
+	}
+
+	void VulkanDevice::SetFallbackPipelineState(RHIPipelineState* pipeline)
+	{
+		CHECK(!pipeline || pipeline->IsReady());
+		m_FallbackPipeline = pipeline;
+	}
+
+	RHIPipelineState* VulkanDevice::ResolvePipelineState(RHIPipelineState* pipeline)
+	{
+		if (pipeline->IsReady())
+			return pipeline;
+
+		if (m_FallbackPipeline) 
+		{
+			m_FallbackDraws.fetch_add(1, std::memory_order_relaxed);
+			return m_FallbackPipeline;
+		}
+
+		m_SkippedDraws.fetch_add(1, std::memory_order_relaxed);
+		return nullptr;
+	}
+
+	PipelineStateCacheStats VulkanDevice::GetPipelineStateCacheStats() const
+	{
+		PipelineStateCacheStats stats{};
+		stats.Hits = m_PipelineStateCacheHits.load(std::memory_order_relaxed);
+		stats.Misses = m_PipelineStateCacheMisses.load(std::memory_order_relaxed);
+
+		stats.PendingCompiles = m_PendingAsyncPipelines.load(std::memory_order_relaxed);
+		stats.AsyncCompiles = m_AsyncPipelineCompiles.load(std::memory_order_relaxed);
+		stats.AvgCompileMs = stats.AsyncCompiles > 0 ? (float)m_AsyncPipelineTimeUs.load(std::memory_order_relaxed) / (float)stats.AsyncCompiles / 1000.f : 0.f;
+		stats.MaxCompileMs = (float)m_AsyncPipelineMaxTimeUs.load(std::memory_order_relaxed) / 1000.f;
+		stats.FallbackDraws = m_FallbackDraws.load(std::memory_order_relaxed);
+		stats.SkippedDraws = m_SkippedDraws.load(std::memory_order_relaxed);
+
+		std::shared_lock lock(m_PipelineStateCacheLock);
+		stats.NumPipelines = (uint32)m_PipelineStateCache.size();
+
+		return stats;
+	}
+
+	GPUFrameTimings VulkanDevice::GetGPUFrameTimings(ERHIQueue queue) const
+	{
+		return m_GPUProfilers[(size_t)queue].GetLastFrame();
+	}
+
+	GPUPassStatisticsFrame VulkanDevice::GetGPUPassStatistics() const
+	{
+		return m_PassStatistics.GetLastFrame();
+	}
+
+	VulkanPSOLayout VulkanDevice::CreateCachedPSOLayout(const VulkanPSOLayoutHash& hash)
+	{
+		std::lock_guard lock(m_PSOLayoutCacheLock);
+
+		auto it = m_PSOLayoutCache.find(hash);
+		if (it != m_PSOLayoutCache.end())
+			return it->second;
+
+		VulkanPSOLayout layout{};
+
+		VkDescriptorSetLayoutCreateInfo setLayoutInfo{ .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO };
+		setLayoutInfo.bindingCount = (uint32)hash.Bindings.size();
+		setLayoutInfo.pBindings = hash.Bindings.data();
+
+		VK_CHECK(vkCreateDescriptorSetLayout(m_Device, &setLayoutInfo, nullptr, &layout.SetLayout));
+
+		// reflected bindings in set 0, the bindless tables in VK_BINDLESS_SET
+		VkDescriptorSetLayout setLayouts[2] = { layout.SetLayout, m_BindlessHeap.GetSetLayout() };
+
+		VkPipelineLayoutCreateInfo layoutInfo{ .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
+		layoutInfo.setLayoutCount = 2;
+		layoutInfo.pSetLayouts = setLayouts;
+		layoutInfo.pushConstantRangeCount = hash.PushConstants.size > 0 ? 1 : 0;
+		layoutInfo.pPushConstantRanges = &hash.PushConstants;
+
+		VK_CHECK(vkCreatePipelineLayout(m_Device, &layoutInfo, nullptr, &layout.Layout));
+
+		m_PSOLayoutCache[hash] = layout;
+		return layout;
+	}
+
+	bool ReflectSpirv(const std::span<const uint8>& bytecode, ShaderReflection& outReflection)
+	{
+		PROFILE_SCOPED;
+
+		SpvReflectShaderModule module;
+		if (spvReflectCreateShaderModule(bytecode.size(), bytecode.data(), &module) != SPV_REFLECT_RESULT_SUCCESS)
+			return false;
+
+		uint32 bindingCount = 0;
+		SpvReflectResult result = spvReflectEnumerateDescriptorBindings(&module, &bindingCount, nullptr);
+		assert(result == SPV_REFLECT_RESULT_SUCCESS);
+
+		std::vector<SpvReflectDescriptorBinding*> bindings(bindingCount);
+		result = spvReflectEnumerateDescriptorBindings(&module, &bindingCount, bindings.data());
+		assert(result == SPV_REFLECT_RESULT_SUCCESS);
+
+		uint32 pushCount = 0;
+		result = spvReflectEnumeratePushConstantBlocks(&module, &pushCount, nullptr);
+		assert(result == SPV_REFLECT_RESULT_SUCCESS);
+
+		std::vector<SpvReflectBlockVariable*> pushConstants(pushCount);
+		result = spvReflectEnumeratePushConstantBlocks(&module, &pushCount, pushConstants.data());
+		assert(result == SPV_REFLECT_RESULT_SUCCESS);
+
+		outReflection = {};
+
+		for (auto x : pushConstants) {
+			outReflection.PushConstantOffset = x->offset;
+			outReflection.PushConstantSize = x->size;
+		}
+
+		for (auto x : bindings) {
+			auto& b = outReflection.Bindings.emplace_back();
+
+			b.Set = x->set;
+			b.Binding = x->binding;
+			b.Count = x->count;
+			b.DescriptorType = (uint32)x->descriptor_type;
+		}
+
+		spvReflectDestroyShaderModule(&module);
+		return true;
+	}
+
+	VulkanShader::VulkanShader(const std::span<uint8>& bytecode, VkShaderStageFlags stage, VulkanDevice& device, const ShaderReflection* reflection)
+		: m_Device(device), m_PushConstants{}
+	{
+		VkShaderModuleCreateInfo info{ .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO };
+		info.codeSize = bytecode.size();
+		info.pCode = (uint32*)bytecode.data();
+
+		VK_CHECK(vkCreateShaderModule(m_Device.GetDeviceHandle(), &info, nullptr, &m_Module));
+
+		// cooked shaders carry their reflection, only loose bytecode is parsed here
+		ShaderReflection runtimeReflection{};
+		if (!reflection) 
+		{
+			bool reflected = ReflectSpirv(bytecode, runtimeReflection);
+			assert(reflected);
+
+			reflection = &runtimeReflection;
+		}
+
+		// the manifest names shaders by their bytecode so the next run can rebuild the pipelines using them
+		m_BytecodeHash = HashShaderBytecode(bytecode);
+		m_Device.GetPipelineCache().RecordShader(m_BytecodeHash, stage, bytecode, *reflection);
+
+		if (reflection->PushConstantSize > 0) 
+		{
+			m_PushConstants.stageFlags = stage;
+			m_PushConstants.size = reflection->PushConstantSize;
+			m_PushConstants.offset = reflection->PushConstantOffset;
+		}
+
+		for (const ShaderReflection::Binding& x : reflection->Bindings) 
+		{
+			// declared by shaders indexing the global tables, bound once from the bindless heap
+			if (x.Set == VK_BINDLESS_SET)
+				continue;
+
+			auto& b = m_Bindings.emplace_back();
+
+			b.stageFlags = stage;
+			b.binding = x.Binding;
+			b.descriptorCount = x.Count;
+			b.descriptorType = (VkDescriptorType)x.DescriptorType;
+
+			if (b.descriptorType == VK_DESCRIPTOR_TYPE_SAMPLER
+				&& x.Binding >= VK_BINDING_SHIFT_S + VK_IMMUTABLE_SAMPLER_FIRST_SLOT) 
+			{
+				b.pImmutableSamplers = m_Device.GetImmutableSamplers() + (x.Binding - VK_BINDING_SHIFT_S - VK_IMMUTABLE_SAMPLER_FIRST_SLOT);
+			}
+		}
+	}
+
+	VulkanShader::~VulkanShader() {
+		vkDestroyShaderModule(m_Device.GetDeviceHandle(), m_Module, nullptr);
+	}
+
+	VulkanPipelineState::VulkanPipelineState(const PipelineStateDesc& desc, VulkanDevice& device, VkPipelineCache cache, bool deferCompile) 
+		: m_Device(device), m_Desc(desc), m_PushConstants{}
+	{
+		// based of wicked engine pso creation
+		{
+			auto insertShader = [&, this](IRHIShader* shader) {
+				if (!shader)
+					return;
+
+				VulkanShader* vkShader = (VulkanShader*)shader;
+				auto& shaderBindings = vkShader->GetBindings();
+
+				for (auto& x : shaderBindings) 
+				{
+					bool found = false;
+
+					for (auto& y : m_LayoutBindings) 
+					{
+						if (x.binding == y.binding) 
+						{
+							// check for overlapping descriptors
+							assert(x.descriptorCount == y.descriptorCount
+								&& x.descriptorType == y.descriptorType);
+
+							y.stageFlags |= x.stageFlags;
+							found = true;
+							break;
+						}
+					}
 
 					if (!found) 
 					{
@@ -1067,13 +2425,6 @@ namespace Spikey {
 			insertShader(desc.VertexShader);
 			insertShader(desc.PixelShader);
 		}
-		{
-			VkDescriptorSetLayoutCreateInfo setLayoutInfo{ .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO };
-			setLayoutInfo.bindingCount = (uint32)m_LayoutBindings.size();
-			setLayoutInfo.pBindings = m_LayoutBindings.data();
-
-			VK_CHECK(vkCreateDescriptorSetLayout(m_Device.GetDeviceHandle(), &setLayoutInfo, nullptr, &m_SetLayout));
-		}
 		{
 			VulkanPSOLayoutHash layoutHash{};
 			for (auto& x : m_LayoutBindings) 
@@ -1089,6 +2440,29 @@ namespace Spikey {
 			m_SetLayout = cachedLayout.SetLayout;
 		}
 
+		if (deferCompile) 
+		{
+			m_Ready.store(false, std::memory_order_relaxed);
+			return;
+		}
+
+		Compile(cache);
+	}
+
+	void VulkanPipelineState::Compile(VkPipelineCache cache)
+	{
+		PROFILE_SCOPED;
+
+		const PipelineStateDesc& desc = m_Desc;
+
+		// pipelines created on the device cache must not race a merge of the precompile caches into it
+		std::shared_lock<std::shared_mutex> cacheLock;
+		if (cache == VK_NULL_HANDLE) 
+		{
+			cacheLock = m_Device.GetPipelineCache().LockForCreate();
+			cache = m_Device.GetPipelineCacheHandle();
+		}
+
 		if (desc.ComputeShader) 
 		{
 
@@ -1101,8 +2475,7 @@ namespace Spikey {
 			info.stage = stageInfo;
 			info.layout = m_Layout;
 
-			VK_CHECK(vkCreateComputePipelines(m_Device.GetDeviceHandle(), m_Device.GetPipelineCacheHandle(),
-				1, &info, nullptr, &m_Pipeline));
+			VK_CHECK(vkCreateComputePipelines(m_Device.GetDeviceHandle(), cache, 1, &info, nullptr, &m_Pipeline));
 		}
 		else 
 		{
@@ -1241,11 +2614,16 @@ namespace Spikey {
 
 			pipelineInfo.pDynamicState = &dynamicInfo;
 
-			VK_CHECK(vkCreateGraphicsPipelines(m_Device.GetDeviceHandle(), m_Device.GetPipelineCacheHandle(), 1, &pipelineInfo, nullptr, &m_Pipeline));
+			VK_CHECK(vkCreateGraphicsPipelines(m_Device.GetDeviceHandle(), cache, 1, &pipelineInfo, nullptr, &m_Pipeline));
 		}
+
+		m_Device.GetPipelineCache().RecordPipeline(desc);
+		m_Ready.store(true, std::memory_order_release);
 	}
 
 	VulkanPipelineState::~VulkanPipelineState() 
 	{
+		// layouts are owned by the device cache
+		vkDestroyPipeline(m_Device.GetDeviceHandle(), m_Pipeline, nullptr);
 	}
 }
\ No newline at end of file
@@ -1,13 +1,26 @@
 #pragma once
 
 #include <Backend/Vulkan/VulkanCommon.h>
+#include <Backend/Vulkan/VulkanPipelineCache.h>
+#include <Backend/Vulkan/VulkanBindlessHeap.h>
+#include <Backend/Vulkan/VulkanDescriptorAllocator.h>
+#include <Backend/Vulkan/VulkanGPUProfiler.h>
+#include <Backend/Vulkan/VulkanPassStatistics.h>
+#include <Backend/Vulkan/VulkanReadback.h>
 #include <Engine/Graphics/GraphicsCore.h>
+#include <Engine/Core/Window.h>
+#include <Engine/Utils/ConcurrentCache.h>
 
 namespace Spikey {
 
 	class VulkanCommandList;
 	class VulkanDevice;
 
+	// resources released by threads hashing to different shards never share a lock. shards are picked by the
+	// releasing thread and not by retire value: every thread releasing during a frame stamps the same value,
+	// so keying shards by it would put them all back on one lock. the retire value keys the batches of a shard
+	constexpr uint32 VK_DESTRUCTION_SHARDS = 16;
+
 	class VulkanQueue
 	{
 	public:
@@ -18,19 +31,27 @@ namespace Spikey {
 
 		TRefCountPtr<VulkanCommandList> CreateCommandList();
 
+		// external semaphores (swapchain acquire and present) waited by the first and signaled by the last
+		// submission of the next flush
 		void AddWaitSemaphore(VkSemaphore wait, uint64 value);
 		void AddSignalSemaphore(VkSemaphore signal, uint64 value);
 
-		void Submit(const VulkanCommandList** cmds, uint64 numCmd);
+		// queues the lists to run after the sync points, which may be of any queue. returns the value the
+		// tracking timeline reaches when they finished. thread safe, the work reaches the gpu with the next Flush
+		SyncPoint Submit(const VulkanCommandList* const* cmds, uint32 numCmd, std::span<const SyncPoint> waits = {});
+
+		// every submission queued since the last flush in one vkQueueSubmit2
+		void Flush();
+
+		bool IsComplete(uint64 value);
+		bool Wait(uint64 value, uint64 timeout);
 		bool WaitCommandList(VulkanCommandList* cmd, uint64 timeout);
 		void RetireCommandLists();
 
 		ERHIQueue GetQueueID() const { return m_QueueID; }
 		uint32    GetFamilyIndex() const { return m_FamilyIndex; }
-
-	private:
-		uint64 UpdateLastFinishedID();
-		bool   PollCommandList(uint64 cmdID);
+		uint64    GetLastSubmitID() const { return m_LastSubmitID.load(std::memory_order_acquire); }
+		uint64    UpdateLastFinishedID();
 
 	private:
 		VulkanDevice& m_Device;
@@ -38,44 +59,137 @@ namespace Spikey {
 		ERHIQueue     m_QueueID;
 		uint32        m_FamilyIndex;
 
-		std::vector<VkSemaphore> m_WaitSemaphores;
-		std::vector<uint64>      m_WaitSemaphoreValues;
-		std::vector<VkSemaphore> m_SignalSemaphores;
-		std::vector<uint64>      m_SignalSemaphoreValues;
+		struct PendingSubmit
+		{
+			uint32 FirstCmd;
+			uint32 NumCmds;
+			uint32 FirstWait;
+			uint32 NumWaits;
+			uint64 Value;
+		};
 
-		uint64 m_LastSubmitID = 0;
-		uint64 m_LastFinishedID = 0;
+		// guarded by m_Mutex, flattened so a flush is a single allocation free submit
+		std::vector<PendingSubmit>             m_PendingSubmits;
+		std::vector<VkCommandBufferSubmitInfo> m_PendingCmds;
+		std::vector<VkSemaphoreSubmitInfo>     m_PendingWaits;
+		std::vector<VkSemaphoreSubmitInfo>     m_ExternalWaits;
+		std::vector<VkSemaphoreSubmitInfo>     m_ExternalSignals;
+		std::vector<VkSubmitInfo2>             m_SubmitInfos;
+		std::vector<VkSemaphoreSubmitInfo>     m_SignalInfos;
+
+		std::atomic<uint64> m_LastSubmitID{ 0 };  // handed out by Submit
+		std::atomic<uint64> m_LastFlushedID{ 0 }; // reached the gpu
+		std::atomic<uint64> m_LastFinishedID{ 0 };
 
 		std::mutex                                   m_Mutex;
 		std::vector<TRefCountPtr<VulkanCommandList>> m_ListsInFlight;
 		std::vector<TRefCountPtr<VulkanCommandList>> m_ListsPool;
 	};
 
-	class VulkanDevice : public RHIDevice {
+	class VulkanDevice : public IRHIDevice {
 	public:
-		VulkanRHIDevice(IWindow* window, bool validationLayers = true);
-		virtual ~VulkanRHIDevice() override;
+		// without a window the device is headless: no surface or swapchain, frames are rendered to offscreen
+		// textures and read back with ReadTexture. software implementations like lavapipe are picked only when
+		// no gpu is present. queues the device has no family for share the graphics queue
+		VulkanDevice(IWindow* window, bool validationLayers = true);
+		virtual ~VulkanDevice() override;
+
+		bool IsHeadless() const { return m_Surface == VK_NULL_HANDLE; }
 
 		VkInstance       GetInstanceHandle() const { return m_Instance; }
+		VkPhysicalDevice GetPhysicalDeviceHandle() const { return m_PhysicalDevice; }
 		VkDevice         GetDeviceHandle() const { return m_Device; }
 		VmaAllocator     GetAllocatorHandle() const { return m_Allocator; }
 		VulkanQueue&     GetQueue(ERHIQueue queue) const { return *m_Queues[(size_t)queue]; }
+		VkSurfaceKHR     GetSurfaceHandle() const { return m_Surface; }
 		VulkanPSOLayout  CreateCachedPSOLayout(const VulkanPSOLayoutHash& hash);
-		VkPipelineCache  GetPipelineCacheHandle() const { return m_PipelineStateCache; }
+		VkPipelineCache  GetPipelineCacheHandle() const { return m_PipelineCache.GetHandle(); }
+		VulkanPipelineCache& GetPipelineCache() { return m_PipelineCache; }
+		VulkanBindlessHeap&  GetBindlessHeap() { return m_BindlessHeap; }
+
+		// descriptor sets valid until the end of the current frame
+		VulkanDescriptorAllocator& GetFrameDescriptorAllocator() { return m_FrameDescriptorAllocator; }
 
 		const VkSampler* GetImmutableSamplers() const { return m_ImmutableSamplers.data(); }
 		const VkPhysicalDeviceLimits& GetLimits() const { return m_Limits; }
 		const VkPhysicalDeviceProperties& GetProperties() const { return m_Properties; }
 
+		virtual PipelineStateRHIRef CreatePipelineState(const PipelineStateDesc& desc) override;
+		virtual PipelineStateCacheStats GetPipelineStateCacheStats() const override;
+		virtual PipelineStateRHIRef CreatePipelineStateAsync(const PipelineStateDesc& desc) override;
+		virtual void SetFallbackPipelineState(RHIPipelineState* pipeline) override;
+		virtual RHIPipelineState* ResolvePipelineState(RHIPipelineState* pipeline) override;
+		virtual void   PrecompilePipelines() override { m_PipelineCache.Precompile(); }
+		virtual uint32 GetNumPendingPipelinePrecompiles() const override { return m_PipelineCache.GetNumPendingPrecompiles(); }
+		virtual GPUFrameTimings GetGPUFrameTimings(ERHIQueue queue) const override;
+		virtual GPUPassStatisticsFrame GetGPUPassStatistics() const override;
+		virtual void ReadTexture(RHITexture* texture, const TextureSlice& slice, std::vector<uint8>& outData) override;
+		virtual std::future<std::vector<uint8>> ReadTextureAsync(RHICommandList* cmd, RHITexture* texture, const TextureSlice& slice) override;
+		virtual std::future<std::vector<uint8>> ReadBufferAsync(RHICommandList* cmd, RHIBuffer* buffer, uint64 offset, uint64 size,
+			ERHIAccess access) override;
+
+		// frame boundary of the per frame subsystems. BeginFrame recycles what the queues finished, EndFrame
+		// stamps the frame with the values the queues signal after its last submit and flushes them
+		void BeginFrame();
+		void EndFrame();
+
+		// identical descriptors return the same sampler, lookups do not lock
+		virtual SamplerStateRHIRef CreateSamplerState(const SamplerStateDesc& desc) override;
+
+		VulkanGPUProfiler&    GetGPUProfiler(ERHIQueue queue) { return m_GPUProfilers[(size_t)queue]; }
+		VulkanPassStatistics& GetPassStatistics() { return m_PassStatistics; }
+
+		// any thread, the resource is not synchronized with recording that uses it
+		virtual TextureRHIRef CreateTexture(const TextureDesc& desc) override;
+		virtual BufferRHIRef CreateBuffer(uint64 size, EBufferFlags flags) override;
+
+		virtual ShaderRHIRef CreateVertexShader(const std::span<uint8>& bytecode, const ShaderReflection* reflection = nullptr) override;
+		virtual ShaderRHIRef CreatePixelShader(const std::span<uint8>& bytecode, const ShaderReflection* reflection = nullptr) override;
+		virtual ShaderRHIRef CreateComputeShader(const std::span<uint8>& bytecode, const ShaderReflection* reflection = nullptr) override;
+
+		// lists of the graphics queue, the device holds a list from begin until it is submitted
+		virtual RHICommandList* BeginCommandList() override;
+		virtual void SubmitCommandList(RHICommandList* cmd) override;
+		virtual void WaitCommandList(RHICommandList* cmd) override;
+
+		// entry points of the old command buffer api, everything records through command lists now
+		virtual void RunGarbageCollection() override {}
+		virtual void CopyDataToTexture(void* src, uint64 srcOffset, IRHITexture* dst, EGPUAccess lastAccess, EGPUAccess newAccess,
+			const std::vector<SubResourceCopyRegion>& regions, uint64 copySize) override {}
+		virtual TextureCubeRHIRef CreateTextureCube(uint32 size, uint32 numMips, ETextureFormat format, ETextureUsage usage) override { return nullptr; }
+		virtual TextureViewRHIRef CreateTextureView(uint32 baseMip, uint32 numMips, uint32 baseLayer, uint32 numLayers, IRHITexture* tex) override { return nullptr; }
+		virtual RHIData CreateSamplerRHI(const SamplerDesc& desc) override { return {}; }
+		virtual void DestroySamplerRHI(RHIData data) override {}
+		virtual RHIData CreateCommandBufferRHI() override { return {}; }
+		virtual void DestroyCommandBufferRHI(RHIData data) override {}
+		virtual void BeginFrameCommandBuffer(RHICommandBuffer* cmd) override {}
+		virtual void WaitForFrameCommandBuffer(RHICommandBuffer* cmd) override {}
+		virtual void ImmediateSubmit(std::function<void(RHICommandBuffer*)>&& func) override {}
+		virtual void WaitGPUIdle() override {}
+		virtual void BeginRendering(RHICommandBuffer* cmd, const RenderInfo& info) override {}
+		virtual void EndRendering(RHICommandBuffer* cmd) override {}
+		virtual void DrawIndirectCount(RHICommandBuffer* cmd, RHIBuffer* commBuffer, uint64 offset, RHIBuffer* countBuffer,
+			uint64 countBufferOffset, uint32 maxDrawCount, uint32 commStride) override {}
+		virtual void Draw(RHICommandBuffer* cmd, uint32 vertexCount, uint32 instanceCount, uint32 firstVertex, uint32 firstInstance) override {}
+		virtual void DrawSwapchain(RHICommandBuffer* cmd, uint32 width, uint32 height, ImGuiRTState* guiState = nullptr, RHITexture2D* fillTexture = nullptr) override {}
+
 		struct ResourceDestroyer {
 			VkImage        Image = nullptr;
 			VkImageView    View = nullptr;
 			VkBuffer       Buffer = nullptr;
+			VkSampler      Sampler = nullptr;
 			VmaAllocation  Allocation = nullptr;
 		};
 
+		// any thread. the handles are destroyed once every queue finished the work submitted before the call
 		void DestroyResource(const ResourceDestroyer& destroyer);
 
+		// destroys what the queues are done with, everything when all is set and the device is idle
+		void ReleaseDestroyedResources(bool all = false);
+
+		// released resources still waiting on the queues
+		uint32 GetNumPendingDestructions() const;
+
 	private:
 		VkInstance m_Instance;
 		VkDebugUtilsMessengerEXT m_DebugMessenger;
@@ -85,17 +199,56 @@ namespace Spikey {
 		VkDevice m_Device;
 		VkSurfaceKHR m_Surface;
 		VmaAllocator m_Allocator;
-		VulkanQueue* m_Queues[(size_t)ERHIQueue::COUNT];
+		VulkanQueue* m_Queues[(size_t)ERHIQueue::Count];
+
+		// loaded after device creation and written back before the device goes away
+		VulkanPipelineCache m_PipelineCache;
+		VulkanBindlessHeap  m_BindlessHeap;
+		VulkanDescriptorAllocator m_FrameDescriptorAllocator;
+		VulkanGPUProfiler         m_GPUProfilers[(size_t)ERHIQueue::Count];
+		VulkanPassStatistics      m_PassStatistics;
+		VulkanReadbackRing        m_ReadbackRing;
+
+		// resources released while the queues stood at the same submit ids, retired together
+		struct DestructionBatch {
+			uint64                         SubmitIDs[(size_t)ERHIQueue::Count];
+			std::vector<ResourceDestroyer> Destroyers;
+		};
+
+		// stamped under the shard lock, so the submit ids of a shard only grow. own cache lines, so threads
+		// releasing at once do not share one
+		struct alignas(64) DestructionShard {
+			mutable std::mutex           Lock;
+			std::deque<DestructionBatch> Batches;
+		};
 
-		VkPipelineCache m_PipelineStateCache;
+		DestructionShard m_DestructionShards[VK_DESTRUCTION_SHARDS];
 
-		std::mutex m_DestructionMutex;
-		std::deque<std::pair<ResourceDestroyer, uint64>> m_DestructionQueue;
+		// pipelines are created from worker threads while precompiling
+		std::mutex m_PSOLayoutCacheLock;
+		std::unordered_map<VulkanPSOLayoutHash, VulkanPSOLayout> m_PSOLayoutCache;
 
-		std::unordered_map<VulkanPSOLayoutHash, VkPipelineLayout> m_PSOLayoutCache;
+		struct CachedPipelineState {
+			PipelineStateRHIRef Pipeline;
+			ShaderRHIRef        Shaders[3]; // keeps the shader addresses the key compares from being reused
+			JobSystem::Counter  Compile;    // the async compile of this entry alone, entries are never erased while the device lives
+		};
 
-		std::mutex m_SamplerCacheLock;
-		std::unordered_map<SamplerStateDesc, SamplerStateRHIRef> m_SamplerCache;
+		// looked up by every material instance, created rarely
+		mutable std::shared_mutex m_PipelineStateCacheLock;
+		std::unordered_map<PipelineStateDesc, CachedPipelineState> m_PipelineStateCache;
+		std::atomic<uint64> m_PipelineStateCacheHits{ 0 };
+		std::atomic<uint64> m_PipelineStateCacheMisses{ 0 };
+
+		std::atomic<uint32> m_PendingAsyncPipelines{ 0 };
+		PipelineStateRHIRef m_FallbackPipeline;
+		std::atomic<uint64> m_AsyncPipelineCompiles{ 0 };
+		std::atomic<uint64> m_AsyncPipelineTimeUs{ 0 };
+		std::atomic<uint64> m_AsyncPipelineMaxTimeUs{ 0 };
+		std::atomic<uint64> m_FallbackDraws{ 0 };
+		std::atomic<uint64> m_SkippedDraws{ 0 };
+
+		ConcurrentCache<SamplerStateDesc, SamplerStateRHIRef> m_SamplerCache;
 		std::vector<VkSampler> m_ImmutableSamplers;
 	};
 
@@ -108,38 +261,68 @@ namespace Spikey {
 		virtual ~VulkanCommandList() override;
 
 		virtual void CopyTexture(RHITexture* src, const TextureSlice& srcSlice, RHITexture* dst, const TextureSlice& dstSlice) override;
+		virtual void CopyTextureToBuffer(RHITexture* src, const TextureSlice& srcSlice, RHIBuffer* dst, uint64 dstOffset) override;
+		virtual void CopyBuffer(RHIBuffer* srcBuffer, RHIBuffer* dstBuffer, uint64 srcOffset, uint64 dstOffset, uint64 size) override;
 		virtual void FlushBarriers() override;
+		virtual void BarrierTexture(RHITexture* texture, const TextureBarrierRegion* regions, uint32 numRegions) override;
+		virtual void BarrierBuffer(RHIBuffer* buffer, uint64 size, uint64 offset, ERHIAccess lastAccess, ERHIAccess newAccess) override;
+		virtual void BeginGPUZone(const GPUZoneSource* source) override;
+		virtual void EndGPUZone() override;
+		virtual void BeginPassStatistics(const char* name) override;
+		virtual void EndPassStatistics() override;
+
+		// recording starts over, the list must not be in flight
+		void Begin();
+		void End();
 
 		VkCommandBuffer GetCmdHandle() const { return m_CmdBuffer; }
 		virtual void*   GetNative() const override { return (void*)m_CmdBuffer; }
 
+	private:
+		void QueueImageBarrier(const VkImageMemoryBarrier2& barrier);
+		void QueueHostReadBarrier(RHIBuffer* dst);
+
 	private:
 		VulkanDevice&   m_Device;
+		VulkanQueue*    m_Queue;
 		VkCommandPool   m_Pool;
 		VkCommandBuffer m_CmdBuffer;
+
+		// profiler handles of the zones still open, innermost last
+		std::vector<uint64> m_GPUZoneStack;
+		uint64              m_PassStatistics = VK_PASS_STATISTICS_INVALID;
+		bool                m_InPassStatistics = false;
+
+		// queued until the next FlushBarriers, buffer barriers fold into the single memory barrier
+		std::vector<VkImageMemoryBarrier2> m_PendingImageBarriers;
+		VkMemoryBarrier2                   m_PendingMemoryBarrier;
+		bool                               m_HasPendingMemoryBarrier;
 	};
 
 	class VulkanBuffer : public RHIBuffer 
 	{
 	public:
-		VulkanBuffer(uint64 size, EBufferFlags flags, VulkanRHIDevice& device);
+		VulkanBuffer(uint64 size, EBufferFlags flags, VulkanDevice& device);
 		virtual ~VulkanBuffer() override;
 
-		virtual void* GetMappedData() const override { return m_MappedData; }
-		virtual void* GetNative() const override { return (void*)m_Buffer; }
-		VkBuffer      GetBufferHandle() const { return m_Buffer; }
+		virtual void*  GetMappedData() const override { return m_MappedData; }
+		virtual uint64 GetGPUAddress() const override { return m_Address; }
+		virtual void*  GetNative() const override { return (void*)m_Buffer; }
+		VkBuffer       GetBufferHandle() const { return m_Buffer; }
+		VmaAllocation  GetAllocationHandle() const { return m_Allocation; }
 
 	private:
-		VulkanRHIDevice& m_Device;
+		VulkanDevice& m_Device;
 		VkBuffer         m_Buffer;
 		VmaAllocation    m_Allocation;
 		void*            m_MappedData;
+		VkDeviceAddress  m_Address;
 	};
 
 	class VulkanTexture : public RHITexture 
 	{
 	public:
-		VulkanTexture(const TextureDesc& desc, VulkanRHIDevice& device);
+		VulkanTexture(const TextureDesc& desc, VulkanDevice& device);
 		virtual ~VulkanTexture() override;
 
 		enum class ESubresourceViewType : uint8
@@ -155,33 +338,38 @@ namespace Spikey {
 			ETextureDimension     Dimension;
 			ETextureFormat        Format;
 			ESubresourceViewType  ViewType;
+
+			bool operator==(const SubresourceViewKey& other) const = default;
 		};
 
+		// created on first use, later lookups do not lock so recording threads can share the texture
 		VkImageView GetSubresourceView(const TextureSubresourceSet& subresource, ETextureDimension dimension,
 			ETextureFormat format, ESubresourceViewType viewType);
 		VkImage       GetImageHandle() const { return m_Image; }
 		virtual void* GetNative() const override { return (void*)m_Image; }
 
 	private:
-		VulkanRHIDevice& m_Device;
+		VkImageView CreateSubresourceView(const SubresourceViewKey& key);
+
+	private:
+		VulkanDevice& m_Device;
 		VkImage          m_Image;
 		VmaAllocation    m_Allocation;
 
-		std::mutex       m_Mutex;
-		std::unordered_map<SubresourceViewKey, VkImageView> m_ViewsMap;
+		ConcurrentCache<SubresourceViewKey, VkImageView> m_ViewsMap;
 	};
 
 	class VulkanSamplerState : public RHISamplerState 
 	{
 	public:
-		VulkanSamplerState(const SamplerStateDesc& desc, VulkanRHIDevice& device);
+		VulkanSamplerState(const SamplerStateDesc& desc, VulkanDevice& device);
 		virtual ~VulkanSamplerState() override;
 
 		VkSampler     GetSamplerHandle() const { return m_Sampler; }
 		virtual void* GetNative() const override { return (void*)m_Sampler; }
 
 	private:
-		VulkanRHIDevice& m_Device;
+		VulkanDevice& m_Device;
 		VkSampler        m_Sampler;
 	};
 
@@ -195,9 +383,13 @@ namespace Spikey {
 	class VulkanPipelineState : public RHIPipelineState 
 	{
 	public:
-		VulkanPipelineState(const PipelineStateDesc& desc, VulkanRHIDevice& device);
+		// cache defaults to the device pipeline cache. deferred pipelines only build their layout and stay
+		// not ready until Compile is called
+		VulkanPipelineState(const PipelineStateDesc& desc, VulkanDevice& device, VkPipelineCache cache = VK_NULL_HANDLE, bool deferCompile = false);
 		virtual ~VulkanPipelineState() override;
 
+		void Compile(VkPipelineCache cache = VK_NULL_HANDLE);
+
 		VkPipelineLayout      GetLayoutHandle() const { return m_Layout; }
 		VkPipeline            GetPipelineHandle() const { return m_Pipeline; }
 		VkDescriptorSetLayout GetSetLayoutHandle() const { return m_SetLayout; }
@@ -209,29 +401,36 @@ namespace Spikey {
 		}
 
 	private:
-		VulkanRHIDevice&                          m_Device;
+		VulkanDevice&                          m_Device;
+		PipelineStateDesc                         m_Desc;
 		VkPipelineLayout                          m_Layout;
-		VkPipeline                                m_Pipeline;
+		VkPipeline                                m_Pipeline = VK_NULL_HANDLE;
 		VkDescriptorSetLayout                     m_SetLayout;
 		VkPushConstantRange                       m_PushConstants;
 		std::vector<VkDescriptorSetLayoutBinding> m_LayoutBindings;
 	};
 
+	// what shader cooking stores in the SCSF file, false for invalid bytecode
+	bool ReflectSpirv(const std::span<const uint8>& bytecode, ShaderReflection& outReflection);
+
 	class VulkanShader : public IRHIShader {
 	public:
-		VulkanShader(const std::span<uint8>& bytecode, VkShaderStageFlags stage, VulkanRHIDevice& device);
+		// reflects the bytecode when no cooked reflection is passed
+		VulkanShader(const std::span<uint8>& bytecode, VkShaderStageFlags stage, VulkanDevice& device, const ShaderReflection* reflection = nullptr);
 		virtual ~VulkanShader() override;
 
 		VkPushConstantRange GetPushConstants() const { return m_PushConstants; }
 		VkShaderModule      GetShaderHandle() const { return m_Module; }
+		uint64              GetBytecodeHash() const { return m_BytecodeHash; }
 		virtual void*       GetNative() const override { return (void*)m_Module; }
 
 		using BindingsArray = std::vector<VkDescriptorSetLayoutBinding>;
 		const BindingsArray& GetBindings() const { return m_Bindings; }
 
 	private:
-		VulkanRHIDevice&    m_Device;
+		VulkanDevice&    m_Device;
 		VkShaderModule      m_Module;
+		uint64              m_BytecodeHash;
 		
 		VkPushConstantRange m_PushConstants;
 		BindingsArray       m_Bindings;
@@ -293,6 +492,24 @@ namespace Spikey {
 }
 
 namespace std {
+	template<>
+	struct hash<Spikey::VulkanTexture::SubresourceViewKey> {
+		size_t operator()(const Spikey::VulkanTexture::SubresourceViewKey& key) const {
+			using namespace Spikey;
+
+			uint64 hash = 0;
+			Math::HashCombine(hash, key.Subresources.BaseMip);
+			Math::HashCombine(hash, key.Subresources.NumMips);
+			Math::HashCombine(hash, key.Subresources.BaseLayer);
+			Math::HashCombine(hash, key.Subresources.NumLayers);
+			Math::HashCombine(hash, key.Dimension);
+			Math::HashCombine(hash, key.Format);
+			Math::HashCombine(hash, key.ViewType);
+
+			return hash;
+		}
+	};
+
 	template<>
 	struct hash<Spikey::VulkanPSOLayoutHash> {
 		constexpr size_t operator()(const Spikey::VulkanPSOLayoutHash& hash) const {
@@ -0,0 +1,229 @@
+#include <Backend/Vulkan/VulkanBindlessHeap.h>
+#include <Backend/Vulkan/VulkanBackend.h>
+
+namespace Spikey {
+
+	void VulkanBindlessHeap::Init(VulkanDevice& device)
+	{
+		m_Device = &device;
+
+		VkPhysicalDeviceDescriptorIndexingProperties indexingProps{ .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES };
+		VkPhysicalDeviceProperties2 props{ .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2 };
+		props.pNext = &indexingProps;
+		vkGetPhysicalDeviceProperties2(m_Device->GetPhysicalDeviceHandle(), &props);
+
+		Table& sampledImages = m_Tables[(size_t)EBindlessTable::SampledImages];
+		sampledImages.Type = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+		sampledImages.Capacity = std::min(VK_BINDLESS_MAX_SAMPLED_IMAGES, indexingProps.maxDescriptorSetUpdateAfterBindSampledImages);
+
+		Table& storageImages = m_Tables[(size_t)EBindlessTable::StorageImages];
+		storageImages.Type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+		storageImages.Capacity = std::min(VK_BINDLESS_MAX_STORAGE_IMAGES, indexingProps.maxDescriptorSetUpdateAfterBindStorageImages);
+
+		Table& storageBuffers = m_Tables[(size_t)EBindlessTable::StorageBuffers];
+		storageBuffers.Type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		storageBuffers.Capacity = std::min(VK_BINDLESS_MAX_STORAGE_BUFFERS, indexingProps.maxDescriptorSetUpdateAfterBindStorageBuffers);
+
+		Table& samplers = m_Tables[(size_t)EBindlessTable::Samplers];
+		samplers.Type = VK_DESCRIPTOR_TYPE_SAMPLER;
+		samplers.Capacity = std::min(VK_BINDLESS_MAX_SAMPLERS, indexingProps.maxDescriptorSetUpdateAfterBindSamplers);
+
+		VkDescriptorSetLayoutBinding bindings[(size_t)EBindlessTable::Count] = {};
+		VkDescriptorBindingFlags     bindingFlags[(size_t)EBindlessTable::Count] = {};
+		VkDescriptorPoolSize         poolSizes[(size_t)EBindlessTable::Count] = {};
+
+		for (uint32 i = 0; i < (uint32)EBindlessTable::Count; i++)
+		{
+			bindings[i].binding = i;
+			bindings[i].descriptorType = m_Tables[i].Type;
+			bindings[i].descriptorCount = m_Tables[i].Capacity;
+			bindings[i].stageFlags = VK_SHADER_STAGE_ALL;
+
+			// unused slots are never accessed and slots are rewritten while earlier frames are in flight
+			bindingFlags[i] = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT
+				| VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT
+				| VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+
+			poolSizes[i].type = m_Tables[i].Type;
+			poolSizes[i].descriptorCount = m_Tables[i].Capacity;
+
+			m_Tables[i].NumAllocated = 0;
+		}
+
+		VkDescriptorSetLayoutBindingFlagsCreateInfo flagsInfo{ .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO };
+		flagsInfo.bindingCount = (uint32)EBindlessTable::Count;
+		flagsInfo.pBindingFlags = bindingFlags;
+
+		VkDescriptorSetLayoutCreateInfo layoutInfo{ .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO };
+		layoutInfo.pNext = &flagsInfo;
+		layoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+		layoutInfo.bindingCount = (uint32)EBindlessTable::Count;
+		layoutInfo.pBindings = bindings;
+
+		VkDevice vkDevice = m_Device->GetDeviceHandle();
+		VK_CHECK(vkCreateDescriptorSetLayout(vkDevice, &layoutInfo, nullptr, &m_SetLayout));
+
+		VkDescriptorPoolCreateInfo poolInfo{ .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO };
+		poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+		poolInfo.maxSets = 1;
+		poolInfo.poolSizeCount = (uint32)EBindlessTable::Count;
+		poolInfo.pPoolSizes = poolSizes;
+
+		VK_CHECK(vkCreateDescriptorPool(vkDevice, &poolInfo, nullptr, &m_Pool));
+
+		VkDescriptorSetAllocateInfo allocInfo{ .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
+		allocInfo.descriptorPool = m_Pool;
+		allocInfo.descriptorSetCount = 1;
+		allocInfo.pSetLayouts = &m_SetLayout;
+
+		VK_CHECK(vkAllocateDescriptorSets(vkDevice, &allocInfo, &m_Set));
+
+		ENGINE_INFO("Bindless heap: {} sampled images, {} storage images, {} storage buffers, {} samplers",
+			sampledImages.Capacity, storageImages.Capacity, storageBuffers.Capacity, samplers.Capacity);
+	}
+
+	void VulkanBindlessHeap::Shutdown()
+	{
+		if (!m_Device)
+			return;
+
+		// frees the set with it
+		vkDestroyDescriptorPool(m_Device->GetDeviceHandle(), m_Pool, nullptr);
+		vkDestroyDescriptorSetLayout(m_Device->GetDeviceHandle(), m_SetLayout, nullptr);
+
+		m_Pool = VK_NULL_HANDLE;
+		m_SetLayout = VK_NULL_HANDLE;
+		m_Set = VK_NULL_HANDLE;
+		m_Device = nullptr;
+	}
+
+	uint32 VulkanBindlessHeap::Allocate(EBindlessTable table, VkWriteDescriptorSet& write)
+	{
+		std::lock_guard lock(m_Lock);
+
+		Table& t = m_Tables[(size_t)table];
+		if (t.NumAllocated == t.Capacity)
+		{
+			ENGINE_ERROR("Bindless table {} is full ({} descriptors)", (uint32)table, t.Capacity);
+			return BINDLESS_INVALID_INDEX;
+		}
+
+		uint32 index = t.FreeIndices.Grab();
+		t.NumAllocated++;
+
+		write.dstSet = m_Set;
+		write.dstBinding = (uint32)table;
+		write.dstArrayElement = index;
+		write.descriptorCount = 1;
+		write.descriptorType = t.Type;
+
+		vkUpdateDescriptorSets(m_Device->GetDeviceHandle(), 1, &write, 0, nullptr);
+		return index;
+	}
+
+	uint32 VulkanBindlessHeap::AllocateSampledImage(VkImageView view)
+	{
+		VkDescriptorImageInfo imageInfo{};
+		imageInfo.imageView = view;
+		imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+		VkWriteDescriptorSet write{ .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+		write.pImageInfo = &imageInfo;
+
+		return Allocate(EBindlessTable::SampledImages, write);
+	}
+
+	uint32 VulkanBindlessHeap::AllocateStorageImage(VkImageView view)
+	{
+		VkDescriptorImageInfo imageInfo{};
+		imageInfo.imageView = view;
+		imageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+		VkWriteDescriptorSet write{ .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+		write.pImageInfo = &imageInfo;
+
+		return Allocate(EBindlessTable::StorageImages, write);
+	}
+
+	uint32 VulkanBindlessHeap::AllocateStorageBuffer(VkBuffer buffer, uint64 size)
+	{
+		VkDescriptorBufferInfo bufferInfo{};
+		bufferInfo.buffer = buffer;
+		bufferInfo.offset = 0;
+		bufferInfo.range = size;
+
+		VkWriteDescriptorSet write{ .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+		write.pBufferInfo = &bufferInfo;
+
+		return Allocate(EBindlessTable::StorageBuffers, write);
+	}
+
+	uint32 VulkanBindlessHeap::AllocateSampler(VkSampler sampler)
+	{
+		VkDescriptorImageInfo imageInfo{};
+		imageInfo.sampler = sampler;
+
+		VkWriteDescriptorSet write{ .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+		write.pImageInfo = &imageInfo;
+
+		return Allocate(EBindlessTable::Samplers, write);
+	}
+
+	void VulkanBindlessHeap::Release(EBindlessTable table, uint32 index)
+	{
+		if (index == BINDLESS_INVALID_INDEX)
+			return;
+
+		// any submitted work may still index the slot, it is free once all of it finished
+		ReleasedIndex released{};
+		released.Index = index;
+
+		for (uint32 q = 0; q < (uint32)ERHIQueue::Count; q++)
+		{
+			released.SubmitIDs[q] = m_Device->GetQueue((ERHIQueue)q).GetLastSubmitID();
+		}
+
+		std::lock_guard lock(m_Lock);
+		m_Tables[(size_t)table].Released.push_back(released);
+	}
+
+	void VulkanBindlessHeap::RecycleReleased()
+	{
+		PROFILE_SCOPED;
+
+		uint64 finishedIDs[(size_t)ERHIQueue::Count];
+		for (uint32 q = 0; q < (uint32)ERHIQueue::Count; q++)
+		{
+			finishedIDs[q] = m_Device->GetQueue((ERHIQueue)q).UpdateLastFinishedID();
+		}
+
+		std::lock_guard lock(m_Lock);
+
+		for (Table& t : m_Tables)
+		{
+			while (!t.Released.empty())
+			{
+				const ReleasedIndex& released = t.Released.front();
+
+				bool finished = true;
+				for (uint32 q = 0; q < (uint32)ERHIQueue::Count; q++)
+				{
+					finished &= released.SubmitIDs[q] <= finishedIDs[q];
+				}
+
+				if (!finished)
+					break;
+
+				t.FreeIndices.Release(released.Index);
+				t.NumAllocated--;
+				t.Released.pop_front();
+			}
+		}
+	}
+
+	uint32 VulkanBindlessHeap::GetNumAllocated(EBindlessTable table)
+	{
+		std::lock_guard lock(m_Lock);
+		return m_Tables[(size_t)table].NumAllocated;
+	}
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <Backend/Vulkan/VulkanCommon.h>
+#include <Engine/Graphics/GraphicsCore.h>
+#include <Engine/Utils/Misc.h>
+
+namespace Spikey {
+
+	class VulkanDevice;
+
+	// set the global tables are bound to, reflected shader bindings stay in set 0
+	constexpr uint32 VK_BINDLESS_SET = 1;
+
+	// requested table sizes, clamped to the update after bind limits of the device
+	constexpr uint32 VK_BINDLESS_MAX_SAMPLED_IMAGES = 1 << 18;
+	constexpr uint32 VK_BINDLESS_MAX_STORAGE_IMAGES = 1 << 16;
+	constexpr uint32 VK_BINDLESS_MAX_STORAGE_BUFFERS = 1 << 18;
+	constexpr uint32 VK_BINDLESS_MAX_SAMPLERS = 1 << 11;
+
+	// binding of each table in VK_BINDLESS_SET
+	enum class EBindlessTable : uint8
+	{
+		SampledImages,
+		StorageImages,
+		StorageBuffers,
+		Samplers,
+
+		Count
+	};
+
+	// one descriptor set of partially bound, update after bind arrays shared by every pipeline. resources
+	// get a stable index when created and shaders index the tables with it, so nothing is rebound per draw.
+	// released indices are reused only once every queue finished the work submitted before the release
+	class VulkanBindlessHeap
+	{
+	public:
+		void Init(VulkanDevice& device);
+		void Shutdown();
+
+		VkDescriptorSetLayout GetSetLayout() const { return m_SetLayout; }
+		VkDescriptorSet       GetSet() const { return m_Set; }
+
+		// write the descriptor and return its index, BINDLESS_INVALID_INDEX when the table is full
+		uint32 AllocateSampledImage(VkImageView view);
+		uint32 AllocateStorageImage(VkImageView view);
+		uint32 AllocateStorageBuffer(VkBuffer buffer, uint64 size);
+		uint32 AllocateSampler(VkSampler sampler);
+
+		void Release(EBindlessTable table, uint32 index);
+
+		// moves released indices the gpu is done with back to the free lists
+		void RecycleReleased();
+
+		uint32 GetNumAllocated(EBindlessTable table);
+		uint32 GetCapacity(EBindlessTable table) const { return m_Tables[(size_t)table].Capacity; }
+
+	private:
+		uint32 Allocate(EBindlessTable table, VkWriteDescriptorSet& write);
+
+	private:
+		struct ReleasedIndex
+		{
+			uint32 Index;
+			uint64 SubmitIDs[(size_t)ERHIQueue::Count];
+		};
+
+		struct Table
+		{
+			VkDescriptorType          Type;
+			uint32                    Capacity;
+			uint32                    NumAllocated;
+			IndexQueue                FreeIndices;
+			std::deque<ReleasedIndex> Released; // in release order, so submit ids only grow
+		};
+
+		VulkanDevice*         m_Device = nullptr;
+		VkDescriptorPool      m_Pool = VK_NULL_HANDLE;
+		VkDescriptorSetLayout m_SetLayout = VK_NULL_HANDLE;
+		VkDescriptorSet       m_Set = VK_NULL_HANDLE;
+
+		// also guards the set, descriptor writes to it have to be externally synchronized
+		std::mutex m_Lock;
+		Table      m_Tables[(size_t)EBindlessTable::Count];
+	};
+}
@@ -0,0 +1,305 @@
+#include <Backend/Vulkan/VulkanDescriptorAllocator.h>
+#include <Backend/Vulkan/VulkanBackend.h>
+
+namespace Spikey {
+
+	static uint64 HashDescriptorWrites(VkDescriptorSetLayout layout, std::span<const VulkanDescriptorWrite> writes)
+	{
+		uint64 hash = 0;
+		Math::HashCombine(hash, (uint64)layout);
+
+		for (const VulkanDescriptorWrite& w : writes)
+		{
+			Math::HashCombine(hash, w.Binding);
+			Math::HashCombine(hash, w.ArrayElement);
+			Math::HashCombine(hash, (uint32)w.Type);
+			Math::HashCombine(hash, (uint64)w.Image.sampler);
+			Math::HashCombine(hash, (uint64)w.Image.imageView);
+			Math::HashCombine(hash, (uint32)w.Image.imageLayout);
+			Math::HashCombine(hash, (uint64)w.Buffer.buffer);
+			Math::HashCombine(hash, w.Buffer.offset);
+			Math::HashCombine(hash, w.Buffer.range);
+			Math::HashCombine(hash, (uint64)w.TexelBuffer);
+		}
+
+		return hash;
+	}
+
+	static bool DescriptorWritesEqual(std::span<const VulkanDescriptorWrite> a, std::span<const VulkanDescriptorWrite> b)
+	{
+		if (a.size() != b.size())
+			return false;
+
+		for (uint64 i = 0; i < a.size(); i++)
+		{
+			const VulkanDescriptorWrite& x = a[i];
+			const VulkanDescriptorWrite& y = b[i];
+
+			if (x.Binding != y.Binding
+				|| x.ArrayElement != y.ArrayElement
+				|| x.Type != y.Type
+				|| x.Image.sampler != y.Image.sampler
+				|| x.Image.imageView != y.Image.imageView
+				|| x.Image.imageLayout != y.Image.imageLayout
+				|| x.Buffer.buffer != y.Buffer.buffer
+				|| x.Buffer.offset != y.Buffer.offset
+				|| x.Buffer.range != y.Buffer.range
+				|| x.TexelBuffer != y.TexelBuffer)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	void VulkanDescriptorAllocator::Init(VulkanDevice& device, ERHIQueue queue)
+	{
+		m_Device = &device;
+		m_Queue = queue;
+
+		for (uint32 i = 0; i < VK_NUM_POOLED_DESCRIPTOR_TYPES; i++)
+		{
+			m_TargetDescriptors[i] = VK_DESCRIPTOR_POOL_MIN_DESCRIPTORS;
+		}
+	}
+
+	void VulkanDescriptorAllocator::Shutdown()
+	{
+		if (!m_Device)
+			return;
+
+		std::lock_guard lock(m_Lock);
+
+		if (!m_Current.Pools.empty())
+		{
+			m_Current.RetireID = m_Device->GetQueue(m_Queue).GetLastSubmitID();
+			m_InFlight.push_back(std::move(m_Current));
+			m_Current = {};
+		}
+
+		RetireFrames(true);
+
+		for (Pool& pool : m_FreePools)
+		{
+			vkDestroyDescriptorPool(m_Device->GetDeviceHandle(), pool.Handle, nullptr);
+		}
+		m_FreePools.clear();
+		m_Device = nullptr;
+	}
+
+	void VulkanDescriptorAllocator::BeginFrame()
+	{
+		PROFILE_SCOPED;
+
+		std::lock_guard lock(m_Lock);
+		RetireFrames(false);
+	}
+
+	void VulkanDescriptorAllocator::EndFrame()
+	{
+		std::lock_guard lock(m_Lock);
+
+		m_Current.RetireID = m_Device->GetQueue(m_Queue).GetLastSubmitID();
+		m_InFlight.push_back(std::move(m_Current));
+		m_Current = {};
+	}
+
+	void VulkanDescriptorAllocator::RetireFrames(bool waitAll)
+	{
+		VulkanQueue& queue = m_Device->GetQueue(m_Queue);
+		VkDevice     device = m_Device->GetDeviceHandle();
+
+		if (waitAll && !m_InFlight.empty())
+		{
+			queue.Wait(m_InFlight.back().RetireID, UINT64_MAX);
+		}
+
+		uint64 finishedID = queue.UpdateLastFinishedID();
+		bool   grown = false;
+
+		while (!m_InFlight.empty() && m_InFlight.front().RetireID <= finishedID)
+		{
+			Frame& frame = m_InFlight.front();
+
+			// size new pools for the largest frame seen, a frame that needed several pools fits in one next time
+			if (frame.NumSets > m_TargetSets)
+			{
+				m_TargetSets = frame.NumSets;
+				grown = true;
+			}
+			for (uint32 i = 0; i < VK_NUM_POOLED_DESCRIPTOR_TYPES; i++)
+			{
+				if (frame.NumDescriptors[i] > m_TargetDescriptors[i])
+				{
+					m_TargetDescriptors[i] = frame.NumDescriptors[i];
+					grown = true;
+				}
+			}
+
+			m_Stats.SetsAllocated = frame.NumSets;
+			m_Stats.PoolsUsed = (uint32)frame.Pools.size();
+
+			for (Pool& pool : frame.Pools)
+			{
+				VK_CHECK(vkResetDescriptorPool(device, pool.Handle, 0));
+				m_FreePools.push_back(pool);
+			}
+
+			m_InFlight.pop_front();
+		}
+
+		if (!grown)
+			return;
+
+		// pools too small for the new targets would only overflow again
+		for (uint32 i = 0; i < (uint32)m_FreePools.size();)
+		{
+			Pool& pool = m_FreePools[i];
+
+			bool tooSmall = pool.MaxSets < m_TargetSets;
+			for (uint32 t = 0; t < VK_NUM_POOLED_DESCRIPTOR_TYPES; t++)
+			{
+				tooSmall |= pool.MaxDescriptors[t] < m_TargetDescriptors[t];
+			}
+
+			if (tooSmall)
+			{
+				vkDestroyDescriptorPool(device, pool.Handle, nullptr);
+				SwapDelete(m_FreePools, i);
+			}
+			else
+			{
+				i++;
+			}
+		}
+	}
+
+	VulkanDescriptorAllocator::Pool VulkanDescriptorAllocator::AcquirePool()
+	{
+		if (!m_FreePools.empty())
+		{
+			Pool pool = m_FreePools.back();
+			m_FreePools.pop_back();
+
+			return pool;
+		}
+
+		Pool pool{};
+		pool.MaxSets = m_TargetSets;
+
+		VkDescriptorPoolSize sizes[VK_NUM_POOLED_DESCRIPTOR_TYPES];
+		for (uint32 i = 0; i < VK_NUM_POOLED_DESCRIPTOR_TYPES; i++)
+		{
+			pool.MaxDescriptors[i] = m_TargetDescriptors[i];
+
+			sizes[i].type = (VkDescriptorType)i;
+			sizes[i].descriptorCount = m_TargetDescriptors[i];
+		}
+
+		VkDescriptorPoolCreateInfo info{ .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO };
+		info.maxSets = pool.MaxSets;
+		info.poolSizeCount = VK_NUM_POOLED_DESCRIPTOR_TYPES;
+		info.pPoolSizes = sizes;
+
+		VK_CHECK(vkCreateDescriptorPool(m_Device->GetDeviceHandle(), &info, nullptr, &pool.Handle));
+		m_Stats.PoolsCreated++;
+
+		return pool;
+	}
+
+	VkDescriptorSet VulkanDescriptorAllocator::Allocate(VkDescriptorSetLayout layout, std::span<const VkDescriptorSetLayoutBinding> bindings)
+	{
+		std::lock_guard lock(m_Lock);
+
+		VkDescriptorSetAllocateInfo info{ .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
+		info.descriptorSetCount = 1;
+		info.pSetLayouts = &layout;
+
+		VkDescriptorSet set = VK_NULL_HANDLE;
+		VkResult result = VK_ERROR_OUT_OF_POOL_MEMORY;
+
+		if (!m_Current.Pools.empty())
+		{
+			info.descriptorPool = m_Current.Pools.back().Handle;
+			result = vkAllocateDescriptorSets(m_Device->GetDeviceHandle(), &info, &set);
+		}
+
+		if (result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL)
+		{
+			m_Current.Pools.push_back(AcquirePool());
+
+			info.descriptorPool = m_Current.Pools.back().Handle;
+			result = vkAllocateDescriptorSets(m_Device->GetDeviceHandle(), &info, &set);
+		}
+		VK_CHECK(result);
+
+		m_Current.NumSets++;
+		for (const VkDescriptorSetLayoutBinding& b : bindings)
+		{
+			CHECK(b.descriptorType < VK_NUM_POOLED_DESCRIPTOR_TYPES);
+			m_Current.NumDescriptors[b.descriptorType] += b.descriptorCount;
+		}
+
+		return set;
+	}
+
+	VkDescriptorSet VulkanDescriptorAllocator::AllocateAndWrite(VkDescriptorSetLayout layout, std::span<const VkDescriptorSetLayoutBinding> bindings,
+		std::span<const VulkanDescriptorWrite> writes)
+	{
+		PROFILE_SCOPED;
+
+		uint64 hash = HashDescriptorWrites(layout, writes);
+		{
+			std::lock_guard lock(m_Lock);
+
+			auto it = m_Current.WriteCache.find(hash);
+			if (it != m_Current.WriteCache.end() && it->second.Layout == layout && DescriptorWritesEqual(it->second.Writes, writes))
+			{
+				m_Stats.SetsReused++;
+				return it->second.Set;
+			}
+		}
+
+		VkDescriptorSet set = Allocate(layout, bindings);
+
+		std::vector<VkWriteDescriptorSet> vkWrites(writes.size());
+		for (uint64 i = 0; i < writes.size(); i++)
+		{
+			const VulkanDescriptorWrite& w = writes[i];
+
+			VkWriteDescriptorSet& write = vkWrites[i];
+			write = { .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+			write.dstSet = set;
+			write.dstBinding = w.Binding;
+			write.dstArrayElement = w.ArrayElement;
+			write.descriptorCount = 1;
+			write.descriptorType = w.Type;
+
+			bool isBuffer = w.Type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER || w.Type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER
+				|| w.Type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC || w.Type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+			bool isTexelBuffer = w.Type == VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER || w.Type == VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER;
+
+			if (isBuffer)
+				write.pBufferInfo = &w.Buffer;
+			else if (isTexelBuffer)
+				write.pTexelBufferView = &w.TexelBuffer;
+			else
+				write.pImageInfo = &w.Image;
+		}
+
+		vkUpdateDescriptorSets(m_Device->GetDeviceHandle(), (uint32)vkWrites.size(), vkWrites.data(), 0, nullptr);
+
+		// on a hash collision the first set stays cached, this one is only used by the caller
+		std::lock_guard lock(m_Lock);
+		m_Current.WriteCache.try_emplace(hash, CachedSet{ layout, std::vector<VulkanDescriptorWrite>(writes.begin(), writes.end()), set });
+
+		return set;
+	}
+
+	VulkanDescriptorAllocatorStats VulkanDescriptorAllocator::GetStats()
+	{
+		std::lock_guard lock(m_Lock);
+		return m_Stats;
+	}
+}
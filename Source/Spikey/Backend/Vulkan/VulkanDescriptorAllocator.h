@@ -0,0 +1,105 @@
+#pragma once
+
+#include <Backend/Vulkan/VulkanCommon.h>
+#include <Engine/Graphics/GraphicsCore.h>
+#include <Engine/Utils/Misc.h>
+
+namespace Spikey {
+
+	class VulkanDevice;
+
+	// descriptor types up to VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT are pooled
+	constexpr uint32 VK_NUM_POOLED_DESCRIPTOR_TYPES = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT + 1;
+
+	// floor of a pool size, so the first frames and overflow pools do not start at zero
+	constexpr uint32 VK_DESCRIPTOR_POOL_MIN_SETS = 256;
+	constexpr uint32 VK_DESCRIPTOR_POOL_MIN_DESCRIPTORS = 512;
+
+	struct VulkanDescriptorWrite
+	{
+		uint32           Binding;
+		uint32           ArrayElement;
+		VkDescriptorType Type;
+
+		// image info for images and samplers, buffer info for buffers, the view for texel buffers
+		VkDescriptorImageInfo  Image;
+		VkDescriptorBufferInfo Buffer;
+		VkBufferView           TexelBuffer;
+	};
+
+	struct VulkanDescriptorAllocatorStats
+	{
+		uint32 SetsAllocated; // last finished frame
+		uint32 SetsReused;    // identical writes served from the frame cache
+		uint32 PoolsUsed;
+		uint32 PoolsCreated;  // total, grows only while the usage does
+	};
+
+	// linear allocator for descriptor sets living a single frame. sets come from pools owned by the frame, all
+	// of them reset together once the timeline value the frame ended with retires. pools are sized from the
+	// usage of the previous frames, so in the steady state a frame fits in one pool
+	class VulkanDescriptorAllocator
+	{
+	public:
+		void Init(VulkanDevice& device, ERHIQueue queue = ERHIQueue::Graphics);
+		void Shutdown();
+
+		// recycles the pools of frames the queue finished, then opens a new frame
+		void BeginFrame();
+
+		// stamps the frame with the value the queue signals after its last submit
+		void EndFrame();
+
+		// bindings are the ones the layout was created from, used for pool sizing
+		VkDescriptorSet Allocate(VkDescriptorSetLayout layout, std::span<const VkDescriptorSetLayoutBinding> bindings);
+
+		// returns the set written earlier in the frame with the same layout and writes instead of a new one
+		VkDescriptorSet AllocateAndWrite(VkDescriptorSetLayout layout, std::span<const VkDescriptorSetLayoutBinding> bindings,
+			std::span<const VulkanDescriptorWrite> writes);
+
+		VulkanDescriptorAllocatorStats GetStats();
+
+	private:
+		struct Pool
+		{
+			VkDescriptorPool Handle;
+			uint32           MaxSets;
+			uint32           MaxDescriptors[VK_NUM_POOLED_DESCRIPTOR_TYPES];
+		};
+
+		struct CachedSet
+		{
+			VkDescriptorSetLayout              Layout;
+			std::vector<VulkanDescriptorWrite> Writes;
+			VkDescriptorSet                    Set;
+		};
+
+		struct Frame
+		{
+			std::vector<Pool> Pools; // last one is allocated from
+			uint64            RetireID = 0;
+			uint32            NumSets = 0;
+			uint32            NumDescriptors[VK_NUM_POOLED_DESCRIPTOR_TYPES] = {};
+
+			std::unordered_map<uint64, CachedSet> WriteCache;
+		};
+
+		Pool AcquirePool();
+		void RetireFrames(bool waitAll);
+
+	private:
+		VulkanDevice* m_Device = nullptr;
+		ERHIQueue     m_Queue = ERHIQueue::Graphics;
+
+		std::mutex        m_Lock;
+		Frame             m_Current;
+		std::deque<Frame> m_InFlight;
+		std::vector<Pool> m_FreePools;
+
+		// high water mark of finished frames, what new pools are sized for
+		uint32 m_TargetSets = VK_DESCRIPTOR_POOL_MIN_SETS;
+		uint32 m_TargetDescriptors[VK_NUM_POOLED_DESCRIPTOR_TYPES] = {};
+
+		VulkanDescriptorAllocatorStats m_Stats = {};
+	};
+}
@@ -0,0 +1,474 @@
+#include <Backend/Vulkan/VulkanGPUProfiler.h>
+#include <Backend/Vulkan/VulkanBackend.h>
+
+#if BUILD_TRACY_PROFILER
+#include <client/TracyProfiler.hpp>
+#endif
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+namespace Spikey {
+
+#if BUILD_TRACY_PROFILER
+	static_assert(sizeof(GPUZoneSource) == sizeof(tracy::SourceLocationData)
+		&& offsetof(GPUZoneSource, Line) == offsetof(tracy::SourceLocationData, line)
+		&& offsetof(GPUZoneSource, Color) == offsetof(tracy::SourceLocationData, color));
+#endif
+
+	static const char* GetQueueName(ERHIQueue queue)
+	{
+		switch (queue)
+		{
+		case ERHIQueue::Graphics:
+			return "Graphics";
+		case ERHIQueue::Compute:
+			return "Compute";
+		case ERHIQueue::Transfer:
+			return "Transfer";
+		default:
+			return "Unknown";
+		}
+	}
+
+	void VulkanGPUProfiler::Init(VulkanDevice& device, ERHIQueue queue)
+	{
+		m_Device = &device;
+		m_Queue = queue;
+
+		uint32 numFamilies = 0;
+		vkGetPhysicalDeviceQueueFamilyProperties(device.GetPhysicalDeviceHandle(), &numFamilies, nullptr);
+
+		std::vector<VkQueueFamilyProperties> families(numFamilies);
+		vkGetPhysicalDeviceQueueFamilyProperties(device.GetPhysicalDeviceHandle(), &numFamilies, families.data());
+
+		uint32 validBits = families[device.GetQueue(queue).GetFamilyIndex()].timestampValidBits;
+		if (validBits == 0)
+		{
+			ENGINE_WARN("{} queue does not support timestamps, gpu zones on it are ignored", GetQueueName(queue));
+			return;
+		}
+
+		m_TimestampMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+		m_NsPerTick = device.GetProperties().limits.timestampPeriod;
+
+		VkQueryPoolCreateInfo info{ .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO };
+		info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+		info.queryCount = VK_GPU_PROFILER_MAX_QUERIES;
+
+		VK_CHECK(vkCreateQueryPool(device.GetDeviceHandle(), &info, nullptr, &m_QueryPool));
+		vkResetQueryPool(device.GetDeviceHandle(), m_QueryPool, 0, VK_GPU_PROFILER_MAX_QUERIES);
+
+		m_Results.resize(VK_GPU_PROFILER_MAX_QUERIES * 2);
+
+		InitCalibration();
+
+#if BUILD_TRACY_PROFILER
+		m_TracyContext = tracy::GetGpuCtxCounter().fetch_add(1, std::memory_order_relaxed);
+
+		// without calibration the context starts from the first frame read back
+		if (m_HostDomain != VK_TIME_DOMAIN_DEVICE_EXT)
+		{
+			SendTracyContext(m_CalibrationGpuTicks);
+		}
+#endif
+	}
+
+	void VulkanGPUProfiler::Shutdown()
+	{
+		if (!IsEnabled())
+			return;
+
+		{
+			std::lock_guard lock(m_Lock);
+
+			if (!m_InFlight.empty())
+			{
+				m_Device->GetQueue(m_Queue).Wait(m_InFlight.back().RetireID, UINT64_MAX);
+			}
+
+			for (Frame& frame : m_InFlight)
+			{
+				ResolveFrame(frame);
+			}
+			m_InFlight.clear();
+			m_Current = {};
+		}
+
+		vkDestroyQueryPool(m_Device->GetDeviceHandle(), m_QueryPool, nullptr);
+		m_QueryPool = VK_NULL_HANDLE;
+	}
+
+	void VulkanGPUProfiler::InitCalibration()
+	{
+		auto getTimeDomains = (PFN_vkGetPhysicalDeviceCalibrateableTimeDomainsEXT)vkGetInstanceProcAddr(m_Device->GetInstanceHandle(),
+			"vkGetPhysicalDeviceCalibrateableTimeDomainsEXT");
+		m_GetCalibratedTimestamps = (PFN_vkGetCalibratedTimestampsEXT)vkGetDeviceProcAddr(m_Device->GetDeviceHandle(), "vkGetCalibratedTimestampsEXT");
+
+		if (!getTimeDomains || !m_GetCalibratedTimestamps)
+		{
+			ENGINE_INFO("VK_EXT_calibrated_timestamps is not enabled, gpu zones are not correlated with cpu time");
+			return;
+		}
+
+		// the clock std::chrono::steady_clock reads
+#if defined(_WIN32)
+		constexpr VkTimeDomainEXT hostDomain = VK_TIME_DOMAIN_QUERY_PERFORMANCE_COUNTER_EXT;
+
+		LARGE_INTEGER frequency;
+		QueryPerformanceFrequency(&frequency);
+		m_HostTicksToNs = 1e9 / (double)frequency.QuadPart;
+#else
+		constexpr VkTimeDomainEXT hostDomain = VK_TIME_DOMAIN_CLOCK_MONOTONIC_EXT;
+#endif
+
+		uint32 numDomains = 0;
+		getTimeDomains(m_Device->GetPhysicalDeviceHandle(), &numDomains, nullptr);
+
+		std::vector<VkTimeDomainEXT> domains(numDomains);
+		getTimeDomains(m_Device->GetPhysicalDeviceHandle(), &numDomains, domains.data());
+
+		if (std::find(domains.begin(), domains.end(), hostDomain) == domains.end())
+		{
+			ENGINE_INFO("device timestamps can not be calibrated against the host clock");
+			return;
+		}
+		m_HostDomain = hostDomain;
+
+		// a sample taken while the thread was preempted deviates far more than the best ones, those are retaken
+		VkCalibratedTimestampInfoEXT infos[2] = {
+			{ VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT, nullptr, VK_TIME_DOMAIN_DEVICE_EXT },
+			{ VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT, nullptr, m_HostDomain }
+		};
+
+		uint64 minDeviation = UINT64_MAX;
+		for (uint32 i = 0; i < 32; i++)
+		{
+			uint64 timestamps[2];
+			uint64 deviation;
+			VK_CHECK(m_GetCalibratedTimestamps(m_Device->GetDeviceHandle(), 2, infos, timestamps, &deviation));
+
+			minDeviation = std::min(minDeviation, deviation);
+		}
+		m_MaxDeviation = minDeviation * 3 / 2;
+
+		Calibrate(m_CalibrationGpuTicks, m_CalibrationCpuNs);
+	}
+
+	bool VulkanGPUProfiler::Calibrate(uint64& outGpuTicks, int64& outCpuNs)
+	{
+		if (m_HostDomain == VK_TIME_DOMAIN_DEVICE_EXT)
+			return false;
+
+		VkCalibratedTimestampInfoEXT infos[2] = {
+			{ VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT, nullptr, VK_TIME_DOMAIN_DEVICE_EXT },
+			{ VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT, nullptr, m_HostDomain }
+		};
+
+		uint64 timestamps[2];
+		uint64 deviation = UINT64_MAX;
+
+		// bounded, a loaded system may not get back under the deviation for a while
+		for (uint32 i = 0; i < 8 && deviation > m_MaxDeviation; i++)
+		{
+			VK_CHECK(m_GetCalibratedTimestamps(m_Device->GetDeviceHandle(), 2, infos, timestamps, &deviation));
+		}
+
+		outGpuTicks = timestamps[0] & m_TimestampMask;
+		outCpuNs = (int64)((double)timestamps[1] * m_HostTicksToNs);
+		return true;
+	}
+
+	void VulkanGPUProfiler::SendTracyContext(uint64 gpuTicks)
+	{
+#if BUILD_TRACY_PROFILER
+		uint8 flags = m_HostDomain != VK_TIME_DOMAIN_DEVICE_EXT ? tracy::GpuContextCalibration : 0;
+
+		auto item = tracy::Profiler::QueueSerial();
+		tracy::MemWrite(&item->hdr.type, tracy::QueueType::GpuNewContext);
+		tracy::MemWrite(&item->gpuNewContext.cpuTime, tracy::Profiler::GetTime());
+		tracy::MemWrite(&item->gpuNewContext.gpuTime, (int64)gpuTicks);
+		memset(&item->gpuNewContext.thread, 0, sizeof(item->gpuNewContext.thread));
+		tracy::MemWrite(&item->gpuNewContext.period, (float)m_NsPerTick);
+		tracy::MemWrite(&item->gpuNewContext.context, m_TracyContext);
+		tracy::MemWrite(&item->gpuNewContext.flags, (tracy::GpuContextFlags)flags);
+		tracy::MemWrite(&item->gpuNewContext.type, tracy::GpuContextType::Vulkan);
+#ifdef TRACY_ON_DEMAND
+		tracy::GetProfiler().DeferItem(*item);
+#endif
+		tracy::Profiler::QueueSerialFinish();
+
+		const char* name = GetQueueName(m_Queue);
+		uint16      length = (uint16)strlen(name);
+
+		char* nameCopy = (char*)tracy::tracy_malloc(length);
+		memcpy(nameCopy, name, length);
+
+		item = tracy::Profiler::QueueSerial();
+		tracy::MemWrite(&item->hdr.type, tracy::QueueType::GpuContextName);
+		tracy::MemWrite(&item->gpuContextNameFat.context, m_TracyContext);
+		tracy::MemWrite(&item->gpuContextNameFat.ptr, (uint64)nameCopy);
+		tracy::MemWrite(&item->gpuContextNameFat.size, length);
+#ifdef TRACY_ON_DEMAND
+		tracy::GetProfiler().DeferItem(*item);
+#endif
+		tracy::Profiler::QueueSerialFinish();
+
+		m_TracyActive = true;
+#endif
+	}
+
+	uint64 VulkanGPUProfiler::BeginZone(VkCommandBuffer cmd, const GPUZoneSource* source, uint32 depth)
+	{
+		if (!IsEnabled())
+			return VK_GPU_PROFILER_INVALID_ZONE;
+
+		std::lock_guard lock(m_Lock);
+
+		// begin and end query of the zone are taken together, so an end never finds the ring full
+		if (m_QueryHead + 2 - m_QueryTail > VK_GPU_PROFILER_MAX_QUERIES)
+		{
+			m_Current.DroppedZones++;
+			return VK_GPU_PROFILER_INVALID_ZONE;
+		}
+
+		Zone zone{};
+		zone.Source = source;
+		zone.BeginQuery = m_QueryHead;
+		zone.Depth = depth;
+		m_QueryHead += 2;
+
+		uint32 query = (uint32)(zone.BeginQuery % VK_GPU_PROFILER_MAX_QUERIES);
+		vkCmdWriteTimestamp2(cmd, VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT, m_QueryPool, query);
+
+#if BUILD_TRACY_PROFILER
+		if (m_TracyActive)
+		{
+			auto item = tracy::Profiler::QueueSerial();
+			tracy::MemWrite(&item->hdr.type, tracy::QueueType::GpuZoneBeginSerial);
+			tracy::MemWrite(&item->gpuZoneBegin.cpuTime, tracy::Profiler::GetTime());
+			tracy::MemWrite(&item->gpuZoneBegin.srcloc, (uint64)source);
+			tracy::MemWrite(&item->gpuZoneBegin.thread, tracy::GetThreadHandle());
+			tracy::MemWrite(&item->gpuZoneBegin.queryId, (uint16)query);
+			tracy::MemWrite(&item->gpuZoneBegin.context, m_TracyContext);
+			tracy::Profiler::QueueSerialFinish();
+
+			zone.Traced = true;
+		}
+#endif
+
+		m_Current.Zones.push_back(zone);
+		return (m_FrameIndex << 32) | (uint64)(m_Current.Zones.size() - 1);
+	}
+
+	void VulkanGPUProfiler::EndZone(VkCommandBuffer cmd, uint64 handle)
+	{
+		if (handle == VK_GPU_PROFILER_INVALID_ZONE)
+			return;
+
+		std::lock_guard lock(m_Lock);
+
+		// zones have to end in the frame they began in, the query of an older frame may be read back already
+		if ((handle >> 32) != m_FrameIndex)
+			return;
+
+		Zone& zone = m_Current.Zones[(uint32)handle];
+		zone.Ended = true;
+
+		uint32 query = (uint32)((zone.BeginQuery + 1) % VK_GPU_PROFILER_MAX_QUERIES);
+		vkCmdWriteTimestamp2(cmd, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, m_QueryPool, query);
+
+#if BUILD_TRACY_PROFILER
+		if (zone.Traced)
+		{
+			auto item = tracy::Profiler::QueueSerial();
+			tracy::MemWrite(&item->hdr.type, tracy::QueueType::GpuZoneEndSerial);
+			tracy::MemWrite(&item->gpuZoneEnd.cpuTime, tracy::Profiler::GetTime());
+			tracy::MemWrite(&item->gpuZoneEnd.thread, tracy::GetThreadHandle());
+			tracy::MemWrite(&item->gpuZoneEnd.queryId, (uint16)query);
+			tracy::MemWrite(&item->gpuZoneEnd.context, m_TracyContext);
+			tracy::Profiler::QueueSerialFinish();
+		}
+#endif
+	}
+
+	void VulkanGPUProfiler::BeginFrame()
+	{
+		if (!IsEnabled())
+			return;
+
+		PROFILE_SCOPED;
+
+		std::lock_guard lock(m_Lock);
+
+		VulkanQueue& queue = m_Device->GetQueue(m_Queue);
+		while (!m_InFlight.empty() && queue.IsComplete(m_InFlight.front().RetireID))
+		{
+			ResolveFrame(m_InFlight.front());
+			m_InFlight.pop_front();
+		}
+	}
+
+	void VulkanGPUProfiler::EndFrame()
+	{
+		if (!IsEnabled())
+			return;
+
+		std::lock_guard lock(m_Lock);
+
+		m_Current.Index = m_FrameIndex++;
+		m_Current.RetireID = m_Device->GetQueue(m_Queue).GetLastSubmitID();
+		m_Current.EndQuery = m_QueryHead;
+		m_InFlight.push_back(std::move(m_Current));
+
+		m_Current = {};
+		m_Current.FirstQuery = m_QueryHead;
+	}
+
+	void VulkanGPUProfiler::ResolveFrame(Frame& frame)
+	{
+		VkDevice device = m_Device->GetDeviceHandle();
+
+		// the range of a frame may wrap around the end of the ring
+		uint32 first = (uint32)(frame.FirstQuery % VK_GPU_PROFILER_MAX_QUERIES);
+		uint32 count = (uint32)(frame.EndQuery - frame.FirstQuery);
+		uint32 chunks[2][2] = {
+			{ first, std::min(count, VK_GPU_PROFILER_MAX_QUERIES - first) },
+			{ 0, count - std::min(count, VK_GPU_PROFILER_MAX_QUERIES - first) }
+		};
+
+		for (auto& [start, num] : chunks)
+		{
+			if (num == 0)
+				continue;
+
+			// queries of lists that were never submitted stay unavailable, VK_NOT_READY then
+			VkResult result = vkGetQueryPoolResults(device, m_QueryPool, start, num, sizeof(uint64) * 2 * num, &m_Results[start * 2],
+				sizeof(uint64) * 2, VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+			CHECK(result == VK_SUCCESS || result == VK_NOT_READY);
+		}
+
+		auto readTimestamp = [&](uint64 query, uint64& outTicks) {
+			uint64 index = (query % VK_GPU_PROFILER_MAX_QUERIES) * 2;
+			outTicks = m_Results[index] & m_TimestampMask;
+
+			return m_Results[index + 1] != 0;
+		};
+
+		uint64 frameBegin = UINT64_MAX;
+		uint64 frameEnd = 0;
+		for (const Zone& zone : frame.Zones)
+		{
+			uint64 begin, end;
+			if (zone.Ended && readTimestamp(zone.BeginQuery, begin) && readTimestamp(zone.BeginQuery + 1, end))
+			{
+				frameBegin = std::min(frameBegin, begin);
+				frameEnd = std::max(frameEnd, end);
+			}
+		}
+
+		GPUFrameTimings timings{};
+		timings.FrameIndex = frame.Index;
+		timings.DroppedZones = frame.DroppedZones;
+		timings.Zones.reserve(frame.Zones.size());
+
+		double msPerTick = m_NsPerTick / 1e6;
+		for (const Zone& zone : frame.Zones)
+		{
+			uint64 begin, end;
+			bool   valid = zone.Ended && readTimestamp(zone.BeginQuery, begin) && readTimestamp(zone.BeginQuery + 1, end);
+
+#if BUILD_TRACY_PROFILER
+			// tracy waits for the time of every query it was told about, a zone that never ran shows up empty
+			if (zone.Traced)
+			{
+				uint64 tracyBegin = valid ? begin : frameBegin != UINT64_MAX ? frameBegin : 0;
+				uint64 tracyEnd = valid ? end : tracyBegin;
+
+				uint64 queries[2] = { zone.BeginQuery, zone.BeginQuery + 1 };
+				uint64 times[2] = { tracyBegin, tracyEnd };
+
+				for (uint32 i = 0; i < (zone.Ended ? 2u : 1u); i++)
+				{
+					auto item = tracy::Profiler::QueueSerial();
+					tracy::MemWrite(&item->hdr.type, tracy::QueueType::GpuTime);
+					tracy::MemWrite(&item->gpuTime.gpuTime, (int64)times[i]);
+					tracy::MemWrite(&item->gpuTime.queryId, (uint16)(queries[i] % VK_GPU_PROFILER_MAX_QUERIES));
+					tracy::MemWrite(&item->gpuTime.context, m_TracyContext);
+					tracy::Profiler::QueueSerialFinish();
+				}
+			}
+#endif
+
+			if (!valid)
+			{
+				timings.DroppedZones++;
+				continue;
+			}
+
+			GPUZoneTiming& timing = timings.Zones.emplace_back();
+			timing.Name = zone.Source->Name;
+			timing.Depth = zone.Depth;
+			timing.BeginMs = (float)((double)((begin - frameBegin) & m_TimestampMask) * msPerTick);
+			timing.DurationMs = (float)((double)((end - begin) & m_TimestampMask) * msPerTick);
+		}
+
+		if (frameBegin != UINT64_MAX)
+		{
+			timings.TotalMs = (float)((double)((frameEnd - frameBegin) & m_TimestampMask) * msPerTick);
+		}
+
+		uint64 gpuTicks;
+		int64  cpuNs;
+		if (Calibrate(gpuTicks, cpuNs))
+		{
+#if BUILD_TRACY_PROFILER
+			if (cpuNs > m_CalibrationCpuNs)
+			{
+				auto item = tracy::Profiler::QueueSerial();
+				tracy::MemWrite(&item->hdr.type, tracy::QueueType::GpuCalibration);
+				tracy::MemWrite(&item->gpuCalibration.gpuTime, (int64)gpuTicks);
+				tracy::MemWrite(&item->gpuCalibration.cpuTime, tracy::Profiler::GetTime());
+				tracy::MemWrite(&item->gpuCalibration.cpuDelta, cpuNs - m_CalibrationCpuNs);
+				tracy::MemWrite(&item->gpuCalibration.context, m_TracyContext);
+				tracy::Profiler::QueueSerialFinish();
+			}
+#endif
+			m_CalibrationGpuTicks = gpuTicks;
+			m_CalibrationCpuNs = cpuNs;
+
+			if (frameBegin != UINT64_MAX)
+			{
+				// signed, the frame began before the calibration point
+				int64 deltaTicks = (int64)(frameBegin - m_CalibrationGpuTicks);
+				timings.CpuBeginNs = m_CalibrationCpuNs + (int64)((double)deltaTicks * m_NsPerTick);
+			}
+		}
+#if BUILD_TRACY_PROFILER
+		else if (!m_TracyActive && frameBegin != UINT64_MAX)
+		{
+			// uncalibrated, the end of this frame is taken as now. off by the readback latency, which tracy
+			// shows as a constant shift of every gpu zone
+			SendTracyContext(frameEnd);
+		}
+#endif
+
+		for (auto& [start, num] : chunks)
+		{
+			if (num > 0)
+				vkResetQueryPool(device, m_QueryPool, start, num);
+		}
+		m_QueryTail = frame.EndQuery;
+
+		m_LastFrame = std::move(timings);
+	}
+
+	GPUFrameTimings VulkanGPUProfiler::GetLastFrame() const
+	{
+		std::lock_guard lock(m_Lock);
+		return m_LastFrame;
+	}
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <Backend/Vulkan/VulkanCommon.h>
+#include <Engine/Graphics/GraphicsCore.h>
+
+namespace Spikey {
+
+	class VulkanDevice;
+
+	// tracy addresses queries with 16 bits
+	constexpr uint32 VK_GPU_PROFILER_MAX_QUERIES = 16384;
+
+	constexpr uint64 VK_GPU_PROFILER_INVALID_ZONE = ~0ull;
+
+	// timestamp queries of one queue. zones write a timestamp into a ring of queries when they begin and end,
+	// the ring is read back once the timeline value their frame ended with retires, so nothing waits on the
+	// gpu. with VK_EXT_calibrated_timestamps the gpu clock is correlated with the cpu one every readback.
+	// queries are reset from the host, which needs the hostQueryReset feature
+	class VulkanGPUProfiler
+	{
+	public:
+		void Init(VulkanDevice& device, ERHIQueue queue);
+		void Shutdown();
+
+		// false for queues without timestamp support
+		bool IsEnabled() const { return m_QueryPool != VK_NULL_HANDLE; }
+
+		// reads back the frames the queue finished
+		void BeginFrame();
+
+		// stamps the frame with the value the queue signals after its last submit, zones of the frame have to be
+		// submitted by then
+		void EndFrame();
+
+		// returns the handle EndZone takes, VK_GPU_PROFILER_INVALID_ZONE when the ring is full
+		uint64 BeginZone(VkCommandBuffer cmd, const GPUZoneSource* source, uint32 depth);
+		void   EndZone(VkCommandBuffer cmd, uint64 zone);
+
+		GPUFrameTimings GetLastFrame() const;
+
+	private:
+		struct Zone
+		{
+			const GPUZoneSource* Source;
+			uint64               BeginQuery; // EndQuery is the one after it
+			uint32               Depth;
+			bool                 Ended;
+			bool                 Traced; // begin was sent to tracy
+		};
+
+		struct Frame
+		{
+			uint64 Index = 0;
+			uint64 RetireID = 0;
+			uint64 FirstQuery = 0;
+			uint64 EndQuery = 0;
+			uint32 DroppedZones = 0;
+
+			std::vector<Zone> Zones;
+		};
+
+		void ResolveFrame(Frame& frame);
+		bool Calibrate(uint64& outGpuTicks, int64& outCpuNs);
+		void InitCalibration();
+		void SendTracyContext(uint64 gpuTicks);
+
+	private:
+		VulkanDevice* m_Device = nullptr;
+		ERHIQueue     m_Queue = ERHIQueue::Graphics;
+		VkQueryPool   m_QueryPool = VK_NULL_HANDLE;
+		uint64        m_TimestampMask = 0;
+		double        m_NsPerTick = 1.0;
+
+		// host time domain matching steady_clock, VK_TIME_DOMAIN_DEVICE_EXT when calibration is unavailable
+		VkTimeDomainEXT                  m_HostDomain = VK_TIME_DOMAIN_DEVICE_EXT;
+		PFN_vkGetCalibratedTimestampsEXT m_GetCalibratedTimestamps = nullptr;
+		uint64                           m_MaxDeviation = 0;
+		double                           m_HostTicksToNs = 1.0;
+		uint64                           m_CalibrationGpuTicks = 0;
+		int64                            m_CalibrationCpuNs = 0;
+
+		mutable std::mutex m_Lock;
+		Frame              m_Current;
+		std::deque<Frame>  m_InFlight;
+		uint64             m_FrameIndex = 0;
+		uint64             m_QueryHead = 0; // next query to hand out, wraps around the ring
+		uint64             m_QueryTail = 0; // oldest query not read back yet
+		GPUFrameTimings    m_LastFrame = {};
+
+		std::vector<uint64> m_Results; // timestamp and availability pairs
+
+#if BUILD_TRACY_PROFILER
+		uint8 m_TracyContext = 0;
+		bool  m_TracyActive = false; // the context was announced, zones may be sent
+#endif
+	};
+}
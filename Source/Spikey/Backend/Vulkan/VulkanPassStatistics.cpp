@@ -0,0 +1,287 @@
+#include <Backend/Vulkan/VulkanPassStatistics.h>
+#include <Backend/Vulkan/VulkanBackend.h>
+
+namespace Spikey {
+
+	// results come back in the order of the bits
+	constexpr VkQueryPipelineStatisticFlags VK_PASS_STATISTICS_FLAGS =
+		VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT
+		| VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT
+		| VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT
+		| VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT
+		| VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT
+		| VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT;
+
+	constexpr uint32 VK_PASS_STATISTICS_COUNT = 6;
+
+	void VulkanPassStatistics::Init(VulkanDevice& device)
+	{
+		m_Device = &device;
+
+		VkPhysicalDeviceFeatures features;
+		vkGetPhysicalDeviceFeatures(device.GetPhysicalDeviceHandle(), &features);
+
+		if (!features.pipelineStatisticsQuery)
+		{
+			ENGINE_WARN("pipeline statistics queries are not supported, pass statistics are disabled");
+			return;
+		}
+
+		m_Enabled = true;
+		m_Occlusion = features.occlusionQueryPrecise;
+	}
+
+	void VulkanPassStatistics::Shutdown()
+	{
+		if (!m_Enabled)
+			return;
+
+		std::lock_guard lock(m_Lock);
+
+		if (!m_InFlight.empty())
+		{
+			m_Device->GetQueue(ERHIQueue::Graphics).Wait(m_InFlight.back().RetireID, UINT64_MAX);
+		}
+
+		for (Frame& frame : m_InFlight)
+		{
+			ResolveFrame(frame);
+		}
+		m_InFlight.clear();
+
+		// passes of the open frame were never submitted
+		m_FreePools.insert(m_FreePools.end(), m_Current.Pools.begin(), m_Current.Pools.end());
+		m_Current = {};
+
+		for (Pool& pool : m_FreePools)
+		{
+			vkDestroyQueryPool(m_Device->GetDeviceHandle(), pool.Statistics, nullptr);
+			vkDestroyQueryPool(m_Device->GetDeviceHandle(), pool.Occlusion, nullptr);
+		}
+		m_FreePools.clear();
+		m_Enabled = false;
+	}
+
+	VulkanPassStatistics::Pool VulkanPassStatistics::AcquirePool()
+	{
+		VkDevice device = m_Device->GetDeviceHandle();
+
+		if (!m_FreePools.empty())
+		{
+			Pool pool = m_FreePools.back();
+			m_FreePools.pop_back();
+
+			return pool;
+		}
+
+		Pool pool{};
+
+		VkQueryPoolCreateInfo info{ .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO };
+		info.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+		info.queryCount = VK_PASS_STATISTICS_POOL_SIZE;
+		info.pipelineStatistics = VK_PASS_STATISTICS_FLAGS;
+
+		VK_CHECK(vkCreateQueryPool(device, &info, nullptr, &pool.Statistics));
+		vkResetQueryPool(device, pool.Statistics, 0, VK_PASS_STATISTICS_POOL_SIZE);
+
+		if (m_Occlusion)
+		{
+			info.queryType = VK_QUERY_TYPE_OCCLUSION;
+			info.pipelineStatistics = 0;
+
+			VK_CHECK(vkCreateQueryPool(device, &info, nullptr, &pool.Occlusion));
+			vkResetQueryPool(device, pool.Occlusion, 0, VK_PASS_STATISTICS_POOL_SIZE);
+		}
+
+		return pool;
+	}
+
+	uint64 VulkanPassStatistics::BeginPass(VkCommandBuffer cmd, const char* name)
+	{
+		if (!m_Enabled)
+			return VK_PASS_STATISTICS_INVALID;
+
+		std::lock_guard lock(m_Lock);
+
+		uint32 index = (uint32)m_Current.Passes.size();
+		if (index >= VK_PASS_STATISTICS_MAX_PASSES)
+		{
+			m_Current.DroppedPasses++;
+			return VK_PASS_STATISTICS_INVALID;
+		}
+
+		if (index % VK_PASS_STATISTICS_POOL_SIZE == 0)
+		{
+			m_Current.Pools.push_back(AcquirePool());
+		}
+
+		const Pool& pool = m_Current.Pools[index / VK_PASS_STATISTICS_POOL_SIZE];
+		uint32      slot = index % VK_PASS_STATISTICS_POOL_SIZE;
+
+		vkCmdBeginQuery(cmd, pool.Statistics, slot, 0);
+		if (pool.Occlusion)
+		{
+			vkCmdBeginQuery(cmd, pool.Occlusion, slot, VK_QUERY_CONTROL_PRECISE_BIT);
+		}
+
+		m_Current.Passes.push_back({ name, false });
+		m_Current.OpenPasses++;
+		return (m_FrameIndex << 32) | index;
+	}
+
+	void VulkanPassStatistics::EndPass(VkCommandBuffer cmd, uint64 handle)
+	{
+		if (handle == VK_PASS_STATISTICS_INVALID)
+			return;
+
+		std::lock_guard lock(m_Lock);
+
+		// the pass may end after its frame did, the frame then waits in flight until the late end is submitted
+		uint32 index = (uint32)handle;
+		bool   current = (handle >> 32) == m_FrameIndex;
+
+		Frame* frame = nullptr;
+		if (current)
+		{
+			frame = &m_Current;
+		}
+		else
+		{
+			for (Frame& inFlight : m_InFlight)
+			{
+				if (inFlight.Index == (handle >> 32))
+				{
+					frame = &inFlight;
+					frame->LateEnd = true;
+					break;
+				}
+			}
+		}
+
+		// frames with open passes are not resolved, so the pools the query was begun in are still there
+		CHECK(frame && frame->OpenPasses > 0);
+		frame->OpenPasses--;
+		frame->Passes[index].Ended = true;
+
+		const Pool* pool = &frame->Pools[index / VK_PASS_STATISTICS_POOL_SIZE];
+		uint32      slot = index % VK_PASS_STATISTICS_POOL_SIZE;
+		if (pool->Occlusion)
+		{
+			vkCmdEndQuery(cmd, pool->Occlusion, slot);
+		}
+		vkCmdEndQuery(cmd, pool->Statistics, slot);
+	}
+
+	void VulkanPassStatistics::BeginFrame()
+	{
+		if (!m_Enabled)
+			return;
+
+		PROFILE_SCOPED;
+
+		std::lock_guard lock(m_Lock);
+
+		VulkanQueue& queue = m_Device->GetQueue(ERHIQueue::Graphics);
+		while (!m_InFlight.empty() && m_InFlight.front().OpenPasses == 0 && !m_InFlight.front().LateEnd
+			&& queue.IsComplete(m_InFlight.front().RetireID))
+		{
+			ResolveFrame(m_InFlight.front());
+			m_InFlight.pop_front();
+		}
+	}
+
+	void VulkanPassStatistics::EndFrame()
+	{
+		if (!m_Enabled)
+			return;
+
+		std::lock_guard lock(m_Lock);
+
+		m_Current.Index = m_FrameIndex++;
+		m_Current.RetireID = m_Device->GetQueue(ERHIQueue::Graphics).GetLastSubmitID();
+
+		// the end of a late query was submitted with this frame, its pools are reset once this frame retires
+		for (Frame& frame : m_InFlight)
+		{
+			if (frame.LateEnd)
+			{
+				frame.RetireID = m_Current.RetireID;
+				frame.LateEnd = false;
+			}
+		}
+
+		m_InFlight.push_back(std::move(m_Current));
+		m_Current = {};
+	}
+
+	void VulkanPassStatistics::ResolveFrame(Frame& frame)
+	{
+		VkDevice device = m_Device->GetDeviceHandle();
+
+		GPUPassStatisticsFrame result{};
+		result.FrameIndex = frame.Index;
+		result.DroppedPasses = frame.DroppedPasses;
+		result.Passes.reserve(frame.Passes.size());
+
+		uint64 statistics[VK_PASS_STATISTICS_POOL_SIZE][VK_PASS_STATISTICS_COUNT + 1];
+		uint64 occlusion[VK_PASS_STATISTICS_POOL_SIZE][2];
+
+		for (uint32 p = 0; p < (uint32)frame.Pools.size(); p++)
+		{
+			const Pool& pool = frame.Pools[p];
+
+			uint32 first = p * VK_PASS_STATISTICS_POOL_SIZE;
+			uint32 count = std::min(VK_PASS_STATISTICS_POOL_SIZE, (uint32)frame.Passes.size() - first);
+
+			// passes of lists that were never submitted stay unavailable, VK_NOT_READY then
+			VkResult res = vkGetQueryPoolResults(device, pool.Statistics, 0, count, sizeof(statistics), statistics, sizeof(statistics[0]),
+				VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+			CHECK(res == VK_SUCCESS || res == VK_NOT_READY);
+
+			if (pool.Occlusion)
+			{
+				res = vkGetQueryPoolResults(device, pool.Occlusion, 0, count, sizeof(occlusion), occlusion, sizeof(occlusion[0]),
+					VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+				CHECK(res == VK_SUCCESS || res == VK_NOT_READY);
+			}
+
+			for (uint32 i = 0; i < count; i++)
+			{
+				const Pass& pass = frame.Passes[first + i];
+				const uint64* values = statistics[i];
+
+				if (!pass.Ended || values[VK_PASS_STATISTICS_COUNT] == 0)
+				{
+					result.DroppedPasses++;
+					continue;
+				}
+
+				GPUPassStatistics& stats = result.Passes.emplace_back();
+				stats.Name = pass.Name;
+				stats.InputVertices = values[0];
+				stats.InputPrimitives = values[1];
+				stats.VertexInvocations = values[2];
+				stats.RasterizedPrimitives = values[3];
+				stats.FragmentInvocations = values[4];
+				stats.ComputeInvocations = values[5];
+				stats.SamplesPassed = pool.Occlusion && occlusion[i][1] != 0 ? occlusion[i][0] : GPU_STATISTIC_UNAVAILABLE;
+			}
+
+			vkResetQueryPool(device, pool.Statistics, 0, VK_PASS_STATISTICS_POOL_SIZE);
+			if (pool.Occlusion)
+			{
+				vkResetQueryPool(device, pool.Occlusion, 0, VK_PASS_STATISTICS_POOL_SIZE);
+			}
+			m_FreePools.push_back(pool);
+		}
+
+		frame.Pools.clear();
+		m_LastFrame = std::move(result);
+	}
+
+	GPUPassStatisticsFrame VulkanPassStatistics::GetLastFrame() const
+	{
+		std::lock_guard lock(m_Lock);
+		return m_LastFrame;
+	}
+}
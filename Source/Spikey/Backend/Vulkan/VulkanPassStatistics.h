@@ -0,0 +1,82 @@
+#pragma once
+
+#include <Backend/Vulkan/VulkanCommon.h>
+#include <Engine/Graphics/GraphicsCore.h>
+
+namespace Spikey {
+
+	class VulkanDevice;
+
+	// passes one query pool holds, a frame takes as many pools as its passes need
+	constexpr uint32 VK_PASS_STATISTICS_POOL_SIZE = 128;
+	constexpr uint32 VK_PASS_STATISTICS_MAX_PASSES = 4096;
+
+	constexpr uint64 VK_PASS_STATISTICS_INVALID = ~0ull;
+
+	// pipeline statistics and precise occlusion queries per pass of the graphics queue. the pools of a frame are
+	// read back and returned to a free list once the timeline value the frame ended with retires, so the ring
+	// grows to the number of frames in flight and nothing waits on the gpu. needs the pipelineStatisticsQuery
+	// and hostQueryReset features, samples passed also occlusionQueryPrecise
+	class VulkanPassStatistics
+	{
+	public:
+		void Init(VulkanDevice& device);
+		void Shutdown();
+
+		bool IsEnabled() const { return m_Enabled; }
+
+		// reads back the frames the queue finished
+		void BeginFrame();
+
+		// stamps the frame with the value the queue signals after its last submit
+		void EndFrame();
+
+		// returns the handle EndPass takes, VK_PASS_STATISTICS_INVALID when the pass is not counted
+		uint64 BeginPass(VkCommandBuffer cmd, const char* name);
+		void   EndPass(VkCommandBuffer cmd, uint64 pass);
+
+		GPUPassStatisticsFrame GetLastFrame() const;
+
+	private:
+		struct Pool
+		{
+			VkQueryPool Statistics;
+			VkQueryPool Occlusion; // VK_NULL_HANDLE without precise occlusion queries
+		};
+
+		struct Pass
+		{
+			const char* Name;
+			bool        Ended;
+		};
+
+		struct Frame
+		{
+			uint64 Index = 0;
+			uint64 RetireID = 0;
+			uint32 DroppedPasses = 0;
+
+			// begun queries keep the pools of their frame, one ended after the frame moves its retirement to the current one
+			uint32 OpenPasses = 0;
+			bool   LateEnd = false;
+
+			std::vector<Pool> Pools; // pass i lives in pool i / VK_PASS_STATISTICS_POOL_SIZE
+			std::vector<Pass> Passes;
+		};
+
+		Pool AcquirePool();
+		void ResolveFrame(Frame& frame);
+
+	private:
+		VulkanDevice* m_Device = nullptr;
+		bool          m_Enabled = false;
+		bool          m_Occlusion = false;
+
+		mutable std::mutex     m_Lock;
+		Frame                  m_Current;
+		std::deque<Frame>      m_InFlight;
+		std::vector<Pool>      m_FreePools;
+		uint64                 m_FrameIndex = 0;
+		GPUPassStatisticsFrame m_LastFrame = {};
+	};
+}
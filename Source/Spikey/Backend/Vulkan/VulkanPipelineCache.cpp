@@ -0,0 +1,391 @@
+#include <Backend/Vulkan/VulkanPipelineCache.h>
+#include <Backend/Vulkan/VulkanBackend.h>
+#include <Engine/Serialization/BinaryStream.h>
+#include <Engine/Utils/Hash.h>
+
+namespace Spikey {
+
+	uint64 HashShaderBytecode(const std::span<const uint8>& bytecode)
+	{
+		return HashBytes(bytecode.data(), bytecode.size());
+	}
+
+	void VulkanPipelineCache::Init(VulkanDevice& device, const std::filesystem::path& directory)
+	{
+		PROFILE_SCOPED;
+
+		m_Device = &device;
+		m_CachePath = directory / "PipelineCache.bin";
+		m_ManifestPath = directory / "PipelineManifest.bin";
+
+		std::vector<uint8> data{};
+		bool loaded = LoadCache(data);
+
+		VkPipelineCacheCreateInfo info{ .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO };
+		info.initialDataSize = loaded ? data.size() : 0;
+		info.pInitialData = loaded ? data.data() : nullptr;
+
+		VK_CHECK(vkCreatePipelineCache(m_Device->GetDeviceHandle(), &info, nullptr, &m_Cache));
+
+		LoadManifest();
+
+		ENGINE_INFO("Pipeline cache: {} ({} KB), {} pipelines in the manifest", loaded ? "loaded" : "empty",
+			data.size() / 1024, m_ManifestEntries.size());
+	}
+
+	void VulkanPipelineCache::Shutdown()
+	{
+		PROFILE_SCOPED;
+
+		// the jobs compile on the device and merge into the cache destroyed below
+		JobSystem::Wait(m_PrecompileCounter);
+
+		MergeWorkerCaches();
+		SaveCache();
+		SaveManifest();
+
+		VkDevice device = m_Device->GetDeviceHandle();
+		for (VkPipelineCache cache : m_WorkerCaches)
+			vkDestroyPipelineCache(device, cache, nullptr);
+
+		vkDestroyPipelineCache(device, m_Cache, nullptr);
+
+		m_WorkerCaches.clear();
+		m_FreeWorkerCaches.clear();
+		m_Cache = VK_NULL_HANDLE;
+	}
+
+	bool VulkanPipelineCache::LoadCache(std::vector<uint8>& outData)
+	{
+		if (!std::filesystem::exists(m_CachePath))
+			return false;
+
+		BinaryReadStream stream(m_CachePath);
+		if (!stream.IsOpen())
+			return false;
+
+		const VkPhysicalDeviceProperties& props = m_Device->GetProperties();
+
+		PipelineCacheFileHeader header{};
+		stream >> header;
+
+		// a cache from another gpu or driver is useless at best, drivers have crashed on foreign data
+		if (memcmp(header.Magic, PIPELINE_CACHE_MAGIC, sizeof(char) * 4) != 0 || header.Version != PIPELINE_CACHE_VERSION)
+		{
+			ENGINE_WARN("Pipeline cache {} has an unknown format, ignoring it", m_CachePath.string());
+			return false;
+		}
+
+		if (header.VendorID != props.vendorID || header.DeviceID != props.deviceID || header.DriverVersion != props.driverVersion
+			|| memcmp(header.CacheUUID, props.pipelineCacheUUID, VK_UUID_SIZE) != 0)
+		{
+			ENGINE_INFO("Pipeline cache was written by another device or driver, starting empty");
+			return false;
+		}
+
+		// the size comes from the file, a truncated or damaged one must not make us allocate whatever it says
+		std::error_code error;
+		uint64 fileSize = std::filesystem::file_size(m_CachePath, error);
+		if (error || fileSize < sizeof(header) || header.DataSize > fileSize - sizeof(header))
+		{
+			ENGINE_WARN("Pipeline cache {} is truncated, ignoring it", m_CachePath.string());
+			return false;
+		}
+
+		outData.resize(header.DataSize);
+		stream.ReadRaw(outData.data(), header.DataSize);
+
+		if (HashBytes(outData.data(), outData.size()) != header.DataHash || outData.size() < sizeof(VkPipelineCacheHeaderVersionOne))
+		{
+			ENGINE_WARN("Pipeline cache {} is corrupted, ignoring it", m_CachePath.string());
+			return false;
+		}
+
+		// the driver header inside the data has to agree with the device as well
+		VkPipelineCacheHeaderVersionOne vkHeader{};
+		memcpy(&vkHeader, outData.data(), sizeof(vkHeader));
+
+		if (vkHeader.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE || vkHeader.vendorID != props.vendorID
+			|| vkHeader.deviceID != props.deviceID || memcmp(vkHeader.pipelineCacheUUID, props.pipelineCacheUUID, VK_UUID_SIZE) != 0)
+		{
+			ENGINE_WARN("Pipeline cache {} does not match the device, ignoring it", m_CachePath.string());
+			return false;
+		}
+
+		return true;
+	}
+
+	void VulkanPipelineCache::SaveCache()
+	{
+		VkDevice device = m_Device->GetDeviceHandle();
+
+		uint64 size = 0;
+		VK_CHECK(vkGetPipelineCacheData(device, m_Cache, &size, nullptr));
+
+		std::vector<uint8> data(size);
+		VK_CHECK(vkGetPipelineCacheData(device, m_Cache, &size, data.data()));
+		data.resize(size);
+
+		const VkPhysicalDeviceProperties& props = m_Device->GetProperties();
+
+		PipelineCacheFileHeader header{};
+		memcpy(header.Magic, PIPELINE_CACHE_MAGIC, sizeof(char) * 4);
+		header.Version = PIPELINE_CACHE_VERSION;
+		header.VendorID = props.vendorID;
+		header.DeviceID = props.deviceID;
+		header.DriverVersion = props.driverVersion;
+		memcpy(header.CacheUUID, props.pipelineCacheUUID, VK_UUID_SIZE);
+		header.DataSize = size;
+		header.DataHash = HashBytes(data.data(), size);
+
+		// written next to the old file and swapped in, a crash while saving keeps the previous cache
+		std::filesystem::path tempPath = m_CachePath;
+		tempPath += ".tmp";
+
+		std::error_code error;
+		std::filesystem::create_directories(m_CachePath.parent_path(), error);
+
+		{
+			BinaryWriteStream stream(tempPath);
+			if (!stream.IsOpen())
+			{
+				ENGINE_WARN("Failed to write pipeline cache {}", tempPath.string());
+				return;
+			}
+
+			stream << header;
+			stream.WriteRaw(data.data(), size);
+		}
+
+		std::filesystem::rename(tempPath, m_CachePath, error);
+		if (error)
+			ENGINE_WARN("Failed to replace pipeline cache {}: {}", m_CachePath.string(), error.message());
+	}
+
+	void VulkanPipelineCache::LoadManifest()
+	{
+		if (!std::filesystem::exists(m_ManifestPath))
+			return;
+
+		BinaryReadStream stream(m_ManifestPath);
+		if (!stream.IsOpen())
+			return;
+
+		char magic[4] = {};
+		uint32 version = 0;
+		uint64 stateSize = 0;
+		stream >> magic >> version >> stateSize;
+
+		// a changed PipelineStateDesc invalidates the recorded states
+		if (memcmp(magic, PSO_MANIFEST_MAGIC, sizeof(char) * 4) != 0 || version != PIPELINE_CACHE_VERSION || stateSize != PSO_STATE_SIZE)
+		{
+			ENGINE_WARN("Pipeline manifest {} is outdated, ignoring it", m_ManifestPath.string());
+			return;
+		}
+
+		std::lock_guard lock(m_ManifestLock);
+
+		uint64 numShaders = 0;
+		stream >> numShaders;
+
+		for (uint64 i = 0; i < numShaders; i++)
+		{
+			uint64 hash = 0;
+			ManifestShader shader{};
+			stream >> hash >> shader.Stage >> shader.Bytecode;
+			stream >> shader.Reflection.Bindings >> shader.Reflection.PushConstantOffset >> shader.Reflection.PushConstantSize;
+
+			m_ManifestShaders.emplace(hash, std::move(shader));
+		}
+
+		stream >> m_ManifestEntries;
+
+		for (const PipelineManifestEntry& entry : m_ManifestEntries)
+			m_ManifestKeys.insert(HashBytes(&entry, sizeof(entry)));
+	}
+
+	void VulkanPipelineCache::SaveManifest()
+	{
+		std::lock_guard lock(m_ManifestLock);
+
+		// swapped in like the cache, a crash while saving keeps the previous manifest
+		std::filesystem::path tempPath = m_ManifestPath;
+		tempPath += ".tmp";
+
+		{
+			BinaryWriteStream stream(tempPath);
+			if (!stream.IsOpen())
+			{
+				ENGINE_WARN("Failed to write pipeline manifest {}", tempPath.string());
+				return;
+			}
+
+			stream << PSO_MANIFEST_MAGIC << PIPELINE_CACHE_VERSION << PSO_STATE_SIZE;
+
+			stream << (uint64)m_ManifestShaders.size();
+			for (auto& [hash, shader] : m_ManifestShaders)
+			{
+				stream << hash << shader.Stage << shader.Bytecode;
+				stream << shader.Reflection.Bindings << shader.Reflection.PushConstantOffset << shader.Reflection.PushConstantSize;
+			}
+
+			stream << m_ManifestEntries;
+		}
+
+		std::error_code error;
+		std::filesystem::rename(tempPath, m_ManifestPath, error);
+		if (error)
+			ENGINE_WARN("Failed to replace pipeline manifest {}: {}", m_ManifestPath.string(), error.message());
+	}
+
+	void VulkanPipelineCache::RecordShader(uint64 hash, VkShaderStageFlags stage, const std::span<const uint8>& bytecode, const ShaderReflection& reflection)
+	{
+		std::lock_guard lock(m_ManifestLock);
+
+		if (!m_ManifestShaders.contains(hash))
+			m_ManifestShaders.emplace(hash, ManifestShader{ stage, std::vector<uint8>(bytecode.begin(), bytecode.end()), reflection });
+	}
+
+	void VulkanPipelineCache::RecordPipeline(const PipelineStateDesc& desc)
+	{
+		// value initialization zeroes the padding too, so equal states hash equal
+		PipelineManifestEntry entry{};
+
+		IRHIShader* shaders[3] = { desc.VertexShader, desc.PixelShader, desc.ComputeShader };
+		for (uint32 i = 0; i < 3; i++)
+			entry.Shaders[i] = shaders[i] ? ((VulkanShader*)shaders[i])->GetBytecodeHash() : 0;
+
+		memcpy(entry.State, (const uint8*)&desc + PSO_STATE_OFFSET, PSO_STATE_SIZE);
+
+		std::lock_guard lock(m_ManifestLock);
+
+		if (m_ManifestKeys.insert(HashBytes(&entry, sizeof(entry))).second)
+			m_ManifestEntries.push_back(entry);
+	}
+
+	uint32 VulkanPipelineCache::GetNumManifestPipelines()
+	{
+		std::lock_guard lock(m_ManifestLock);
+		return (uint32)m_ManifestEntries.size();
+	}
+
+	VkPipelineCache VulkanPipelineCache::AcquireWorkerCache()
+	{
+		{
+			std::lock_guard lock(m_WorkerLock);
+
+			if (!m_FreeWorkerCaches.empty())
+			{
+				VkPipelineCache cache = m_FreeWorkerCaches.back();
+				m_FreeWorkerCaches.pop_back();
+				return cache;
+			}
+		}
+
+		// workers compile into caches of their own so they never contend on the main one
+		VkPipelineCacheCreateInfo info{ .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO };
+
+		VkPipelineCache cache = VK_NULL_HANDLE;
+		VK_CHECK(vkCreatePipelineCache(m_Device->GetDeviceHandle(), &info, nullptr, &cache));
+
+		std::lock_guard lock(m_WorkerLock);
+		m_WorkerCaches.push_back(cache);
+
+		return cache;
+	}
+
+	void VulkanPipelineCache::ReleaseWorkerCache(VkPipelineCache cache)
+	{
+		std::lock_guard lock(m_WorkerLock);
+		m_FreeWorkerCaches.push_back(cache);
+	}
+
+	void VulkanPipelineCache::MergeWorkerCaches()
+	{
+		std::unique_lock cacheLock(m_CacheLock);
+		std::lock_guard lock(m_WorkerLock);
+
+		if (m_WorkerCaches.empty())
+			return;
+
+		VkDevice device = m_Device->GetDeviceHandle();
+		VK_CHECK(vkMergePipelineCaches(device, m_Cache, (uint32)m_WorkerCaches.size(), m_WorkerCaches.data()));
+
+		for (VkPipelineCache cache : m_WorkerCaches)
+			vkDestroyPipelineCache(device, cache, nullptr);
+
+		m_WorkerCaches.clear();
+		m_FreeWorkerCaches.clear();
+	}
+
+	void VulkanPipelineCache::Precompile()
+	{
+		PROFILE_SCOPED;
+
+		// the jobs work on a copy, pipelines created meanwhile keep recording into the manifest
+		struct Snapshot
+		{
+			std::unordered_map<uint64, ManifestShader> Shaders;
+			std::vector<PipelineManifestEntry>         Entries;
+		};
+
+		auto snapshot = std::make_shared<Snapshot>();
+		{
+			std::lock_guard lock(m_ManifestLock);
+			snapshot->Shaders = m_ManifestShaders;
+			snapshot->Entries = m_ManifestEntries;
+		}
+
+		if (snapshot->Entries.empty())
+			return;
+
+		m_PrecompileRemaining += (uint32)snapshot->Entries.size();
+
+		for (uint32 i = 0; i < (uint32)snapshot->Entries.size(); i++)
+		{
+			JobSystem::Execute(m_PrecompileCounter, [this, snapshot, i]() {
+				PROFILE_SCOPED_NAMED("PrecompilePipeline");
+
+				const PipelineManifestEntry& entry = snapshot->Entries[i];
+
+				PipelineStateDesc desc{};
+				memcpy((uint8*)&desc + PSO_STATE_OFFSET, entry.State, PSO_STATE_SIZE);
+
+				TRefCountPtr<VulkanShader> shaders[3];
+				bool complete = true;
+
+				for (uint32 s = 0; s < 3; s++)
+				{
+					if (!entry.Shaders[s])
+						continue;
+
+					auto it = snapshot->Shaders.find(entry.Shaders[s]);
+					if (it == snapshot->Shaders.end())
+					{
+						complete = false;
+						break;
+					}
+
+					std::span<uint8> bytecode((uint8*)it->second.Bytecode.data(), it->second.Bytecode.size());
+					shaders[s] = new VulkanShader(bytecode, it->second.Stage, *m_Device, &it->second.Reflection);
+				}
+
+				if (complete)
+				{
+					desc.VertexShader = shaders[0];
+					desc.PixelShader = shaders[1];
+					desc.ComputeShader = shaders[2];
+
+					// only the cache entry is kept, the pipeline itself goes away right away
+					VkPipelineCache cache = AcquireWorkerCache();
+					TRefCountPtr<VulkanPipelineState> pipeline = new VulkanPipelineState(desc, *m_Device, cache);
+					pipeline = nullptr;
+					ReleaseWorkerCache(cache);
+				}
+
+				if (--m_PrecompileRemaining == 0)
+					MergeWorkerCaches();
+				});
+		}
+	}
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <Backend/Vulkan/VulkanCommon.h>
+#include <Engine/Graphics/Shader.h>
+#include <Engine/Threading/JobSystem.h>
+#include <shared_mutex>
+#include <unordered_set>
+
+namespace Spikey {
+
+	class VulkanDevice;
+
+	constexpr char PIPELINE_CACHE_MAGIC[4] = { 'S', 'P', 'C', 'F' };
+	constexpr char PSO_MANIFEST_MAGIC[4] = { 'S', 'P', 'M', 'F' };
+	constexpr uint32 PIPELINE_CACHE_VERSION = 2;
+
+	// every member after the shaders is a single byte, so the fixed function state is a padding free byte range
+	constexpr uint64 PSO_STATE_OFFSET = offsetof(PipelineStateDesc, DepthEnable);
+	constexpr uint64 PSO_STATE_SIZE = offsetof(PipelineStateDesc, RenderTargets) + sizeof(PipelineStateDesc::RenderTargets) - PSO_STATE_OFFSET;
+
+	// stable across runs, names shaders in the manifest
+	uint64 HashShaderBytecode(const std::span<const uint8>& bytecode);
+
+	struct PipelineCacheFileHeader
+	{
+		char   Magic[4];
+		uint32 Version;
+		uint32 VendorID;
+		uint32 DeviceID;
+		uint32 DriverVersion;
+		uint8  CacheUUID[VK_UUID_SIZE];
+		uint64 DataSize;
+		uint64 DataHash;
+	};
+
+	struct PipelineManifestEntry
+	{
+		uint64 Shaders[3]; // vertex, pixel, compute bytecode hashes, 0 when unused
+		uint8  State[PSO_STATE_SIZE];
+	};
+
+	// VkPipelineCache persisted next to a manifest of every pipeline created. the manifest of the previous
+	// runs is compiled on the job system at startup, so the pipelines the game asks for later are cache hits
+	class VulkanPipelineCache
+	{
+	public:
+		// loads the cache when it was written by the same gpu and driver, starts empty otherwise
+		void Init(VulkanDevice& device, const std::filesystem::path& directory);
+
+		// waits for the precompile jobs, merges the worker caches and writes the cache and manifest back
+		void Shutdown();
+
+		VkPipelineCache GetHandle() const { return m_Cache; }
+
+		// pipeline creation on the main cache, excludes merging worker caches into it
+		std::shared_lock<std::shared_mutex> LockForCreate() { return std::shared_lock(m_CacheLock); }
+
+		void RecordShader(uint64 hash, VkShaderStageFlags stage, const std::span<const uint8>& bytecode, const ShaderReflection& reflection);
+		void RecordPipeline(const PipelineStateDesc& desc);
+
+		// one job per manifest pipeline, each on its own cache merged into the main one when the last finishes.
+		// GetNumPendingPrecompiles tells the loading screen how many are left
+		void   Precompile();
+		uint32 GetNumPendingPrecompiles() const { return m_PrecompileCounter.Pending.load(std::memory_order_relaxed); }
+
+		uint32 GetNumManifestPipelines();
+
+	private:
+		bool LoadCache(std::vector<uint8>& outData);
+		void SaveCache();
+		void LoadManifest();
+		void SaveManifest();
+
+		VkPipelineCache AcquireWorkerCache();
+		void            ReleaseWorkerCache(VkPipelineCache cache);
+		void            MergeWorkerCaches();
+
+	private:
+		VulkanDevice*         m_Device = nullptr;
+		std::filesystem::path m_CachePath;
+		std::filesystem::path m_ManifestPath;
+
+		std::shared_mutex m_CacheLock;
+		VkPipelineCache   m_Cache = VK_NULL_HANDLE;
+
+		std::mutex                   m_WorkerLock;
+		std::vector<VkPipelineCache> m_WorkerCaches;
+		std::vector<VkPipelineCache> m_FreeWorkerCaches;
+		std::atomic<uint32>          m_PrecompileRemaining{ 0 };
+		JobSystem::Counter           m_PrecompileCounter;
+
+		struct ManifestShader
+		{
+			VkShaderStageFlags Stage;
+			std::vector<uint8> Bytecode;
+			ShaderReflection   Reflection;
+		};
+
+		std::mutex                                 m_ManifestLock;
+		std::unordered_map<uint64, ManifestShader> m_ManifestShaders;
+		std::vector<PipelineManifestEntry>         m_ManifestEntries;
+		std::unordered_set<uint64>                 m_ManifestKeys;
+	};
+}
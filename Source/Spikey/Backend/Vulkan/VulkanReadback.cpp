@@ -0,0 +1,173 @@
+#include <Backend/Vulkan/VulkanReadback.h>
+#include <Backend/Vulkan/VulkanBackend.h>
+
+namespace Spikey {
+
+	void VulkanReadbackRing::Init(VulkanDevice& device)
+	{
+		m_Device = &device;
+
+		// copy offsets have to be a multiple of 4 and of the texel size, 16 covers every format
+		m_Alignment = std::max<uint64>(16, device.GetLimits().optimalBufferCopyOffsetAlignment);
+		m_Ring = new VulkanBuffer(VK_READBACK_RING_SIZE, EBufferFlags::ReadBack, device);
+	}
+
+	void VulkanReadbackRing::Shutdown()
+	{
+		if (!m_Device)
+			return;
+
+		// copies of the open frame may be submitted already, it is waited for like the others
+		EndFrame();
+
+		std::lock_guard lock(m_Lock);
+
+		for (Frame& frame : m_InFlight)
+		{
+			for (uint32 i = 0; i < (uint32)ERHIQueue::Count; i++)
+			{
+				m_Device->GetQueue((ERHIQueue)i).Wait(frame.RetireIDs[i], UINT64_MAX);
+			}
+
+			ResolveFrame(frame);
+		}
+		m_InFlight.clear();
+
+		m_Ring = nullptr;
+		m_Device = nullptr;
+	}
+
+	uint64 VulkanReadbackRing::AllocateRing(uint64 size)
+	{
+		if (size > VK_READBACK_RING_SIZE)
+			return VK_READBACK_INVALID_OFFSET;
+
+		uint64 start = (m_Head + m_Alignment - 1) / m_Alignment * m_Alignment;
+		uint64 offset = start % VK_READBACK_RING_SIZE;
+
+		// a copy does not wrap around, the rest of the ring is skipped
+		if (offset + size > VK_READBACK_RING_SIZE)
+		{
+			start += VK_READBACK_RING_SIZE - offset;
+			offset = 0;
+		}
+
+		if (start + size - m_Tail > VK_READBACK_RING_SIZE)
+			return VK_READBACK_INVALID_OFFSET;
+
+		m_Head = start + size;
+		return offset;
+	}
+
+	std::future<std::vector<uint8>> VulkanReadbackRing::AddRequest(uint64 size, RHIBuffer*& outBuffer, uint64& outOffset)
+	{
+		std::lock_guard lock(m_Lock);
+
+		Request& request = m_Current.Requests.emplace_back();
+		request.Size = size;
+		request.Offset = AllocateRing(size);
+
+		if (request.Offset == VK_READBACK_INVALID_OFFSET)
+		{
+			ENGINE_WARN("Readback ring is full, {} bytes get a buffer of their own", size);
+
+			request.Dedicated = new VulkanBuffer(size, EBufferFlags::ReadBack, *m_Device);
+			request.Offset = 0;
+		}
+
+		// the frame is not resolved before the copy is submitted, so the buffer outlives the request
+		outBuffer = request.Dedicated ? request.Dedicated.Get() : m_Ring.Get();
+		outOffset = request.Offset;
+
+		return request.Promise.get_future();
+	}
+
+	std::future<std::vector<uint8>> VulkanReadbackRing::ReadTexture(RHICommandList* cmd, RHITexture* texture, const TextureSlice& slice)
+	{
+		TextureSlice resolved = ResolveTextureSlice(texture->GetDesc(), slice);
+
+		RHIBuffer* dst = nullptr;
+		uint64     offset = 0;
+		std::future<std::vector<uint8>> future = AddRequest(TextureSliceSizeInBytes(texture->GetFormat(), resolved), dst, offset);
+
+		texture->Barrier(cmd, TextureSubresourceSet{ resolved.MipLevel, 1, resolved.ArraySlice, 1 }, ERHIAccess::CopySrc);
+		cmd->CopyTextureToBuffer(texture, resolved, dst, offset);
+
+		return future;
+	}
+
+	std::future<std::vector<uint8>> VulkanReadbackRing::ReadBuffer(RHICommandList* cmd, RHIBuffer* buffer, uint64 offset, uint64 size, ERHIAccess access)
+	{
+		RHIBuffer* dst = nullptr;
+		uint64     dstOffset = 0;
+		std::future<std::vector<uint8>> future = AddRequest(size, dst, dstOffset);
+
+		cmd->BarrierBuffer(buffer, size, offset, access, ERHIAccess::CopySrc);
+		cmd->CopyBuffer(buffer, dst, offset, dstOffset, size);
+		cmd->BarrierBuffer(buffer, size, offset, ERHIAccess::CopySrc, access);
+
+		return future;
+	}
+
+	void VulkanReadbackRing::BeginFrame()
+	{
+		PROFILE_SCOPED;
+
+		std::lock_guard lock(m_Lock);
+
+		while (!m_InFlight.empty() && IsFrameComplete(m_InFlight.front()))
+		{
+			ResolveFrame(m_InFlight.front());
+			m_InFlight.pop_front();
+		}
+	}
+
+	void VulkanReadbackRing::EndFrame()
+	{
+		std::lock_guard lock(m_Lock);
+
+		if (m_Current.Requests.empty())
+			return;
+
+		// a copy may have been recorded to any queue
+		for (uint32 i = 0; i < (uint32)ERHIQueue::Count; i++)
+		{
+			m_Current.RetireIDs[i] = m_Device->GetQueue((ERHIQueue)i).GetLastSubmitID();
+		}
+
+		m_Current.RingEnd = m_Head;
+		m_InFlight.push_back(std::move(m_Current));
+		m_Current = {};
+	}
+
+	bool VulkanReadbackRing::IsFrameComplete(const Frame& frame) const
+	{
+		for (uint32 i = 0; i < (uint32)ERHIQueue::Count; i++)
+		{
+			if (!m_Device->GetQueue((ERHIQueue)i).IsComplete(frame.RetireIDs[i]))
+				return false;
+		}
+
+		return true;
+	}
+
+	void VulkanReadbackRing::ResolveFrame(Frame& frame)
+	{
+		VmaAllocator allocator = m_Device->GetAllocatorHandle();
+
+		for (Request& request : frame.Requests)
+		{
+			VulkanBuffer* buffer = (VulkanBuffer*)(request.Dedicated ? request.Dedicated.Get() : m_Ring.Get());
+
+			// readback memory is not always coherent
+			VK_CHECK(vmaInvalidateAllocation(allocator, buffer->GetAllocationHandle(), request.Offset, request.Size));
+
+			const uint8* data = (const uint8*)buffer->GetMappedData() + request.Offset;
+			request.Promise.set_value(std::vector<uint8>(data, data + request.Size));
+		}
+
+		// frames resolve in order, everything before the end of this one is free
+		m_Tail = frame.RingEnd;
+		frame.Requests.clear();
+	}
+}
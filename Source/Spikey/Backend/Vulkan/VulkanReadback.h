@@ -0,0 +1,72 @@
+#pragma once
+
+#include <Backend/Vulkan/VulkanCommon.h>
+#include <Engine/Graphics/GraphicsCore.h>
+
+namespace Spikey {
+
+	class VulkanDevice;
+
+	// persistently mapped memory the copies of a few frames land in
+	constexpr uint64 VK_READBACK_RING_SIZE = 32ull << 20;
+
+	constexpr uint64 VK_READBACK_INVALID_OFFSET = ~0ull;
+
+	// gpu to cpu copies completing a few frames after they were recorded. the copies go into a ring of ReadBack
+	// memory, the frame they were requested in is stamped with the value every queue signals after its last submit
+	// and its futures are fulfilled once the queues passed it, so nothing waits on the gpu. requests the ring has
+	// no room for get a buffer of their own instead of stalling
+	class VulkanReadbackRing
+	{
+	public:
+		void Init(VulkanDevice& device);
+		void Shutdown();
+
+		// fulfils the requests of the frames the queues finished
+		void BeginFrame();
+
+		// stamps the frame, the lists with its copies have to be submitted by then
+		void EndFrame();
+
+		// records the copy to cmd, the texture is left in CopySrc
+		std::future<std::vector<uint8>> ReadTexture(RHICommandList* cmd, RHITexture* texture, const TextureSlice& slice);
+
+		// records the copy to cmd, the buffer is in access before and after it
+		std::future<std::vector<uint8>> ReadBuffer(RHICommandList* cmd, RHIBuffer* buffer, uint64 offset, uint64 size, ERHIAccess access);
+
+	private:
+		struct Request
+		{
+			std::promise<std::vector<uint8>> Promise;
+			uint64                           Offset; // in the ring, or in Dedicated
+			uint64                           Size;
+			BufferRHIRef                     Dedicated;
+		};
+
+		struct Frame
+		{
+			uint64 RetireIDs[(size_t)ERHIQueue::Count] = {};
+			uint64 RingEnd = 0; // the ring is free up to here once the frame is resolved
+
+			std::vector<Request> Requests;
+		};
+
+		std::future<std::vector<uint8>> AddRequest(uint64 size, RHIBuffer*& outBuffer, uint64& outOffset);
+		uint64 AllocateRing(uint64 size);
+		bool   IsFrameComplete(const Frame& frame) const;
+		void   ResolveFrame(Frame& frame);
+
+	private:
+		VulkanDevice* m_Device = nullptr;
+		BufferRHIRef  m_Ring;
+		uint64        m_Alignment = 16;
+
+		// guarded by m_Lock. head and tail count every byte ever allocated and freed, the ring offset is
+		// head modulo its size
+		std::mutex        m_Lock;
+		uint64            m_Head = 0;
+		uint64            m_Tail = 0;
+		Frame             m_Current;
+		std::deque<Frame> m_InFlight;
+	};
+}
@@ -13,6 +13,9 @@
 #include <stack>
 #include <filesystem>
 #include <type_traits>
+#include <mutex>
+#include <atomic>
+#include <future>
 #include <assert.h>
 #include <Engine/Core/Log.h>
 
@@ -17,6 +17,19 @@ namespace Spikey {
 			}
 		}
 
+		// adds a reference unless the last one is already gone, the destructor may be running then.
+		// for holders of raw pointers that are told about destruction by the destructor
+		bool TryAddRef() const {
+			uint32 count = m_Counter.load();
+			while (count != 0) {
+				if (m_Counter.compare_exchange_weak(count, count + 1)) {
+					return true;
+				}
+			}
+
+			return false;
+		}
+
 		uint32 GetRefCount() const { return m_Counter.load(); }
 	protected:
 		mutable std::atomic<uint32> m_Counter{ 0 };
@@ -28,6 +28,15 @@ namespace Spikey {
 		EBufferFlags  GetUsage() const { return m_Flags; }
 		virtual void* GetMappedData() const = 0;
 
+		// only valid for buffers created with EBufferFlags::GPUAddress
+		virtual uint64 GetGPUAddress() const = 0;
+
+		// storage buffer table index, only valid for buffers created with EBufferFlags::Storage
+		uint32 GetBindlessIndex() const { return m_BindlessIndex; }
+
+	protected:
+		uint32 m_BindlessIndex = BINDLESS_INVALID_INDEX;
+
 	private:
 		uint64       m_Size;
 		EBufferFlags m_Flags;
@@ -0,0 +1,175 @@
+#include <Engine/Graphics/GeometryPool.h>
+#include <Engine/Graphics/GraphicsCore.h>
+#include <Engine/Utils/RangeAllocator.h>
+
+namespace Spikey {
+
+	// frames a freed range stays reserved, matches the number of frames in flight
+	constexpr uint64 GEOMETRY_RETIRE_FRAMES = 2;
+
+	struct GeometryPoolData
+	{
+		BufferRHIRef VertexBuffer;
+		BufferRHIRef IndexBuffer;
+
+		RangeAllocator VertexAllocator;
+		RangeAllocator IndexAllocator;
+
+		std::mutex                                        Mutex;
+		std::deque<std::pair<GeometryAllocation, uint64>> PendingFrees;
+		uint64                                            FrameIndex = 0;
+	};
+
+	static GeometryPoolData* s_Pool = nullptr;
+
+	// an empty range takes no space, it sits at offset 0 and is never handed to the allocator
+	static uint64 AllocateRange(RangeAllocator& allocator, uint32 count)
+	{
+		return count > 0 ? allocator.Allocate(count) : 0;
+	}
+
+	static void FreeRange(RangeAllocator& allocator, uint32 offset, uint32 count)
+	{
+		if (count > 0)
+			allocator.Free(offset);
+	}
+
+	void GeometryPool::Init(const GeometryPoolDesc& desc)
+	{
+		CHECK(!s_Pool);
+		s_Pool = new GeometryPoolData();
+
+		s_Pool->VertexBuffer = Graphics::GetRHI().CreateBuffer((uint64)desc.MaxVertices * sizeof(Vertex),
+			EBufferFlags::Storage | EBufferFlags::GPUAddress);
+		s_Pool->IndexBuffer = Graphics::GetRHI().CreateBuffer((uint64)desc.MaxIndices * sizeof(uint32),
+			EBufferFlags::Index | EBufferFlags::Storage | EBufferFlags::GPUAddress);
+
+		s_Pool->VertexAllocator.Reset(desc.MaxVertices);
+		s_Pool->IndexAllocator.Reset(desc.MaxIndices);
+	}
+
+	void GeometryPool::Shutdown()
+	{
+		delete s_Pool;
+		s_Pool = nullptr;
+	}
+
+	void GeometryPool::Tick()
+	{
+		std::lock_guard lock(s_Pool->Mutex);
+		s_Pool->FrameIndex++;
+
+		while (!s_Pool->PendingFrees.empty())
+		{
+			auto& [alloc, frame] = s_Pool->PendingFrees.front();
+			if (frame + GEOMETRY_RETIRE_FRAMES > s_Pool->FrameIndex)
+				break;
+
+			FreeRange(s_Pool->VertexAllocator, alloc.VertexOffset, alloc.VertexCount);
+			FreeRange(s_Pool->IndexAllocator, alloc.IndexOffset, alloc.IndexCount);
+			s_Pool->PendingFrees.pop_front();
+		}
+	}
+
+	GeometryAllocation GeometryPool::Allocate(uint32 numVertices, uint32 numIndices)
+	{
+		if (numVertices == 0 && numIndices == 0)
+			return {};
+
+		std::lock_guard lock(s_Pool->Mutex);
+
+		uint64 vertexOffset = AllocateRange(s_Pool->VertexAllocator, numVertices);
+		uint64 indexOffset = AllocateRange(s_Pool->IndexAllocator, numIndices);
+
+		if (vertexOffset == RangeAllocator::INVALID_OFFSET || indexOffset == RangeAllocator::INVALID_OFFSET)
+		{
+			ENGINE_ERROR("Geometry pool is out of memory, requested {} vertices and {} indices!", numVertices, numIndices);
+
+			if (vertexOffset != RangeAllocator::INVALID_OFFSET)
+				FreeRange(s_Pool->VertexAllocator, (uint32)vertexOffset, numVertices);
+			if (indexOffset != RangeAllocator::INVALID_OFFSET)
+				FreeRange(s_Pool->IndexAllocator, (uint32)indexOffset, numIndices);
+
+			return {};
+		}
+
+		GeometryAllocation alloc{};
+		alloc.VertexOffset = (uint32)vertexOffset;
+		alloc.VertexCount = numVertices;
+		alloc.IndexOffset = (uint32)indexOffset;
+		alloc.IndexCount = numIndices;
+
+		return alloc;
+	}
+
+	void GeometryPool::Free(const GeometryAllocation& alloc)
+	{
+		if (!alloc.IsValid())
+			return;
+
+		std::lock_guard lock(s_Pool->Mutex);
+		s_Pool->PendingFrees.push_back({ alloc, s_Pool->FrameIndex });
+	}
+
+	void GeometryPool::Upload(const GeometryAllocation& alloc, MeshData&& data)
+	{
+		CHECK(alloc.IsValid() && data.Vertices.size() == alloc.VertexCount && data.Indices.size() == alloc.IndexCount);
+
+		Graphics::SubmitCommand([alloc, dt = std::move(data)]() {
+			const uint64 vertexDataSize = sizeof(Vertex) * dt.Vertices.size();
+			const uint64 indexDataSize = sizeof(uint32) * dt.Indices.size();
+
+			BufferRHIRef staging = Graphics::GetRHI().CreateBuffer(vertexDataSize + indexDataSize, EBufferFlags::Upload);
+
+			memcpy(staging->GetMappedData(), dt.Vertices.data(), vertexDataSize);
+			memcpy((uint8*)staging->GetMappedData() + vertexDataSize, dt.Indices.data(), indexDataSize);
+
+			// copies of zero bytes are not allowed, one of the two ranges may be empty
+			Graphics::GetRHI().ImmediateSubmit([&](RHICommandBuffer* cmd) {
+				if (vertexDataSize > 0)
+				{
+					Graphics::GetRHI().CopyBuffer(cmd, staging, s_Pool->VertexBuffer, 0,
+						(uint64)alloc.VertexOffset * sizeof(Vertex), vertexDataSize);
+				}
+				if (indexDataSize > 0)
+				{
+					Graphics::GetRHI().CopyBuffer(cmd, staging, s_Pool->IndexBuffer, vertexDataSize,
+						(uint64)alloc.IndexOffset * sizeof(uint32), indexDataSize);
+				}
+				});
+			});
+	}
+
+	RHIBuffer* GeometryPool::GetVertexBuffer()
+	{
+		return s_Pool->VertexBuffer;
+	}
+
+	RHIBuffer* GeometryPool::GetIndexBuffer()
+	{
+		return s_Pool->IndexBuffer;
+	}
+
+	uint64 GeometryPool::GetVertexAddress(const GeometryAllocation& alloc)
+	{
+		return s_Pool->VertexBuffer->GetGPUAddress() + (uint64)alloc.VertexOffset * sizeof(Vertex);
+	}
+
+	uint64 GeometryPool::GetIndexAddress(const GeometryAllocation& alloc)
+	{
+		return s_Pool->IndexBuffer->GetGPUAddress() + (uint64)alloc.IndexOffset * sizeof(uint32);
+	}
+
+	GeometryPool::Stats GeometryPool::GetStats()
+	{
+		std::lock_guard lock(s_Pool->Mutex);
+
+		Stats stats{};
+		stats.UsedVertices = s_Pool->VertexAllocator.GetUsedSize();
+		stats.UsedIndices = s_Pool->IndexAllocator.GetUsedSize();
+		stats.NumVertexFreeBlocks = s_Pool->VertexAllocator.GetNumFreeBlocks();
+		stats.NumIndexFreeBlocks = s_Pool->IndexAllocator.GetNumFreeBlocks();
+
+		return stats;
+	}
+}
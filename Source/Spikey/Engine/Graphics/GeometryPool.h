@@ -0,0 +1,58 @@
+#pragma once
+#include <Engine/Graphics/Buffer.h>
+
+namespace Spikey {
+
+	struct MeshData;
+
+	// offsets are in elements (vertices / indices), not bytes
+	struct GeometryAllocation
+	{
+		uint32 VertexOffset = ~0u;
+		uint32 VertexCount = 0;
+		uint32 IndexOffset = ~0u;
+		uint32 IndexCount = 0;
+
+		bool IsValid() const { return VertexOffset != ~0u && IndexOffset != ~0u; }
+	};
+
+	struct GeometryPoolDesc
+	{
+		uint32 MaxVertices = 1u << 22;
+		uint32 MaxIndices = 1u << 24;
+	};
+
+	// global pool of device local vertex and index data, every mesh gets a sub range of the two
+	// buffers, so draws can share one binding and pull vertices through the buffer address.
+	// indices stay relative to the mesh, use VertexOffset as the draw vertex offset
+	class GeometryPool
+	{
+	public:
+		static void Init(const GeometryPoolDesc& desc = {});
+		static void Shutdown();
+
+		// releases ranges freed enough frames ago to be no longer used by the gpu
+		static void Tick();
+
+		static GeometryAllocation Allocate(uint32 numVertices, uint32 numIndices);
+		static void               Free(const GeometryAllocation& alloc);
+		static void               Upload(const GeometryAllocation& alloc, MeshData&& data);
+
+		static RHIBuffer* GetVertexBuffer();
+		static RHIBuffer* GetIndexBuffer();
+
+		// gpu address of the first vertex of the allocation
+		static uint64 GetVertexAddress(const GeometryAllocation& alloc);
+		static uint64 GetIndexAddress(const GeometryAllocation& alloc);
+
+		struct Stats
+		{
+			uint64 UsedVertices;
+			uint64 UsedIndices;
+			uint32 NumVertexFreeBlocks;
+			uint32 NumIndexFreeBlocks;
+		};
+
+		static Stats GetStats();
+	};
+}
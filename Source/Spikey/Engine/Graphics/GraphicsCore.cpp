@@ -0,0 +1,110 @@
+#include <Engine/Graphics/GraphicsCore.h>
+#include <Engine/Graphics/GeometryPool.h>
+#include <Engine/Graphics/TextureStreamer.h>
+#include <Engine/Threading/JobSystem.h>
+#include <cstdarg>
+
+namespace Spikey {
+
+	static IRHIDevice* s_RHI = nullptr;
+
+	void Graphics::Init(IRHIDevice* device)
+	{
+		CHECK(!s_RHI && device);
+		s_RHI = device;
+
+		// async pipeline compiles and streaming run on the workers, without them every job runs inline
+		JobSystem::Init();
+
+		// pipelines of the previous run compile while the rest of the engine loads
+		s_RHI->PrecompilePipelines();
+
+		GeometryPool::Init();
+		TextureStreamer::Init();
+	}
+
+	void Graphics::Shutdown()
+	{
+		if (!s_RHI)
+			return;
+
+		// the pools drop their last references here, the device releases them on destruction
+		TextureStreamer::Shutdown();
+		GeometryPool::Shutdown();
+
+		delete s_RHI;
+		s_RHI = nullptr;
+
+		// after the device, which waits for the compiles it still has in flight
+		JobSystem::Shutdown();
+	}
+
+	void Graphics::Tick()
+	{
+		PROFILE_SCOPED;
+
+		GeometryPool::Tick();
+		TextureStreamer::Tick();
+	}
+
+	IRHIDevice& Graphics::GetRHI()
+	{
+		CHECK(s_RHI);
+		return *s_RHI;
+	}
+
+	static void AppendLine(std::string& out, const char* format, ...)
+	{
+		char line[256];
+
+		va_list args;
+		va_start(args, format);
+		vsnprintf(line, sizeof(line), format, args);
+		va_end(args);
+
+		out += line;
+		out += '\n';
+	}
+
+	static void FormatStatistic(char (&out)[24], uint64 value)
+	{
+		if (value == GPU_STATISTIC_UNAVAILABLE)
+			snprintf(out, sizeof(out), "-");
+		else
+			snprintf(out, sizeof(out), "%llu", (unsigned long long)value);
+	}
+
+	std::string FormatGPUFrameReport(const GPUFrameTimings& timings, const GPUPassStatisticsFrame& statistics)
+	{
+		std::string report;
+
+		AppendLine(report, "gpu frame %llu: %.3f ms, %u zones (%u dropped)", (unsigned long long)timings.FrameIndex, timings.TotalMs,
+			(uint32)timings.Zones.size(), timings.DroppedZones);
+
+		for (const GPUZoneTiming& zone : timings.Zones)
+		{
+			AppendLine(report, "  %*s%-32s %8.3f ms  @ %.3f ms", zone.Depth * 2, "", zone.Name, zone.DurationMs, zone.BeginMs);
+		}
+
+		if (statistics.Passes.empty())
+			return report;
+
+		AppendLine(report, "pass statistics of frame %llu (%u dropped)", (unsigned long long)statistics.FrameIndex, statistics.DroppedPasses);
+		AppendLine(report, "  %-32s %12s %12s %12s %12s %10s %12s %12s", "pass", "vertices", "primitives", "rasterized", "fragments",
+			"frag/prim", "compute", "samples");
+
+		for (const GPUPassStatistics& pass : statistics.Passes)
+		{
+			char samples[24];
+			FormatStatistic(samples, pass.SamplesPassed);
+
+			double fragmentsPerPrimitive = pass.RasterizedPrimitives > 0 ? (double)pass.FragmentInvocations / (double)pass.RasterizedPrimitives : 0.0;
+
+			AppendLine(report, "  %-32s %12llu %12llu %12llu %12llu %10.1f %12llu %12s", pass.Name,
+				(unsigned long long)pass.InputVertices, (unsigned long long)pass.InputPrimitives, (unsigned long long)pass.RasterizedPrimitives,
+				(unsigned long long)pass.FragmentInvocations, fragmentsPerPrimitive, (unsigned long long)pass.ComputeInvocations, samples);
+		}
+
+		return report;
+	}
+}
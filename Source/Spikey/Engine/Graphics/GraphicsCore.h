@@ -18,6 +18,15 @@ namespace Spikey {
 		Count
 	};
 
+	// value the timeline of a queue reaches once a submission finished
+	struct SyncPoint
+	{
+		ERHIQueue Queue = ERHIQueue::Count;
+		uint64    Value = 0;
+
+		bool IsValid() const { return Queue != ERHIQueue::Count; }
+	};
+
 	struct TextureCopyRegion
 	{
 		uint32 BaseArrayLayer;
@@ -34,14 +43,6 @@ namespace Spikey {
 		uint32 NumLayers;
 	};
 
-	struct TextureBarrierRegion
-	{
-		SubresourceRange Range;
-		EGPUAccess LastAccess;
-		EGPUAccess NewAccess;
-		bool EntireTexture;
-	};
-
 	struct RenderInfo
 	{
 		std::vector<IRHITextureView*> ColorTargets;
@@ -71,6 +72,81 @@ namespace Spikey {
 		std::vector<DrawList> CmdLists;
 	};
 
+	struct CommandListStats
+	{
+		uint32 BarriersRequested; // regions passed to BarrierTexture / BarrierBuffer calls
+		uint32 BarriersEmitted;   // barriers left after merging and dropping redundant ones
+		uint32 BarrierBatches;    // pipeline barrier commands recorded
+	};
+
+	struct PipelineStateCacheStats
+	{
+		uint64 Hits;
+		uint64 Misses;       // pipelines created
+		uint32 NumPipelines; // currently cached
+
+		uint32 PendingCompiles;
+		uint64 AsyncCompiles;
+		float  AvgCompileMs; // request to ready, includes time queued
+		float  MaxCompileMs;
+		uint64 FallbackDraws;
+		uint64 SkippedDraws; // not ready without a fallback set
+	};
+
+	// laid out like tracy::SourceLocationData, so zones reach tracy without a copy
+	struct GPUZoneSource
+	{
+		const char* Name;
+		const char* Function;
+		const char* File;
+		uint32      Line;
+		uint32      Color;
+	};
+
+	struct GPUZoneTiming
+	{
+		const char* Name;
+		uint32      Depth;   // zones open around it in the same command list
+		float       BeginMs; // from the start of the first zone of the frame
+		float       DurationMs;
+	};
+
+	struct GPUFrameTimings
+	{
+		uint64 FrameIndex;
+		float  TotalMs;    // first zone begin to last zone end
+		int64  CpuBeginNs; // steady_clock time the first zone began, 0 without calibrated timestamps
+		uint32 DroppedZones;
+
+		std::vector<GPUZoneTiming> Zones; // in the order they were recorded
+	};
+
+	constexpr uint64 GPU_STATISTIC_UNAVAILABLE = ~0ull;
+
+	// a pass with many fragments per primitive is shading bound, one with few is limited by geometry
+	struct GPUPassStatistics
+	{
+		const char* Name;
+		uint64      InputVertices;
+		uint64      InputPrimitives;
+		uint64      VertexInvocations;
+		uint64      RasterizedPrimitives; // left after clipping and culling
+		uint64      FragmentInvocations;
+		uint64      ComputeInvocations;
+		uint64      SamplesPassed;        // depth and stencil test, GPU_STATISTIC_UNAVAILABLE without precise occlusion queries
+	};
+
+	struct GPUPassStatisticsFrame
+	{
+		uint64 FrameIndex;
+		uint32 DroppedPasses;
+
+		std::vector<GPUPassStatistics> Passes; // in the order they were recorded
+	};
+
+	// one line per zone and per pass, for logs and the console
+	std::string FormatGPUFrameReport(const GPUFrameTimings& timings, const GPUPassStatisticsFrame& statistics);
+
 	class RHICommandList
 	{
 	public:
@@ -78,15 +154,33 @@ namespace Spikey {
 		virtual void* GetNative() const = 0;
 
 		virtual void CopyTexture(RHITexture* src, const TextureSlice& srcSlice, RHITexture* dst, const TextureSlice& dstSlice) = 0;
+
+		// rows are tightly packed, TextureSliceSizeInBytes gives the bytes written. a ReadBack destination is
+		// visible to the host once the list finished
+		virtual void CopyTextureToBuffer(RHITexture* src, const TextureSlice& srcSlice, RHIBuffer* dst, uint64 dstOffset) = 0;
+
+		// barriers are queued and recorded as one batch by FlushBarriers, which every draw, dispatch and copy
+		// calls first. call it directly only before handing the command list to code outside the rhi
 		virtual void FlushBarriers() = 0;
 
+		// timestamps around the commands recorded in between, see PROFILE_GPU_SCOPED
+		virtual void BeginGPUZone(const GPUZoneSource* source) = 0;
+		virtual void EndGPUZone() = 0;
+
+		// pipeline statistics and samples passed of the commands recorded in between, see PROFILE_GPU_PASS.
+		// passes do not nest, only the graphics queue counts them
+		virtual void BeginPassStatistics(const char* name) = 0;
+		virtual void EndPassStatistics() = 0;
+
+		const CommandListStats& GetStats() const { return m_Stats; }
+		void                    ResetStats() { m_Stats = {}; }
+
 		//virtual void MipMapTexture2D(RHITexture* tex, uint32 numMips) = 0;
 		//virtual void CopyTexture(RHITexture* src, const TextureCopyRegion& srcRegion, RHITexture* dst, const TextureCopyRegion& dstRegion, Vec2Uint copySize) = 0;
 		//virtual void ClearTexture(RHITexture* tex, const SubresourceRange& range, const Vec4& color) = 0;
-		//virtual void CopyTextureData(RHITexture* src, const SubresourceCopyRegion& region, RHIBuffer* dst) = 0;
-		//virtual void BarrierTexture(RHITexture* texture, const TextureBarrierRegion* regions, uint32 numRegions) = 0;
-		//virtual void CopyBuffer(RHIBuffer* srcBuffer, RHIBuffer* dstBuffer, uint64 srcOffset, uint64 dstOffset, uint64 size) = 0;
-		//virtual void BarrierBuffer(RHIBuffer* buffer, uint64 size, uint64 offset, EGPUAccess lastAccess, EGPUAccess newAccess) = 0;
+		virtual void BarrierTexture(RHITexture* texture, const TextureBarrierRegion* regions, uint32 numRegions) = 0;
+		virtual void CopyBuffer(RHIBuffer* srcBuffer, RHIBuffer* dstBuffer, uint64 srcOffset, uint64 dstOffset, uint64 size) = 0;
+		virtual void BarrierBuffer(RHIBuffer* buffer, uint64 size, uint64 offset, ERHIAccess lastAccess, ERHIAccess newAccess) = 0;
 		//virtual void FillBuffer(RHIBuffer* buffer, uint64 size, uint64 offset, uint32 value) = 0;
 		// virtual void BindShader(RHIShader* shader, std::vector<RHIBindingSet*> shaderSets = {}, void* pushData = nullptr) = 0;
 		// virtual void DispatchCompute(uint32 groupCountX, uint32 groupCountY, uint32 groupCountZ) = 0;
@@ -97,8 +191,66 @@ namespace Spikey {
 		//virtual void BindTextureUAV() = 0;
 		//virtual void BindBuffer() = 0;
 		//virtual void BindSamplerState() = 0;
+
+	protected:
+		CommandListStats m_Stats = {};
+	};
+
+	class GPUZoneScope
+	{
+	public:
+		GPUZoneScope(RHICommandList* cmd, const GPUZoneSource* source)
+			: m_Cmd(cmd)
+		{
+			m_Cmd->BeginGPUZone(source);
+		}
+
+		~GPUZoneScope()
+		{
+			m_Cmd->EndGPUZone();
+		}
+
+	private:
+		RHICommandList* m_Cmd;
 	};
 
+	class GPUPassStatisticsScope
+	{
+	public:
+		GPUPassStatisticsScope(RHICommandList* cmd, const char* name)
+			: m_Cmd(cmd)
+		{
+			m_Cmd->BeginPassStatistics(name);
+		}
+
+		~GPUPassStatisticsScope()
+		{
+			m_Cmd->EndPassStatistics();
+		}
+
+	private:
+		RHICommandList* m_Cmd;
+	};
+
+#define PROFILE_GPU_CONCAT_IMPL(a, b) a##b
+#define PROFILE_GPU_CONCAT(a, b) PROFILE_GPU_CONCAT_IMPL(a, b)
+
+	// gpu counterpart of PROFILE_SCOPED_NAMED, times the commands recorded to cmd until the end of the scope.
+	// results arrive a few frames later in tracy and IRHIDevice::GetGPUFrameTimings
+#define PROFILE_GPU_SCOPED(cmd, name) \
+	static constexpr GPUZoneSource PROFILE_GPU_CONCAT(__gpuZoneSource, __LINE__){ name, __FUNCTION__, __FILE__, (uint32)__LINE__, 0 }; \
+	GPUZoneScope PROFILE_GPU_CONCAT(__gpuZoneScope, __LINE__)(cmd, &PROFILE_GPU_CONCAT(__gpuZoneSource, __LINE__))
+
+	// PROFILE_GPU_SCOPED that also counts the pipeline statistics of the pass
+#define PROFILE_GPU_PASS(cmd, name) \
+	PROFILE_GPU_SCOPED(cmd, name); \
+	GPUPassStatisticsScope PROFILE_GPU_CONCAT(__gpuPassScope, __LINE__)(cmd, name)
+
+	// threading: creating resources, shaders, samplers and pipelines and dropping the last reference to any of
+	// them is safe from every thread, loaders call them directly. destruction is deferred until the queues
+	// finished the work submitted before it. a command list is recorded by one thread at a time, and a resource
+	// created on one thread is only seen by another after the two synchronized. frame functions
+	// belong to the thread running the frame
 	class IRHIDevice {
 	public:
 		virtual ~IRHIDevice() = default;
@@ -110,13 +262,45 @@ namespace Spikey {
 		virtual TextureRHIRef CreateTexture(const TextureDesc& desc) = 0;
 		virtual TextureCubeRHIRef CreateTextureCube(uint32 size, uint32 numMips, ETextureFormat format, ETextureUsage usage) = 0;
 		virtual TextureViewRHIRef CreateTextureView(uint32 baseMip, uint32 numMips, uint32 baseLayer, uint32 numLayers, IRHITexture* tex) = 0;
-		virtual BufferRHIRef CreateBuffer(uint64 size, EBufferUsage usage) = 0;
+		virtual BufferRHIRef CreateBuffer(uint64 size, EBufferFlags flags) = 0;
 		virtual SamplerStateRHIRef CreateSamplerState(const SamplerStateDesc& desc) = 0;
 
-		virtual ShaderRHIRef CreateVertexShader(const std::span<uint8>& bytecode) = 0;
-		virtual ShaderRHIRef CreatePixelShader(const std::span<uint8>& bytecode) = 0;
-		virtual ShaderRHIRef CreateComputeShader(const std::span<uint8>& bytecode) = 0;
+		// reflection read from the SCSF file, the bytecode is reflected when it is nullptr
+		virtual ShaderRHIRef CreateVertexShader(const std::span<uint8>& bytecode, const ShaderReflection* reflection = nullptr) = 0;
+		virtual ShaderRHIRef CreatePixelShader(const std::span<uint8>& bytecode, const ShaderReflection* reflection = nullptr) = 0;
+		virtual ShaderRHIRef CreateComputeShader(const std::span<uint8>& bytecode, const ShaderReflection* reflection = nullptr) = 0;
+		// identical descriptors return the same pipeline, see PipelineStateDesc::operator==
 		virtual PipelineStateRHIRef CreatePipelineState(const PipelineStateDesc& desc) = 0;
+		virtual PipelineStateCacheStats GetPipelineStateCacheStats() const = 0;
+
+		// returns at once, the pipeline compiles on the job system and is not IsReady until it finishes
+		virtual PipelineStateRHIRef CreatePipelineStateAsync(const PipelineStateDesc& desc) = 0;
+
+		// drawn instead of pipelines still compiling, nullptr skips those draws
+		virtual void SetFallbackPipelineState(RHIPipelineState* pipeline) = 0;
+
+		// the pipeline to draw with this frame, nullptr when the draw has to be skipped. materials keep their
+		// real pipeline and resolve it per draw, so they switch over as soon as it is ready
+		virtual RHIPipelineState* ResolvePipelineState(RHIPipelineState* pipeline) = 0;
+
+		// compiles the pipelines earlier runs created on the job system, the loading screen waits for the
+		// pending count to reach zero
+		virtual void   PrecompilePipelines() = 0;
+		virtual uint32 GetNumPendingPipelinePrecompiles() const = 0;
+
+		// last frame whose timestamps were read back, zones of that queue only
+		virtual GPUFrameTimings GetGPUFrameTimings(ERHIQueue queue = ERHIQueue::Graphics) const = 0;
+		virtual GPUPassStatisticsFrame GetGPUPassStatistics() const = 0;
+
+		// copies one slice to the cpu and waits for it, for tests and tools rendering offscreen. rows are tightly
+		// packed and the texture is left in CopySrc
+		virtual void ReadTexture(RHITexture* texture, const TextureSlice& slice, std::vector<uint8>& outData) = 0;
+
+		// copies recorded to cmd that arrive a few frames later, once the queues passed the frame. the futures are
+		// fulfilled by the frame loop, so waiting on one from the thread running it never returns
+		virtual std::future<std::vector<uint8>> ReadTextureAsync(RHICommandList* cmd, RHITexture* texture, const TextureSlice& slice) = 0;
+		virtual std::future<std::vector<uint8>> ReadBufferAsync(RHICommandList* cmd, RHIBuffer* buffer, uint64 offset, uint64 size,
+			ERHIAccess access) = 0;
 
 		virtual RHICommandList* BeginCommandList() = 0;
 		virtual void SubmitCommandList(RHICommandList* cmd) = 0;
@@ -158,8 +342,11 @@ namespace Spikey {
 
 	class Graphics {
 	public:
-		static void Init();
+		// takes ownership of the device, it is deleted by Shutdown after the pools using it. starts the job
+		// system and stops it again once the device is gone
+		static void Init(IRHIDevice* device);
 		static void Shutdown();
+		// once per frame, retires what the pools freed and resolves streaming requests
 		static void Tick();
 		//void SubmitCommand(std::function<void()>&& command);
 		//void SubmitResourceChange(std::function<void()>&& command);
@@ -0,0 +1,468 @@
+#include <Engine/Graphics/IBLProcessor.h>
+#include <Engine/Graphics/MipGenerator.h>
+#include <Engine/Graphics/Texture.h>
+#include <Engine/Serialization/BinaryStream.h>
+#include <Engine/Threading/JobSystem.h>
+#include <Engine/Utils/Hash.h>
+#include <immintrin.h>
+
+namespace Spikey {
+
+	// real sh basis constants
+	static constexpr float32 SH_Y0 = 0.282095f;
+	static constexpr float32 SH_Y1 = 0.488603f;
+	static constexpr float32 SH_Y2 = 1.092548f;
+	static constexpr float32 SH_Y20 = 0.315392f;
+	static constexpr float32 SH_Y22 = 0.546274f;
+
+	Vec3 SHIrradiance::Evaluate(const Vec3& n) const
+	{
+		Vec3 result = Coefficients[0] * SH_Y0;
+		result += Coefficients[1] * (SH_Y1 * n.y);
+		result += Coefficients[2] * (SH_Y1 * n.z);
+		result += Coefficients[3] * (SH_Y1 * n.x);
+		result += Coefficients[4] * (SH_Y2 * n.x * n.y);
+		result += Coefficients[5] * (SH_Y2 * n.y * n.z);
+		result += Coefficients[6] * (SH_Y20 * (3.f * n.z * n.z - 1.f));
+		result += Coefficients[7] * (SH_Y2 * n.x * n.z);
+		result += Coefficients[8] * (SH_Y22 * (n.x * n.x - n.y * n.y));
+
+		return glm::max(result, Vec3(0.f));
+	}
+
+	// per row partial sums, reduced in a fixed order so results do not depend on thread timing
+	struct SHRowSum
+	{
+		float32 Coefficients[9][3] = {};
+		float32 Weight = 0.f;
+	};
+
+	// face directions of four texels of a row, see CubeTexelToDirection
+	static void GetFaceDirections(uint32 face, __m128 s, __m128 t, __m128& x, __m128& y, __m128& z)
+	{
+		__m128 one = _mm_set1_ps(1.f);
+		__m128 zero = _mm_setzero_ps();
+
+		switch (face)
+		{
+		case 0:  x = one;                  y = _mm_sub_ps(zero, t); z = _mm_sub_ps(zero, s); break;
+		case 1:  x = _mm_sub_ps(zero, one); y = _mm_sub_ps(zero, t); z = s;                  break;
+		case 2:  x = s;                    y = one;                 z = t;                  break;
+		case 3:  x = s;                    y = _mm_sub_ps(zero, one); z = _mm_sub_ps(zero, t); break;
+		case 4:  x = s;                    y = _mm_sub_ps(zero, t); z = one;                break;
+		default: x = _mm_sub_ps(zero, s); y = _mm_sub_ps(zero, t); z = _mm_sub_ps(zero, one); break;
+		}
+	}
+
+	static void ProjectRow(const float32* faces, uint32 size, uint32 face, uint32 y, SHRowSum& out)
+	{
+		const float32* row = faces + (((uint64)face * size + y) * size) * 4;
+		float32 texelArea = (2.f / size) * (2.f / size);
+		float32 t = (2.f * y + 1.f) / size - 1.f;
+
+		__m128 acc[9][3];
+		for (uint32 i = 0; i < 9; i++)
+			acc[i][0] = acc[i][1] = acc[i][2] = _mm_setzero_ps();
+		__m128 weightSum = _mm_setzero_ps();
+
+		for (uint32 x = 0; x < size; x += 4)
+		{
+			uint32 count = std::min(4u, size - x);
+
+			alignas(16) float32 texels[4][4] = {};
+			alignas(16) float32 lanes[4] = {};
+			for (uint32 i = 0; i < count; i++)
+			{
+				memcpy(texels[i], row + (uint64)(x + i) * 4, sizeof(float32) * 4);
+				lanes[i] = 1.f;
+			}
+
+			__m128 r = _mm_load_ps(texels[0]);
+			__m128 g = _mm_load_ps(texels[1]);
+			__m128 b = _mm_load_ps(texels[2]);
+			__m128 a = _mm_load_ps(texels[3]);
+			_MM_TRANSPOSE4_PS(r, g, b, a);
+
+			__m128 s = _mm_sub_ps(_mm_div_ps(_mm_add_ps(_mm_set_ps(x + 3.f, x + 2.f, x + 1.f, (float32)x), _mm_set1_ps(0.5f)),
+				_mm_set1_ps(size * 0.5f)), _mm_set1_ps(1.f));
+			__m128 tv = _mm_set1_ps(t);
+
+			__m128 dx, dy, dz;
+			GetFaceDirections(face, s, tv, dx, dy, dz);
+
+			// solid angle of a cube texel is area / (1 + s^2 + t^2)^(3/2)
+			__m128 lenSq = _mm_add_ps(_mm_set1_ps(1.f), _mm_add_ps(_mm_mul_ps(s, s), _mm_mul_ps(tv, tv)));
+			__m128 invLen = _mm_div_ps(_mm_set1_ps(1.f), _mm_sqrt_ps(lenSq));
+			__m128 weight = _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(invLen, invLen), invLen), _mm_set1_ps(texelArea));
+			weight = _mm_mul_ps(weight, _mm_load_ps(lanes));
+
+			dx = _mm_mul_ps(dx, invLen);
+			dy = _mm_mul_ps(dy, invLen);
+			dz = _mm_mul_ps(dz, invLen);
+
+			__m128 basis[9];
+			basis[0] = _mm_set1_ps(SH_Y0);
+			basis[1] = _mm_mul_ps(_mm_set1_ps(SH_Y1), dy);
+			basis[2] = _mm_mul_ps(_mm_set1_ps(SH_Y1), dz);
+			basis[3] = _mm_mul_ps(_mm_set1_ps(SH_Y1), dx);
+			basis[4] = _mm_mul_ps(_mm_set1_ps(SH_Y2), _mm_mul_ps(dx, dy));
+			basis[5] = _mm_mul_ps(_mm_set1_ps(SH_Y2), _mm_mul_ps(dy, dz));
+			basis[6] = _mm_mul_ps(_mm_set1_ps(SH_Y20), _mm_sub_ps(_mm_mul_ps(_mm_set1_ps(3.f), _mm_mul_ps(dz, dz)), _mm_set1_ps(1.f)));
+			basis[7] = _mm_mul_ps(_mm_set1_ps(SH_Y2), _mm_mul_ps(dx, dz));
+			basis[8] = _mm_mul_ps(_mm_set1_ps(SH_Y22), _mm_sub_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)));
+
+			__m128 wr = _mm_mul_ps(r, weight);
+			__m128 wg = _mm_mul_ps(g, weight);
+			__m128 wb = _mm_mul_ps(b, weight);
+
+			for (uint32 i = 0; i < 9; i++)
+			{
+				acc[i][0] = _mm_add_ps(acc[i][0], _mm_mul_ps(basis[i], wr));
+				acc[i][1] = _mm_add_ps(acc[i][1], _mm_mul_ps(basis[i], wg));
+				acc[i][2] = _mm_add_ps(acc[i][2], _mm_mul_ps(basis[i], wb));
+			}
+			weightSum = _mm_add_ps(weightSum, weight);
+		}
+
+		alignas(16) float32 lanes[4];
+		for (uint32 i = 0; i < 9; i++)
+		{
+			for (uint32 c = 0; c < 3; c++)
+			{
+				_mm_store_ps(lanes, acc[i][c]);
+				out.Coefficients[i][c] = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+			}
+		}
+
+		_mm_store_ps(lanes, weightSum);
+		out.Weight = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+	}
+
+	SHIrradiance IBLProcessor::ComputeIrradiance(const float32* faces, uint32 size)
+	{
+		PROFILE_SCOPED;
+
+		std::vector<SHRowSum> rows((uint64)size * 6);
+
+		JobSystem::ParallelFor(size * 6, 16, [&](uint32 begin, uint32 end) {
+			for (uint32 row = begin; row < end; row++)
+				ProjectRow(faces, size, row / size, row % size, rows[row]);
+			});
+
+		float64 sums[9][3] = {};
+		float64 totalWeight = 0.0;
+		for (const SHRowSum& row : rows)
+		{
+			for (uint32 i = 0; i < 9; i++)
+			{
+				for (uint32 c = 0; c < 3; c++)
+					sums[i][c] += row.Coefficients[i][c];
+			}
+			totalWeight += row.Weight;
+		}
+
+		// renormalize the discrete solid angles to the full sphere, then convolve with the clamped cosine
+		static constexpr float64 bandScale[9] = {
+			glm::pi<float64>(),
+			glm::pi<float64>() * 2.0 / 3.0, glm::pi<float64>() * 2.0 / 3.0, glm::pi<float64>() * 2.0 / 3.0,
+			glm::pi<float64>() / 4.0, glm::pi<float64>() / 4.0, glm::pi<float64>() / 4.0, glm::pi<float64>() / 4.0, glm::pi<float64>() / 4.0 };
+
+		float64 norm = 4.0 * glm::pi<float64>() / totalWeight;
+
+		SHIrradiance result{};
+		for (uint32 i = 0; i < 9; i++)
+		{
+			for (uint32 c = 0; c < 3; c++)
+				result.Coefficients[i][c] = (float32)(sums[i][c] * norm * bandScale[i]);
+		}
+
+		return result;
+	}
+
+	// ggx samples around +z, shared by every texel of a mip. padded to a multiple of four with zero weights
+	struct GGXSampleSet
+	{
+		std::vector<float32> X;
+		std::vector<float32> Y;
+		std::vector<float32> Z;
+		std::vector<float32> Weight;
+		std::vector<uint32>  Lod;
+		float32              TotalWeight = 0.f;
+	};
+
+	static Vec2 Hammersley(uint32 i, uint32 count)
+	{
+		uint32 bits = i;
+		bits = (bits << 16u) | (bits >> 16u);
+		bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+		bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+		bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+		bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+
+		return Vec2((float32)i / (float32)count, (float32)bits * 2.3283064365386963e-10f);
+	}
+
+	static void BuildGGXSamples(float32 roughness, uint32 numSamples, uint32 sourceSize, uint32 numSourceMips, GGXSampleSet& out)
+	{
+		float32 alpha = roughness * roughness;
+		float32 alphaSq = alpha * alpha;
+
+		// solid angle of a texel of the top source mip, samples with a larger footprint read lower mips
+		float32 texelSolidAngle = 4.f * glm::pi<float32>() / (6.f * sourceSize * sourceSize);
+
+		for (uint32 i = 0; i < numSamples; i++)
+		{
+			Vec2 xi = Hammersley(i, numSamples);
+
+			float32 phi = 2.f * glm::pi<float32>() * xi.x;
+			float32 cosTheta = std::sqrt((1.f - xi.y) / (1.f + (alphaSq - 1.f) * xi.y));
+			float32 sinTheta = std::sqrt(1.f - cosTheta * cosTheta);
+
+			Vec3 h(sinTheta * std::cos(phi), sinTheta * std::sin(phi), cosTheta);
+
+			// view equals normal, so the light direction is the view reflected around h
+			Vec3 l = 2.f * cosTheta * h - Vec3(0.f, 0.f, 1.f);
+			if (l.z <= 0.f)
+				continue;
+
+			float32 denom = cosTheta * cosTheta * (alphaSq - 1.f) + 1.f;
+			float32 pdf = alphaSq / (glm::pi<float32>() * denom * denom) * 0.25f;
+			float32 sampleSolidAngle = 1.f / (numSamples * pdf + 1e-6f);
+			float32 lod = std::max(0.5f * std::log2(sampleSolidAngle / texelSolidAngle) + 1.f, 0.f);
+
+			out.X.push_back(l.x);
+			out.Y.push_back(l.y);
+			out.Z.push_back(l.z);
+			out.Weight.push_back(l.z);
+			out.Lod.push_back(std::min((uint32)(lod + 0.5f), numSourceMips - 1));
+			out.TotalWeight += l.z;
+		}
+
+		while (out.X.size() % 4 != 0)
+		{
+			out.X.push_back(0.f);
+			out.Y.push_back(0.f);
+			out.Z.push_back(1.f);
+			out.Weight.push_back(0.f);
+			out.Lod.push_back(0);
+		}
+	}
+
+	struct SourceChain
+	{
+		std::vector<float32> Texels; // mip after mip, six faces per mip
+		std::vector<uint64>  MipOffsets;
+		uint32               Size;
+
+		Vec3 Fetch(const Vec3& dir, uint32 mip) const
+		{
+			uint32 mipSize = std::max(1u, Size >> mip);
+			uint32 face, x, y;
+			DirectionToCubeTexel(dir, mipSize, face, x, y);
+
+			const float32* texel = Texels.data() + (MipOffsets[mip] + ((uint64)face * mipSize + y) * mipSize + x) * 4;
+			return Vec3(texel[0], texel[1], texel[2]);
+		}
+	};
+
+	static void PrefilterTexel(const SourceChain& source, const GGXSampleSet& samples, const Vec3& n, float32* out)
+	{
+		Vec3 up = std::abs(n.z) < 0.999f ? Vec3(0.f, 0.f, 1.f) : Vec3(1.f, 0.f, 0.f);
+		Vec3 tangent = glm::normalize(glm::cross(up, n));
+		Vec3 bitangent = glm::cross(n, tangent);
+
+		Vec3 color(0.f);
+		alignas(16) float32 wx[4], wy[4], wz[4];
+
+		for (uint64 i = 0; i < samples.X.size(); i += 4)
+		{
+			// rotate four samples into the frame of the texel at once
+			__m128 lx = _mm_loadu_ps(samples.X.data() + i);
+			__m128 ly = _mm_loadu_ps(samples.Y.data() + i);
+			__m128 lz = _mm_loadu_ps(samples.Z.data() + i);
+
+			_mm_store_ps(wx, _mm_add_ps(_mm_add_ps(_mm_mul_ps(lx, _mm_set1_ps(tangent.x)), _mm_mul_ps(ly, _mm_set1_ps(bitangent.x))), _mm_mul_ps(lz, _mm_set1_ps(n.x))));
+			_mm_store_ps(wy, _mm_add_ps(_mm_add_ps(_mm_mul_ps(lx, _mm_set1_ps(tangent.y)), _mm_mul_ps(ly, _mm_set1_ps(bitangent.y))), _mm_mul_ps(lz, _mm_set1_ps(n.y))));
+			_mm_store_ps(wz, _mm_add_ps(_mm_add_ps(_mm_mul_ps(lx, _mm_set1_ps(tangent.z)), _mm_mul_ps(ly, _mm_set1_ps(bitangent.z))), _mm_mul_ps(lz, _mm_set1_ps(n.z))));
+
+			for (uint32 j = 0; j < 4; j++)
+			{
+				float32 weight = samples.Weight[i + j];
+				if (weight > 0.f)
+					color += source.Fetch(Vec3(wx[j], wy[j], wz[j]), samples.Lod[i + j]) * weight;
+			}
+		}
+
+		color /= samples.TotalWeight;
+		out[0] = color.r;
+		out[1] = color.g;
+		out[2] = color.b;
+		out[3] = 1.f;
+	}
+
+	static void PrefilterSpecular(const float32* faces, uint32 size, const IBLProcessDesc& desc, IBLResult& out)
+	{
+		PROFILE_SCOPED;
+
+		MipGenDesc mipDesc{};
+		mipDesc.Width = size;
+		mipDesc.Height = size;
+		mipDesc.NumLayers = 6;
+		mipDesc.Filter = EMipFilter::Box;
+		mipDesc.Flags = EMipGenFlags::Cubemap;
+
+		SourceChain source{};
+		source.Size = size;
+		source.Texels = GenerateMips(faces, mipDesc);
+
+		uint32 numSourceMips = NumTextureMips(size, size);
+		uint64 offset = 0;
+		for (uint32 m = 0; m < numSourceMips; m++)
+		{
+			uint32 mipSize = std::max(1u, size >> m);
+			source.MipOffsets.push_back(offset);
+			offset += (uint64)mipSize * mipSize * 6;
+		}
+
+		out.SpecularSize = desc.SpecularSize;
+		out.NumSpecularMips = std::min(desc.NumSpecularMips, NumTextureMips(desc.SpecularSize, desc.SpecularSize));
+
+		uint64 totalTexels = 0;
+		for (uint32 m = 0; m < out.NumSpecularMips; m++)
+			totalTexels += (uint64)std::max(1u, desc.SpecularSize >> m) * std::max(1u, desc.SpecularSize >> m) * 6;
+		out.Specular.resize(totalTexels * 4);
+
+		uint64 dstOffset = 0;
+		for (uint32 m = 0; m < out.NumSpecularMips; m++)
+		{
+			uint32 mipSize = std::max(1u, desc.SpecularSize >> m);
+			float32 roughness = out.NumSpecularMips > 1 ? (float32)m / (float32)(out.NumSpecularMips - 1) : 0.f;
+
+			// a mirror needs no integration, read the source mip closest in resolution
+			uint32 mirrorLod = std::min((uint32)std::max(std::log2((float32)size / (float32)mipSize), 0.f), numSourceMips - 1);
+
+			GGXSampleSet samples{};
+			if (roughness > 0.f)
+				BuildGGXSamples(roughness, desc.NumSamples, size, numSourceMips, samples);
+
+			float32* dst = out.Specular.data() + dstOffset * 4;
+
+			JobSystem::ParallelFor(mipSize * 6, 4, [&](uint32 begin, uint32 end) {
+				for (uint32 row = begin; row < end; row++)
+				{
+					uint32 face = row / mipSize;
+					uint32 y = row % mipSize;
+
+					for (uint32 x = 0; x < mipSize; x++)
+					{
+						Vec3 n = glm::normalize(CubeTexelToDirection(face, x, y, mipSize));
+						float32* texel = dst + (((uint64)face * mipSize + y) * mipSize + x) * 4;
+
+						if (roughness > 0.f)
+						{
+							PrefilterTexel(source, samples, n, texel);
+						}
+						else
+						{
+							Vec3 color = source.Fetch(n, mirrorLod);
+							texel[0] = color.r;
+							texel[1] = color.g;
+							texel[2] = color.b;
+							texel[3] = 1.f;
+						}
+					}
+				}
+				});
+
+			dstOffset += (uint64)mipSize * mipSize * 6;
+		}
+	}
+
+	uint64 IBLProcessor::HashSource(const float32* faces, uint32 size, const IBLProcessDesc& desc)
+	{
+		// cheap next to the processing and stable across runs
+		uint64 hash = HashBytes(&size, sizeof(size));
+		hash = HashBytes(faces, (uint64)size * size * 6 * 4 * sizeof(float32), hash);
+		hash = HashBytes(&desc.SpecularSize, sizeof(desc.SpecularSize), hash);
+		hash = HashBytes(&desc.NumSpecularMips, sizeof(desc.NumSpecularMips), hash);
+		hash = HashBytes(&desc.NumSamples, sizeof(desc.NumSamples), hash);
+
+		return hash;
+	}
+
+	static std::filesystem::path GetCachePath(const IBLProcessDesc& desc, uint64 hash)
+	{
+		char name[32] = {};
+		snprintf(name, sizeof(name), "%016llx.ibl", (unsigned long long)hash);
+
+		return desc.CacheDirectory / name;
+	}
+
+	static bool ReadCache(const std::filesystem::path& path, uint64 hash, IBLResult& out)
+	{
+		if (!std::filesystem::exists(path))
+			return false;
+
+		BinaryReadStream stream(path);
+		if (!stream.IsOpen())
+			return false;
+
+		char magic[4] = {};
+		uint64 storedHash = 0;
+		stream >> magic >> storedHash;
+
+		if (memcmp(magic, IBL_CACHE_MAGIC, sizeof(char) * 4) != 0 || storedHash != hash)
+		{
+			ENGINE_WARN("Ignoring stale IBL cache entry: {}", path.string());
+			return false;
+		}
+
+		stream >> out.Irradiance >> out.SpecularSize >> out.NumSpecularMips >> out.Specular;
+		return true;
+	}
+
+	static void WriteCache(const std::filesystem::path& path, uint64 hash, const IBLResult& result)
+	{
+		std::error_code error;
+		std::filesystem::create_directories(path.parent_path(), error);
+
+		BinaryWriteStream stream(path);
+		if (!stream.IsOpen())
+		{
+			ENGINE_WARN("Failed to write IBL cache entry: {}", path.string());
+			return;
+		}
+
+		stream << IBL_CACHE_MAGIC << hash;
+		stream << result.Irradiance << result.SpecularSize << result.NumSpecularMips << result.Specular;
+	}
+
+	bool IBLProcessor::Process(const float32* faces, uint32 size, const IBLProcessDesc& desc, IBLResult& out)
+	{
+		if (size == 0 || desc.SpecularSize == 0 || desc.NumSpecularMips == 0)
+		{
+			ENGINE_ERROR("Invalid IBL processing parameters!");
+			return false;
+		}
+
+		PROFILE_SCOPED;
+
+		bool useCache = !desc.CacheDirectory.empty();
+		uint64 hash = 0;
+
+		if (useCache)
+		{
+			hash = HashSource(faces, size, desc);
+			if (ReadCache(GetCachePath(desc, hash), hash, out))
+				return true;
+		}
+
+		out.Irradiance = ComputeIrradiance(faces, size);
+		PrefilterSpecular(faces, size, desc, out);
+
+		if (useCache)
+			WriteCache(GetCachePath(desc, hash), hash, out);
+
+		return true;
+	}
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <Engine/Core/Math.h>
+
+namespace Spikey {
+
+	// third order spherical harmonics of the cosine convolved environment,
+	// Evaluate returns irradiance, divide by pi for the lambertian radiance
+	struct SHIrradiance
+	{
+		Vec3 Coefficients[9];
+
+		Vec3 Evaluate(const Vec3& normal) const;
+	};
+
+	struct IBLProcessDesc
+	{
+		uint32                SpecularSize = 128;
+		uint32                NumSpecularMips = 6;   // roughness goes linearly from 0 to 1 across the mips
+		uint32                NumSamples = 512;      // ggx samples per texel
+		std::filesystem::path CacheDirectory;        // empty disables the disk cache
+	};
+
+	struct IBLResult
+	{
+		SHIrradiance Irradiance;
+		uint32       SpecularSize = 0;
+		uint32       NumSpecularMips = 0;
+
+		// RGBA32F, mip after mip with the six faces of a mip next to each other (the TextureCube layout)
+		std::vector<float32> Specular;
+	};
+
+	constexpr char IBL_CACHE_MAGIC[4] = { 'S', 'I', 'B', 'L' };
+
+	// offline image based lighting preprocessing of an environment cube, deterministic for a given input.
+	// source is RGBA32F mip 0 with the faces stored one after another
+	class IBLProcessor
+	{
+	public:
+		static bool Process(const float32* faces, uint32 size, const IBLProcessDesc& desc, IBLResult& out);
+
+		static SHIrradiance ComputeIrradiance(const float32* faces, uint32 size);
+
+		// hash of the source texels and the settings, names the cache entry
+		static uint64 HashSource(const float32* faces, uint32 size, const IBLProcessDesc& desc);
+	};
+}
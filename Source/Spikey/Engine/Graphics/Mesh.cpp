@@ -14,11 +14,26 @@ void Spikey::CalculateMeshBounds(const std::vector<Vertex>& vertices, AABBBounds
 	}
 }
 
+void Spikey::WriteMeshFile(BinaryWriteStream& stream, const MeshData& data, const AABBBounds& bounds, const MeshBVH* bvh) {
+	stream << MESH_MAGIC << MESH_FILE_VERSION;
+	stream << bounds;
+	stream << data.Vertices << data.Indices << data.SubMeshes;
+
+	// bvh is optional and stored after the geometry, so it is not rebuilt at load time
+	uint8 hasBVH = bvh ? 1 : 0;
+	stream << hasBVH;
+
+	if (bvh) {
+		bvh->Serialize(stream);
+	}
+}
+
 namespace Spikey {
 
-    Mesh::Mesh(MeshData&& data, AABBBounds* bounds, UUID id) {
+    Mesh::Mesh(MeshData&& data, AABBBounds* bounds, TUniquePtr<MeshBVH>&& bvh, UUID id) {
 		m_ID = id;
 		m_SubMeshes = std::move(data.SubMeshes);
+		m_BVH = std::move(bvh);
 
 		if (bounds) {
 			m_Bounds = *bounds;
@@ -27,68 +42,50 @@ namespace Spikey {
 			CalculateMeshBounds(data.Vertices, m_Bounds);
 		}
 
-		BufferDesc bufferDesc{};
-		bufferDesc.UsageFlags = EBufferUsage::Storage | EBufferUsage::CopyDst | EBufferUsage::Addressable;
-		bufferDesc.MemUsage = EBufferMemUsage::GPUOnly;
-		bufferDesc.Size = sizeof(Vertex) * data.Vertices.size();
-
-		m_VertexBuffer = new RHIBuffer(bufferDesc);
-		bufferDesc.Size = sizeof(uint32) * data.Indices.size();
-		m_IndexBuffer = new RHIBuffer(bufferDesc);
-
-		Graphics::SubmitCommand([vb = m_VertexBuffer, ib = m_IndexBuffer, dt = std::move(data)]() {
-			vb->InitRHI();
-			ib->InitRHI();
-
-			const uint64 vertexBufferSize = sizeof(Vertex) * dt.Vertices.size();
-			const uint64 indexBufferSize = sizeof(uint32) * dt.Indices.size();
-
-			BufferDesc stagingDesc{};
-			stagingDesc.Size = vertexBufferSize + indexBufferSize;
-			stagingDesc.UsageFlags = EBufferUsage::CopySrc;
-			stagingDesc.MemUsage = EBufferMemUsage::CPUOnly;
-
-			RHIBuffer* staging = new RHIBuffer(stagingDesc);
-			staging->InitRHI();
-
-			memcpy(staging->GetMappedData(), dt.Vertices.data(), vertexBufferSize);
-			memcpy((uint8*)staging->GetMappedData() + vertexBufferSize, dt.Indices.data(), indexBufferSize);
-
-			Graphics::GetRHI().ImmediateSubmit([&](RHICommandBuffer* cmd) {
-
-				Graphics::GetRHI().CopyBuffer(cmd, staging, vb, 0, 0, vertexBufferSize);
-				Graphics::GetRHI().CopyBuffer(cmd, staging, ib, vertexBufferSize, 0, indexBufferSize);
-				});
-
-			staging->ReleaseRHI();
-			delete staging;
-			});
+		m_Geometry = GeometryPool::Allocate((uint32)data.Vertices.size(), (uint32)data.Indices.size());
+		if (m_Geometry.IsValid()) {
+			GeometryPool::Upload(m_Geometry, std::move(data));
+		}
 	}
 
 	Mesh::~Mesh() {
-		SafeResourceRelease(m_VertexBuffer);
-		SafeResourceRelease(m_IndexBuffer);
+		GeometryPool::Free(m_Geometry);
 	}
 
 	TRef<Mesh> Mesh::Create(BinaryReadStream& stream, UUID id) {
 		char magic[4] = {};
-		stream >> magic;
+		uint32 version = 0;
+		stream >> magic >> version;
 
 		if (memcmp(MESH_MAGIC, magic, sizeof(char) * 4) != 0) {
 			ENGINE_ERROR("Mesh asset file is not valid: {}!", (uint64)id);
 			return nullptr;
 		}
 
+		if (version != MESH_FILE_VERSION) {
+			ENGINE_ERROR("Mesh asset file {} has version {}, expected {}, import it again!", (uint64)id, version, MESH_FILE_VERSION);
+			return nullptr;
+		}
+
 		AABBBounds bounds{};
 		MeshData data{};
 
 		stream >> bounds;
 		stream >> data.Vertices >> data.Indices >> data.SubMeshes;
 
-		return CreateRef<Mesh>(std::move(data), &bounds, id);
+		uint8 hasBVH = 0;
+		stream >> hasBVH;
+
+		TUniquePtr<MeshBVH> bvh = nullptr;
+		if (hasBVH) {
+			bvh = MeshBVH::Deserialize(stream);
+		}
+
+		return CreateRef<Mesh>(std::move(data), &bounds, std::move(bvh), id);
 	}
 
-    TRef<Mesh> Mesh::Create(MeshData&& data, AABBBounds* bounds) {
-		return CreateRef<Mesh>(std::move(data), bounds, 0);
+    TRef<Mesh> Mesh::Create(MeshData&& data, AABBBounds* bounds, bool buildBVH) {
+		TUniquePtr<MeshBVH> bvh = buildBVH ? MeshBVH::Build(data) : nullptr;
+		return CreateRef<Mesh>(std::move(data), bounds, std::move(bvh), 0);
 	}
 }
\ No newline at end of file
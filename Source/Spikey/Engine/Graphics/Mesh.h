@@ -1,5 +1,7 @@
 #pragma once
 #include <Engine/Graphics/Material.h>
+#include <Engine/Graphics/GeometryPool.h>
+#include <Engine/Graphics/MeshBVH.h>
 
 namespace Spikey {
 
@@ -21,6 +23,8 @@ namespace Spikey {
 	};
 
 	constexpr char MESH_MAGIC[4] = { 'S', 'M', 'S', 'F' };
+	// 1 was written without a version and without the bvh flag, those files have to be imported again
+	constexpr uint32 MESH_FILE_VERSION = 2;
 
 	struct AABBBounds {
 		Vec3 LowerBound;
@@ -34,25 +38,33 @@ namespace Spikey {
 	};
 
 	void CalculateMeshBounds(const std::vector<Vertex>& vertices, AABBBounds& out);
+	void WriteMeshFile(BinaryWriteStream& stream, const MeshData& data, const AABBBounds& bounds, const MeshBVH* bvh);
 
 	class Mesh : public IAsset {
 	public:
-		Mesh(MeshData&& data, AABBBounds* bounds, UUID id);
+		Mesh(MeshData&& data, AABBBounds* bounds, TUniquePtr<MeshBVH>&& bvh, UUID id);
 		virtual ~Mesh() override;
 
 		static TRef<Mesh> Create(BinaryReadStream& stream, UUID id);
-		static TRef<Mesh> Create(MeshData&& data, AABBBounds* bounds = nullptr);
+		static TRef<Mesh> Create(MeshData&& data, AABBBounds* bounds = nullptr, bool buildBVH = false);
 
-		RHIBufferRef GetVertexBuffer() { return m_VertexBuffer; }
-		RHIBufferRef GetIndexBuffer() { return m_IndexBuffer; }
+		RHIBuffer* GetVertexBuffer() { return GeometryPool::GetVertexBuffer(); }
+		RHIBuffer* GetIndexBuffer() { return GeometryPool::GetIndexBuffer(); }
+		const GeometryAllocation& GetGeometry() const { return m_Geometry; }
 		const AABBBounds& GetBounds() const { return m_Bounds; }
 
+		// vertex pulling address, indices of the mesh are relative to it
+		uint64 GetVertexAddress() const { return GeometryPool::GetVertexAddress(m_Geometry); }
+
 		uint32 GetNumSubMeshes() const { return (uint32)m_SubMeshes.size(); }
 		const std::vector<SubMesh>& GetSubMeshes() const { return m_SubMeshes; }
 
+		// null if the mesh was neither cooked nor created with a bvh
+		const MeshBVH* GetBVH() const { return m_BVH.get(); }
+
 	private:
-		RHIBufferRef m_VertexBuffer;
-		RHIBufferRef m_IndexBuffer;
+		GeometryAllocation  m_Geometry;
+		TUniquePtr<MeshBVH> m_BVH;
 
 		std::vector<SubMesh> m_SubMeshes;
 		AABBBounds m_Bounds;
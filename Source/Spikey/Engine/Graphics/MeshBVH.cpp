@@ -0,0 +1,720 @@
+#include <Engine/Graphics/MeshBVH.h>
+#include <Engine/Graphics/Mesh.h>
+#include <Engine/Threading/JobSystem.h>
+#include <emmintrin.h>
+#include <cfloat>
+
+namespace Spikey {
+
+	constexpr uint32 BVH_NUM_BINS = 16;
+	constexpr uint32 BVH_MAX_LEAF_SIZE = 4;
+	constexpr uint32 BVH_FORCE_SPLIT_SIZE = 32;
+	constexpr uint32 BVH_PARALLEL_THRESHOLD = 16 * 1024;
+	constexpr uint32 BVH_STACK_SIZE = 64;
+	// a traversal holds one pending sibling per level plus the two children it pushes, so leaves
+	// never go deeper than this, whatever the triangle distribution
+	constexpr uint32 BVH_MAX_DEPTH = BVH_STACK_SIZE - 1;
+
+	struct BVHBounds
+	{
+		Vec3 Min = Vec3(FLT_MAX);
+		Vec3 Max = Vec3(-FLT_MAX);
+
+		void Grow(const Vec3& p) { Min = glm::min(Min, p); Max = glm::max(Max, p); }
+		void Grow(const BVHBounds& b) { Min = glm::min(Min, b.Min); Max = glm::max(Max, b.Max); }
+
+		float32 HalfArea() const
+		{
+			Vec3 e = glm::max(Max - Min, Vec3(0.f));
+			return e.x * e.y + e.y * e.z + e.z * e.x;
+		}
+	};
+
+	struct BVHBin
+	{
+		BVHBounds Bounds;
+		BVHBounds CentroidBounds;
+		uint32    Count = 0;
+	};
+
+	using BVHBinSet = std::array<std::array<BVHBin, BVH_NUM_BINS>, 3>;
+
+	struct BVHBuildContext
+	{
+		std::vector<BVHNode>&  Nodes;
+		std::vector<uint32>    TriIndices;
+		std::vector<BVHBounds> TriBounds;
+		std::vector<Vec3>      Centroids;
+		std::atomic<uint32>    NodesUsed{ 1 };
+	};
+
+	static uint32 BinIndex(const Vec3& centroid, const BVHBounds& centroidBounds, const Vec3& scale, uint32 axis)
+	{
+		uint32 bin = (uint32)((centroid[axis] - centroidBounds.Min[axis]) * scale[axis]);
+		return std::min(bin, BVH_NUM_BINS - 1);
+	}
+
+	static void BinTriangles(BVHBuildContext& ctx, uint32 first, uint32 count, const BVHBounds& centroidBounds,
+		const Vec3& scale, BVHBinSet& outBins)
+	{
+		auto binRange = [&](uint32 begin, uint32 end, BVHBinSet& bins) {
+			for (uint32 i = begin; i < end; i++)
+			{
+				uint32 tri = ctx.TriIndices[first + i];
+				const Vec3& c = ctx.Centroids[tri];
+
+				for (uint32 a = 0; a < 3; a++)
+				{
+					BVHBin& bin = bins[a][BinIndex(c, centroidBounds, scale, a)];
+					bin.Bounds.Grow(ctx.TriBounds[tri]);
+					bin.CentroidBounds.Grow(c);
+					bin.Count++;
+				}
+			}
+			};
+
+		if (count < BVH_PARALLEL_THRESHOLD)
+		{
+			binRange(0, count, outBins);
+			return;
+		}
+
+		std::mutex mergeMutex;
+		JobSystem::ParallelFor(count, BVH_PARALLEL_THRESHOLD / 4, [&](uint32 begin, uint32 end) {
+			BVHBinSet localBins{};
+			binRange(begin, end, localBins);
+
+			std::lock_guard lock(mergeMutex);
+			for (uint32 a = 0; a < 3; a++)
+			{
+				for (uint32 b = 0; b < BVH_NUM_BINS; b++)
+				{
+					outBins[a][b].Bounds.Grow(localBins[a][b].Bounds);
+					outBins[a][b].CentroidBounds.Grow(localBins[a][b].CentroidBounds);
+					outBins[a][b].Count += localBins[a][b].Count;
+				}
+			}
+			});
+	}
+
+	static void Subdivide(BVHBuildContext& ctx, uint32 nodeIdx, const BVHBounds& centroidBounds, uint32 depth)
+	{
+		BVHNode& node = ctx.Nodes[nodeIdx];
+		uint32 first = node.LeftOrFirst;
+		uint32 count = node.Count;
+
+		if (count <= BVH_MAX_LEAF_SIZE || depth >= BVH_MAX_DEPTH)
+			return;
+
+		Vec3 extent = centroidBounds.Max - centroidBounds.Min;
+		if (extent.x <= 0.f && extent.y <= 0.f && extent.z <= 0.f)
+			return;
+
+		Vec3 scale{};
+		for (uint32 a = 0; a < 3; a++)
+			scale[a] = extent[a] > 0.f ? (float32)BVH_NUM_BINS / extent[a] : 0.f;
+
+		BVHBinSet bins{};
+		BinTriangles(ctx, first, count, centroidBounds, scale, bins);
+
+		// sweep the bins for the cheapest sah split
+		float32 bestCost = FLT_MAX;
+		uint32  bestAxis = 0;
+		uint32  bestSplit = 0;
+
+		for (uint32 a = 0; a < 3; a++)
+		{
+			if (extent[a] <= 0.f)
+				continue;
+
+			float32 leftArea[BVH_NUM_BINS - 1];
+			uint32  leftCount[BVH_NUM_BINS - 1];
+			BVHBounds acc{};
+			uint32 accCount = 0;
+
+			for (uint32 b = 0; b < BVH_NUM_BINS - 1; b++)
+			{
+				acc.Grow(bins[a][b].Bounds);
+				accCount += bins[a][b].Count;
+				leftArea[b] = acc.HalfArea();
+				leftCount[b] = accCount;
+			}
+
+			acc = {};
+			accCount = 0;
+			for (uint32 b = BVH_NUM_BINS - 1; b > 0; b--)
+			{
+				acc.Grow(bins[a][b].Bounds);
+				accCount += bins[a][b].Count;
+
+				if (leftCount[b - 1] == 0 || accCount == 0)
+					continue;
+
+				float32 cost = leftCount[b - 1] * leftArea[b - 1] + accCount * acc.HalfArea();
+				if (cost < bestCost)
+				{
+					bestCost = cost;
+					bestAxis = a;
+					bestSplit = b - 1;
+				}
+			}
+		}
+
+		BVHBounds nodeBounds{ node.Min, node.Max };
+		float32 leafCost = count * nodeBounds.HalfArea();
+		if (bestCost == FLT_MAX || (bestCost >= leafCost && count <= BVH_FORCE_SPLIT_SIZE))
+			return;
+
+		uint32* begin = ctx.TriIndices.data() + first;
+		uint32* middle = std::partition(begin, begin + count, [&](uint32 tri) {
+			return BinIndex(ctx.Centroids[tri], centroidBounds, scale, bestAxis) <= bestSplit;
+			});
+
+		uint32 leftCount = (uint32)(middle - begin);
+		if (leftCount == 0 || leftCount == count)
+			return;
+
+		BVHBounds leftBounds{}, leftCentroids{}, rightBounds{}, rightCentroids{};
+		for (uint32 b = 0; b < BVH_NUM_BINS; b++)
+		{
+			const BVHBin& bin = bins[bestAxis][b];
+			(b <= bestSplit ? leftBounds : rightBounds).Grow(bin.Bounds);
+			(b <= bestSplit ? leftCentroids : rightCentroids).Grow(bin.CentroidBounds);
+		}
+
+		uint32 leftIdx = ctx.NodesUsed.fetch_add(2, std::memory_order_relaxed);
+		BVHNode& left = ctx.Nodes[leftIdx];
+		BVHNode& right = ctx.Nodes[leftIdx + 1];
+
+		left = { leftBounds.Min, first, leftBounds.Max, leftCount };
+		right = { rightBounds.Min, first + leftCount, rightBounds.Max, count - leftCount };
+
+		node.LeftOrFirst = leftIdx;
+		node.Count = 0;
+
+		if (count >= BVH_PARALLEL_THRESHOLD)
+		{
+			JobSystem::Counter counter{};
+			JobSystem::Execute(counter, [&ctx, leftIdx, leftCentroids, depth]() { Subdivide(ctx, leftIdx, leftCentroids, depth + 1); });
+
+			Subdivide(ctx, leftIdx + 1, rightCentroids, depth + 1);
+			JobSystem::Wait(counter);
+		}
+		else
+		{
+			Subdivide(ctx, leftIdx, leftCentroids, depth + 1);
+			Subdivide(ctx, leftIdx + 1, rightCentroids, depth + 1);
+		}
+	}
+
+	TUniquePtr<MeshBVH> MeshBVH::Build(const MeshData& data)
+	{
+		PROFILE_SCOPED;
+
+		TUniquePtr<MeshBVH> bvh = CreateUnique<MeshBVH>();
+		uint32 numTris = (uint32)(data.Indices.size() / 3);
+
+		if (numTris == 0)
+			return bvh;
+
+		BVHBuildContext ctx{ bvh->m_Nodes };
+		ctx.Nodes.resize(numTris * 2);
+		ctx.TriIndices.resize(numTris);
+		ctx.TriBounds.resize(numTris);
+		ctx.Centroids.resize(numTris);
+
+		std::mutex rootMutex;
+		BVHBounds rootBounds{}, rootCentroids{};
+
+		JobSystem::ParallelFor(numTris, 4096, [&](uint32 begin, uint32 end) {
+			BVHBounds bounds{}, centroids{};
+
+			for (uint32 i = begin; i < end; i++)
+			{
+				BVHBounds& tb = ctx.TriBounds[i];
+				tb = {};
+				tb.Grow(data.Vertices[data.Indices[i * 3 + 0]].Position);
+				tb.Grow(data.Vertices[data.Indices[i * 3 + 1]].Position);
+				tb.Grow(data.Vertices[data.Indices[i * 3 + 2]].Position);
+
+				ctx.Centroids[i] = (tb.Min + tb.Max) * 0.5f;
+				ctx.TriIndices[i] = i;
+
+				bounds.Grow(tb);
+				centroids.Grow(ctx.Centroids[i]);
+			}
+
+			std::lock_guard lock(rootMutex);
+			rootBounds.Grow(bounds);
+			rootCentroids.Grow(centroids);
+			});
+
+		ctx.Nodes[0] = { rootBounds.Min, 0, rootBounds.Max, numTris };
+		Subdivide(ctx, 0, rootCentroids, 0);
+
+		ctx.Nodes.resize(ctx.NodesUsed.load());
+		ctx.Nodes.shrink_to_fit();
+
+		bvh->m_Triangles.resize(numTris);
+		for (uint32 i = 0; i < numTris; i++)
+		{
+			uint32 tri = ctx.TriIndices[i];
+			BVHTriangle& t = bvh->m_Triangles[i];
+
+			t.V0 = data.Vertices[data.Indices[tri * 3 + 0]].Position;
+			t.V1 = data.Vertices[data.Indices[tri * 3 + 1]].Position;
+			t.V2 = data.Vertices[data.Indices[tri * 3 + 2]].Position;
+			t.Index = tri;
+		}
+
+		return bvh;
+	}
+
+	template<typename T>
+	static bool ReadBVHArray(BinaryReadStream& stream, uint64 fileSize, std::vector<T>& out)
+	{
+		uint64 count = 0;
+		stream >> count;
+
+		uint64 offset = stream.Tell();
+		if (offset > fileSize || count > (fileSize - offset) / sizeof(T) || count > UINT32_MAX)
+			return false;
+
+		out.resize(count);
+		stream.ReadRaw(out.data(), count * sizeof(T));
+		return true;
+	}
+
+	// every node has to be reached once from the root, children in range and after their parent. leaves deeper
+	// than the builder makes them would overflow the traversal stacks
+	static bool ValidateBVH(const std::vector<BVHNode>& nodes, uint32 numTris)
+	{
+		if (nodes.empty() || numTris == 0)
+			return nodes.empty() && numTris == 0;
+
+		std::vector<bool> reached(nodes.size(), false);
+		std::vector<std::pair<uint32, uint32>> pending{ { 0u, 0u } };
+
+		while (!pending.empty())
+		{
+			auto [index, depth] = pending.back();
+			pending.pop_back();
+
+			if (reached[index])
+				return false;
+
+			reached[index] = true;
+
+			const BVHNode& node = nodes[index];
+			if (node.IsLeaf())
+			{
+				if (node.LeftOrFirst > numTris || node.Count > numTris - node.LeftOrFirst)
+					return false;
+
+				continue;
+			}
+
+			if (depth >= BVH_MAX_DEPTH || node.LeftOrFirst <= index || node.LeftOrFirst >= nodes.size() - 1)
+				return false;
+
+			pending.push_back({ node.LeftOrFirst, depth + 1 });
+			pending.push_back({ node.LeftOrFirst + 1, depth + 1 });
+		}
+
+		return true;
+	}
+
+	TUniquePtr<MeshBVH> MeshBVH::Deserialize(BinaryReadStream& stream)
+	{
+		char magic[4] = {};
+		stream >> magic;
+
+		if (memcmp(magic, BVH_MAGIC, sizeof(char) * 4) != 0)
+		{
+			ENGINE_ERROR("Corrupted mesh BVH data!");
+			return nullptr;
+		}
+
+		// the counts come from the file, nothing is allocated for more than it can still hold
+		uint64 fileSize = std::filesystem::file_size(stream.GetPath());
+
+		TUniquePtr<MeshBVH> bvh = CreateUnique<MeshBVH>();
+		if (!ReadBVHArray(stream, fileSize, bvh->m_Nodes) || !ReadBVHArray(stream, fileSize, bvh->m_Triangles) ||
+			!ValidateBVH(bvh->m_Nodes, (uint32)bvh->m_Triangles.size()))
+		{
+			ENGINE_ERROR("Corrupted mesh BVH data!");
+			return nullptr;
+		}
+
+		return bvh;
+	}
+
+	void MeshBVH::Serialize(BinaryWriteStream& stream) const
+	{
+		stream << BVH_MAGIC;
+		stream << m_Nodes << m_Triangles;
+	}
+
+	// swizzles xyz so lane 0 ends up with the horizontal max / min of the three
+	static inline float32 HorizontalMax3(__m128 v)
+	{
+		__m128 yzx = _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 0, 2, 1));
+		__m128 zxy = _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 1, 0, 2));
+		return _mm_cvtss_f32(_mm_max_ps(v, _mm_max_ps(yzx, zxy)));
+	}
+
+	static inline float32 HorizontalMin3(__m128 v)
+	{
+		__m128 yzx = _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 0, 2, 1));
+		__m128 zxy = _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 1, 0, 2));
+		return _mm_cvtss_f32(_mm_min_ps(v, _mm_min_ps(yzx, zxy)));
+	}
+
+	struct BVHRay
+	{
+		__m128  Origin;
+		__m128  InvDirection;
+		Vec3    OriginScalar;
+		Vec3    Direction;
+	};
+
+	// returns entry distance or FLT_MAX on miss
+	static inline float32 IntersectNode(const BVHNode& node, const BVHRay& ray, float32 maxDistance)
+	{
+		__m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&node.Min.x), ray.Origin), ray.InvDirection);
+		__m128 t2 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&node.Max.x), ray.Origin), ray.InvDirection);
+
+		float32 tEnter = std::max(HorizontalMax3(_mm_min_ps(t1, t2)), 0.f);
+		float32 tExit = std::min(HorizontalMin3(_mm_max_ps(t1, t2)), maxDistance);
+
+		return tEnter <= tExit ? tEnter : FLT_MAX;
+	}
+
+	// moller-trumbore
+	static inline bool IntersectTriangle(const BVHTriangle& tri, const BVHRay& ray, float32 maxDistance, BVHRayHit& outHit)
+	{
+		Vec3 e1 = tri.V1 - tri.V0;
+		Vec3 e2 = tri.V2 - tri.V0;
+		Vec3 p = glm::cross(ray.Direction, e2);
+		float32 det = glm::dot(e1, p);
+
+		if (std::abs(det) < 1e-12f)
+			return false;
+
+		float32 invDet = 1.f / det;
+		Vec3 s = ray.OriginScalar - tri.V0;
+		float32 u = glm::dot(s, p) * invDet;
+		if (u < 0.f || u > 1.f)
+			return false;
+
+		Vec3 q = glm::cross(s, e1);
+		float32 v = glm::dot(ray.Direction, q) * invDet;
+		if (v < 0.f || u + v > 1.f)
+			return false;
+
+		float32 t = glm::dot(e2, q) * invDet;
+		if (t < 0.f || t >= maxDistance)
+			return false;
+
+		outHit.Distance = t;
+		outHit.Triangle = tri.Index;
+		outHit.Barycentrics = Vec2(u, v);
+		return true;
+	}
+
+	static BVHRay MakeRay(const Vec3& origin, const Vec3& direction)
+	{
+		Vec3 inv = 1.f / direction;
+
+		BVHRay ray{};
+		ray.Origin = _mm_setr_ps(origin.x, origin.y, origin.z, 0.f);
+		ray.InvDirection = _mm_setr_ps(inv.x, inv.y, inv.z, 0.f);
+		ray.OriginScalar = origin;
+		ray.Direction = direction;
+
+		return ray;
+	}
+
+	template<bool AnyHit>
+	static bool TraverseRay(const std::vector<BVHNode>& nodes, const std::vector<BVHTriangle>& triangles,
+		const BVHRay& ray, float32 maxDistance, BVHRayHit& outHit)
+	{
+		if (nodes.empty())
+			return false;
+
+		uint32 stack[BVH_STACK_SIZE];
+		uint32 stackSize = 0;
+		bool   found = false;
+
+		if (IntersectNode(nodes[0], ray, maxDistance) == FLT_MAX)
+			return false;
+
+		stack[stackSize++] = 0;
+		while (stackSize > 0)
+		{
+			const BVHNode& node = nodes[stack[--stackSize]];
+
+			if (node.IsLeaf())
+			{
+				for (uint32 i = 0; i < node.Count; i++)
+				{
+					if (IntersectTriangle(triangles[node.LeftOrFirst + i], ray, maxDistance, outHit))
+					{
+						if constexpr (AnyHit)
+							return true;
+
+						maxDistance = outHit.Distance;
+						found = true;
+					}
+				}
+				continue;
+			}
+
+			uint32 nearIdx = node.LeftOrFirst;
+			uint32 farIdx = node.LeftOrFirst + 1;
+			float32 tNear = IntersectNode(nodes[nearIdx], ray, maxDistance);
+			float32 tFar = IntersectNode(nodes[farIdx], ray, maxDistance);
+
+			if (tFar < tNear)
+			{
+				std::swap(nearIdx, farIdx);
+				std::swap(tNear, tFar);
+			}
+
+			// push farIdx first so the nearIdx child is visited next
+			if (tFar != FLT_MAX)
+				stack[stackSize++] = farIdx;
+			if (tNear != FLT_MAX)
+				stack[stackSize++] = nearIdx;
+
+			CHECK(stackSize <= BVH_STACK_SIZE);
+		}
+
+		return found;
+	}
+
+	bool MeshBVH::Raycast(const Vec3& origin, const Vec3& direction, float32 maxDistance, BVHRayHit& outHit) const
+	{
+		return TraverseRay<false>(m_Nodes, m_Triangles, MakeRay(origin, direction), maxDistance, outHit);
+	}
+
+	bool MeshBVH::Occluded(const Vec3& origin, const Vec3& direction, float32 maxDistance) const
+	{
+		BVHRayHit hit{};
+		return TraverseRay<true>(m_Nodes, m_Triangles, MakeRay(origin, direction), maxDistance, hit);
+	}
+
+	static bool PlaneBoxOverlap(const Vec3& normal, const Vec3& vert, const Vec3& halfSize)
+	{
+		Vec3 vmin{}, vmax{};
+		for (uint32 a = 0; a < 3; a++)
+		{
+			float32 v = vert[a];
+			vmin[a] = normal[a] > 0.f ? -halfSize[a] - v : halfSize[a] - v;
+			vmax[a] = normal[a] > 0.f ? halfSize[a] - v : -halfSize[a] - v;
+		}
+
+		if (glm::dot(normal, vmin) > 0.f)
+			return false;
+		return glm::dot(normal, vmax) >= 0.f;
+	}
+
+	// separating axis test (akenine-moller)
+	static bool TriangleBoxOverlap(const BVHTriangle& tri, const Vec3& center, const Vec3& halfSize)
+	{
+		Vec3 v[3] = { tri.V0 - center, tri.V1 - center, tri.V2 - center };
+		Vec3 e[3] = { v[1] - v[0], v[2] - v[1], v[0] - v[2] };
+
+		// 9 cross product axes
+		for (uint32 i = 0; i < 3; i++)
+		{
+			for (uint32 a = 0; a < 3; a++)
+			{
+				Vec3 boxAxis(0.f);
+				boxAxis[a] = 1.f;
+
+				Vec3 axis = glm::cross(boxAxis, e[i]);
+
+				float32 p0 = glm::dot(v[0], axis);
+				float32 p1 = glm::dot(v[1], axis);
+				float32 p2 = glm::dot(v[2], axis);
+				float32 r = halfSize.x * std::abs(axis.x) + halfSize.y * std::abs(axis.y) + halfSize.z * std::abs(axis.z);
+
+				if (std::min({ p0, p1, p2 }) > r || std::max({ p0, p1, p2 }) < -r)
+					return false;
+			}
+		}
+
+		// box face normals
+		for (uint32 a = 0; a < 3; a++)
+		{
+			if (std::min({ v[0][a], v[1][a], v[2][a] }) > halfSize[a] || std::max({ v[0][a], v[1][a], v[2][a] }) < -halfSize[a])
+				return false;
+		}
+
+		return PlaneBoxOverlap(glm::cross(e[0], e[1]), v[0], halfSize);
+	}
+
+	void MeshBVH::QueryOverlap(const AABBBounds& bounds, std::vector<uint32>& outTriangles) const
+	{
+		if (m_Nodes.empty())
+			return;
+
+		__m128 boxMin = _mm_setr_ps(bounds.LowerBound.x, bounds.LowerBound.y, bounds.LowerBound.z, 0.f);
+		__m128 boxMax = _mm_setr_ps(bounds.UpperBound.x, bounds.UpperBound.y, bounds.UpperBound.z, 0.f);
+		Vec3 center = (bounds.LowerBound + bounds.UpperBound) * 0.5f;
+		Vec3 halfSize = (bounds.UpperBound - bounds.LowerBound) * 0.5f;
+
+		auto overlaps = [&](const BVHNode& node) {
+			__m128 a = _mm_cmple_ps(_mm_loadu_ps(&node.Min.x), boxMax);
+			__m128 b = _mm_cmple_ps(boxMin, _mm_loadu_ps(&node.Max.x));
+			return (_mm_movemask_ps(_mm_and_ps(a, b)) & 0x7) == 0x7;
+			};
+
+		uint32 stack[BVH_STACK_SIZE];
+		uint32 stackSize = 0;
+
+		if (overlaps(m_Nodes[0]))
+			stack[stackSize++] = 0;
+
+		while (stackSize > 0)
+		{
+			const BVHNode& node = m_Nodes[stack[--stackSize]];
+
+			if (node.IsLeaf())
+			{
+				for (uint32 i = 0; i < node.Count; i++)
+				{
+					const BVHTriangle& tri = m_Triangles[node.LeftOrFirst + i];
+					if (TriangleBoxOverlap(tri, center, halfSize))
+						outTriangles.push_back(tri.Index);
+				}
+				continue;
+			}
+
+			if (overlaps(m_Nodes[node.LeftOrFirst]))
+				stack[stackSize++] = node.LeftOrFirst;
+			if (overlaps(m_Nodes[node.LeftOrFirst + 1]))
+				stack[stackSize++] = node.LeftOrFirst + 1;
+
+			CHECK(stackSize <= BVH_STACK_SIZE);
+		}
+	}
+
+	// from real-time collision detection (ericson)
+	static Vec3 ClosestPointOnTriangle(const Vec3& p, const Vec3& a, const Vec3& b, const Vec3& c)
+	{
+		Vec3 ab = b - a;
+		Vec3 ac = c - a;
+		Vec3 ap = p - a;
+
+		float32 d1 = glm::dot(ab, ap);
+		float32 d2 = glm::dot(ac, ap);
+		if (d1 <= 0.f && d2 <= 0.f)
+			return a;
+
+		Vec3 bp = p - b;
+		float32 d3 = glm::dot(ab, bp);
+		float32 d4 = glm::dot(ac, bp);
+		if (d3 >= 0.f && d4 <= d3)
+			return b;
+
+		float32 vc = d1 * d4 - d3 * d2;
+		if (vc <= 0.f && d1 >= 0.f && d3 <= 0.f)
+			return a + ab * (d1 / (d1 - d3));
+
+		Vec3 cp = p - c;
+		float32 d5 = glm::dot(ab, cp);
+		float32 d6 = glm::dot(ac, cp);
+		if (d6 >= 0.f && d5 <= d6)
+			return c;
+
+		float32 vb = d5 * d2 - d1 * d6;
+		if (vb <= 0.f && d2 >= 0.f && d6 <= 0.f)
+			return a + ac * (d2 / (d2 - d6));
+
+		float32 va = d3 * d6 - d5 * d4;
+		if (va <= 0.f && (d4 - d3) >= 0.f && (d5 - d6) >= 0.f)
+			return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+
+		float32 denom = 1.f / (va + vb + vc);
+		return a + ab * (vb * denom) + ac * (vc * denom);
+	}
+
+	bool MeshBVH::ClosestPoint(const Vec3& point, float32 maxDistance, BVHClosestPoint& outResult) const
+	{
+		if (m_Nodes.empty())
+			return false;
+
+		__m128 p = _mm_setr_ps(point.x, point.y, point.z, 0.f);
+		__m128 zero = _mm_setzero_ps();
+
+		auto distanceSq = [&](const BVHNode& node) {
+			__m128 below = _mm_sub_ps(_mm_loadu_ps(&node.Min.x), p);
+			__m128 above = _mm_sub_ps(p, _mm_loadu_ps(&node.Max.x));
+			__m128 d = _mm_max_ps(_mm_max_ps(below, above), zero);
+			d = _mm_mul_ps(d, d);
+
+			alignas(16) float32 lanes[4];
+			_mm_store_ps(lanes, d);
+			return lanes[0] + lanes[1] + lanes[2];
+			};
+
+		float32 bestSq = maxDistance * maxDistance;
+		bool found = false;
+
+		uint32 stack[BVH_STACK_SIZE];
+		uint32 stackSize = 0;
+		stack[stackSize++] = 0;
+
+		while (stackSize > 0)
+		{
+			const BVHNode& node = m_Nodes[stack[--stackSize]];
+			if (distanceSq(node) > bestSq)
+				continue;
+
+			if (node.IsLeaf())
+			{
+				for (uint32 i = 0; i < node.Count; i++)
+				{
+					const BVHTriangle& tri = m_Triangles[node.LeftOrFirst + i];
+					Vec3 closest = ClosestPointOnTriangle(point, tri.V0, tri.V1, tri.V2);
+					Vec3 delta = closest - point;
+					float32 dSq = glm::dot(delta, delta);
+
+					if (dSq <= bestSq)
+					{
+						bestSq = dSq;
+						outResult.Point = closest;
+						outResult.Triangle = tri.Index;
+						found = true;
+					}
+				}
+				continue;
+			}
+
+			uint32 nearIdx = node.LeftOrFirst;
+			uint32 farIdx = node.LeftOrFirst + 1;
+			float32 dNear = distanceSq(m_Nodes[nearIdx]);
+			float32 dFar = distanceSq(m_Nodes[farIdx]);
+
+			if (dFar < dNear)
+			{
+				std::swap(nearIdx, farIdx);
+				std::swap(dNear, dFar);
+			}
+
+			if (dFar <= bestSq)
+				stack[stackSize++] = farIdx;
+			if (dNear <= bestSq)
+				stack[stackSize++] = nearIdx;
+
+			CHECK(stackSize <= BVH_STACK_SIZE);
+		}
+
+		if (found)
+			outResult.Distance = std::sqrt(bestSq);
+
+		return found;
+	}
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <Engine/Core/Math.h>
+#include <Engine/Serialization/BinaryStream.h>
+
+namespace Spikey {
+
+	struct MeshData;
+	struct AABBBounds;
+
+	// 32 byte node, inner nodes store the index of the left child (right is next to it),
+	// leaves store the first triangle and a non zero triangle count
+	struct BVHNode
+	{
+		Vec3   Min;
+		uint32 LeftOrFirst;
+		Vec3   Max;
+		uint32 Count;
+
+		bool IsLeaf() const { return Count > 0; }
+	};
+	static_assert(sizeof(BVHNode) == 32);
+
+	struct BVHTriangle
+	{
+		Vec3   V0;
+		Vec3   V1;
+		Vec3   V2;
+		uint32 Index; // triangle index in the source mesh (first vertex index / 3)
+	};
+
+	struct BVHRayHit
+	{
+		float32 Distance;
+		uint32  Triangle;
+		Vec2    Barycentrics;
+	};
+
+	struct BVHClosestPoint
+	{
+		Vec3    Point;
+		float32 Distance;
+		uint32  Triangle;
+	};
+
+	constexpr char BVH_MAGIC[4] = { 'S', 'B', 'V', 'H' };
+
+	class MeshBVH
+	{
+	public:
+		static TUniquePtr<MeshBVH> Build(const MeshData& data);
+		static TUniquePtr<MeshBVH> Deserialize(BinaryReadStream& stream);
+		void Serialize(BinaryWriteStream& stream) const;
+
+		// closest hit along the ray, direction does not have to be normalized
+		// (distances are then in units of its length)
+		bool Raycast(const Vec3& origin, const Vec3& direction, float32 maxDistance, BVHRayHit& outHit) const;
+
+		// any hit, cheaper than Raycast for line of sight tests
+		bool Occluded(const Vec3& origin, const Vec3& direction, float32 maxDistance) const;
+
+		// appends indices of triangles intersecting the box
+		void QueryOverlap(const AABBBounds& bounds, std::vector<uint32>& outTriangles) const;
+
+		bool ClosestPoint(const Vec3& point, float32 maxDistance, BVHClosestPoint& outResult) const;
+
+		uint32 GetNumNodes() const { return (uint32)m_Nodes.size(); }
+		uint32 GetNumTriangles() const { return (uint32)m_Triangles.size(); }
+		const std::vector<BVHNode>& GetNodes() const { return m_Nodes; }
+
+	private:
+		std::vector<BVHNode>     m_Nodes;
+		std::vector<BVHTriangle> m_Triangles;
+	};
+}
@@ -0,0 +1,548 @@
+#include <Engine/Graphics/MipGenerator.h>
+#include <Engine/Graphics/Texture.h>
+#include <Engine/Threading/JobSystem.h>
+#include <immintrin.h>
+
+namespace Spikey {
+
+	// every mip is filtered in float from the unquantized previous level
+	struct MipImage
+	{
+		uint32            Width = 0;
+		uint32            Height = 0;
+		std::vector<Vec4> Texels;
+	};
+
+	// source texels and weights of a single output texel along one axis
+	struct FilterTap
+	{
+		uint32 Offset;
+		uint32 Count;
+	};
+
+	struct FilterTaps
+	{
+		std::vector<FilterTap> Taps;
+		std::vector<uint32>    Indices;
+		std::vector<float32>   Weights;
+	};
+
+	static constexpr float32 KAISER_WIDTH = 3.f;
+	static constexpr float32 KAISER_ALPHA = 4.f;
+	static constexpr float32 LANCZOS_WIDTH = 3.f;
+
+	static float32 Sinc(float32 x)
+	{
+		if (std::abs(x) < 1e-5f)
+			return 1.f;
+
+		x *= glm::pi<float32>();
+		return std::sin(x) / x;
+	}
+
+	static float32 BesselI0(float32 x)
+	{
+		float32 sum = 1.f;
+		float32 term = 1.f;
+		float32 halfX = x * 0.5f;
+
+		for (uint32 k = 1; k < 32; k++)
+		{
+			term *= (halfX / k) * (halfX / k);
+			sum += term;
+
+			if (term < sum * 1e-7f)
+				break;
+		}
+
+		return sum;
+	}
+
+	// support radius in destination texels
+	static float32 GetFilterWidth(EMipFilter filter)
+	{
+		switch (filter)
+		{
+		case EMipFilter::Kaiser:
+			return KAISER_WIDTH;
+		case EMipFilter::Lanczos:
+			return LANCZOS_WIDTH;
+		default:
+			return 0.5f;
+		}
+	}
+
+	static float32 EvaluateFilter(EMipFilter filter, float32 t)
+	{
+		t = std::abs(t);
+
+		switch (filter)
+		{
+		case EMipFilter::Kaiser:
+		{
+			if (t >= KAISER_WIDTH)
+				return 0.f;
+
+			float32 r = t / KAISER_WIDTH;
+			return Sinc(t) * BesselI0(KAISER_ALPHA * std::sqrt(1.f - r * r)) / BesselI0(KAISER_ALPHA);
+		}
+		case EMipFilter::Lanczos:
+			return t < LANCZOS_WIDTH ? Sinc(t) * Sinc(t / LANCZOS_WIDTH) : 0.f;
+		default:
+			return t <= 0.5f ? 1.f : 0.f;
+		}
+	}
+
+	static void ComputeFilterTaps(EMipFilter filter, uint32 srcSize, uint32 dstSize, FilterTaps& out)
+	{
+		float32 scale = (float32)srcSize / (float32)dstSize;
+		float32 radius = GetFilterWidth(filter) * scale;
+
+		out.Taps.resize(dstSize);
+		out.Indices.clear();
+		out.Weights.clear();
+
+		for (uint32 x = 0; x < dstSize; x++)
+		{
+			float32 center = ((float32)x + 0.5f) * scale;
+			int32 first = (int32)std::floor(center - radius);
+			int32 last = (int32)std::ceil(center + radius);
+
+			FilterTap& tap = out.Taps[x];
+			tap.Offset = (uint32)out.Weights.size();
+
+			float32 sum = 0.f;
+			for (int32 s = first; s <= last; s++)
+			{
+				float32 weight = EvaluateFilter(filter, ((float32)s + 0.5f - center) / scale);
+				if (std::abs(weight) < 1e-6f)
+					continue;
+
+				// clamp addressing, cubemap seams are handled separately
+				out.Indices.push_back((uint32)std::clamp(s, 0, (int32)srcSize - 1));
+				out.Weights.push_back(weight);
+				sum += weight;
+			}
+
+			tap.Count = (uint32)out.Weights.size() - tap.Offset;
+			for (uint32 i = 0; i < tap.Count; i++)
+				out.Weights[tap.Offset + i] /= sum;
+		}
+	}
+
+	// separable two pass resample, rows of both passes are spread over the job system
+	static void Resample(const MipImage& src, const FilterTaps& tapsX, const FilterTaps& tapsY, MipImage& dst)
+	{
+		uint32 dstW = (uint32)tapsX.Taps.size();
+		uint32 dstH = (uint32)tapsY.Taps.size();
+
+		std::vector<Vec4> horizontal((uint64)dstW * src.Height);
+
+		JobSystem::ParallelFor(src.Height, 8, [&](uint32 begin, uint32 end) {
+			for (uint32 y = begin; y < end; y++)
+			{
+				const float32* srcRow = (const float32*)(src.Texels.data() + (uint64)y * src.Width);
+				float32* dstRow = (float32*)(horizontal.data() + (uint64)y * dstW);
+
+				for (uint32 x = 0; x < dstW; x++)
+				{
+					const FilterTap& tap = tapsX.Taps[x];
+					__m128 acc = _mm_setzero_ps();
+
+					for (uint32 i = tap.Offset; i < tap.Offset + tap.Count; i++)
+					{
+						__m128 texel = _mm_loadu_ps(srcRow + tapsX.Indices[i] * 4);
+						acc = _mm_add_ps(acc, _mm_mul_ps(texel, _mm_set1_ps(tapsX.Weights[i])));
+					}
+
+					_mm_storeu_ps(dstRow + x * 4, acc);
+				}
+			}
+			});
+
+		dst.Width = dstW;
+		dst.Height = dstH;
+		dst.Texels.resize((uint64)dstW * dstH);
+
+		JobSystem::ParallelFor(dstH, 8, [&](uint32 begin, uint32 end) {
+			for (uint32 y = begin; y < end; y++)
+			{
+				const FilterTap& tap = tapsY.Taps[y];
+				float32* dstRow = (float32*)(dst.Texels.data() + (uint64)y * dstW);
+
+				for (uint32 x = 0; x < dstW; x++)
+					_mm_storeu_ps(dstRow + x * 4, _mm_setzero_ps());
+
+				for (uint32 i = tap.Offset; i < tap.Offset + tap.Count; i++)
+				{
+					const float32* srcRow = (const float32*)(horizontal.data() + (uint64)tapsY.Indices[i] * dstW);
+					__m128 weight = _mm_set1_ps(tapsY.Weights[i]);
+
+					for (uint32 x = 0; x < dstW; x++)
+					{
+						__m128 acc = _mm_loadu_ps(dstRow + x * 4);
+						_mm_storeu_ps(dstRow + x * 4, _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(srcRow + x * 4), weight)));
+					}
+				}
+			}
+			});
+	}
+
+	Vec3 CubeTexelToDirection(uint32 face, uint32 x, uint32 y, uint32 size)
+	{
+		float32 s = (2.f * x + 1.f) / size - 1.f;
+		float32 t = (2.f * y + 1.f) / size - 1.f;
+
+		switch (face)
+		{
+		case 0:  return Vec3(1.f, -t, -s);
+		case 1:  return Vec3(-1.f, -t, s);
+		case 2:  return Vec3(s, 1.f, t);
+		case 3:  return Vec3(s, -1.f, -t);
+		case 4:  return Vec3(s, -t, 1.f);
+		default: return Vec3(-s, -t, -1.f);
+		}
+	}
+
+	void DirectionToCubeTexel(const Vec3& dir, uint32 size, uint32& outFace, uint32& outX, uint32& outY)
+	{
+		Vec3 a = glm::abs(dir);
+		float32 ma, sc, tc;
+
+		if (a.x >= a.y && a.x >= a.z)
+		{
+			outFace = dir.x > 0.f ? 0 : 1;
+			ma = a.x;
+			sc = dir.x > 0.f ? -dir.z : dir.z;
+			tc = -dir.y;
+		}
+		else if (a.y >= a.z)
+		{
+			outFace = dir.y > 0.f ? 2 : 3;
+			ma = a.y;
+			sc = dir.x;
+			tc = dir.y > 0.f ? dir.z : -dir.z;
+		}
+		else
+		{
+			outFace = dir.z > 0.f ? 4 : 5;
+			ma = a.z;
+			sc = dir.z > 0.f ? dir.x : -dir.x;
+			tc = -dir.y;
+		}
+
+		float32 u = (sc / ma + 1.f) * 0.5f;
+		float32 v = (tc / ma + 1.f) * 0.5f;
+		outX = std::min((uint32)(u * size), size - 1);
+		outY = std::min((uint32)(v * size), size - 1);
+	}
+
+	// averages every border texel with the texels across the face edges (two at the corners),
+	// so bilinear filtering across a seam does not show a discontinuity on lower mips
+	static void FixupCubeEdges(std::vector<MipImage>& faces)
+	{
+		uint32 size = faces[0].Width;
+
+		if (size == 1)
+		{
+			Vec4 average(0.f);
+			for (const MipImage& face : faces)
+				average += face.Texels[0] / 6.f;
+
+			for (MipImage& face : faces)
+				face.Texels[0] = average;
+
+			return;
+		}
+
+		std::vector<MipImage> source = faces;
+		float32 edge = 1.f - 1.f / size;
+
+		JobSystem::ParallelFor(6, 1, [&](uint32 begin, uint32 end) {
+			for (uint32 face = begin; face < end; face++)
+			{
+				for (uint32 y = 0; y < size; y++)
+				{
+					// interior rows only touch the first and last column
+					uint32 step = (y == 0 || y == size - 1) ? 1 : size - 1;
+
+					for (uint32 x = 0; x < size; x += step)
+					{
+						Vec3 dir = CubeTexelToDirection(face, x, y, size);
+						uint32 major = 0;
+						for (uint32 k = 1; k < 3; k++)
+						{
+							if (std::abs(dir[k]) > std::abs(dir[major]))
+								major = k;
+						}
+
+						Vec4 sum = source[face].Texels[(uint64)y * size + x];
+						float32 count = 1.f;
+
+						for (uint32 k = 0; k < 3; k++)
+						{
+							if (k == major || std::abs(dir[k]) < edge - 1e-4f)
+								continue;
+
+							// mirror the texel center over the edge onto the neighbouring face
+							Vec3 neighbour = dir;
+							neighbour[major] = dir[major] > 0.f ? edge : -edge;
+							neighbour[k] = dir[k] > 0.f ? 1.f : -1.f;
+
+							uint32 nFace, nX, nY;
+							DirectionToCubeTexel(neighbour, size, nFace, nX, nY);
+
+							sum += source[nFace].Texels[(uint64)nY * size + nX];
+							count += 1.f;
+						}
+
+						faces[face].Texels[(uint64)y * size + x] = sum / count;
+					}
+				}
+			}
+			});
+	}
+
+	static float32 ComputeAlphaCoverage(const MipImage& image, float32 cutoff, float32 scale)
+	{
+		uint64 passed = 0;
+		for (const Vec4& texel : image.Texels)
+			passed += texel.a * scale >= cutoff ? 1 : 0;
+
+		return (float32)passed / (float32)image.Texels.size();
+	}
+
+	static float32 FindAlphaScale(const MipImage& image, float32 cutoff, float32 targetCoverage)
+	{
+		float32 low = 0.f;
+		float32 high = 4.f;
+
+		for (uint32 i = 0; i < 12; i++)
+		{
+			float32 mid = (low + high) * 0.5f;
+
+			if (ComputeAlphaCoverage(image, cutoff, mid) > targetCoverage)
+				high = mid;
+			else
+				low = mid;
+		}
+
+		return (low + high) * 0.5f;
+	}
+
+	static void FinalizeMip(MipImage& image, const MipGenDesc& desc, float32 targetCoverage)
+	{
+		if (EnumHasAnyFlags(desc.Flags, EMipGenFlags::NormalMap))
+		{
+			for (Vec4& texel : image.Texels)
+			{
+				Vec3 normal(texel);
+				float32 len = glm::length(normal);
+				normal = len > 1e-6f ? normal / len : Vec3(0.f, 0.f, 1.f);
+
+				texel = Vec4(normal, texel.a);
+			}
+		}
+
+		if (EnumHasAnyFlags(desc.Flags, EMipGenFlags::PreserveAlphaCoverage))
+		{
+			float32 scale = FindAlphaScale(image, desc.AlphaCutoff, targetCoverage);
+
+			for (Vec4& texel : image.Texels)
+				texel.a = std::min(texel.a * scale, 1.f);
+		}
+	}
+
+	using StoreMipDelegate = std::function<void(uint32 mip, uint32 layer, const MipImage& image)>;
+
+	static uint32 GetNumGeneratedMips(const MipGenDesc& desc)
+	{
+		uint32 fullChain = NumTextureMips(desc.Width, desc.Height);
+		return desc.NumMips > 0 ? std::min(desc.NumMips, fullChain) : fullChain;
+	}
+
+	static uint64 GetMipTexelOffset(const MipGenDesc& desc, uint32 mip, uint32 layer)
+	{
+		uint64 offset = 0;
+		for (uint32 m = 0; m < mip; m++)
+			offset += (uint64)std::max(1u, desc.Width >> m) * std::max(1u, desc.Height >> m) * desc.NumLayers;
+
+		return offset + (uint64)std::max(1u, desc.Width >> mip) * std::max(1u, desc.Height >> mip) * layer;
+	}
+
+	static bool ValidateMipGenDesc(const MipGenDesc& desc)
+	{
+		if (desc.Width == 0 || desc.Height == 0 || desc.NumLayers == 0)
+		{
+			ENGINE_ERROR("Invalid mip generation source extents!");
+			return false;
+		}
+
+		if (EnumHasAnyFlags(desc.Flags, EMipGenFlags::Cubemap) && (desc.NumLayers != 6 || desc.Width != desc.Height))
+		{
+			ENGINE_ERROR("Cubemap mip generation expects six square layers!");
+			return false;
+		}
+
+		return true;
+	}
+
+	// generates mips 1..n from the already loaded base level, mip 0 is stored by the caller
+	static void GenerateMipChain(const MipGenDesc& desc, std::vector<MipImage>&& baseLayers, const StoreMipDelegate& store)
+	{
+		PROFILE_SCOPED;
+
+		uint32 numMips = GetNumGeneratedMips(desc);
+
+		std::vector<float32> targetCoverage(desc.NumLayers, 0.f);
+		if (EnumHasAnyFlags(desc.Flags, EMipGenFlags::PreserveAlphaCoverage))
+		{
+			for (uint32 layer = 0; layer < desc.NumLayers; layer++)
+				targetCoverage[layer] = ComputeAlphaCoverage(baseLayers[layer], desc.AlphaCutoff, 1.f);
+		}
+
+		std::vector<MipImage> current = std::move(baseLayers);
+		std::vector<MipImage> next(desc.NumLayers);
+		FilterTaps tapsX, tapsY;
+
+		for (uint32 mip = 1; mip < numMips; mip++)
+		{
+			uint32 dstW = std::max(1u, desc.Width >> mip);
+			uint32 dstH = std::max(1u, desc.Height >> mip);
+
+			ComputeFilterTaps(desc.Filter, current[0].Width, dstW, tapsX);
+			ComputeFilterTaps(desc.Filter, current[0].Height, dstH, tapsY);
+
+			// layers run as separate jobs on top of the per row split inside Resample
+			JobSystem::Counter counter{};
+			for (uint32 layer = 0; layer < desc.NumLayers; layer++)
+			{
+				JobSystem::Execute(counter, [&, layer]() {
+					Resample(current[layer], tapsX, tapsY, next[layer]);
+					});
+			}
+			JobSystem::Wait(counter);
+
+			// the next level is filtered from the unmodified data, fixups only go to the output
+			std::vector<MipImage> output = next;
+			if (EnumHasAnyFlags(desc.Flags, EMipGenFlags::Cubemap))
+				FixupCubeEdges(output);
+
+			JobSystem::ParallelFor(desc.NumLayers, 1, [&](uint32 begin, uint32 end) {
+				for (uint32 layer = begin; layer < end; layer++)
+				{
+					FinalizeMip(output[layer], desc, targetCoverage[layer]);
+					store(mip, layer, output[layer]);
+				}
+				});
+
+			std::swap(current, next);
+		}
+	}
+
+	static float32 SRGBToLinear(float32 value)
+	{
+		return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+	}
+
+	static float32 LinearToSRGB(float32 value)
+	{
+		return value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.f / 2.4f) - 0.055f;
+	}
+
+	std::vector<uint8> GenerateMips(const uint8* rgba, const MipGenDesc& desc)
+	{
+		if (!ValidateMipGenDesc(desc))
+			return {};
+
+		bool srgb = EnumHasAnyFlags(desc.Flags, EMipGenFlags::SRGB);
+		bool normalMap = EnumHasAnyFlags(desc.Flags, EMipGenFlags::NormalMap);
+
+		float32 decodeTable[256];
+		for (uint32 i = 0; i < 256; i++)
+		{
+			float32 value = (float32)i / 255.f;
+
+			if (normalMap)
+				decodeTable[i] = value * 2.f - 1.f;
+			else
+				decodeTable[i] = srgb ? SRGBToLinear(value) : value;
+		}
+
+		uint64 baseTexels = (uint64)desc.Width * desc.Height;
+		uint32 numMips = GetNumGeneratedMips(desc);
+		std::vector<uint8> result(GetMipTexelOffset(desc, numMips, 0) * 4);
+
+		// mip 0 is copied as is, no round trip through float
+		memcpy(result.data(), rgba, baseTexels * desc.NumLayers * 4);
+
+		std::vector<MipImage> baseLayers(desc.NumLayers);
+		for (uint32 layer = 0; layer < desc.NumLayers; layer++)
+		{
+			MipImage& image = baseLayers[layer];
+			image.Width = desc.Width;
+			image.Height = desc.Height;
+			image.Texels.resize(baseTexels);
+
+			const uint8* src = rgba + baseTexels * layer * 4;
+			for (uint64 i = 0; i < baseTexels; i++)
+			{
+				image.Texels[i] = Vec4(decodeTable[src[i * 4 + 0]], decodeTable[src[i * 4 + 1]],
+					decodeTable[src[i * 4 + 2]], (float32)src[i * 4 + 3] / 255.f);
+			}
+		}
+
+		GenerateMipChain(desc, std::move(baseLayers), [&](uint32 mip, uint32 layer, const MipImage& image) {
+			uint8* dst = result.data() + GetMipTexelOffset(desc, mip, layer) * 4;
+
+			for (uint64 i = 0; i < image.Texels.size(); i++)
+			{
+				Vec4 texel = image.Texels[i];
+
+				for (uint32 c = 0; c < 3; c++)
+				{
+					if (normalMap)
+						texel[c] = texel[c] * 0.5f + 0.5f;
+					else if (srgb)
+						texel[c] = LinearToSRGB(std::max(texel[c], 0.f));
+				}
+
+				texel = glm::clamp(texel, Vec4(0.f), Vec4(1.f));
+				for (uint32 c = 0; c < 4; c++)
+					dst[i * 4 + c] = (uint8)(texel[c] * 255.f + 0.5f);
+			}
+			});
+
+		return result;
+	}
+
+	std::vector<float32> GenerateMips(const float32* rgba, const MipGenDesc& desc)
+	{
+		if (!ValidateMipGenDesc(desc))
+			return {};
+
+		uint64 baseTexels = (uint64)desc.Width * desc.Height;
+		uint32 numMips = GetNumGeneratedMips(desc);
+		std::vector<float32> result(GetMipTexelOffset(desc, numMips, 0) * 4);
+
+		memcpy(result.data(), rgba, baseTexels * desc.NumLayers * sizeof(Vec4));
+
+		std::vector<MipImage> baseLayers(desc.NumLayers);
+		for (uint32 layer = 0; layer < desc.NumLayers; layer++)
+		{
+			MipImage& image = baseLayers[layer];
+			image.Width = desc.Width;
+			image.Height = desc.Height;
+			image.Texels.resize(baseTexels);
+
+			memcpy(image.Texels.data(), rgba + baseTexels * layer * 4, baseTexels * sizeof(Vec4));
+		}
+
+		GenerateMipChain(desc, std::move(baseLayers), [&](uint32 mip, uint32 layer, const MipImage& image) {
+			float32* dst = result.data() + GetMipTexelOffset(desc, mip, layer) * 4;
+			memcpy(dst, image.Texels.data(), image.Texels.size() * sizeof(Vec4));
+			});
+
+		return result;
+	}
+}
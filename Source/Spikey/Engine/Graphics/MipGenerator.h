@@ -0,0 +1,45 @@
+#pragma once
+#include <Engine/Core/Math.h>
+
+namespace Spikey {
+
+	enum class EMipFilter : uint8
+	{
+		Box,
+		Kaiser,
+		Lanczos
+	};
+
+	enum class EMipGenFlags : uint8
+	{
+		None = 0,
+		SRGB                  = BIT(0), // filter rgb in linear space
+		NormalMap             = BIT(1), // renormalize xyz after filtering
+		PreserveAlphaCoverage = BIT(2), // keep the fraction of texels passing AlphaCutoff constant
+		Cubemap               = BIT(3)  // six layers, edges are averaged with the neighbouring faces
+	};
+	ENUM_FLAGS_OPERATORS(EMipGenFlags);
+
+	struct MipGenDesc
+	{
+		uint32       Width = 0;
+		uint32       Height = 0;
+		uint32       NumLayers = 1;
+		uint32       NumMips = 0; // 0 generates the full chain
+		EMipFilter   Filter = EMipFilter::Kaiser;
+		EMipGenFlags Flags = EMipGenFlags::None;
+		float32      AlphaCutoff = 0.5f;
+	};
+
+	// vulkan cube face order and orientation (+x, -x, +y, -y, +z, -z), directions are not normalized
+	Vec3 CubeTexelToDirection(uint32 face, uint32 x, uint32 y, uint32 size);
+	void DirectionToCubeTexel(const Vec3& dir, uint32 size, uint32& outFace, uint32& outX, uint32& outY);
+
+	// builds the mip chain of a RGBA8U image, layers of the source are stored one after another.
+	// the result holds mip 0 too and is laid out mip after mip with all layers of a mip next to each other,
+	// the layout texture files store. normal maps are expected in the usual unsigned encoding
+	std::vector<uint8> GenerateMips(const uint8* rgba, const MipGenDesc& desc);
+
+	// same for RGBA32F data, the SRGB flag is ignored and normal maps are expected to be signed
+	std::vector<float32> GenerateMips(const float32* rgba, const MipGenDesc& desc);
+}
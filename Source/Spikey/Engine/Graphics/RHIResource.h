@@ -17,12 +17,27 @@ namespace Spikey {
 		CopyDst = BIT(6),
 		ColorTarget = BIT(7),
 		DepthTarget = BIT(8),
+		General = BIT(9), // reads no single optimal layout serves, the texture is kept in one every access supports
 
 		SRV = SRVCompute | SRVGraphics,
 		UAV = UAVCompute | UAVGraphics
 	};
 	ENUM_FLAGS_OPERATORS(ERHIAccess);
 
+	// state of several reads of the same subresources at once. shader reads and copies read from different
+	// layouts, together they need General
+	inline ERHIAccess CombineReadAccess(ERHIAccess a, ERHIAccess b)
+	{
+		ERHIAccess combined = a | b;
+		if (EnumHasAnyFlags(combined, ERHIAccess::SRV) && EnumHasAnyFlags(combined, ERHIAccess::CopySrc))
+			combined |= ERHIAccess::General;
+
+		return combined;
+	}
+
+	// slot of a resource in the global bindless tables, stable for the lifetime of the resource
+	constexpr uint32 BINDLESS_INVALID_INDEX = ~0u;
+
 	class IRHIResource : public IRefCounted
 	{
 	public:
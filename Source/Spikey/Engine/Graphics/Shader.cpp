@@ -82,33 +82,195 @@ namespace Spikey {
 		}
 	}
 
-	Shader::Shader(const ShaderDesc& desc, ShaderData&& data, UUID id) {
+	Shader::Shader(ShaderFile&& file, UUID id) {
 		m_ID = id;
-		CreateResource(desc, std::move(data));
-	}
+		m_Type = file.Type;
+
+		IRHIDevice& rhi = Graphics::GetRHI();
+		std::span<uint8> bytecode(file.Bytecode);
 
-	Shader::~Shader() {
-		ReleaseResource();
+		switch (file.Type) {
+		case EShaderType::Vertex:
+			m_RHIShader = rhi.CreateVertexShader(bytecode, &file.Reflection);
+			break;
+		case EShaderType::Pixel:
+			m_RHIShader = rhi.CreatePixelShader(bytecode, &file.Reflection);
+			break;
+		case EShaderType::Compute:
+			m_RHIShader = rhi.CreateComputeShader(bytecode, &file.Reflection);
+			break;
+		default:
+			CHECK(false);
+			break;
+		}
 	}
 
 	TRef<Shader> Shader::Create(BinaryReadStream& stream, UUID id) {
-		char magic[4] = {};
-		stream >> magic;
+		ShaderFile file{};
+
+		if (!ReadShaderFile(stream, file)) {
+			ENGINE_ERROR("Shader asset file {} is corrupted or of an older version, cook it again!", (uint64)id);
+			return nullptr;
+		}
 
-		if (memcmp(magic, SHADER_MAGIC, sizeof(char) * 4) != 0) {
-			ENGINE_ERROR("Corrupted shader asset file: {}", (uint64)id);
+		if (file.Type == EShaderType::None) {
+			ENGINE_ERROR("Shader asset file {} has no shader type!", (uint64)id);
 			return nullptr;
 		}
 
-		ShaderData data{};
+		return CreateRef<Shader>(std::move(file), id);
+	}
+
+	bool ReadShaderFile(BinaryReadStream& stream, ShaderFile& outFile) 
+	{
+		char   magic[4] = {};
+		uint32 version = 0;
+		stream >> magic >> version;
+
+		if (memcmp(magic, SHADER_MAGIC, sizeof(char) * 4) != 0 || version != SHADER_FILE_VERSION)
+			return false;
+
+		ShaderReflection& reflection = outFile.Reflection;
+		stream >> outFile.Type >> reflection.Bindings >> reflection.PushConstantOffset >> reflection.PushConstantSize;
+		stream >> outFile.Bytecode;
+
+		return !outFile.Bytecode.empty();
+	}
+
+	void WriteShaderFile(BinaryWriteStream& stream, const ShaderFile& file) 
+	{
+		const ShaderReflection& reflection = file.Reflection;
+
+		stream << SHADER_MAGIC << SHADER_FILE_VERSION;
+		stream << file.Type << reflection.Bindings << reflection.PushConstantOffset << reflection.PushConstantSize;
+		stream << file.Bytecode;
+	}
+
+	static bool StencilEqual(const PipelineStateDesc::StencilState& a, const PipelineStateDesc::StencilState& b) 
+	{
+		return (a.ReadMask == b.ReadMask
+			&& a.WriteMask == b.WriteMask
+			&& a.Func == b.Func
+			&& a.FailOp == b.FailOp
+			&& a.DepthFailOp == b.DepthFailOp
+			&& a.PassOp == b.PassOp);
+	}
+
+	static bool RenderTargetEqual(const PipelineStateDesc::RenderTarget& a, const PipelineStateDesc::RenderTarget& b) 
+	{
+		if (a.Format != b.Format || a.EnableBlend != b.EnableBlend || a.ColorMask != b.ColorMask)
+			return false;
+
+		if (!a.EnableBlend)
+			return true;
+
+		return (a.SrcBlend == b.SrcBlend
+			&& a.DstBlend == b.DstBlend
+			&& a.BlendOp == b.BlendOp
+			&& a.SrcBlendAlpha == b.SrcBlendAlpha
+			&& a.DstBlendAlpha == b.DstBlendAlpha
+			&& a.BlendOpAlpha == b.BlendOpAlpha);
 	}
 
-	void Shader::ReleaseResource() {
-		SafeResourceRelease(m_RHIResource);
+	bool PipelineStateDesc::operator==(const PipelineStateDesc& other) const 
+	{
+		if (ComputeShader || other.ComputeShader)
+			return ComputeShader == other.ComputeShader;
+
+		if (VertexShader != other.VertexShader || PixelShader != other.PixelShader)
+			return false;
+
+		if (DepthEnable != other.DepthEnable
+			|| DepthWriteEnable != other.DepthWriteEnable
+			|| DepthClipEnable != other.DepthClipEnable
+			|| DepthFormat != other.DepthFormat
+			|| (DepthEnable && DepthFunc != other.DepthFunc))
+		{
+			return false;
+		}
+
+		if (StencilEnable != other.StencilEnable)
+			return false;
+		if (StencilEnable && (!StencilEqual(FrontStencil, other.FrontStencil) || !StencilEqual(BackStencil, other.BackStencil)))
+			return false;
+
+		if (PrimitiveTopology != other.PrimitiveTopology
+			|| CullMode != other.CullMode
+			|| FrontFace != other.FrontFace
+			|| Wireframe != other.Wireframe
+			|| NumRenderTargets != other.NumRenderTargets)
+		{
+			return false;
+		}
+
+		for (uint8 i = 0; i < NumRenderTargets; i++) 
+		{
+			if (!RenderTargetEqual(RenderTargets[i], other.RenderTargets[i]))
+				return false;
+		}
+
+		return true;
 	}
 
-	void Shader::CreateResource(const ShaderDesc& desc, ShaderData&& data) {
-		m_RHIResource = new RHIShader(desc, std::move(data));
-		SafeResourceInit(m_RHIResource);
+	// has to skip exactly what operator== skips
+	uint64 HashPipelineStateDesc(const PipelineStateDesc& desc) 
+	{
+		uint64 hash = 0;
+
+		if (desc.ComputeShader) 
+		{
+			Math::HashCombine(hash, desc.ComputeShader);
+			return hash;
+		}
+
+		Math::HashCombine(hash, desc.VertexShader);
+		Math::HashCombine(hash, desc.PixelShader);
+
+		Math::HashCombine(hash, desc.DepthEnable);
+		Math::HashCombine(hash, desc.DepthWriteEnable);
+		Math::HashCombine(hash, desc.DepthClipEnable);
+		Math::HashCombine(hash, desc.DepthFormat);
+		if (desc.DepthEnable)
+			Math::HashCombine(hash, desc.DepthFunc);
+
+		Math::HashCombine(hash, desc.StencilEnable);
+		if (desc.StencilEnable) 
+		{
+			for (const PipelineStateDesc::StencilState* stencil : { &desc.FrontStencil, &desc.BackStencil }) 
+			{
+				Math::HashCombine(hash, stencil->ReadMask);
+				Math::HashCombine(hash, stencil->WriteMask);
+				Math::HashCombine(hash, stencil->Func);
+				Math::HashCombine(hash, stencil->FailOp);
+				Math::HashCombine(hash, stencil->DepthFailOp);
+				Math::HashCombine(hash, stencil->PassOp);
+			}
+		}
+
+		Math::HashCombine(hash, desc.PrimitiveTopology);
+		Math::HashCombine(hash, desc.CullMode);
+		Math::HashCombine(hash, desc.FrontFace);
+		Math::HashCombine(hash, desc.Wireframe);
+		Math::HashCombine(hash, desc.NumRenderTargets);
+
+		for (uint8 i = 0; i < desc.NumRenderTargets; i++) 
+		{
+			const PipelineStateDesc::RenderTarget& rt = desc.RenderTargets[i];
+
+			Math::HashCombine(hash, rt.Format);
+			Math::HashCombine(hash, rt.EnableBlend);
+			Math::HashCombine(hash, rt.ColorMask);
+			if (rt.EnableBlend) 
+			{
+				Math::HashCombine(hash, rt.SrcBlend);
+				Math::HashCombine(hash, rt.DstBlend);
+				Math::HashCombine(hash, rt.BlendOp);
+				Math::HashCombine(hash, rt.SrcBlendAlpha);
+				Math::HashCombine(hash, rt.DstBlendAlpha);
+				Math::HashCombine(hash, rt.BlendOpAlpha);
+			}
+		}
+
+		return hash;
 	}
-}
\ No newline at end of file
+}
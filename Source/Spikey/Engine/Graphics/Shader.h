@@ -3,6 +3,7 @@
 #include <Engine/Graphics/Texture2D.h>
 #include <Engine/Graphics/Buffer.h>
 #include <Engine/Graphics/TextureCube.h>
+#include <Engine/Serialization/BinaryStream.h>
 
 namespace Spikey {
 
@@ -28,6 +29,36 @@ namespace Spikey {
 
 	constexpr char SHADER_MAGIC[4] = { 'S', 'C', 'S', 'F' };
 	constexpr char MATERIAL_SHADER_MAGIC[4] = { 'S', 'M', 'S', 'F' };
+	constexpr uint32 SHADER_FILE_VERSION = 1;
+
+	// binding layout reflected from the bytecode when the shader is cooked, so creating it at runtime
+	// does not have to parse the bytecode again
+	struct ShaderReflection
+	{
+		struct Binding
+		{
+			uint32 Set;
+			uint32 Binding;
+			uint32 Count;
+			uint32 DescriptorType; // SpvReflectDescriptorType, the values match VkDescriptorType
+		};
+
+		std::vector<Binding> Bindings;
+		uint32               PushConstantOffset = 0;
+		uint32               PushConstantSize = 0; // 0 without push constants
+	};
+
+	// SCSF file, magic, version, type, reflection, bytecode
+	struct ShaderFile
+	{
+		EShaderType        Type = EShaderType::None;
+		ShaderReflection   Reflection;
+		std::vector<uint8> Bytecode;
+	};
+
+	// false for files of other formats or older versions, those have to be cooked again
+	bool ReadShaderFile(BinaryReadStream& stream, ShaderFile& outFile);
+	void WriteShaderFile(BinaryWriteStream& stream, const ShaderFile& file);
 
 	class IRHIShader : public IRefCounted {
 	public:
@@ -37,6 +68,21 @@ namespace Spikey {
 
 	using ShaderRHIRef = TRef<IRHIShader>;
 
+	// cooked SCSF shader, created with the reflection stored in the file so the bytecode is not parsed again
+	class Shader : public IAsset {
+	public:
+		Shader(ShaderFile&& file, UUID id);
+
+		static TRef<Shader> Create(BinaryReadStream& stream, UUID id);
+
+		EShaderType GetType() const { return m_Type; }
+		IRHIShader* GetRHI() const { return m_RHIShader.Get(); }
+
+	private:
+		EShaderType  m_Type = EShaderType::None;
+		ShaderRHIRef m_RHIShader;
+	};
+
 	enum class EFrontFace : uint8 {
 		None = 0,
 
@@ -174,13 +220,36 @@ namespace Spikey {
 			EBlendOp BlendOpAlpha = EBlendOp::Add;
 			EColorMask ColorMask = EColorMask::All;
 		} RenderTargets[8];
+
+		// canonical, state the pipeline can not observe is skipped (graphics state of compute pipelines,
+		// disabled stencil and blend, render targets past NumRenderTargets)
+		bool operator==(const PipelineStateDesc& other) const;
 	};
 
+	uint64 HashPipelineStateDesc(const PipelineStateDesc& desc);
+
 	class RHIPipelineState : public IRefCounted 
 	{
 	public:
 		RHIPipelineState() = default;
+
+		// false while an async compile is in flight, see IRHIDevice::ResolvePipelineState
+		bool IsReady() const { return m_Ready.load(std::memory_order_acquire); }
+
+	protected:
+		std::atomic<bool> m_Ready{ true };
 	};
 
 	using PipelineStateRHIRef = TRef<RHIPipelineState>;
-}
\ No newline at end of file
+}
+
+namespace std 
+{
+	template<> struct hash<Spikey::PipelineStateDesc> 
+	{
+		size_t operator()(const Spikey::PipelineStateDesc& desc) const 
+		{
+			return Spikey::HashPipelineStateDesc(desc);
+		}
+	};
+}
@@ -0,0 +1,68 @@
+#include <Engine/Graphics/ShaderArchive.h>
+
+namespace Spikey {
+
+	bool ShaderArchive::Read(BinaryReadStream& stream)
+	{
+		char   magic[4] = {};
+		uint32 version = 0;
+		stream >> magic >> version;
+
+		if (memcmp(magic, SHADER_ARCHIVE_MAGIC, sizeof(char) * 4) != 0 || version != SHADER_ARCHIVE_VERSION)
+			return false;
+
+		uint64 numBlobs = 0;
+		stream >> numBlobs;
+
+		Blobs.resize(numBlobs);
+		for (ShaderFile& blob : Blobs)
+		{
+			if (!ReadShaderFile(stream, blob))
+				return false;
+		}
+
+		uint64 numEntries = 0;
+		stream >> numEntries;
+
+		Entries.resize(numEntries);
+		for (Entry& entry : Entries)
+		{
+			stream >> entry.Key >> entry.Blob >> entry.DependencyHash >> entry.Dependencies;
+
+			if (entry.Blob >= Blobs.size())
+				return false;
+		}
+
+		return true;
+	}
+
+	void ShaderArchive::Write(BinaryWriteStream& stream) const
+	{
+		stream << SHADER_ARCHIVE_MAGIC << SHADER_ARCHIVE_VERSION;
+
+		stream << (uint64)Blobs.size();
+		for (const ShaderFile& blob : Blobs)
+			WriteShaderFile(stream, blob);
+
+		stream << (uint64)Entries.size();
+		for (const Entry& entry : Entries)
+			stream << entry.Key << entry.Blob << entry.DependencyHash << entry.Dependencies;
+	}
+
+	const ShaderArchive::Entry* ShaderArchive::FindEntry(ShaderPermutationKey key) const
+	{
+		auto it = std::lower_bound(Entries.begin(), Entries.end(), key,
+			[](const Entry& entry, ShaderPermutationKey k) { return entry.Key < k; });
+
+		if (it == Entries.end() || it->Key != key)
+			return nullptr;
+
+		return &(*it);
+	}
+
+	const ShaderFile* ShaderArchive::Find(ShaderPermutationKey key) const
+	{
+		const Entry* entry = FindEntry(key);
+		return entry ? &Blobs[entry->Blob] : nullptr;
+	}
+}
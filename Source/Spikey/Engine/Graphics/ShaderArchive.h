@@ -0,0 +1,35 @@
+#pragma once
+#include <Engine/Graphics/Shader.h>
+
+namespace Spikey {
+
+	constexpr char SHADER_ARCHIVE_MAGIC[4] = { 'S', 'V', 'A', 'F' };
+	constexpr uint32 SHADER_ARCHIVE_VERSION = 1;
+
+	// bit i of a key enables the i-th define the permutations were declared with
+	using ShaderPermutationKey = uint64;
+
+	// cooked variants of one shader entry point. permutations compiling to the same bytecode share a blob
+	struct ShaderArchive
+	{
+		struct Entry
+		{
+			ShaderPermutationKey Key;
+			uint32               Blob;
+			uint64               DependencyHash; // source, includes and compile options the blob was built from
+
+			// source and every file it included, only needed to check the entry is up to date
+			std::vector<std::string> Dependencies;
+		};
+
+		std::vector<Entry>      Entries; // sorted by key
+		std::vector<ShaderFile> Blobs;
+
+		// false for files of other formats or older versions
+		bool Read(BinaryReadStream& stream);
+		void Write(BinaryWriteStream& stream) const;
+
+		const Entry*      FindEntry(ShaderPermutationKey key) const;
+		const ShaderFile* Find(ShaderPermutationKey key) const;
+	};
+}
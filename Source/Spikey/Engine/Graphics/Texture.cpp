@@ -1,4 +1,4 @@
-#include <Engine/Graphics/TextureBase.h>
+#include <Engine/Graphics/Texture.h>
 #include <Engine/Graphics/GraphicsCore.h>
 #include <Engine/Graphics/FrameRenderer.h>
 
@@ -17,6 +17,7 @@ uint32 Spikey::TextureTexelSize(ETextureFormat format) {
 	case ETextureFormat::RGBABC6:
 		return 16;
 	case ETextureFormat::RGBA8U:
+	case ETextureFormat::BGRA8U:
 	case ETextureFormat::D32F:
 	case ETextureFormat::R32F:
 	case ETextureFormat::RG16F:
@@ -35,6 +36,11 @@ uint32 Spikey::NumTextureMips(uint32 width, uint32 height) {
 	return uint32(std::floor(std::log2(std::max(width, height)))) + 1;
 }
 
+bool Spikey::IsTextureCompressed(ETextureFormat format) {
+	return format == ETextureFormat::RGBBC1 || format == ETextureFormat::RGBABC6
+		|| format == ETextureFormat::RGBABC3 || format == ETextureFormat::RGBC5;
+}
+
 Vec2Uint Spikey::TextureMipExtents(ETextureFormat format, uint32 texW, uint32 texH, uint32 mip) {
 	bool compressed = (format == ETextureFormat::RGBBC1 || format == ETextureFormat::RGBABC6
 		|| format == ETextureFormat::RGBABC3 || format == ETextureFormat::RGBC5);
@@ -64,110 +70,47 @@ uint64 Spikey::TextureSizeInBytes(ETextureFormat format, uint32 width, uint32 he
 	return size;
 }
 
-namespace Spikey {
+Spikey::TextureSlice Spikey::ResolveTextureSlice(const TextureDesc& desc, const TextureSlice& slice) {
+	TextureSlice resolved = slice;
 
-	static uint32 GetSubresourceIdx(uint32 mip, uint32 layer, uint32 numMips) {
-		return mip + (layer * numMips);
-	}
+	if (slice.Width == ~0u) resolved.Width = std::max(1u, desc.Width >> slice.MipLevel) - slice.X;
+	if (slice.Height == ~0u) resolved.Height = std::max(1u, desc.Height >> slice.MipLevel) - slice.Y;
+	if (slice.Depth == ~0u) resolved.Depth = std::max(1u, desc.Depth >> slice.MipLevel) - slice.Z;
 
-	void IRHITexture::TextureState::SetResourceState(EGPUAccess newAccess) {
-		Access = newAccess;
-		AllSubresourcesSame = true;
-	}
-
-	void IRHITexture::TextureState::SetSubresourceState(uint32 index, EGPUAccess newAccess) {
-		if (AllSubresourcesSame) {
-			for (int32 i = 0; i < SubresourceAccess.size(); i++) {
-				SubresourceAccess[i] = Access;
-			}
+	return resolved;
+}
 
-			AllSubresourcesSame = false;
-		}
+uint64 Spikey::TextureSliceSizeInBytes(ETextureFormat format, const TextureSlice& slice) {
+	uint64 width = slice.Width;
+	uint64 height = slice.Height;
 
-		SubresourceAccess[index] = newAccess;
+	if (IsTextureCompressed(format)) {
+		width = (width + 3) / 4;
+		height = (height + 3) / 4;
 	}
 
-	IRHITexture::IRHITexture(uint32 numMips, uint32 numSubresources, ETextureFormat format, ETextureUsage usage)
-		: m_NumMips(numMips), m_Format(format), m_Usage(usage)
-	{
-		m_TextureView = Graphics::GetRHI().CreateTextureView(
-			0,
-			numMips,
-			0,
-			GetNumLayers(),
-			this
-		);
-
-		// TODO: maybe make optional
-		InitStateTracking(numSubresources);
-	}
+	return width * height * slice.Depth * TextureTexelSize(format);
+}
 
-	void IRHITexture::Barrier(IRHICommandList* cmd, uint32 baseMip, uint32 numMips, uint32 baseLayer, uint32 numLayers, EGPUAccess newAccess) {
-		bool entireTexture = (numMips == GetNumMips() && numLayers == GetNumLayers());
+namespace Spikey {
 
-		if (entireTexture && m_State.AllSubresourcesSame) {
-			bool needTransiton = (m_State.Access != newAccess) ||
-				EnumHasAnyFlags(newAccess, EGPUAccess::UAVCompute | EGPUAccess::UAVGraphics);
+	RHITexture::RHITexture(const TextureDesc& desc) : m_Desc(desc) {
+		m_State.Initialize(desc.MipLevels, desc.ArraySize, ERHIAccess::None, desc.EnableStateTracking);
+	}
 
-			if (needTransiton) {
-				TextureBarrierRegion region{};
-				region.EntireTexture = true;
-				region.LastAccess = m_State.Access;
-				region.NewAccess = newAccess;
+	void RHITexture::Barrier(RHICommandList* cmd, const TextureSubresourceSet& range, ERHIAccess newAccess) {
+		std::vector<TextureBarrierRegion> regions{};
+		TextureBarrierBuilder::Transition(m_State, range, newAccess, regions);
 
-				cmd->BarrierTexture(this, &region, 1);
-				m_State.SetResourceState(newAccess);
-			}
-		}
-		else {
-			std::vector<TextureBarrierRegion> regions{};
-
-			for (uint32 l = baseLayer; l < numLayers + baseLayer; l++) {
-				for (uint32 m = baseMip; m < numMips + baseMip; m++) {
-					uint32 subIdx = GetSubresourceIdx(m, l, GetNumMips());
-
-					bool needTransiton = (m_State.SubresourceAccess[subIdx] != newAccess) ||
-						EnumHasAnyFlags(newAccess, EGPUAccess::UAVCompute | EGPUAccess::UAVGraphics);
-
-					if (needTransiton) {
-						TextureBarrierRegion& region = regions.emplace_back(TextureBarrierRegion{});
-
-						region.BaseArrayLayer = l;
-						region.BaseMipLevel = m;
-						region.LayerCount = 1;
-						region.MipCount = 1;
-						region.EntireTexture = false;
-						region.LastAccess = m_State.SubresourceAccess[subIdx];
-						region.NewAccess = newAccess;
-					}
-
-					m_State.SetSubresourceState(subIdx, newAccess);
-				}
-			}
-
-			if (!regions.empty()) {
-				cmd->BarrierTexture(this, regions.data(), (uint32)regions.size());
-			}
-
-			if (entireTexture) {
-				m_State.SetResourceState(newAccess);
-			}
+		if (!regions.empty()) {
+			cmd->BarrierTexture(this, regions.data(), (uint32)regions.size());
 		}
 	}
 
-	void IRHITexture::Barrier(IRHICommandList* cmd, EGPUAccess newAccess) {
-		Barrier(cmd, 0, GetNumMips(), 0, GetNumLayers(), newAccess);
+	void RHITexture::Barrier(RHICommandList* cmd, ERHIAccess newAccess) {
+		Barrier(cmd, TextureSubresourceSet::AllTexture(), newAccess);
 	}
 
-	void IRHITexture::InitStateTracking(uint32 numSubresources) {
-		m_State.SubresourceAccess.clear();
-		m_State.SubresourceAccess.reserve(numSubresources);
-
-		for (uint32 i = 0; i < numSubresources; i++) {
-			m_State.SubresourceAccess.push_back(EGPUAccess::None);
-		}
-
-		m_State.Access = EGPUAccess::None;
-		m_State.AllSubresourcesSame = true;
+	RHISamplerState::RHISamplerState(const SamplerStateDesc& desc) : m_Desc(desc) {
 	}
 }
\ No newline at end of file
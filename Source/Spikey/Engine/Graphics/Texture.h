@@ -1,6 +1,6 @@
 #pragma once
 
-#include <Engine/Graphics/RHIResource.h>
+#include <Engine/Graphics/TextureState.h>
 #include <Engine/Core/Math.h>
 
 namespace Spikey 
@@ -61,25 +61,6 @@ namespace Spikey
 	};
 	ENUM_FLAGS_OPERATORS(ETextureFlags);
 
-	struct TextureSubresourceSet 
-	{
-		uint32 BaseMip;
-		uint32 NumMips;
-		uint32 BaseLayer;
-		uint32 NumLayers;
-
-		static TextureSubresourceSet AllTexture() 
-		{
-			TextureSubresourceSet range{};
-			range.BaseMip = 0;
-			range.BaseLayer = 0;
-			range.NumMips = ~0u;
-			range.NumLayers = ~0u;
-
-			return range;
-		}
-	};
-
 	struct TextureDesc 
 	{
 		uint32            Width = 1;
@@ -108,57 +89,13 @@ namespace Spikey
 		uint32 ArraySlice;
 	};
 
-	struct TextureState
-	{
-		ERHIAccess              State;
-		bool                    AllSubresourcesSame;
-		std::vector<ERHIAccess> SubresourceStates;
+	// -1 extents resolved to the rest of the mip
+	TextureSlice ResolveTextureSlice(const TextureDesc& desc, const TextureSlice& slice);
 
-		void Initialize(uint32 subresourceCount, ERHIAccess initialState, bool usePerStateTracking)
-		{
-			assert(SubresourceStates.empty() && subresourceCount > 0);
-			AllSubresourcesSame = true;
-			State = initialState;
+	// a resolved slice with tightly packed rows, compressed formats in whole blocks
+	uint64 TextureSliceSizeInBytes(ETextureFormat format, const TextureSlice& slice);
 
-			if (usePerStateTracking && subresourceCount > 1)
-				SubresourceStates.resize(subresourceCount);
-		}
-
-		ERHIAccess GetSubresourceState(uint32 index)
-		{
-			if (AllSubresourcesSame)
-				return State;
-			return SubresourceStates[index];
-		}
-
-		void SetState(ERHIAccess state)
-		{
-			AllSubresourcesSame = true;
-			State = state;
-		}
-
-		void SetSubresourceState(uint32 index, ERHIAccess state)
-		{
-			if (index == -1 || SubresourceStates.size() <= 1)
-			{
-				SetState(state);
-			}
-			else
-			{
-				assert(index < SubresourceStates.size());
-
-				// transition for all subresources
-				if (AllSubresourcesSame)
-				{
-					for (int32 i = 0; i < SubresourceStates.size(); i++)
-						SubresourceStates[i] = State;
-					AllSubresourcesSame = false;
-				}
-
-				SubresourceStates[index] = state;
-			}
-		}
-	};
+	class RHICommandList;
 
 	class RHITexture : public IRHIResource
 	{
@@ -177,9 +114,20 @@ namespace Spikey
 		TextureState&      GetState() { return m_State; }
 		const TextureDesc& GetDesc() const { return m_Desc; }
 
+		// bindless table indices of the whole texture (sampled) and its first mip (storage),
+		// BINDLESS_INVALID_INDEX without the matching ETextureFlags
+		uint32 GetSRVIndex() const { return m_SRVIndex; }
+		uint32 GetUAVIndex() const { return m_UAVIndex; }
+
+		// records the coalesced barriers moving the range to newAccess
+		void Barrier(RHICommandList* cmd, const TextureSubresourceSet& range, ERHIAccess newAccess);
+		void Barrier(RHICommandList* cmd, ERHIAccess newAccess);
+
 	protected:
 		TextureDesc  m_Desc;
 		TextureState m_State;
+		uint32       m_SRVIndex = BINDLESS_INVALID_INDEX;
+		uint32       m_UAVIndex = BINDLESS_INVALID_INDEX;
 	};
 
 	using TextureRHIRef = TRef<RHITexture>;
@@ -243,8 +191,11 @@ namespace Spikey
 			return m_Desc;
 		}
 
+		uint32 GetBindlessIndex() const { return m_BindlessIndex; }
+
 	protected:
 		SamplerStateDesc m_Desc;
+		uint32           m_BindlessIndex = BINDLESS_INVALID_INDEX;
 	};
 }
 
@@ -1,5 +1,36 @@
 #include <Engine/Graphics/Texture2D.h>
 #include <Engine/Graphics/FrameRenderer.h>
+#include <Engine/Graphics/TextureStreamer.h>
+
+uint64 Spikey::Texture2DMipFileOffset(const Texture2DHeader& header, uint32 mip) {
+	bool tailFirst = EnumHasAnyFlags(header.FileFlags, ETexture2DFileFlags::TailFirst);
+	uint64 offset = 0;
+
+	for (uint32 m = 0; m < header.NumMips; m++) {
+		if (tailFirst ? m > mip : m < mip) {
+			offset += MipSizeInBytes(header.Format, header.Width, header.Height, m);
+		}
+	}
+	return offset;
+}
+
+void Spikey::WriteTexture2DFile(BinaryWriteStream& stream, Texture2DHeader header, const uint8* mipData) {
+	header.FileFlags |= ETexture2DFileFlags::TailFirst;
+	header.ByteSize = TextureSizeInBytes(header.Format, header.Width, header.Height, header.NumMips);
+
+	stream << TEXTURE_2D_MAGIC << TEXTURE_2D_FILE_VERSION;
+	stream << header;
+
+	// smallest mip first, so the always resident tail is a single read at load time
+	for (int32 m = (int32)header.NumMips - 1; m >= 0; m--) {
+		uint64 srcOffset = 0;
+		for (int32 i = 0; i < m; i++) {
+			srcOffset += MipSizeInBytes(header.Format, header.Width, header.Height, i);
+		}
+
+		stream.WriteRaw(mipData + srcOffset, MipSizeInBytes(header.Format, header.Width, header.Height, m));
+	}
+}
 
 namespace Spikey {
 
@@ -51,47 +82,92 @@ namespace Spikey {
 		m_RHIResource = Graphics::GetRHI().CreateTexture2D(desc);
 	}
 
-	Texture2D::~Texture2D() {}
+	Texture2D::~Texture2D() {
+		if (IsStreamed()) {
+			TextureStreamer::Unregister(m_StreamingHandle);
+		}
+	}
 
 	TRef<Texture2D> Texture2D::Create(const Texture2DDesc& desc) {
 		return CreateRef<Texture2D>(desc, 0);
 	}
 
+	void Texture2D::RequestMip(uint32 mip) {
+		if (IsStreamed()) {
+			TextureStreamer::RequestMip(m_StreamingHandle, mip);
+		}
+	}
+
+	void Texture2D::RequestScreenSize(float32 screenSize, float32 uvScale) {
+		if (IsStreamed()) {
+			TextureStreamer::RequestScreenSize(m_StreamingHandle, screenSize, uvScale);
+		}
+	}
+
 	TRef<Texture2D> Texture2D::Create(BinaryReadStream& stream, UUID id) {
 
 		char magic[4] = {};
-		stream >> magic;
+		uint32 version = 0;
+		stream >> magic >> version;
 
 		if (memcmp(magic, TEXTURE_2D_MAGIC, sizeof(char) * 4) != 0) {
 			ENGINE_ERROR("Corrupted texture 2D asset file: {}", (uint64)id);
 			return nullptr;
 		}
 
+		if (version != TEXTURE_2D_FILE_VERSION) {
+			ENGINE_ERROR("Texture 2D asset file {} has version {}, expected {}, import it again!", (uint64)id, version, TEXTURE_2D_FILE_VERSION);
+			return nullptr;
+		}
+
 		Texture2DHeader header{};
 		stream >> header;
 
+		// streamable files only load their tail here, higher mips are brought in by the texture streamer
+		bool streamable = EnumHasAnyFlags(header.FileFlags, ETexture2DFileFlags::TailFirst);
+		uint32 firstMip = streamable ? TextureStreamer::GetMinResidentMip(header.Width, header.Height, header.NumMips) : 0;
+
 		SamplerDesc samplDesc{};
 		samplDesc.Filter = header.Filter;
 		samplDesc.AddressU = header.AddressU;
 		samplDesc.AddressV = header.AddressV;
 		samplDesc.AddressW = header.AddressW;
-		samplDesc.MaxLOD = header.NumMips;
+		samplDesc.MaxLOD = header.NumMips - firstMip;
+
+		SamplerStateDesc samplerStateDesc{};
+		samplerStateDesc.Filter = header.Filter;
+		samplerStateDesc.AddressU = header.AddressU;
+		samplerStateDesc.AddressV = header.AddressV;
+		samplerStateDesc.AddressW = header.AddressW;
+		samplerStateDesc.MaxLOD = (float)(header.NumMips - firstMip);
 
 		Texture2DDesc desc{};
-		desc.Width = header.Width;
-		desc.Height = header.Height;
+		desc.Width = std::max(1u, header.Width >> firstMip);
+		desc.Height = std::max(1u, header.Height >> firstMip);
 		desc.Format = header.Format;
-		desc.NumMips = header.NumMips;
+		desc.NumMips = header.NumMips - firstMip;
 		desc.UsageFlags = ETextureUsage::Sampled | ETextureUsage::CopyDst;
 		desc.SamplerDesc = samplDesc;
 
-		uint8_t* buff = new uint8_t[header.ByteSize];
-		stream.ReadRaw(buff, header.ByteSize);
+		// the streamer copies the resident mips out when it reallocates
+		if (streamable)
+			desc.UsageFlags |= ETextureUsage::CopySrc;
+
+		// resident mips are at the start of a tail first payload
+		uint64 payloadOffset = stream.Tell();
+		uint64 loadSize = header.ByteSize;
+		if (firstMip > 0) {
+			loadSize = Texture2DMipFileOffset(header, firstMip) + MipSizeInBytes(header.Format, header.Width, header.Height, firstMip);
+		}
+
+		uint8_t* buff = new uint8_t[loadSize];
+		stream.ReadRaw(buff, loadSize);
+		stream.Seek(payloadOffset + header.ByteSize);
 
 		TRef<Texture2D> tex = CreateRef<Texture2D>(desc, id);
-		Graphics::SubmitCommand([rhi = tex->GetResource(), copySize = header.ByteSize, buff]() {
-			uint64 offset = 0;
+		tex->m_SamplerState = Graphics::GetRHI().CreateSamplerState(samplerStateDesc);
 
+		Graphics::SubmitCommand([rhi = tex->GetResource(), header, firstMip, copySize = loadSize, buff]() {
 			std::vector<SubResourceCopyRegion> regions{};
 			regions.reserve(rhi->GetNumMips());
 
@@ -99,14 +175,17 @@ namespace Spikey {
 
 				SubResourceCopyRegion& region = regions.emplace_back(SubResourceCopyRegion{});
 				region.ArrayLayer = 0;
-				region.DataOffset = offset;
+				region.DataOffset = Texture2DMipFileOffset(header, m + firstMip);
 				region.MipLevel = m;
-				offset += MipSizeInBytes(rhi->GetFormat(), rhi->GetSizeXYZ().x, rhi->GetSizeXYZ().y, m);
 			}
 			Graphics::GetRHI().CopyDataToTexture(buff, 0, rhi, EGPUAccess::None, EGPUAccess::SRV, regions, copySize);
 			delete[] buff;
 			});
 
+		if (firstMip > 0) {
+			tex->m_StreamingHandle = TextureStreamer::Register(tex, stream.GetPath(), payloadOffset, header, samplerStateDesc, firstMip);
+		}
+
 		return tex;
 	}
 }
\ No newline at end of file
@@ -24,7 +24,15 @@ namespace Spikey {
 		uint32 m_Height;
 	};
 
+	enum class ETexture2DFileFlags : uint8 {
+		None = 0,
+		TailFirst = BIT(0) // mips are stored smallest first, the file supports streaming
+	};
+	ENUM_FLAGS_OPERATORS(ETexture2DFileFlags);
+
 	constexpr char TEXTURE_2D_MAGIC[4] = { 'S', 'T', '2', 'D' };
+	// 1 was written without a version and with FileFlags as padding, those files have to be imported again
+	constexpr uint32 TEXTURE_2D_FILE_VERSION = 2;
 	struct Texture2DHeader {
 
 		uint64 ByteSize;
@@ -39,9 +47,16 @@ namespace Spikey {
 		ESamplerAddress AddressV : 2;
 		ESamplerAddress AddressW : 2;
 
-		uint8 _Padding[2];
+		ETexture2DFileFlags FileFlags;
+		uint8 _Padding;
 	};
 
+	// offset of a mip from the start of the payload
+	uint64 Texture2DMipFileOffset(const Texture2DHeader& header, uint32 mip);
+
+	// mipData holds the chain mip 0 first (the encoder layout), it is written smallest mip first
+	void WriteTexture2DFile(BinaryWriteStream& stream, Texture2DHeader header, const uint8* mipData);
+
 	class Texture2D : public IAsset {
 	public:
 		Texture2D(uint32 width, uint32 height, uint32 numMips, ETextureFormat format, ETextureUsage usage, UUID id);
@@ -60,7 +75,20 @@ namespace Spikey {
 		uint32 GetNumMips() const { return m_RHIResource->GetNumMips(); }
 		bool IsMipmapped() const { return m_RHIResource->IsMipmaped(); }
 
+		// streamed textures only allocate their resident mips, the resource then starts at a lower
+		// resolution and the sampler MinLOD hides mips which are allocated but not uploaded yet
+		bool IsStreamed() const { return m_StreamingHandle != ~0u; }
+		void RequestMip(uint32 mip);
+
+		// for surfaces covering screenSize pixels along their longest side, see TextureStreamer::ComputeRequestedMip
+		void RequestScreenSize(float32 screenSize, float32 uvScale = 1.f);
+		RHISamplerState* GetSamplerState() { return m_SamplerState; }
+
 	private:
-		Texture2DRHIRef m_RHIResource;
+		friend class TextureStreamer;
+
+		Texture2DRHIRef    m_RHIResource;
+		SamplerStateRHIRef m_SamplerState;
+		uint32             m_StreamingHandle = ~0u;
 	};
 }
\ No newline at end of file
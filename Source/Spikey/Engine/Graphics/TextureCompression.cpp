@@ -0,0 +1,834 @@
+#include <Engine/Graphics/TextureCompression.h>
+#include <Engine/Threading/JobSystem.h>
+#include <Glm/gtc/packing.hpp>
+#include <immintrin.h>
+#include <cfloat>
+
+namespace Spikey {
+
+	// 16 texels of a 4x4 block, structure of arrays so 4 texels fit into a single sse register
+	struct alignas(16) ColorBlock
+	{
+		float32 R[16];
+		float32 G[16];
+		float32 B[16];
+		float32 A[16];
+	};
+
+	static void LoadBlock(const uint8* rgba, uint32 width, uint32 height, uint32 blockX, uint32 blockY, ColorBlock& out)
+	{
+		for (uint32 y = 0; y < 4; y++)
+		{
+			uint32 srcY = std::min(blockY * 4 + y, height - 1);
+
+			for (uint32 x = 0; x < 4; x++)
+			{
+				uint32 srcX = std::min(blockX * 4 + x, width - 1);
+				const uint8* texel = rgba + ((uint64)srcY * width + srcX) * 4;
+
+				uint32 i = y * 4 + x;
+				out.R[i] = texel[0];
+				out.G[i] = texel[1];
+				out.B[i] = texel[2];
+				out.A[i] = texel[3];
+			}
+		}
+	}
+
+	static float32 HorizontalSum(__m128 v)
+	{
+		__m128 shuf = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+		__m128 sums = _mm_add_ps(v, shuf);
+		shuf = _mm_movehl_ps(shuf, sums);
+		return _mm_cvtss_f32(_mm_add_ss(sums, shuf));
+	}
+
+	// picks the closest palette entry for every texel, returns the summed squared error
+	static float32 FindColorIndices(const ColorBlock& block, const Vec3* palette, uint32 numEntries, uint32 outIndices[16])
+	{
+		__m128 totalError = _mm_setzero_ps();
+
+		for (uint32 i = 0; i < 16; i += 4)
+		{
+			__m128 r = _mm_load_ps(block.R + i);
+			__m128 g = _mm_load_ps(block.G + i);
+			__m128 b = _mm_load_ps(block.B + i);
+
+			__m128  bestError = _mm_set1_ps(FLT_MAX);
+			__m128i bestIndex = _mm_setzero_si128();
+
+			for (uint32 p = 0; p < numEntries; p++)
+			{
+				__m128 dr = _mm_sub_ps(r, _mm_set1_ps(palette[p].r));
+				__m128 dg = _mm_sub_ps(g, _mm_set1_ps(palette[p].g));
+				__m128 db = _mm_sub_ps(b, _mm_set1_ps(palette[p].b));
+				__m128 error = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dr, dr), _mm_mul_ps(dg, dg)), _mm_mul_ps(db, db));
+
+				__m128i closer = _mm_castps_si128(_mm_cmplt_ps(error, bestError));
+				bestIndex = _mm_or_si128(_mm_and_si128(closer, _mm_set1_epi32(p)), _mm_andnot_si128(closer, bestIndex));
+				bestError = _mm_min_ps(error, bestError);
+			}
+
+			_mm_storeu_si128((__m128i*)(outIndices + i), bestIndex);
+			totalError = _mm_add_ps(totalError, bestError);
+		}
+
+		return HorizontalSum(totalError);
+	}
+
+	static float32 FindChannelIndices(const float32 values[16], const float32 palette[8], uint32 outIndices[16])
+	{
+		__m128 totalError = _mm_setzero_ps();
+
+		for (uint32 i = 0; i < 16; i += 4)
+		{
+			__m128 v = _mm_load_ps(values + i);
+
+			__m128  bestError = _mm_set1_ps(FLT_MAX);
+			__m128i bestIndex = _mm_setzero_si128();
+
+			for (uint32 p = 0; p < 8; p++)
+			{
+				__m128 d = _mm_sub_ps(v, _mm_set1_ps(palette[p]));
+				__m128 error = _mm_mul_ps(d, d);
+
+				__m128i closer = _mm_castps_si128(_mm_cmplt_ps(error, bestError));
+				bestIndex = _mm_or_si128(_mm_and_si128(closer, _mm_set1_epi32(p)), _mm_andnot_si128(closer, bestIndex));
+				bestError = _mm_min_ps(error, bestError);
+			}
+
+			_mm_storeu_si128((__m128i*)(outIndices + i), bestIndex);
+			totalError = _mm_add_ps(totalError, bestError);
+		}
+
+		return HorizontalSum(totalError);
+	}
+
+	static uint16 PackColor565(const Vec3& color)
+	{
+		uint32 r = (uint32)std::clamp(color.r * (31.f / 255.f) + 0.5f, 0.f, 31.f);
+		uint32 g = (uint32)std::clamp(color.g * (63.f / 255.f) + 0.5f, 0.f, 63.f);
+		uint32 b = (uint32)std::clamp(color.b * (31.f / 255.f) + 0.5f, 0.f, 31.f);
+
+		return (uint16)((r << 11) | (g << 5) | b);
+	}
+
+	static Vec3 UnpackColor565(uint16 color)
+	{
+		uint32 r = (color >> 11) & 31;
+		uint32 g = (color >> 5) & 63;
+		uint32 b = color & 31;
+
+		return Vec3((float32)((r << 3) | (r >> 2)), (float32)((g << 2) | (g >> 4)), (float32)((b << 3) | (b >> 2)));
+	}
+
+	static void ComputeBoundingBoxEndpoints(const ColorBlock& block, float32 insetDivisor, Vec3& outMax, Vec3& outMin)
+	{
+		__m128 minR = _mm_load_ps(block.R), maxR = minR;
+		__m128 minG = _mm_load_ps(block.G), maxG = minG;
+		__m128 minB = _mm_load_ps(block.B), maxB = minB;
+
+		for (uint32 i = 4; i < 16; i += 4)
+		{
+			__m128 r = _mm_load_ps(block.R + i);
+			__m128 g = _mm_load_ps(block.G + i);
+			__m128 b = _mm_load_ps(block.B + i);
+
+			minR = _mm_min_ps(minR, r); maxR = _mm_max_ps(maxR, r);
+			minG = _mm_min_ps(minG, g); maxG = _mm_max_ps(maxG, g);
+			minB = _mm_min_ps(minB, b); maxB = _mm_max_ps(maxB, b);
+		}
+
+		alignas(16) float32 lanes[6][4];
+		_mm_store_ps(lanes[0], minR); _mm_store_ps(lanes[1], minG); _mm_store_ps(lanes[2], minB);
+		_mm_store_ps(lanes[3], maxR); _mm_store_ps(lanes[4], maxG); _mm_store_ps(lanes[5], maxB);
+
+		Vec3 mn(FLT_MAX), mx(-FLT_MAX);
+		for (uint32 i = 0; i < 4; i++)
+		{
+			mn = glm::min(mn, Vec3(lanes[0][i], lanes[1][i], lanes[2][i]));
+			mx = glm::max(mx, Vec3(lanes[3][i], lanes[4][i], lanes[5][i]));
+		}
+
+		// pull the endpoints slightly inwards, the interpolated colors then cover the box better
+		Vec3 inset = (mx - mn) / insetDivisor;
+		outMax = mx - inset;
+		outMin = mn + inset;
+	}
+
+	static void ComputePrincipalAxisEndpoints(const ColorBlock& block, float32 maxValue, Vec3& outMax, Vec3& outMin)
+	{
+		Vec3 mean(0.f);
+		for (uint32 i = 0; i < 16; i++)
+			mean += Vec3(block.R[i], block.G[i], block.B[i]);
+		mean /= 16.f;
+
+		// upper triangle of the covariance matrix
+		float32 cov[6] = {};
+		for (uint32 i = 0; i < 16; i++)
+		{
+			Vec3 d = Vec3(block.R[i], block.G[i], block.B[i]) - mean;
+			cov[0] += d.r * d.r; cov[1] += d.r * d.g; cov[2] += d.r * d.b;
+			cov[3] += d.g * d.g; cov[4] += d.g * d.b; cov[5] += d.b * d.b;
+		}
+
+		// power iteration, starting from the longest box diagonal converges in a few steps
+		Vec3 boxMax, boxMin;
+		ComputeBoundingBoxEndpoints(block, 16.f, boxMax, boxMin);
+		Vec3 axis = boxMax - boxMin;
+		if (glm::dot(axis, axis) < 1e-6f)
+			axis = Vec3(1.f);
+
+		for (uint32 i = 0; i < 8; i++)
+		{
+			Vec3 next(
+				cov[0] * axis.r + cov[1] * axis.g + cov[2] * axis.b,
+				cov[1] * axis.r + cov[3] * axis.g + cov[4] * axis.b,
+				cov[2] * axis.r + cov[4] * axis.g + cov[5] * axis.b);
+
+			float32 len = glm::length(next);
+			if (len < 1e-6f)
+				break;
+
+			axis = next / len;
+		}
+
+		float32 minProj = FLT_MAX, maxProj = -FLT_MAX;
+		for (uint32 i = 0; i < 16; i++)
+		{
+			float32 proj = glm::dot(Vec3(block.R[i], block.G[i], block.B[i]) - mean, axis);
+			minProj = std::min(minProj, proj);
+			maxProj = std::max(maxProj, proj);
+		}
+
+		float32 inset = (maxProj - minProj) / 32.f;
+		outMax = glm::clamp(mean + axis * (maxProj - inset), Vec3(0.f), Vec3(maxValue));
+		outMin = glm::clamp(mean + axis * (minProj + inset), Vec3(0.f), Vec3(maxValue));
+	}
+
+	struct ColorBlockResult
+	{
+		uint16  Color0;
+		uint16  Color1;
+		uint32  Indices[16];
+		float32 Error;
+	};
+
+	static void EvaluateColorEndpoints(const ColorBlock& block, const Vec3& e0, const Vec3& e1, ColorBlockResult& out)
+	{
+		uint16 c0 = PackColor565(e0);
+		uint16 c1 = PackColor565(e1);
+
+		// four color mode requires color0 > color1
+		if (c0 < c1)
+			std::swap(c0, c1);
+
+		Vec3 palette[4];
+		palette[0] = UnpackColor565(c0);
+		palette[1] = UnpackColor565(c1);
+		palette[2] = (palette[0] * 2.f + palette[1]) / 3.f;
+		palette[3] = (palette[0] + palette[1] * 2.f) / 3.f;
+
+		out.Color0 = c0;
+		out.Color1 = c1;
+		out.Error = FindColorIndices(block, palette, 4, out.Indices);
+
+		// equal endpoints switch the block into three color mode, index 0 still maps to color0
+		if (c0 == c1)
+		{
+			for (uint32 i = 0; i < 16; i++)
+				out.Indices[i] = 0;
+		}
+	}
+
+	// solves for the endpoints minimizing the error for the current index assignment,
+	// weights holds the interpolation factor towards the second endpoint for every index
+	static bool RefineEndpoints(const ColorBlock& block, const uint32 indices[16], const float32* weights, float32 maxValue,
+		Vec3& outE0, Vec3& outE1)
+	{
+		float32 aa = 0.f, ab = 0.f, bb = 0.f;
+		Vec3 ax(0.f), bx(0.f);
+
+		for (uint32 i = 0; i < 16; i++)
+		{
+			float32 beta = weights[indices[i]];
+			float32 alpha = 1.f - beta;
+			Vec3 texel(block.R[i], block.G[i], block.B[i]);
+
+			aa += alpha * alpha;
+			ab += alpha * beta;
+			bb += beta * beta;
+			ax += texel * alpha;
+			bx += texel * beta;
+		}
+
+		float32 det = aa * bb - ab * ab;
+		if (std::abs(det) < 1e-6f)
+			return false;
+
+		float32 invDet = 1.f / det;
+		outE0 = glm::clamp((ax * bb - bx * ab) * invDet, Vec3(0.f), Vec3(maxValue));
+		outE1 = glm::clamp((bx * aa - ax * ab) * invDet, Vec3(0.f), Vec3(maxValue));
+		return true;
+	}
+
+	static constexpr float32 BC1_WEIGHTS[4] = { 0.f, 1.f, 1.f / 3.f, 2.f / 3.f };
+
+	static void EncodeColorBlock(const ColorBlock& block, ECompressionQuality quality, uint8* out)
+	{
+		Vec3 e0, e1;
+		if (quality == ECompressionQuality::Fast)
+			ComputeBoundingBoxEndpoints(block, 16.f, e0, e1);
+		else
+			ComputePrincipalAxisEndpoints(block, 255.f, e0, e1);
+
+		ColorBlockResult best;
+		EvaluateColorEndpoints(block, e0, e1, best);
+
+		if (quality == ECompressionQuality::High)
+		{
+			for (uint32 iter = 0; iter < 2 && best.Error > 0.f; iter++)
+			{
+				if (!RefineEndpoints(block, best.Indices, BC1_WEIGHTS, 255.f, e0, e1))
+					break;
+
+				ColorBlockResult refined;
+				EvaluateColorEndpoints(block, e0, e1, refined);
+				if (refined.Error >= best.Error)
+					break;
+
+				best = refined;
+			}
+		}
+
+		uint32 indices = 0;
+		for (uint32 i = 0; i < 16; i++)
+			indices |= best.Indices[i] << (i * 2);
+
+		memcpy(out + 0, &best.Color0, 2);
+		memcpy(out + 2, &best.Color1, 2);
+		memcpy(out + 4, &indices, 4);
+	}
+
+	static float32 EvaluateChannelEndpoints(const float32 values[16], uint32 a0, uint32 a1, uint32 outIndices[16])
+	{
+		float32 palette[8];
+		palette[0] = (float32)a0;
+		palette[1] = (float32)a1;
+
+		if (a0 > a1)
+		{
+			for (uint32 i = 1; i < 7; i++)
+				palette[i + 1] = (float32)(((7 - i) * a0 + i * a1 + 3) / 7);
+		}
+		else
+		{
+			for (uint32 i = 1; i < 5; i++)
+				palette[i + 1] = (float32)(((5 - i) * a0 + i * a1 + 2) / 5);
+
+			palette[6] = 0.f;
+			palette[7] = 255.f;
+		}
+
+		return FindChannelIndices(values, palette, outIndices);
+	}
+
+	// single channel block shared by the BC3 alpha and both BC5 channels
+	static void EncodeChannelBlock(const float32 values[16], ECompressionQuality quality, uint8* out)
+	{
+		float32 mn = 255.f, mx = 0.f;
+		float32 innerMin = 255.f, innerMax = 0.f;
+
+		for (uint32 i = 0; i < 16; i++)
+		{
+			mn = std::min(mn, values[i]);
+			mx = std::max(mx, values[i]);
+
+			if (values[i] > 0.f && values[i] < 255.f)
+			{
+				innerMin = std::min(innerMin, values[i]);
+				innerMax = std::max(innerMax, values[i]);
+			}
+		}
+
+		uint32 bestA0 = (uint32)mx, bestA1 = (uint32)mn;
+		uint32 bestIndices[16];
+		float32 bestError = EvaluateChannelEndpoints(values, bestA0, bestA1, bestIndices);
+
+		auto tryEndpoints = [&](uint32 a0, uint32 a1) {
+			uint32 indices[16];
+			float32 error = EvaluateChannelEndpoints(values, a0, a1, indices);
+
+			if (error < bestError)
+			{
+				bestError = error;
+				bestA0 = a0;
+				bestA1 = a1;
+				memcpy(bestIndices, indices, sizeof(indices));
+			}
+			};
+
+		if (quality != ECompressionQuality::Fast && bestError > 0.f)
+		{
+			// six value mode keeps exact 0 and 255, useful for alpha cutouts
+			if (innerMin <= innerMax)
+				tryEndpoints((uint32)innerMin, (uint32)innerMax);
+
+			if (quality == ECompressionQuality::High && mx - mn > 2.f)
+			{
+				for (uint32 shrinkMax = 0; shrinkMax < 3; shrinkMax++)
+				{
+					for (uint32 shrinkMin = 0; shrinkMin < 3; shrinkMin++)
+					{
+						if (shrinkMax + shrinkMin > 0)
+							tryEndpoints((uint32)mx - shrinkMax, (uint32)mn + shrinkMin);
+					}
+				}
+			}
+		}
+
+		uint64 indices = 0;
+		for (uint32 i = 0; i < 16; i++)
+			indices |= (uint64)bestIndices[i] << (i * 3);
+
+		out[0] = (uint8)bestA0;
+		out[1] = (uint8)bestA1;
+		memcpy(out + 2, &indices, 6);
+	}
+
+	static void EncodeBlock(const ColorBlock& block, ETextureFormat format, ECompressionQuality quality, uint8* out)
+	{
+		switch (format)
+		{
+		case ETextureFormat::RGBBC1:
+			EncodeColorBlock(block, quality, out);
+			break;
+		case ETextureFormat::RGBABC3:
+			EncodeChannelBlock(block.A, quality, out);
+			EncodeColorBlock(block, quality, out + 8);
+			break;
+		case ETextureFormat::RGBC5:
+			EncodeChannelBlock(block.R, quality, out);
+			EncodeChannelBlock(block.G, quality, out + 8);
+			break;
+		default:
+			break;
+		}
+	}
+
+	// bc6h interpolates the unquantized 16 bit endpoints, which are the half float bit patterns
+	// scaled by 64 / 31. blocks are encoded in that domain so the error is roughly relative
+	static constexpr uint32 BC6H_WEIGHTS[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+	static constexpr float32 BC6H_MAX_VALUE = 65535.f;
+
+	// only the single region modes are used, 10 bit raw endpoints or an 11 bit base with a 9 bit delta
+	struct BC6HMode
+	{
+		uint32 ModeBits;
+		uint32 EndpointBits;
+		uint32 DeltaBits;
+	};
+
+	static constexpr BC6HMode BC6H_MODES[2] = { { 0x03, 10, 0 }, { 0x07, 11, 9 } };
+
+	struct HDRBlock
+	{
+		ColorBlock Encoded;
+		Vec3       Linear[16];
+	};
+
+	struct BC6HBlockResult
+	{
+		uint32  Mode;
+		uint32  Endpoint0[3];
+		uint32  Endpoint1[3];
+		uint32  Indices[16];
+		Vec3    Palette[16];
+		float32 Error;
+	};
+
+	struct BC6HErrorSum
+	{
+		float64 SquaredError = 0.0;
+		float64 Peak = 0.0;
+		uint64  NumValues = 0;
+	};
+
+	static Vec4 FetchHDRTexel(const void* texels, ETextureFormat srcFormat, uint64 index)
+	{
+		if (srcFormat == ETextureFormat::RGBA16F)
+		{
+			const uint16* half = (const uint16*)texels + index * 4;
+			return Vec4(glm::unpackHalf1x16(half[0]), glm::unpackHalf1x16(half[1]), glm::unpackHalf1x16(half[2]), glm::unpackHalf1x16(half[3]));
+		}
+
+		const float32* values = (const float32*)texels + index * 4;
+		return Vec4(values[0], values[1], values[2], values[3]);
+	}
+
+	static void LoadHDRBlock(const void* texels, ETextureFormat srcFormat, uint32 width, uint32 height,
+		uint32 blockX, uint32 blockY, HDRBlock& out)
+	{
+		for (uint32 y = 0; y < 4; y++)
+		{
+			uint32 srcY = std::min(blockY * 4 + y, height - 1);
+
+			for (uint32 x = 0; x < 4; x++)
+			{
+				uint32 srcX = std::min(blockX * 4 + x, width - 1);
+				Vec4 texel = FetchHDRTexel(texels, srcFormat, (uint64)srcY * width + srcX);
+
+				uint32 i = y * 4 + x;
+				float32* encoded[3] = { out.Encoded.R, out.Encoded.G, out.Encoded.B };
+
+				for (uint32 c = 0; c < 3; c++)
+				{
+					// unsigned format, negatives and nans go to zero, anything above the half range saturates
+					float32 value = texel[c] > 0.f ? std::min(texel[c], 65504.f) : 0.f;
+					uint16 half = glm::packHalf1x16(value);
+
+					encoded[c][i] = (float32)half * (64.f / 31.f);
+					out.Linear[i][c] = glm::unpackHalf1x16(half);
+				}
+			}
+		}
+	}
+
+	static uint32 QuantizeBC6H(float32 value, uint32 bits)
+	{
+		float32 q = value * (float32)(1u << bits) / 65536.f;
+		return (uint32)std::clamp(q, 0.f, (float32)((1u << bits) - 1));
+	}
+
+	static uint32 UnquantizeBC6H(uint32 value, uint32 bits)
+	{
+		if (value == 0)
+			return 0;
+
+		if (value == (1u << bits) - 1)
+			return 0xFFFF;
+
+		return ((value << 16) + 0x8000) >> bits;
+	}
+
+	static void EvaluateBC6HEndpoints(const ColorBlock& block, const Vec3& e0, const Vec3& e1, uint32 mode, BC6HBlockResult& out)
+	{
+		const BC6HMode& desc = BC6H_MODES[mode];
+
+		for (uint32 c = 0; c < 3; c++)
+		{
+			out.Endpoint0[c] = QuantizeBC6H(e0[c], desc.EndpointBits);
+			out.Endpoint1[c] = QuantizeBC6H(e1[c], desc.EndpointBits);
+
+			if (desc.DeltaBits > 0)
+			{
+				// kept symmetric so the anchor swap below can negate it
+				int32 range = (1 << (desc.DeltaBits - 1)) - 1;
+				int32 delta = std::clamp((int32)out.Endpoint1[c] - (int32)out.Endpoint0[c], -range, range);
+				out.Endpoint1[c] = (uint32)((int32)out.Endpoint0[c] + delta);
+			}
+		}
+
+		uint32 unq0[3], unq1[3];
+		for (uint32 c = 0; c < 3; c++)
+		{
+			unq0[c] = UnquantizeBC6H(out.Endpoint0[c], desc.EndpointBits);
+			unq1[c] = UnquantizeBC6H(out.Endpoint1[c], desc.EndpointBits);
+		}
+
+		for (uint32 i = 0; i < 16; i++)
+		{
+			for (uint32 c = 0; c < 3; c++)
+				out.Palette[i][c] = (float32)((unq0[c] * (64 - BC6H_WEIGHTS[i]) + unq1[c] * BC6H_WEIGHTS[i] + 32) >> 6);
+		}
+
+		out.Mode = mode;
+		out.Error = FindColorIndices(block, out.Palette, 16, out.Indices);
+	}
+
+	static void EncodeBC6HBlock(const HDRBlock& block, ECompressionQuality quality, uint8* out, BC6HErrorSum& errorSum)
+	{
+		static constexpr float32 weights[16] = {
+			0.f / 64.f, 4.f / 64.f, 9.f / 64.f, 13.f / 64.f, 17.f / 64.f, 21.f / 64.f, 26.f / 64.f, 30.f / 64.f,
+			34.f / 64.f, 38.f / 64.f, 43.f / 64.f, 47.f / 64.f, 51.f / 64.f, 55.f / 64.f, 60.f / 64.f, 64.f / 64.f };
+
+		Vec3 e0, e1;
+		if (quality == ECompressionQuality::Fast)
+			ComputeBoundingBoxEndpoints(block.Encoded, 32.f, e0, e1);
+		else
+			ComputePrincipalAxisEndpoints(block.Encoded, BC6H_MAX_VALUE, e0, e1);
+
+		BC6HBlockResult best;
+		if (quality == ECompressionQuality::Fast)
+		{
+			EvaluateBC6HEndpoints(block.Encoded, e0, e1, 0, best);
+		}
+		else
+		{
+			best.Error = FLT_MAX;
+
+			// the delta mode trades range for one more bit of precision, usually a win for smooth blocks
+			for (uint32 mode = 0; mode < 2; mode++)
+			{
+				Vec3 m0 = e0, m1 = e1;
+				BC6HBlockResult current;
+				EvaluateBC6HEndpoints(block.Encoded, m0, m1, mode, current);
+
+				for (uint32 iter = 0; quality == ECompressionQuality::High && iter < 2 && current.Error > 0.f; iter++)
+				{
+					if (!RefineEndpoints(block.Encoded, current.Indices, weights, BC6H_MAX_VALUE, m0, m1))
+						break;
+
+					BC6HBlockResult refined;
+					EvaluateBC6HEndpoints(block.Encoded, m0, m1, mode, refined);
+					if (refined.Error >= current.Error)
+						break;
+
+					current = refined;
+				}
+
+				if (current.Error < best.Error)
+					best = current;
+			}
+		}
+
+		// error of what the gpu will decode, the final unquantize step turns the palette back into half floats
+		for (uint32 i = 0; i < 16; i++)
+		{
+			const Vec3& color = best.Palette[best.Indices[i]];
+
+			for (uint32 c = 0; c < 3; c++)
+			{
+				float32 decoded = glm::unpackHalf1x16((uint16)(((uint32)color[c] * 31) >> 6));
+				float64 diff = (float64)decoded - (float64)block.Linear[i][c];
+
+				errorSum.SquaredError += diff * diff;
+				errorSum.Peak = std::max(errorSum.Peak, (float64)block.Linear[i][c]);
+			}
+		}
+		errorSum.NumValues += 48;
+
+		// the anchor index is stored without its top bit
+		if (best.Indices[0] >= 8)
+		{
+			for (uint32 c = 0; c < 3; c++)
+				std::swap(best.Endpoint0[c], best.Endpoint1[c]);
+
+			for (uint32 i = 0; i < 16; i++)
+				best.Indices[i] = 15 - best.Indices[i];
+		}
+
+		const BC6HMode& desc = BC6H_MODES[best.Mode];
+		uint64 bits[2] = {};
+		uint32 pos = 0;
+
+		auto write = [&](uint32 value, uint32 count) {
+			for (uint32 i = 0; i < count; i++, pos++)
+				bits[pos >> 6] |= (uint64)((value >> i) & 1) << (pos & 63);
+			};
+
+		write(desc.ModeBits, 5);
+		if (desc.DeltaBits == 0)
+		{
+			for (uint32 c = 0; c < 3; c++)
+				write(best.Endpoint0[c], 10);
+			for (uint32 c = 0; c < 3; c++)
+				write(best.Endpoint1[c], 10);
+		}
+		else
+		{
+			for (uint32 c = 0; c < 3; c++)
+				write(best.Endpoint0[c], 10);
+
+			// delta bits of every channel are followed by the top bit of its base endpoint
+			for (uint32 c = 0; c < 3; c++)
+			{
+				write(best.Endpoint1[c] - best.Endpoint0[c], desc.DeltaBits);
+				write(best.Endpoint0[c] >> 10, 1);
+			}
+		}
+
+		write(best.Indices[0], 3);
+		for (uint32 i = 1; i < 16; i++)
+			write(best.Indices[i], 4);
+
+		memcpy(out, bits, 16);
+	}
+
+	bool EncodeBlockCompressed(const uint8* rgba, uint32 width, uint32 height, ETextureFormat format,
+		ECompressionQuality quality, uint8* outBlocks)
+	{
+		if (format != ETextureFormat::RGBBC1 && format != ETextureFormat::RGBABC3 && format != ETextureFormat::RGBC5)
+		{
+			ENGINE_ERROR("Texture format is not supported by the block encoder!");
+			return false;
+		}
+
+		PROFILE_SCOPED;
+
+		Vec2Uint numBlocks = TextureMipExtents(format, width, height, 0);
+		uint32 blockSize = TextureTexelSize(format);
+
+		// rows are independent, a row of a 4k texture is 1024 blocks which is plenty per job
+		JobSystem::ParallelFor(numBlocks.y, 1, [&](uint32 begin, uint32 end) {
+			ColorBlock block;
+
+			for (uint32 y = begin; y < end; y++)
+			{
+				uint8* row = outBlocks + (uint64)y * numBlocks.x * blockSize;
+
+				for (uint32 x = 0; x < numBlocks.x; x++)
+				{
+					LoadBlock(rgba, width, height, x, y, block);
+					EncodeBlock(block, format, quality, row + (uint64)x * blockSize);
+				}
+			}
+			});
+
+		return true;
+	}
+
+	std::vector<uint8> EncodeTextureMips(const uint8* rgba, uint32 width, uint32 height, uint32 numMips,
+		ETextureFormat format, ECompressionQuality quality)
+	{
+		std::vector<uint8> result(TextureSizeInBytes(format, width, height, numMips));
+
+		uint64 srcOffset = 0;
+		uint64 dstOffset = 0;
+
+		for (uint32 mip = 0; mip < numMips; mip++)
+		{
+			uint32 mipW = std::max(1u, width >> mip);
+			uint32 mipH = std::max(1u, height >> mip);
+
+			if (!EncodeBlockCompressed(rgba + srcOffset, mipW, mipH, format, quality, result.data() + dstOffset))
+				return {};
+
+			srcOffset += (uint64)mipW * mipH * 4;
+			dstOffset += MipSizeInBytes(format, width, height, mip);
+		}
+
+		return result;
+	}
+
+	static void EncodeBC6HImage(const void* texels, ETextureFormat srcFormat, uint32 width, uint32 height,
+		ECompressionQuality quality, uint8* outBlocks, BC6HErrorSum& outError)
+	{
+		PROFILE_SCOPED;
+
+		Vec2Uint numBlocks = TextureMipExtents(ETextureFormat::RGBABC6, width, height, 0);
+		std::vector<BC6HErrorSum> rowErrors(numBlocks.y);
+
+		JobSystem::ParallelFor(numBlocks.y, 1, [&](uint32 begin, uint32 end) {
+			HDRBlock block;
+
+			for (uint32 y = begin; y < end; y++)
+			{
+				uint8* row = outBlocks + (uint64)y * numBlocks.x * 16;
+
+				for (uint32 x = 0; x < numBlocks.x; x++)
+				{
+					LoadHDRBlock(texels, srcFormat, width, height, x, y, block);
+					EncodeBC6HBlock(block, quality, row + (uint64)x * 16, rowErrors[y]);
+				}
+			}
+			});
+
+		for (const BC6HErrorSum& row : rowErrors)
+		{
+			outError.SquaredError += row.SquaredError;
+			outError.Peak = std::max(outError.Peak, row.Peak);
+			outError.NumValues += row.NumValues;
+		}
+	}
+
+	static TextureCompressionStats GetCompressionStats(const BC6HErrorSum& error)
+	{
+		TextureCompressionStats stats{};
+		stats.RMSE = error.NumValues > 0 ? std::sqrt(error.SquaredError / (float64)error.NumValues) : 0.0;
+		stats.PSNR = stats.RMSE > 0.0 ? 20.0 * std::log10(error.Peak / stats.RMSE) : std::numeric_limits<float64>::infinity();
+
+		return stats;
+	}
+
+	static bool IsHDRSourceFormat(ETextureFormat format)
+	{
+		if (format == ETextureFormat::RGBA16F || format == ETextureFormat::RGBA32F)
+			return true;
+
+		ENGINE_ERROR("BC6H encoder expects RGBA16F or RGBA32F source data!");
+		return false;
+	}
+
+	bool EncodeBC6H(const void* texels, ETextureFormat srcFormat, uint32 width, uint32 height,
+		ECompressionQuality quality, uint8* outBlocks, TextureCompressionStats* outStats)
+	{
+		if (!IsHDRSourceFormat(srcFormat))
+			return false;
+
+		BC6HErrorSum error{};
+		EncodeBC6HImage(texels, srcFormat, width, height, quality, outBlocks, error);
+
+		if (outStats)
+			*outStats = GetCompressionStats(error);
+
+		return true;
+	}
+
+	std::vector<uint8> EncodeHDRTexture(const void* texels, ETextureFormat srcFormat, uint32 width, uint32 height,
+		uint32 numMips, uint32 numLayers, ECompressionQuality quality, TextureCompressionStats* outStats)
+	{
+		if (!IsHDRSourceFormat(srcFormat))
+			return {};
+
+		PROFILE_SCOPED;
+
+		uint32 srcTexelSize = TextureTexelSize(srcFormat);
+		std::vector<uint8> result(TextureSizeInBytes(ETextureFormat::RGBABC6, width, height, numMips) * numLayers);
+		std::vector<BC6HErrorSum> errors((uint64)numMips * numLayers);
+
+		JobSystem::Counter counter{};
+		uint64 srcOffset = 0;
+		uint64 dstOffset = 0;
+
+		for (uint32 mip = 0; mip < numMips; mip++)
+		{
+			uint32 mipW = std::max(1u, width >> mip);
+			uint32 mipH = std::max(1u, height >> mip);
+
+			for (uint32 layer = 0; layer < numLayers; layer++)
+			{
+				const uint8* src = (const uint8*)texels + srcOffset;
+				uint8* dst = result.data() + dstOffset;
+				BC6HErrorSum* error = &errors[(uint64)mip * numLayers + layer];
+
+				// rows of each subresource are split further, small mips end up as single jobs
+				JobSystem::Execute(counter, [=]() {
+					EncodeBC6HImage(src, srcFormat, mipW, mipH, quality, dst, *error);
+					});
+
+				srcOffset += (uint64)mipW * mipH * srcTexelSize;
+				dstOffset += MipSizeInBytes(ETextureFormat::RGBABC6, width, height, mip);
+			}
+		}
+
+		JobSystem::Wait(counter);
+
+		BC6HErrorSum total{};
+		for (const BC6HErrorSum& error : errors)
+		{
+			total.SquaredError += error.SquaredError;
+			total.Peak = std::max(total.Peak, error.Peak);
+			total.NumValues += error.NumValues;
+		}
+
+		TextureCompressionStats stats = GetCompressionStats(total);
+		ENGINE_INFO("BC6H encoded {}x{} texture ({} mips, {} layers): RMSE {:.5f}, PSNR {:.2f} dB",
+			width, height, numMips, numLayers, stats.RMSE, stats.PSNR);
+
+		if (outStats)
+			*outStats = stats;
+
+		return result;
+	}
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <Engine/Graphics/Texture.h>
+
+namespace Spikey {
+
+	enum class ECompressionQuality : uint8
+	{
+		Fast,   // bounding box endpoints
+		Normal, // principal axis endpoints
+		High    // principal axis with least squares endpoint refinement
+	};
+
+	struct TextureCompressionStats
+	{
+		float64 RMSE = 0.0; // linear rgb
+		float64 PSNR = 0.0; // relative to the brightest source value
+	};
+
+	// encodes a tightly packed rgba8 image into RGBBC1, RGBABC3 or RGBC5 blocks,
+	// blocks are written row major, the same layout MipSizeInBytes expects for a single mip.
+	// RGBC5 takes the red and green channels, partial edge blocks repeat the border texels
+	bool EncodeBlockCompressed(const uint8* rgba, uint32 width, uint32 height, ETextureFormat format,
+		ECompressionQuality quality, uint8* outBlocks);
+
+	// encodes a rgba8 mip chain stored mip after mip (mip 0 first), the result can be written
+	// as the texture payload and uploaded as is by Texture2D::Create
+	std::vector<uint8> EncodeTextureMips(const uint8* rgba, uint32 width, uint32 height, uint32 numMips,
+		ETextureFormat format, ECompressionQuality quality);
+
+	// encodes a RGBA16F or RGBA32F image into RGBABC6 (unsigned BC6H) blocks,
+	// alpha is dropped and negative values are clamped to zero
+	bool EncodeBC6H(const void* texels, ETextureFormat srcFormat, uint32 width, uint32 height,
+		ECompressionQuality quality, uint8* outBlocks, TextureCompressionStats* outStats = nullptr);
+
+	// encodes every mip and layer of a RGBA16F or RGBA32F texture into RGBABC6. source and result are laid out
+	// mip after mip with all layers (cube faces) of a mip next to each other, the order TextureCube::Create reads.
+	// subresources are encoded in parallel and the achieved error is logged
+	std::vector<uint8> EncodeHDRTexture(const void* texels, ETextureFormat srcFormat, uint32 width, uint32 height,
+		uint32 numMips, uint32 numLayers, ECompressionQuality quality, TextureCompressionStats* outStats = nullptr);
+}
@@ -0,0 +1,210 @@
+#include <Engine/Graphics/TextureState.h>
+
+namespace Spikey {
+
+	void TextureState::Initialize(uint32 numMips, uint32 numLayers, ERHIAccess initialState, bool usePerStateTracking)
+	{
+		assert(numMips > 0 && numLayers > 0);
+
+		NumMips = numMips;
+		NumLayers = numLayers;
+		PerSubresourceTracking = usePerStateTracking && numMips * numLayers > 1;
+
+		Ranges.clear();
+		Ranges.push_back(Range{ 0, numMips * numLayers, initialState });
+	}
+
+	ERHIAccess TextureState::GetSubresourceState(uint32 mip, uint32 layer) const
+	{
+		uint32 index = mip + layer * NumMips;
+
+		auto it = std::upper_bound(Ranges.begin(), Ranges.end(), index,
+			[](uint32 i, const Range& range) { return i < range.End; });
+		assert(it != Ranges.end());
+
+		return it->State;
+	}
+
+	void TextureState::SetState(ERHIAccess state)
+	{
+		Ranges.resize(1);
+		Ranges[0] = Range{ 0, NumMips * NumLayers, state };
+	}
+
+	void TextureState::SetSubresourceState(uint32 mip, uint32 layer, ERHIAccess state)
+	{
+		uint32 index = mip + layer * NumMips;
+		SetIndexRangeState(index, index + 1, state);
+	}
+
+	void TextureState::SetSubresourcesState(const TextureSubresourceSet& range, ERHIAccess state)
+	{
+		TextureSubresourceSet set = Resolve(range);
+
+		// full mip chains of neighbouring layers are one contiguous index range
+		if (set.NumMips == NumMips)
+		{
+			SetIndexRangeState(set.BaseLayer * NumMips, (set.BaseLayer + set.NumLayers) * NumMips, state);
+			return;
+		}
+
+		for (uint32 l = set.BaseLayer; l < set.BaseLayer + set.NumLayers; l++)
+		{
+			uint32 begin = set.BaseMip + l * NumMips;
+			SetIndexRangeState(begin, begin + set.NumMips, state);
+		}
+	}
+
+	void TextureState::SetIndexRangeState(uint32 begin, uint32 end, ERHIAccess state)
+	{
+		if (begin >= end)
+			return;
+
+		if (!PerSubresourceTracking || (begin == 0 && end == NumMips * NumLayers))
+		{
+			SetState(state);
+			return;
+		}
+
+		// runs [first, last) overlap the new range
+		auto first = std::upper_bound(Ranges.begin(), Ranges.end(), begin,
+			[](uint32 i, const Range& range) { return i < range.End; });
+		auto last = first;
+		while (last != Ranges.end() && last->Begin < end)
+			last++;
+
+		Range replacement[3];
+		uint32 numReplacement = 0;
+
+		if (first->Begin < begin)
+			replacement[numReplacement++] = Range{ first->Begin, begin, first->State };
+
+		replacement[numReplacement++] = Range{ begin, end, state };
+
+		Range& tail = *(last - 1);
+		if (tail.End > end)
+			replacement[numReplacement++] = Range{ end, tail.End, tail.State };
+
+		uint64 index = first - Ranges.begin();
+		first = Ranges.erase(first, last);
+		Ranges.insert(first, replacement, replacement + numReplacement);
+
+		// merge with the runs around the replacement, a split remainder can share the new state too
+		uint64 mid = index + (replacement[0].Begin < begin ? 1 : 0);
+		if (mid + 1 < Ranges.size() && Ranges[mid + 1].State == state)
+		{
+			Ranges[mid].End = Ranges[mid + 1].End;
+			Ranges.erase(Ranges.begin() + mid + 1);
+		}
+		if (mid > 0 && Ranges[mid - 1].State == state)
+		{
+			Ranges[mid - 1].End = Ranges[mid].End;
+			Ranges.erase(Ranges.begin() + mid);
+		}
+	}
+
+	TextureSubresourceSet TextureState::Resolve(const TextureSubresourceSet& range) const
+	{
+		TextureSubresourceSet set = range;
+		set.NumMips = std::min(range.NumMips, NumMips - range.BaseMip);
+		set.NumLayers = std::min(range.NumLayers, NumLayers - range.BaseLayer);
+
+		return set;
+	}
+
+	uint32 TextureBarrierBuilder::Transition(TextureState& state, const TextureSubresourceSet& range, ERHIAccess newAccess,
+		std::vector<TextureBarrierRegion>& outRegions)
+	{
+		TextureSubresourceSet set = state.Resolve(range);
+		bool entireTexture = set.NumMips == state.NumMips && set.NumLayers == state.NumLayers;
+		uint64 numStart = outRegions.size();
+
+		if (entireTexture && state.AllSubresourcesSame())
+		{
+			if (NeedsBarrier(state.GetState(), newAccess))
+			{
+				TextureBarrierRegion& region = outRegions.emplace_back();
+				region.Range = set;
+				region.LastAccess = state.GetState();
+				region.NewAccess = newAccess;
+				region.EntireTexture = true;
+			}
+
+			state.SetState(newAccess);
+			return (uint32)(outRegions.size() - numStart);
+		}
+
+		// rectangles still growing over the layers, a run of the current layer extends a rectangle of
+		// the previous one when it covers the same mips in the same state
+		std::vector<TextureBarrierRegion> open{};
+		std::vector<TextureBarrierRegion> next{};
+		std::vector<bool> extended{};
+
+		for (uint32 l = set.BaseLayer; l < set.BaseLayer + set.NumLayers; l++)
+		{
+			extended.assign(open.size(), false);
+			next.clear();
+
+			uint32 begin = set.BaseMip + l * state.NumMips;
+			uint32 end = begin + set.NumMips;
+
+			auto it = std::upper_bound(state.Ranges.begin(), state.Ranges.end(), begin,
+				[](uint32 i, const TextureState::Range& r) { return i < r.End; });
+
+			for (; it != state.Ranges.end() && it->Begin < end; it++)
+			{
+				if (!NeedsBarrier(it->State, newAccess))
+					continue;
+
+				uint32 runBegin = std::max(it->Begin, begin) - l * state.NumMips;
+				uint32 runEnd = std::min(it->End, end) - l * state.NumMips;
+
+				// both lists are sorted by mip, so this stays short
+				bool found = false;
+				for (uint32 i = 0; i < (uint32)open.size(); i++)
+				{
+					TextureBarrierRegion& rect = open[i];
+					if (!extended[i] && rect.Range.BaseMip == runBegin && rect.Range.NumMips == runEnd - runBegin && rect.LastAccess == it->State)
+					{
+						rect.Range.NumLayers++;
+						extended[i] = true;
+						next.push_back(rect);
+						found = true;
+						break;
+					}
+				}
+
+				if (!found)
+				{
+					TextureBarrierRegion& region = next.emplace_back();
+					region.Range.BaseMip = runBegin;
+					region.Range.NumMips = runEnd - runBegin;
+					region.Range.BaseLayer = l;
+					region.Range.NumLayers = 1;
+					region.LastAccess = it->State;
+					region.NewAccess = newAccess;
+					region.EntireTexture = false;
+				}
+			}
+
+			for (uint32 i = 0; i < (uint32)open.size(); i++)
+			{
+				if (!extended[i])
+					outRegions.push_back(open[i]);
+			}
+
+			std::swap(open, next);
+		}
+
+		outRegions.insert(outRegions.end(), open.begin(), open.end());
+
+		for (uint64 i = numStart; i < outRegions.size(); i++)
+		{
+			TextureBarrierRegion& region = outRegions[i];
+			region.EntireTexture = region.Range.NumMips == state.NumMips && region.Range.NumLayers == state.NumLayers;
+		}
+
+		state.SetSubresourcesState(set, newAccess);
+		return (uint32)(outRegions.size() - numStart);
+	}
+}
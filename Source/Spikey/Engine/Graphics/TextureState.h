@@ -0,0 +1,84 @@
+#pragma once
+#include <Engine/Graphics/RHIResource.h>
+
+namespace Spikey {
+
+	struct TextureSubresourceSet
+	{
+		uint32 BaseMip;
+		uint32 NumMips;
+		uint32 BaseLayer;
+		uint32 NumLayers;
+
+		static TextureSubresourceSet AllTexture()
+		{
+			TextureSubresourceSet range{};
+			range.BaseMip = 0;
+			range.BaseLayer = 0;
+			range.NumMips = ~0u;
+			range.NumLayers = ~0u;
+
+			return range;
+		}
+
+		bool operator==(const TextureSubresourceSet& other) const = default;
+	};
+
+	struct TextureBarrierRegion
+	{
+		TextureSubresourceSet Range;
+		ERHIAccess            LastAccess;
+		ERHIAccess            NewAccess;
+		bool                  EntireTexture;
+	};
+
+	// access state of every subresource, stored as sorted runs of subresource indices (mip + layer * numMips)
+	// sharing one state. neighbouring runs always differ, so a texture in a single state is a single run
+	struct TextureState
+	{
+		struct Range
+		{
+			uint32     Begin;
+			uint32     End;
+			ERHIAccess State;
+		};
+
+		uint32             NumMips = 1;
+		uint32             NumLayers = 1;
+		bool               PerSubresourceTracking = false;
+		std::vector<Range> Ranges;
+
+		void Initialize(uint32 numMips, uint32 numLayers, ERHIAccess initialState, bool usePerStateTracking);
+
+		bool       AllSubresourcesSame() const { return Ranges.size() == 1; }
+		ERHIAccess GetState() const { return Ranges.front().State; }
+		ERHIAccess GetSubresourceState(uint32 mip, uint32 layer) const;
+
+		void SetState(ERHIAccess state);
+		void SetSubresourceState(uint32 mip, uint32 layer, ERHIAccess state);
+		void SetSubresourcesState(const TextureSubresourceSet& range, ERHIAccess state);
+
+		// sets subresource indices [begin, end), merging with the neighbouring runs
+		void SetIndexRangeState(uint32 begin, uint32 end, ERHIAccess state);
+
+		// clamps ~0u counts to the rest of the texture
+		TextureSubresourceSet Resolve(const TextureSubresourceSet& range) const;
+	};
+
+	// turns a transition of a mip / layer rectangle into the fewest barrier regions, one per
+	// rectangle of subresources sharing the previous state, and updates the tracked state.
+	// does not touch the gpu, the regions go to RHICommandList::BarrierTexture
+	class TextureBarrierBuilder
+	{
+	public:
+		// appends to outRegions, returns the number of regions added
+		static uint32 Transition(TextureState& state, const TextureSubresourceSet& range, ERHIAccess newAccess,
+			std::vector<TextureBarrierRegion>& outRegions);
+
+		// unordered access needs a barrier even without a state change, to order the writes
+		static bool NeedsBarrier(ERHIAccess lastAccess, ERHIAccess newAccess)
+		{
+			return lastAccess != newAccess || EnumHasAnyFlags(newAccess, ERHIAccess::UAV);
+		}
+	};
+}
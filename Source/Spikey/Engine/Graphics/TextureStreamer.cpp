@@ -0,0 +1,490 @@
+#include <Engine/Graphics/TextureStreamer.h>
+#include <Engine/Graphics/GraphicsCore.h>
+#include <Engine/Threading/JobSystem.h>
+
+namespace Spikey {
+
+	struct StreamingTexture
+	{
+		Texture2D*            Texture = nullptr;
+		std::filesystem::path Path;
+		uint64                PayloadOffset = 0;
+		Texture2DHeader       Header{};
+		SamplerStateDesc      SamplerDesc{};
+
+		uint32 MinResidentMip = 0; // tail that never leaves memory
+		uint32 AllocatedMip = 0;   // first mip of the current allocation
+		uint32 ResidentMip = 0;    // first mip with uploaded data, never below AllocatedMip
+		uint32 RequestedMip = 0;
+		uint32 FrameRequest = ~0u; // combined requests of the current frame
+		uint64 LastRequestFrame = 0;
+		uint32 Generation = 0;     // bumped on unregister, loads of an old generation are dropped
+		bool   LoadInFlight = false;
+		bool   Active = false;
+	};
+
+	struct CompletedMipLoad
+	{
+		uint32             Handle;
+		uint32             Generation;
+		uint32             Mip;
+		std::vector<uint8> Data;
+	};
+
+	struct TextureStreamerData
+	{
+		TextureStreamerDesc           Desc;
+		std::vector<StreamingTexture> Textures;
+		IndexQueue                    Handles;
+		std::mutex                    Mutex;
+
+		std::mutex                    LoadMutex;
+		std::vector<CompletedMipLoad> CompletedLoads;
+		JobSystem::Counter            LoadCounter;
+
+		uint64 FrameIndex = 0;
+		uint64 ResidentBytes = 0;
+		uint64 StreamedInBytes = 0;
+		uint64 EvictedBytes = 0;
+		uint32 NumTextures = 0;
+	};
+
+	static TextureStreamerData* s_Streamer = nullptr;
+
+	static uint64 GetMipSize(const StreamingTexture& tex, uint32 mip)
+	{
+		return MipSizeInBytes(tex.Header.Format, tex.Header.Width, tex.Header.Height, mip);
+	}
+
+	static uint64 GetAllocationSize(const StreamingTexture& tex, uint32 firstMip)
+	{
+		uint64 size = 0;
+		for (uint32 m = firstMip; m < tex.Header.NumMips; m++)
+			size += GetMipSize(tex, m);
+
+		return size;
+	}
+
+	// a texture unregisters from its destructor, which waits for the streamer lock held here, so the pointer
+	// stays valid, but one whose last reference is gone must not be revived. nullptr for those
+	static TRef<Texture2D> AcquireTexture(const StreamingTexture& tex)
+	{
+		if (!tex.Texture || !tex.Texture->TryAddRef())
+			return nullptr;
+
+		TRef<Texture2D> texture = tex.Texture;
+		tex.Texture->Release();
+
+		return texture;
+	}
+
+	static void UpdateSampler(StreamingTexture& tex)
+	{
+		TRef<Texture2D> texture = AcquireTexture(tex);
+		if (!texture)
+			return;
+
+		// lods are relative to the allocation, its mip 0 is AllocatedMip of the full chain
+		SamplerStateDesc desc = tex.SamplerDesc;
+		desc.MinLOD = (float)(tex.ResidentMip - tex.AllocatedMip);
+		desc.MaxLOD = (float)(tex.Header.NumMips - tex.AllocatedMip);
+
+		Graphics::SubmitCommand([texture = std::move(texture), sampler = Graphics::GetRHI().CreateSamplerState(desc)]() {
+			texture->m_SamplerState = sampler;
+			});
+	}
+
+	// moves the texture into an allocation starting at firstMip, mips resident in both are copied on the gpu
+	static void Reallocate(StreamingTexture& tex, uint32 firstMip)
+	{
+		uint32 oldFirstMip = tex.AllocatedMip;
+		uint32 keptMip = std::max(tex.ResidentMip, firstMip);
+
+		Texture2DDesc desc{};
+		desc.Width = std::max(1u, tex.Header.Width >> firstMip);
+		desc.Height = std::max(1u, tex.Header.Height >> firstMip);
+		desc.Format = tex.Header.Format;
+		desc.NumMips = tex.Header.NumMips - firstMip;
+		desc.UsageFlags = ETextureUsage::Sampled | ETextureUsage::CopyDst | ETextureUsage::CopySrc;
+
+		int64 sizeDelta = (int64)GetAllocationSize(tex, firstMip) - (int64)GetAllocationSize(tex, oldFirstMip);
+		if (sizeDelta < 0)
+			s_Streamer->EvictedBytes += (uint64)-sizeDelta;
+		s_Streamer->ResidentBytes = (uint64)((int64)s_Streamer->ResidentBytes + sizeDelta);
+
+		tex.AllocatedMip = firstMip;
+		tex.ResidentMip = keptMip;
+
+		TRef<Texture2D> texture = AcquireTexture(tex);
+		if (!texture)
+			return;
+
+		Graphics::SubmitCommand([texture = std::move(texture), desc, oldFirstMip, firstMip, keptMip, numMips = tex.Header.NumMips]() {
+			Texture2DRHIRef newResource = Graphics::GetRHI().CreateTexture2D(desc);
+			Texture2DRHIRef oldResource = texture->m_RHIResource;
+
+			RHICommandList* cmd = Graphics::GetRHI().BeginCommandList();
+
+			// the kept mips are sampled, every mip of the new image leaves undefined, also the ones not copied
+			if (keptMip < numMips)
+			{
+				TextureBarrierRegion toCopySrc{};
+				toCopySrc.Range = TextureSubresourceSet{ keptMip - oldFirstMip, numMips - keptMip, 0, 1 };
+				toCopySrc.LastAccess = ERHIAccess::SRV;
+				toCopySrc.NewAccess = ERHIAccess::CopySrc;
+				toCopySrc.EntireTexture = keptMip == oldFirstMip;
+				cmd->BarrierTexture(oldResource, &toCopySrc, 1);
+			}
+
+			TextureBarrierRegion toCopyDst{};
+			toCopyDst.Range = TextureSubresourceSet::AllTexture();
+			toCopyDst.LastAccess = ERHIAccess::None;
+			toCopyDst.NewAccess = ERHIAccess::CopyDst;
+			toCopyDst.EntireTexture = true;
+			cmd->BarrierTexture(newResource, &toCopyDst, 1);
+
+			for (uint32 m = keptMip; m < numMips; m++)
+			{
+				TextureSlice srcSlice{};
+				srcSlice.MipLevel = m - oldFirstMip;
+
+				TextureSlice dstSlice{};
+				dstSlice.MipLevel = m - firstMip;
+
+				cmd->CopyTexture(oldResource, srcSlice, newResource, dstSlice);
+			}
+
+			TextureBarrierRegion toSRV = toCopyDst;
+			toSRV.LastAccess = ERHIAccess::CopyDst;
+			toSRV.NewAccess = ERHIAccess::SRV;
+			cmd->BarrierTexture(newResource, &toSRV, 1);
+
+			Graphics::GetRHI().SubmitCommandList(cmd);
+
+			// the old resource is released through its reference once the copy retired
+			texture->m_RHIResource = newResource;
+			});
+
+		UpdateSampler(tex);
+	}
+
+	static void IssueMipLoad(uint32 handle, StreamingTexture& tex, uint32 mip)
+	{
+		tex.LoadInFlight = true;
+
+		uint64 offset = tex.PayloadOffset + Texture2DMipFileOffset(tex.Header, mip);
+		uint64 size = GetMipSize(tex, mip);
+
+		JobSystem::Execute(s_Streamer->LoadCounter, [handle, generation = tex.Generation, mip, path = tex.Path, offset, size]() {
+			PROFILE_SCOPED_NAMED("Texture Mip Load");
+
+			CompletedMipLoad load{ handle, generation, mip };
+
+			BinaryReadStream stream(path);
+			if (stream.IsOpen())
+			{
+				stream.Seek(offset);
+				load.Data.resize(size);
+				stream.ReadRaw(load.Data.data(), size);
+			}
+
+			std::lock_guard lock(s_Streamer->LoadMutex);
+			s_Streamer->CompletedLoads.push_back(std::move(load));
+			});
+	}
+
+	static void ApplyCompletedLoads()
+	{
+		std::vector<CompletedMipLoad> loads;
+		{
+			std::lock_guard lock(s_Streamer->LoadMutex);
+			loads.swap(s_Streamer->CompletedLoads);
+		}
+
+		for (CompletedMipLoad& load : loads)
+		{
+			StreamingTexture& tex = s_Streamer->Textures[load.Handle];
+			if (!tex.Active || tex.Generation != load.Generation)
+				continue;
+
+			tex.LoadInFlight = false;
+
+			if (load.Data.empty())
+			{
+				ENGINE_ERROR("Failed to stream mip {} of texture: {}", load.Mip, tex.Path.string());
+
+				// stop streaming this texture instead of retrying every frame
+				tex.MinResidentMip = tex.ResidentMip;
+				continue;
+			}
+
+			// the texture may have shrunk or moved on while the read was in flight
+			if (load.Mip < tex.AllocatedMip || load.Mip + 1 != tex.ResidentMip)
+				continue;
+
+			TRef<Texture2D> texture = AcquireTexture(tex);
+			if (!texture)
+				continue;
+
+			SubResourceCopyRegion region{};
+			region.DataOffset = 0;
+			region.MipLevel = load.Mip - tex.AllocatedMip;
+			region.ArrayLayer = 0;
+
+			Graphics::SubmitCommand([texture = std::move(texture), region, data = std::move(load.Data)]() mutable {
+				Graphics::GetRHI().CopyDataToTexture(data.data(), 0, texture->GetResource(), EGPUAccess::None, EGPUAccess::SRV,
+					{ region }, data.size());
+				});
+
+			s_Streamer->StreamedInBytes += GetMipSize(tex, load.Mip);
+			tex.ResidentMip = load.Mip;
+			UpdateSampler(tex);
+		}
+	}
+
+	static void EvictOverBudget()
+	{
+		if (s_Streamer->ResidentBytes <= s_Streamer->Desc.MemoryBudget)
+			return;
+
+		std::vector<uint32> candidates;
+		for (uint32 i = 0; i < (uint32)s_Streamer->Textures.size(); i++)
+		{
+			const StreamingTexture& tex = s_Streamer->Textures[i];
+			if (tex.Active && tex.AllocatedMip < tex.MinResidentMip)
+				candidates.push_back(i);
+		}
+
+		// unneeded mips first, then least recently requested, then the largest allocations
+		std::sort(candidates.begin(), candidates.end(), [](uint32 a, uint32 b) {
+			const StreamingTexture& texA = s_Streamer->Textures[a];
+			const StreamingTexture& texB = s_Streamer->Textures[b];
+
+			bool unneededA = texA.RequestedMip > texA.AllocatedMip;
+			bool unneededB = texB.RequestedMip > texB.AllocatedMip;
+			if (unneededA != unneededB)
+				return unneededA;
+
+			if (texA.LastRequestFrame != texB.LastRequestFrame)
+				return texA.LastRequestFrame < texB.LastRequestFrame;
+
+			return texA.AllocatedMip < texB.AllocatedMip;
+			});
+
+		for (uint32 handle : candidates)
+		{
+			StreamingTexture& tex = s_Streamer->Textures[handle];
+
+			// drop one mip at a time, a texture still in use only loses what is needed
+			uint32 firstMip = tex.AllocatedMip;
+			while (firstMip < tex.MinResidentMip && s_Streamer->ResidentBytes - (GetAllocationSize(tex, tex.AllocatedMip)
+				- GetAllocationSize(tex, firstMip)) > s_Streamer->Desc.MemoryBudget)
+			{
+				firstMip++;
+			}
+
+			if (firstMip != tex.AllocatedMip)
+				Reallocate(tex, firstMip);
+
+			if (s_Streamer->ResidentBytes <= s_Streamer->Desc.MemoryBudget)
+				break;
+		}
+	}
+
+	static void StreamRequestedMips()
+	{
+		std::vector<uint32> candidates;
+		for (uint32 i = 0; i < (uint32)s_Streamer->Textures.size(); i++)
+		{
+			const StreamingTexture& tex = s_Streamer->Textures[i];
+			if (tex.Active && !tex.LoadInFlight && tex.RequestedMip < tex.ResidentMip)
+				candidates.push_back(i);
+		}
+
+		// textures furthest from what they need go first
+		std::sort(candidates.begin(), candidates.end(), [](uint32 a, uint32 b) {
+			const StreamingTexture& texA = s_Streamer->Textures[a];
+			const StreamingTexture& texB = s_Streamer->Textures[b];
+
+			return texA.ResidentMip - texA.RequestedMip > texB.ResidentMip - texB.RequestedMip;
+			});
+
+		uint64 uploadBudget = s_Streamer->Desc.MaxUploadPerFrame;
+
+		for (uint32 handle : candidates)
+		{
+			StreamingTexture& tex = s_Streamer->Textures[handle];
+			uint32 mip = tex.ResidentMip - 1;
+			uint64 mipSize = GetMipSize(tex, mip);
+
+			// always let a single mip through, so a mip bigger than the budget does not stall forever
+			if (mipSize > uploadBudget && uploadBudget != s_Streamer->Desc.MaxUploadPerFrame)
+				break;
+
+			if (tex.RequestedMip < tex.AllocatedMip)
+			{
+				uint64 growth = GetAllocationSize(tex, tex.RequestedMip) - GetAllocationSize(tex, tex.AllocatedMip);
+				if (s_Streamer->ResidentBytes + growth > s_Streamer->Desc.MemoryBudget)
+					continue;
+
+				Reallocate(tex, tex.RequestedMip);
+			}
+
+			IssueMipLoad(handle, tex, mip);
+			uploadBudget -= std::min(uploadBudget, mipSize);
+		}
+	}
+
+	void TextureStreamer::Init(const TextureStreamerDesc& desc)
+	{
+		CHECK(!s_Streamer);
+		s_Streamer = new TextureStreamerData();
+		s_Streamer->Desc = desc;
+	}
+
+	void TextureStreamer::Shutdown()
+	{
+		if (!s_Streamer)
+			return;
+
+		JobSystem::Wait(s_Streamer->LoadCounter);
+
+		delete s_Streamer;
+		s_Streamer = nullptr;
+	}
+
+	void TextureStreamer::Tick()
+	{
+		PROFILE_SCOPED;
+
+		std::lock_guard lock(s_Streamer->Mutex);
+		s_Streamer->FrameIndex++;
+
+		// textures nobody asked for fall back to their tail and become eviction candidates
+		for (StreamingTexture& tex : s_Streamer->Textures)
+		{
+			if (!tex.Active)
+				continue;
+
+			if (tex.FrameRequest != ~0u)
+			{
+				tex.RequestedMip = tex.FrameRequest;
+				tex.LastRequestFrame = s_Streamer->FrameIndex;
+			}
+			else
+			{
+				tex.RequestedMip = tex.MinResidentMip;
+			}
+
+			tex.FrameRequest = ~0u;
+		}
+
+		ApplyCompletedLoads();
+		EvictOverBudget();
+		StreamRequestedMips();
+	}
+
+	uint32 TextureStreamer::Register(Texture2D* texture, const std::filesystem::path& path, uint64 payloadOffset,
+		const Texture2DHeader& header, const SamplerStateDesc& samplerDesc, uint32 firstResidentMip)
+	{
+		std::lock_guard lock(s_Streamer->Mutex);
+
+		uint32 handle = s_Streamer->Handles.Grab();
+		if (handle >= s_Streamer->Textures.size())
+			s_Streamer->Textures.resize(handle + 1);
+
+		StreamingTexture& tex = s_Streamer->Textures[handle];
+		uint32 generation = tex.Generation;
+
+		tex = StreamingTexture{};
+		tex.Texture = texture;
+		tex.Path = path;
+		tex.PayloadOffset = payloadOffset;
+		tex.Header = header;
+		tex.SamplerDesc = samplerDesc;
+		tex.MinResidentMip = firstResidentMip;
+		tex.AllocatedMip = firstResidentMip;
+		tex.ResidentMip = firstResidentMip;
+		tex.RequestedMip = firstResidentMip;
+		tex.LastRequestFrame = s_Streamer->FrameIndex;
+		tex.Generation = generation;
+		tex.Active = true;
+
+		s_Streamer->ResidentBytes += GetAllocationSize(tex, firstResidentMip);
+		s_Streamer->NumTextures++;
+
+		return handle;
+	}
+
+	void TextureStreamer::Unregister(uint32 handle)
+	{
+		// textures may outlive the streamer during shutdown
+		if (!s_Streamer)
+			return;
+
+		std::lock_guard lock(s_Streamer->Mutex);
+
+		StreamingTexture& tex = s_Streamer->Textures[handle];
+		s_Streamer->ResidentBytes -= GetAllocationSize(tex, tex.AllocatedMip);
+		s_Streamer->NumTextures--;
+
+		tex.Active = false;
+		tex.Texture = nullptr;
+		tex.Generation++;
+
+		s_Streamer->Handles.Release(handle);
+	}
+
+	void TextureStreamer::RequestMip(uint32 handle, uint32 mip)
+	{
+		std::lock_guard lock(s_Streamer->Mutex);
+
+		StreamingTexture& tex = s_Streamer->Textures[handle];
+		tex.FrameRequest = std::min(tex.FrameRequest, std::min(mip, tex.Header.NumMips - 1));
+	}
+
+	void TextureStreamer::RequestScreenSize(uint32 handle, float32 screenSize, float32 uvScale)
+	{
+		std::lock_guard lock(s_Streamer->Mutex);
+
+		StreamingTexture& tex = s_Streamer->Textures[handle];
+		uint32 mip = ComputeRequestedMip(tex.Header.Width, tex.Header.Height, tex.Header.NumMips, screenSize, uvScale);
+		tex.FrameRequest = std::min(tex.FrameRequest, mip);
+	}
+
+	uint32 TextureStreamer::ComputeRequestedMip(uint32 width, uint32 height, uint32 numMips, float32 screenSize, float32 uvScale)
+	{
+		float32 texels = (float32)std::max(width, height) * uvScale;
+		if (screenSize <= 1.f)
+			return numMips - 1;
+
+		float32 mip = std::floor(std::log2(std::max(texels / screenSize, 1.f)));
+		return std::min((uint32)mip, numMips - 1);
+	}
+
+	uint32 TextureStreamer::GetMinResidentMip(uint32 width, uint32 height, uint32 numMips)
+	{
+		if (!s_Streamer)
+			return 0;
+
+		uint32 mip = 0;
+		while (mip + 1 < numMips && std::max(width >> mip, height >> mip) > s_Streamer->Desc.MinResidentSize)
+			mip++;
+
+		return mip;
+	}
+
+	TextureStreamer::Stats TextureStreamer::GetStats()
+	{
+		std::lock_guard lock(s_Streamer->Mutex);
+
+		Stats stats{};
+		stats.ResidentBytes = s_Streamer->ResidentBytes;
+		stats.StreamedInBytes = s_Streamer->StreamedInBytes;
+		stats.EvictedBytes = s_Streamer->EvictedBytes;
+		stats.NumTextures = s_Streamer->NumTextures;
+		stats.PendingLoads = s_Streamer->LoadCounter.Pending.load(std::memory_order_relaxed);
+
+		return stats;
+	}
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <Engine/Graphics/Texture2D.h>
+
+namespace Spikey {
+
+	struct TextureStreamerDesc
+	{
+		uint64 MemoryBudget = 512ull << 20;     // bytes of texture memory streamed textures may occupy
+		uint64 MaxUploadPerFrame = 32ull << 20; // bytes read and uploaded per tick
+		uint32 MinResidentSize = 64;            // mips of this size and smaller never leave memory
+	};
+
+	// keeps textures stored with their mips smallest first at the resolution they are requested at.
+	// requests made during a frame are resolved on Tick, missing mips are read on the job system and
+	// uploaded one at a time. when a texture grows it is reallocated right away and the sampler
+	// MinLOD hides mips that are not uploaded yet. over budget, mips of textures nobody requested
+	// are dropped first, then those of the least recently requested ones
+	class TextureStreamer
+	{
+	public:
+		static void Init(const TextureStreamerDesc& desc = {});
+		static void Shutdown();
+
+		// once per frame on the game thread
+		static void Tick();
+
+		static uint32 Register(Texture2D* texture, const std::filesystem::path& path, uint64 payloadOffset,
+			const Texture2DHeader& header, const SamplerStateDesc& samplerDesc, uint32 firstResidentMip);
+		static void   Unregister(uint32 handle);
+
+		// requests of a frame are combined, the most detailed one wins
+		static void RequestMip(uint32 handle, uint32 mip);
+
+		// requests the mip ComputeRequestedMip picks for the registered texture
+		static void RequestScreenSize(uint32 handle, float32 screenSize, float32 uvScale = 1.f);
+
+		// mip that gives about one texel per pixel for a surface covering screenSize pixels
+		// along its longest side, uvScale being the texture tiling across that surface
+		static uint32 ComputeRequestedMip(uint32 width, uint32 height, uint32 numMips, float32 screenSize, float32 uvScale = 1.f);
+
+		// first mip loaded with the texture, 0 (everything) when streaming is not running
+		static uint32 GetMinResidentMip(uint32 width, uint32 height, uint32 numMips);
+
+		struct Stats
+		{
+			uint64 ResidentBytes;
+			uint64 StreamedInBytes;
+			uint64 EvictedBytes;
+			uint32 NumTextures;
+			uint32 PendingLoads;
+		};
+
+		static Stats GetStats();
+	};
+}
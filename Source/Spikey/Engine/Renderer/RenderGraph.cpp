@@ -0,0 +1,501 @@
+#include <Engine/Renderer/RenderGraph.h>
+#include <Engine/Graphics/GraphicsCore.h>
+
+namespace Spikey {
+
+	RHITexture* RGPassContext::GetTexture(RGHandle handle) const
+	{
+		return m_Graph.m_Resources[handle.Index].Texture;
+	}
+
+	RHIBuffer* RGPassContext::GetBuffer(RGHandle handle) const
+	{
+		return m_Graph.m_Resources[handle.Index].Buffer;
+	}
+
+	RGPassBuilder& RGPassBuilder::Read(RGHandle resource, ERHIAccess access, const TextureSubresourceSet& range)
+	{
+		m_Graph.AddAccess(m_Pass, resource, access, range, false);
+		return *this;
+	}
+
+	RGPassBuilder& RGPassBuilder::Write(RGHandle resource, ERHIAccess access, const TextureSubresourceSet& range)
+	{
+		m_Graph.AddAccess(m_Pass, resource, access, range, true);
+		return *this;
+	}
+
+	RGHandle RenderGraph::AddResource(const std::string& name, bool isTexture)
+	{
+		Resource& resource = m_Resources.emplace_back();
+		resource.Name = name;
+		resource.IsTexture = isTexture;
+		resource.Imported = false;
+		resource.Output = false;
+		resource.BufferSize = 0;
+		resource.BufferFlags = EBufferFlags::None;
+		resource.Texture = nullptr;
+		resource.Buffer = nullptr;
+		resource.Access = ERHIAccess::None;
+		resource.InitialAccess = ERHIAccess::None;
+
+		m_Compiled = false;
+		return RGHandle{ (uint32)m_Resources.size() - 1 };
+	}
+
+	RGHandle RenderGraph::CreateTexture(const std::string& name, const TextureDesc& desc)
+	{
+		RGHandle handle = AddResource(name, true);
+		m_Resources[handle.Index].TexDesc = desc;
+
+		return handle;
+	}
+
+	RGHandle RenderGraph::CreateBuffer(const std::string& name, uint64 size, EBufferFlags flags)
+	{
+		RGHandle handle = AddResource(name, false);
+		m_Resources[handle.Index].BufferSize = size;
+		m_Resources[handle.Index].BufferFlags = flags;
+
+		return handle;
+	}
+
+	RGHandle RenderGraph::ImportTexture(const std::string& name, RHITexture* texture)
+	{
+		RGHandle handle = AddResource(name, true);
+
+		Resource& resource = m_Resources[handle.Index];
+		resource.TexDesc = texture->GetDesc();
+		resource.Imported = true;
+		resource.Texture = texture;
+
+		return handle;
+	}
+
+	RGHandle RenderGraph::ImportBuffer(const std::string& name, RHIBuffer* buffer, ERHIAccess currentAccess)
+	{
+		RGHandle handle = AddResource(name, false);
+
+		Resource& resource = m_Resources[handle.Index];
+		resource.BufferSize = buffer->GetSize();
+		resource.BufferFlags = buffer->GetUsage();
+		resource.Imported = true;
+		resource.Buffer = buffer;
+		resource.InitialAccess = currentAccess;
+
+		return handle;
+	}
+
+	void RenderGraph::MarkOutput(RGHandle resource)
+	{
+		m_Resources[resource.Index].Output = true;
+		m_Compiled = false;
+	}
+
+	RGPassBuilder RenderGraph::AddPass(const std::string& name, ERGPassFlags flags, RGExecuteFunc&& execute)
+	{
+		Pass& pass = m_Passes.emplace_back();
+		pass.Name = name;
+		pass.Flags = flags;
+		pass.Execute = std::move(execute);
+		pass.FirstAccess = (uint32)m_Accesses.size();
+		pass.NumAccesses = 0;
+		pass.RefCount = 0;
+		pass.Culled = false;
+		pass.FirstTextureBarrier = pass.NumTextureBarriers = 0;
+		pass.FirstBufferBarrier = pass.NumBufferBarriers = 0;
+
+		m_Compiled = false;
+		return RGPassBuilder(*this, (uint32)m_Passes.size() - 1);
+	}
+
+	void RenderGraph::AddAccess(uint32 passIndex, RGHandle resource, ERHIAccess access, const TextureSubresourceSet& range, bool write)
+	{
+		CHECK(resource.IsValid() && resource.Index < m_Resources.size());
+
+		// accesses of a pass are stored next to each other
+		Pass& pass = m_Passes[passIndex];
+		CHECK(passIndex == m_Passes.size() - 1);
+
+		// reading the same subresources in several ways becomes one combined read state, see CombineReadAccess
+		if (!write)
+		{
+			for (uint32 i = pass.FirstAccess; i < pass.FirstAccess + pass.NumAccesses; i++)
+			{
+				Access& other = m_Accesses[i];
+
+				if (other.Resource == resource.Index && !other.Write && other.Range.BaseMip == range.BaseMip && other.Range.NumMips == range.NumMips
+					&& other.Range.BaseLayer == range.BaseLayer && other.Range.NumLayers == range.NumLayers)
+				{
+					other.Access = CombineReadAccess(other.Access, access);
+					return;
+				}
+			}
+		}
+
+		m_Accesses.push_back(Access{ resource.Index, access, range, write });
+		pass.NumAccesses++;
+	}
+
+	void RenderGraph::CullPasses()
+	{
+		PROFILE_SCOPED;
+
+		// resources are referenced by their readers, passes by the resources they write.
+		// anything imported or marked as output is referenced from outside the graph
+		for (Resource& resource : m_Resources)
+		{
+			resource.RefCount = (resource.Imported || resource.Output) ? 1 : 0;
+			resource.NumWriters = 0;
+		}
+
+		for (Pass& pass : m_Passes)
+		{
+			pass.RefCount = EnumHasAllFlags(pass.Flags, ERGPassFlags::NeverCull) ? 1 : 0;
+			pass.Culled = false;
+
+			for (uint32 i = pass.FirstAccess; i < pass.FirstAccess + pass.NumAccesses; i++)
+			{
+				const Access& access = m_Accesses[i];
+
+				if (access.Write)
+				{
+					m_Resources[access.Resource].NumWriters++;
+					pass.RefCount++;
+				}
+				else
+				{
+					m_Resources[access.Resource].RefCount++;
+				}
+			}
+		}
+
+		// group the writers of every resource
+		uint32 offset = 0;
+		for (Resource& resource : m_Resources)
+		{
+			resource.FirstWriter = offset;
+			offset += resource.NumWriters;
+			resource.NumWriters = 0;
+		}
+
+		m_Writers.resize(offset);
+		for (uint32 p = 0; p < (uint32)m_Passes.size(); p++)
+		{
+			const Pass& pass = m_Passes[p];
+
+			for (uint32 i = pass.FirstAccess; i < pass.FirstAccess + pass.NumAccesses; i++)
+			{
+				const Access& access = m_Accesses[i];
+				if (access.Write)
+				{
+					Resource& resource = m_Resources[access.Resource];
+					m_Writers[resource.FirstWriter + resource.NumWriters++] = p;
+				}
+			}
+		}
+
+		std::vector<uint32> unreferenced{};
+		auto cullPass = [&](Pass& pass) {
+			pass.Culled = true;
+
+			for (uint32 i = pass.FirstAccess; i < pass.FirstAccess + pass.NumAccesses; i++)
+			{
+				const Access& access = m_Accesses[i];
+				if (!access.Write && --m_Resources[access.Resource].RefCount == 0)
+					unreferenced.push_back(access.Resource);
+			}
+			};
+
+		for (Pass& pass : m_Passes)
+		{
+			if (pass.RefCount == 0)
+				cullPass(pass);
+		}
+
+		for (uint32 r = 0; r < (uint32)m_Resources.size(); r++)
+		{
+			if (m_Resources[r].RefCount == 0)
+				unreferenced.push_back(r);
+		}
+
+		// walk back from unused resources to the passes producing them
+		while (!unreferenced.empty())
+		{
+			const Resource& resource = m_Resources[unreferenced.back()];
+			unreferenced.pop_back();
+
+			for (uint32 w = resource.FirstWriter; w < resource.FirstWriter + resource.NumWriters; w++)
+			{
+				Pass& writer = m_Passes[m_Writers[w]];
+				if (!writer.Culled && --writer.RefCount == 0)
+					cullPass(writer);
+			}
+		}
+
+		m_ExecutionOrder.clear();
+		for (uint32 p = 0; p < (uint32)m_Passes.size(); p++)
+		{
+			if (!m_Passes[p].Culled)
+				m_ExecutionOrder.push_back(p);
+		}
+	}
+
+	void RenderGraph::BuildBarriers()
+	{
+		PROFILE_SCOPED;
+
+		// replay the frame from the state every resource starts in
+		for (Resource& resource : m_Resources)
+		{
+			if (!resource.IsTexture)
+			{
+				resource.Access = resource.InitialAccess;
+			}
+			else if (resource.Imported)
+			{
+				resource.State = resource.Texture->GetState();
+			}
+			else
+			{
+				resource.State.Initialize(resource.TexDesc.MipLevels, resource.TexDesc.ArraySize, ERHIAccess::None, true);
+			}
+		}
+
+		for (Pass& pass : m_Passes)
+		{
+			pass.FirstTextureBarrier = pass.NumTextureBarriers = 0;
+			pass.FirstBufferBarrier = pass.NumBufferBarriers = 0;
+		}
+
+		m_TextureBarriers.clear();
+		m_BufferBarriers.clear();
+
+		for (uint32 p : m_ExecutionOrder)
+		{
+			Pass& pass = m_Passes[p];
+			pass.FirstTextureBarrier = (uint32)m_TextureBarriers.size();
+			pass.FirstBufferBarrier = (uint32)m_BufferBarriers.size();
+
+			for (uint32 i = pass.FirstAccess; i < pass.FirstAccess + pass.NumAccesses; i++)
+			{
+				const Access& access = m_Accesses[i];
+				Resource& resource = m_Resources[access.Resource];
+
+				if (resource.IsTexture)
+				{
+					m_RegionScratch.clear();
+					TextureBarrierBuilder::Transition(resource.State, access.Range, access.Access, m_RegionScratch);
+
+					for (const TextureBarrierRegion& region : m_RegionScratch)
+						m_TextureBarriers.push_back(TextureBarrier{ access.Resource, region });
+				}
+				else
+				{
+					if (TextureBarrierBuilder::NeedsBarrier(resource.Access, access.Access))
+						m_BufferBarriers.push_back(BufferBarrier{ access.Resource, resource.Access, access.Access });
+
+					resource.Access = access.Access;
+				}
+			}
+
+			pass.NumTextureBarriers = (uint32)m_TextureBarriers.size() - pass.FirstTextureBarrier;
+			pass.NumBufferBarriers = (uint32)m_BufferBarriers.size() - pass.FirstBufferBarrier;
+		}
+	}
+
+	static uint64 GetTextureMemorySize(const TextureDesc& desc)
+	{
+		return TextureSizeInBytes(desc.Format, desc.Width, desc.Height, desc.MipLevels) * desc.ArraySize * desc.Depth * desc.SampleCount;
+	}
+
+	void RenderGraph::ComputeLifetimes()
+	{
+		PROFILE_SCOPED;
+
+		for (Resource& resource : m_Resources)
+		{
+			resource.FirstPass = ~0u;
+			resource.LastPass = 0;
+		}
+
+		for (uint32 e = 0; e < (uint32)m_ExecutionOrder.size(); e++)
+		{
+			const Pass& pass = m_Passes[m_ExecutionOrder[e]];
+
+			for (uint32 i = pass.FirstAccess; i < pass.FirstAccess + pass.NumAccesses; i++)
+			{
+				Resource& resource = m_Resources[m_Accesses[i].Resource];
+				resource.FirstPass = std::min(resource.FirstPass, e);
+				resource.LastPass = std::max(resource.LastPass, e);
+			}
+		}
+
+		m_Lifetimes.clear();
+		for (uint32 r = 0; r < (uint32)m_Resources.size(); r++)
+		{
+			const Resource& resource = m_Resources[r];
+			if (resource.Imported || resource.FirstPass == ~0u)
+				continue;
+
+			RGTransientLifetime& lifetime = m_Lifetimes.emplace_back();
+			lifetime.Resource = RGHandle{ r };
+			lifetime.FirstPass = resource.FirstPass;
+			lifetime.LastPass = resource.Output ? (uint32)m_ExecutionOrder.size() : resource.LastPass;
+			lifetime.Size = resource.IsTexture ? GetTextureMemorySize(resource.TexDesc) : resource.BufferSize;
+			lifetime.AliasSlot = ~0u;
+		}
+
+		// greedy interval packing, in order of first use every resource takes the tightest fitting slot
+		// that is free again by then, or grows the largest free one
+		std::sort(m_Lifetimes.begin(), m_Lifetimes.end(), [](const RGTransientLifetime& a, const RGTransientLifetime& b) {
+			return a.FirstPass != b.FirstPass ? a.FirstPass < b.FirstPass : a.Size > b.Size;
+			});
+
+		struct AliasSlot
+		{
+			uint64 Size;
+			uint32 LastPass;
+		};
+		std::vector<AliasSlot> slots{};
+
+		m_Stats.TransientMemory = 0;
+		for (RGTransientLifetime& lifetime : m_Lifetimes)
+		{
+			uint32 bestFit = ~0u;
+			uint32 largestFree = ~0u;
+
+			for (uint32 s = 0; s < (uint32)slots.size(); s++)
+			{
+				const AliasSlot& slot = slots[s];
+				if (slot.LastPass >= lifetime.FirstPass)
+					continue;
+
+				if (slot.Size >= lifetime.Size && (bestFit == ~0u || slot.Size < slots[bestFit].Size))
+					bestFit = s;
+				if (largestFree == ~0u || slot.Size > slots[largestFree].Size)
+					largestFree = s;
+			}
+
+			uint32 slot = bestFit != ~0u ? bestFit : largestFree;
+			if (slot == ~0u)
+			{
+				slot = (uint32)slots.size();
+				slots.push_back(AliasSlot{ 0, 0 });
+			}
+
+			slots[slot].Size = std::max(slots[slot].Size, lifetime.Size);
+			slots[slot].LastPass = lifetime.LastPass;
+			lifetime.AliasSlot = slot;
+
+			m_Stats.TransientMemory += lifetime.Size;
+		}
+
+		m_Stats.AliasedMemory = 0;
+		for (const AliasSlot& slot : slots)
+			m_Stats.AliasedMemory += slot.Size;
+
+		m_Stats.NumTransientResources = (uint32)m_Lifetimes.size();
+	}
+
+	void RenderGraph::Compile()
+	{
+		PROFILE_SCOPED;
+
+		CullPasses();
+		BuildBarriers();
+		ComputeLifetimes();
+
+		m_Stats.NumPasses = (uint32)m_Passes.size();
+		m_Stats.NumCulledPasses = (uint32)(m_Passes.size() - m_ExecutionOrder.size());
+		m_Stats.NumBarriers = (uint32)(m_TextureBarriers.size() + m_BufferBarriers.size());
+
+		m_Compiled = true;
+	}
+
+	void RenderGraph::BindTexture(RGHandle handle, RHITexture* texture)
+	{
+		CHECK(m_Resources[handle.Index].IsTexture);
+		m_Resources[handle.Index].Texture = texture;
+	}
+
+	void RenderGraph::BindBuffer(RGHandle handle, RHIBuffer* buffer)
+	{
+		CHECK(!m_Resources[handle.Index].IsTexture);
+		m_Resources[handle.Index].Buffer = buffer;
+	}
+
+	void RenderGraph::Execute(RHICommandList* cmd)
+	{
+		PROFILE_SCOPED;
+		CHECK(m_Compiled);
+
+		RGPassContext context(*this);
+
+		for (uint32 p : m_ExecutionOrder)
+		{
+			const Pass& pass = m_Passes[p];
+
+			for (const TextureBarrier& barrier : GetTextureBarriers(p))
+			{
+				RHITexture* texture = m_Resources[barrier.Resource].Texture;
+				CHECK(texture);
+
+				cmd->BarrierTexture(texture, &barrier.Region, 1);
+			}
+
+			for (const BufferBarrier& barrier : GetBufferBarriers(p))
+			{
+				RHIBuffer* buffer = m_Resources[barrier.Resource].Buffer;
+				CHECK(buffer);
+
+				cmd->BarrierBuffer(buffer, buffer->GetSize(), 0, barrier.LastAccess, barrier.NewAccess);
+			}
+
+			// the pass records against the states it declared, not ones still batched
+			cmd->FlushBarriers();
+
+			if (pass.Execute)
+				pass.Execute(cmd, context);
+		}
+
+		// barriers were recorded behind the back of the textures, hand them the final state
+		for (Resource& resource : m_Resources)
+		{
+			if (resource.IsTexture && resource.Texture && resource.FirstPass != ~0u)
+				resource.Texture->GetState() = resource.State;
+		}
+	}
+
+	void RenderGraph::Reset()
+	{
+		m_Resources.clear();
+		m_Passes.clear();
+		m_Accesses.clear();
+		m_ExecutionOrder.clear();
+		m_TextureBarriers.clear();
+		m_BufferBarriers.clear();
+		m_Lifetimes.clear();
+
+		m_Stats = {};
+		m_Compiled = false;
+	}
+
+	std::span<const RenderGraph::TextureBarrier> RenderGraph::GetTextureBarriers(uint32 pass) const
+	{
+		const Pass& p = m_Passes[pass];
+		return std::span<const TextureBarrier>(m_TextureBarriers.data() + p.FirstTextureBarrier, p.NumTextureBarriers);
+	}
+
+	std::span<const RenderGraph::BufferBarrier> RenderGraph::GetBufferBarriers(uint32 pass) const
+	{
+		const Pass& p = m_Passes[pass];
+		return std::span<const BufferBarrier>(m_BufferBarriers.data() + p.FirstBufferBarrier, p.NumBufferBarriers);
+	}
+
+	ERHIAccess RenderGraph::GetFinalAccess(RGHandle resource) const
+	{
+		const Resource& r = m_Resources[resource.Index];
+		return r.IsTexture ? r.State.Ranges.front().State : r.Access;
+	}
+}
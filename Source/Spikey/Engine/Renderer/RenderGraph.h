@@ -0,0 +1,202 @@
+#pragma once
+#include <Engine/Graphics/Texture.h>
+#include <Engine/Graphics/Buffer.h>
+
+namespace Spikey {
+
+	class RHICommandList;
+	class RenderGraph;
+
+	struct RGHandle
+	{
+		uint32 Index = ~0u;
+
+		bool IsValid() const { return Index != ~0u; }
+	};
+
+	enum class ERGPassFlags : uint8
+	{
+		None = 0,
+		Raster    = BIT(0),
+		Compute   = BIT(1),
+		Copy      = BIT(2),
+		NeverCull = BIT(3) // has side effects outside the graph (readback, present)
+	};
+	ENUM_FLAGS_OPERATORS(ERGPassFlags);
+
+	// resolves graph handles to the resources bound for this frame while a pass executes
+	class RGPassContext
+	{
+	public:
+		RGPassContext(const RenderGraph& graph) : m_Graph(graph) {}
+
+		RHITexture* GetTexture(RGHandle handle) const;
+		RHIBuffer*  GetBuffer(RGHandle handle) const;
+
+	private:
+		const RenderGraph& m_Graph;
+	};
+
+	using RGExecuteFunc = std::function<void(RHICommandList* cmd, const RGPassContext& context)>;
+
+	// declares the resources a pass touches, only valid until the next AddPass
+	class RGPassBuilder
+	{
+	public:
+		RGPassBuilder(RenderGraph& graph, uint32 pass) : m_Graph(graph), m_Pass(pass) {}
+
+		// the range only applies to textures, writes keep the passes reading them later alive
+		RGPassBuilder& Read(RGHandle resource, ERHIAccess access, const TextureSubresourceSet& range = TextureSubresourceSet::AllTexture());
+		RGPassBuilder& Write(RGHandle resource, ERHIAccess access, const TextureSubresourceSet& range = TextureSubresourceSet::AllTexture());
+
+	private:
+		RenderGraph& m_Graph;
+		uint32       m_Pass;
+	};
+
+	struct RGTransientLifetime
+	{
+		RGHandle Resource;
+		uint32   FirstPass; // in execution order
+		uint32   LastPass;
+		uint64   Size;
+		uint32   AliasSlot; // resources sharing a slot never overlap in time and may share memory
+	};
+
+	struct RGStats
+	{
+		uint32 NumPasses;
+		uint32 NumCulledPasses;
+		uint32 NumBarriers;
+		uint32 NumTransientResources;
+		uint64 TransientMemory; // sum of all transient resources
+		uint64 AliasedMemory;   // sum of the alias slots
+	};
+
+	// frame graph of render passes. passes are recorded in submission order with the resources they read and
+	// write, Compile culls passes nothing depends on, derives the barriers between them and the lifetimes of
+	// transient resources. compiling does not touch the gpu, the graph is meant to be rebuilt every frame
+	class RenderGraph
+	{
+	public:
+		// transient resources live within the frame, imported ones start and end in the state of the resource
+		RGHandle CreateTexture(const std::string& name, const TextureDesc& desc);
+		RGHandle CreateBuffer(const std::string& name, uint64 size, EBufferFlags flags);
+		RGHandle ImportTexture(const std::string& name, RHITexture* texture);
+		RGHandle ImportBuffer(const std::string& name, RHIBuffer* buffer, ERHIAccess currentAccess);
+
+		// keeps the passes producing a transient resource alive, for results read after the graph
+		void MarkOutput(RGHandle resource);
+
+		RGPassBuilder AddPass(const std::string& name, ERGPassFlags flags, RGExecuteFunc&& execute);
+
+		void Compile();
+
+		// transient resources have to be bound before executing, see GetTransientLifetimes
+		void BindTexture(RGHandle handle, RHITexture* texture);
+		void BindBuffer(RGHandle handle, RHIBuffer* buffer);
+		void Execute(RHICommandList* cmd);
+
+		// clears the graph, keeping the allocations for the next frame
+		void Reset();
+
+		const std::vector<uint32>&              GetExecutionOrder() const { return m_ExecutionOrder; }
+		const std::vector<RGTransientLifetime>& GetTransientLifetimes() const { return m_Lifetimes; }
+		const RGStats&                          GetStats() const { return m_Stats; }
+		bool                                    IsPassCulled(uint32 pass) const { return m_Passes[pass].Culled; }
+		const std::string&                      GetPassName(uint32 pass) const { return m_Passes[pass].Name; }
+
+		struct TextureBarrier
+		{
+			uint32               Resource;
+			TextureBarrierRegion Region;
+		};
+
+		struct BufferBarrier
+		{
+			uint32     Resource;
+			ERHIAccess LastAccess;
+			ERHIAccess NewAccess;
+		};
+
+		// barriers recorded before a pass runs
+		std::span<const TextureBarrier> GetTextureBarriers(uint32 pass) const;
+		std::span<const BufferBarrier>  GetBufferBarriers(uint32 pass) const;
+
+		// state the resource ends the frame in, for textures with mixed states the one of the first subresource
+		ERHIAccess GetFinalAccess(RGHandle resource) const;
+
+	private:
+		friend class RGPassBuilder;
+		friend class RGPassContext;
+
+		struct Resource
+		{
+			std::string  Name;
+			bool         IsTexture;
+			bool         Imported;
+			bool         Output;
+			TextureDesc  TexDesc;
+			uint64       BufferSize;
+			EBufferFlags BufferFlags;
+			RHITexture*  Texture;
+			RHIBuffer*   Buffer;
+
+			TextureState State;      // textures, replayed from the initial state on every compile
+			ERHIAccess   Access;     // buffers
+			ERHIAccess   InitialAccess;
+
+			uint32 RefCount;
+			uint32 FirstWriter;
+			uint32 NumWriters;
+			uint32 FirstPass;
+			uint32 LastPass;
+		};
+
+		struct Access
+		{
+			uint32                Resource;
+			ERHIAccess            Access;
+			TextureSubresourceSet Range;
+			bool                  Write;
+		};
+
+		struct Pass
+		{
+			std::string   Name;
+			ERGPassFlags  Flags;
+			RGExecuteFunc Execute;
+			uint32        FirstAccess;
+			uint32        NumAccesses;
+			uint32        RefCount;
+			bool          Culled;
+
+			uint32 FirstTextureBarrier;
+			uint32 NumTextureBarriers;
+			uint32 FirstBufferBarrier;
+			uint32 NumBufferBarriers;
+		};
+
+		RGHandle AddResource(const std::string& name, bool isTexture);
+		void     AddAccess(uint32 pass, RGHandle resource, ERHIAccess access, const TextureSubresourceSet& range, bool write);
+
+		void CullPasses();
+		void BuildBarriers();
+		void ComputeLifetimes();
+
+	private:
+		std::vector<Resource> m_Resources;
+		std::vector<Pass>     m_Passes;
+		std::vector<Access>   m_Accesses;
+
+		std::vector<uint32>               m_Writers; // passes writing each resource, grouped per resource
+		std::vector<uint32>               m_ExecutionOrder;
+		std::vector<TextureBarrier>       m_TextureBarriers;
+		std::vector<BufferBarrier>        m_BufferBarriers;
+		std::vector<TextureBarrierRegion> m_RegionScratch;
+		std::vector<RGTransientLifetime>  m_Lifetimes;
+
+		RGStats m_Stats = {};
+		bool    m_Compiled = false;
+	};
+}
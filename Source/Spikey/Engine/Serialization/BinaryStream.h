@@ -7,13 +7,18 @@ namespace Spikey {
 
 	class BinaryReadStream {
 	public:
-		BinaryReadStream(const std::filesystem::path& path) : m_Stream(path, std::ios::binary) {}
+		BinaryReadStream(const std::filesystem::path& path) : m_Stream(path, std::ios::binary), m_Path(path) {}
 		~BinaryReadStream() { m_Stream.close(); }
 
 		void ReadRaw(void* out, uint64 size) { m_Stream.read((char*)out, size); }
 		bool IsOpen() const { return m_Stream.is_open(); }
 		uint64 Size() { return m_Stream.tellg(); }
 
+		// random access, lets assets read only part of their payload (texture mip streaming)
+		void Seek(uint64 offset) { m_Stream.seekg(offset, std::ios::beg); }
+		uint64 Tell() { return m_Stream.tellg(); }
+		const std::filesystem::path& GetPath() const { return m_Path; }
+
 		template<typename T>
 		friend BinaryReadStream& operator>>(BinaryReadStream& stream, T& t) {
 			stream.ReadRaw((void*)&t, sizeof(T));
@@ -67,6 +72,7 @@ namespace Spikey {
 
 	private:
 		std::ifstream m_Stream;
+		std::filesystem::path m_Path;
 	};
 
 	class BinaryWriteStream {
@@ -0,0 +1,158 @@
+#include <Engine/Threading/JobSystem.h>
+#include <thread>
+#include <condition_variable>
+
+namespace Spikey {
+
+	struct Job
+	{
+		JobSystem::JobDelegate Delegate;
+		JobSystem::Counter*    Counter;
+	};
+
+	struct JobSystemData
+	{
+		std::vector<std::thread> Workers;
+		std::deque<Job>          Queue;
+		std::mutex               Mutex;
+		std::condition_variable  WakeCondition;
+		bool                     ShouldTerminate = false;
+	};
+
+	static JobSystemData* s_Jobs = nullptr;
+
+	static bool TryPopJob(Job& out)
+	{
+		std::lock_guard lock(s_Jobs->Mutex);
+		if (s_Jobs->Queue.empty())
+			return false;
+
+		out = std::move(s_Jobs->Queue.front());
+		s_Jobs->Queue.pop_front();
+		return true;
+	}
+
+	static void RunJob(Job& job)
+	{
+		job.Delegate();
+		job.Counter->Pending.fetch_sub(1, std::memory_order_release);
+	}
+
+	void JobSystem::Init(uint32 numWorkers)
+	{
+		CHECK(!s_Jobs);
+		s_Jobs = new JobSystemData();
+
+		if (numWorkers == 0)
+			numWorkers = std::max(1u, std::thread::hardware_concurrency() - 1);
+
+		for (uint32 i = 0; i < numWorkers; i++)
+		{
+			s_Jobs->Workers.emplace_back([]() {
+				PROFILE_THREAD_NAME("Job Worker");
+
+				while (true)
+				{
+					Job job{};
+					{
+						std::unique_lock lock(s_Jobs->Mutex);
+						s_Jobs->WakeCondition.wait(lock, []() { return s_Jobs->ShouldTerminate || !s_Jobs->Queue.empty(); });
+
+						if (s_Jobs->Queue.empty())
+							break;
+
+						job = std::move(s_Jobs->Queue.front());
+						s_Jobs->Queue.pop_front();
+					}
+
+					RunJob(job);
+				}
+				});
+		}
+	}
+
+	void JobSystem::Shutdown()
+	{
+		if (!s_Jobs)
+			return;
+
+		{
+			std::lock_guard lock(s_Jobs->Mutex);
+			s_Jobs->ShouldTerminate = true;
+		}
+		s_Jobs->WakeCondition.notify_all();
+
+		for (auto& worker : s_Jobs->Workers)
+			worker.join();
+
+		delete s_Jobs;
+		s_Jobs = nullptr;
+	}
+
+	uint32 JobSystem::GetNumWorkers()
+	{
+		return s_Jobs ? (uint32)s_Jobs->Workers.size() : 0;
+	}
+
+	void JobSystem::Execute(Counter& counter, JobDelegate&& job)
+	{
+		counter.Pending.fetch_add(1, std::memory_order_relaxed);
+
+		if (!s_Jobs)
+		{
+			Job inlineJob{ std::move(job), &counter };
+			RunJob(inlineJob);
+			return;
+		}
+
+		{
+			std::lock_guard lock(s_Jobs->Mutex);
+			s_Jobs->Queue.push_back({ std::move(job), &counter });
+		}
+		s_Jobs->WakeCondition.notify_one();
+	}
+
+	void JobSystem::Wait(Counter& counter)
+	{
+		while (counter.Pending.load(std::memory_order_acquire) > 0)
+		{
+			Job job{};
+			if (s_Jobs && TryPopJob(job))
+			{
+				RunJob(job);
+			}
+			else
+			{
+				std::this_thread::yield();
+			}
+		}
+	}
+
+	void JobSystem::ParallelFor(uint32 count, uint32 grainSize, const RangeDelegate& func)
+	{
+		if (count == 0)
+			return;
+
+		grainSize = std::max(grainSize, 1u);
+		uint32 numChunks = std::min((count + grainSize - 1) / grainSize, (GetNumWorkers() + 1) * 4);
+
+		if (numChunks <= 1)
+		{
+			func(0, count);
+			return;
+		}
+
+		uint32 chunkSize = (count + numChunks - 1) / numChunks;
+		Counter counter{};
+
+		// calling thread takes the first chunk itself
+		for (uint32 begin = chunkSize; begin < count; begin += chunkSize)
+		{
+			uint32 end = std::min(begin + chunkSize, count);
+			Execute(counter, [&func, begin, end]() { func(begin, end); });
+		}
+
+		func(0, std::min(chunkSize, count));
+		Wait(counter);
+	}
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <Engine/Core/Common.h>
+
+namespace Spikey {
+
+	// pool of worker threads for cpu heavy engine work (asset processing, builds),
+	// jobs may spawn and wait on other jobs, waiting threads help executing queued work.
+	// when not initialized every job runs inline on the calling thread
+	class JobSystem
+	{
+	public:
+		static void   Init(uint32 numWorkers = 0);
+		static void   Shutdown();
+		static uint32 GetNumWorkers();
+
+		struct Counter
+		{
+			std::atomic<uint32> Pending{ 0 };
+		};
+
+		using JobDelegate = std::function<void()>;
+		using RangeDelegate = std::function<void(uint32 begin, uint32 end)>;
+
+		static void Execute(Counter& counter, JobDelegate&& job);
+		static void Wait(Counter& counter);
+
+		// splits [0, count) into chunks of at least grainSize elements, blocks until all are done
+		static void ParallelFor(uint32 count, uint32 grainSize, const RangeDelegate& func);
+	};
+}
@@ -0,0 +1,158 @@
+#pragma once
+#include <Engine/Core/Common.h>
+
+namespace Spikey {
+
+	// insert only hash map for caches read far more often than written. lookups never lock: entries live in
+	// stable storage and are published to an open addressing table with release stores. inserts take a lock,
+	// a full table is copied to one twice the size and swapped in. readers may still walk the old table, so
+	// old tables are kept until the cache is cleared, at most as much memory as the current one
+	template<typename K, typename V, typename H = std::hash<K>, typename E = std::equal_to<K>>
+	class ConcurrentCache
+	{
+	public:
+		ConcurrentCache()
+		{
+			m_Table.store(AllocateTable(16), std::memory_order_relaxed);
+		}
+
+		ConcurrentCache(const ConcurrentCache&) = delete;
+		ConcurrentCache& operator=(const ConcurrentCache&) = delete;
+
+		// nullptr when absent. the value stays valid until Clear
+		const V* Find(const K& key) const
+		{
+			return Find(key, H{}(key));
+		}
+
+		// create runs under the insertion lock, at most once per key
+		template<typename F>
+		const V& FindOrAdd(const K& key, F&& create)
+		{
+			uint64 hash = H{}(key);
+			if (const V* value = Find(key, hash))
+				return *value;
+
+			std::lock_guard lock(m_InsertLock);
+
+			// inserted by another thread while this one waited
+			if (const V* value = Find(key, hash))
+				return *value;
+
+			Node& node = m_Nodes.emplace_back(Node{ key, create(), hash });
+
+			Table* table = m_Table.load(std::memory_order_relaxed);
+			if ((m_Nodes.size()) * 2 > (uint64)table->Mask + 1)
+			{
+				table = Grow(table);
+			}
+
+			Insert(*table, &node);
+			return node.Value;
+		}
+
+		// not safe against concurrent inserts
+		template<typename F>
+		void ForEach(F&& func) const
+		{
+			for (const Node& node : m_Nodes)
+			{
+				func(node.Key, node.Value);
+			}
+		}
+
+		uint32 Size() const
+		{
+			std::lock_guard lock(m_InsertLock);
+			return (uint32)m_Nodes.size();
+		}
+
+		// no lookups may run concurrently
+		void Clear()
+		{
+			std::lock_guard lock(m_InsertLock);
+
+			m_Tables.clear();
+			m_Nodes.clear();
+			m_Table.store(AllocateTable(16), std::memory_order_release);
+		}
+
+	private:
+		struct Node
+		{
+			K      Key;
+			V      Value;
+			uint64 Hash;
+		};
+
+		struct Table
+		{
+			uint32                                   Mask;
+			std::unique_ptr<std::atomic<const Node*>[]> Slots;
+		};
+
+		const V* Find(const K& key, uint64 hash) const
+		{
+			const Table* table = m_Table.load(std::memory_order_acquire);
+
+			for (uint32 i = (uint32)hash & table->Mask;; i = (i + 1) & table->Mask)
+			{
+				const Node* node = table->Slots[i].load(std::memory_order_acquire);
+				if (!node)
+					return nullptr;
+
+				if (node->Hash == hash && E{}(node->Key, key))
+					return &node->Value;
+			}
+		}
+
+		Table* AllocateTable(uint32 size)
+		{
+			auto table = std::make_unique<Table>();
+			table->Mask = size - 1;
+			table->Slots = std::make_unique<std::atomic<const Node*>[]>(size);
+
+			for (uint32 i = 0; i < size; i++)
+			{
+				table->Slots[i].store(nullptr, std::memory_order_relaxed);
+			}
+
+			m_Tables.push_back(std::move(table));
+			return m_Tables.back().get();
+		}
+
+		static void Insert(Table& table, const Node* node)
+		{
+			uint32 i = (uint32)node->Hash & table.Mask;
+			while (table.Slots[i].load(std::memory_order_relaxed))
+			{
+				i = (i + 1) & table.Mask;
+			}
+
+			table.Slots[i].store(node, std::memory_order_release);
+		}
+
+		Table* Grow(Table* table)
+		{
+			Table* grown = AllocateTable((table->Mask + 1) * 2);
+
+			for (uint32 i = 0; i <= table->Mask; i++)
+			{
+				if (const Node* node = table->Slots[i].load(std::memory_order_relaxed))
+					Insert(*grown, node);
+			}
+
+			// the filled table is seen whole by readers picking it up
+			m_Table.store(grown, std::memory_order_release);
+			return grown;
+		}
+
+	private:
+		std::atomic<Table*> m_Table;
+
+		// guarded by m_InsertLock. deque, so nodes never move
+		mutable std::mutex                  m_InsertLock;
+		std::deque<Node>                    m_Nodes;
+		std::vector<std::unique_ptr<Table>> m_Tables;
+	};
+}
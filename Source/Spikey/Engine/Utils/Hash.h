@@ -0,0 +1,21 @@
+#pragma once
+#include <Engine/Core/Common.h>
+
+namespace Spikey {
+
+	constexpr uint64 FNV_OFFSET_BASIS = 14695981039346656037ull;
+
+	// fnv-1a, for hashes written to disk. the std hashes are not guaranteed to match between runs of different
+	// builds. pass the previous result as hash to continue it over more data
+	inline uint64 HashBytes(const void* data, uint64 size, uint64 hash = FNV_OFFSET_BASIS)
+	{
+		const uint8* bytes = (const uint8*)data;
+		for (uint64 i = 0; i < size; i++)
+		{
+			hash ^= bytes[i];
+			hash *= 1099511628211ull;
+		}
+
+		return hash;
+	}
+}
@@ -0,0 +1,121 @@
+#include <Engine/Utils/RangeAllocator.h>
+
+namespace Spikey {
+
+	RangeAllocator::RangeAllocator(uint64 capacity)
+	{
+		Reset(capacity);
+	}
+
+	void RangeAllocator::Reset(uint64 capacity)
+	{
+		m_Capacity = capacity;
+		m_UsedSize = 0;
+
+		m_FreeByOffset.clear();
+		m_FreeBySize.clear();
+		m_Allocations.clear();
+
+		if (capacity > 0)
+			InsertFreeBlock(0, capacity);
+	}
+
+	uint64 RangeAllocator::Allocate(uint64 size, uint64 alignment)
+	{
+		if (size == 0)
+			return INVALID_OFFSET;
+
+		alignment = std::max(alignment, 1ull);
+
+		// smallest block that still fits the aligned request
+		for (auto it = m_FreeBySize.lower_bound(size); it != m_FreeBySize.end(); it++)
+		{
+			uint64 blockSize = it->first;
+			uint64 blockOffset = it->second;
+			uint64 alignedOffset = (blockOffset + alignment - 1) / alignment * alignment;
+			uint64 padding = alignedOffset - blockOffset;
+
+			if (blockSize < size + padding)
+				continue;
+
+			RemoveFreeBlock(m_FreeByOffset.find(blockOffset));
+
+			if (padding > 0)
+				InsertFreeBlock(blockOffset, padding);
+
+			uint64 remainder = blockSize - padding - size;
+			if (remainder > 0)
+				InsertFreeBlock(alignedOffset + size, remainder);
+
+			m_Allocations[alignedOffset] = size;
+			m_UsedSize += size;
+
+			return alignedOffset;
+		}
+
+		return INVALID_OFFSET;
+	}
+
+	void RangeAllocator::Free(uint64 offset)
+	{
+		auto alloc = m_Allocations.find(offset);
+		if (alloc == m_Allocations.end())
+		{
+			ENGINE_ERROR("RangeAllocator: trying to free unknown offset {}", offset);
+			return;
+		}
+
+		uint64 size = alloc->second;
+		m_Allocations.erase(alloc);
+		m_UsedSize -= size;
+
+		// coalesce with the following block
+		auto next = m_FreeByOffset.find(offset + size);
+		if (next != m_FreeByOffset.end())
+		{
+			size += next->second;
+			RemoveFreeBlock(next);
+		}
+
+		// coalesce with the preceding block
+		auto prev = m_FreeByOffset.lower_bound(offset);
+		if (prev != m_FreeByOffset.begin())
+		{
+			prev--;
+			if (prev->first + prev->second == offset)
+			{
+				offset = prev->first;
+				size += prev->second;
+				RemoveFreeBlock(prev);
+			}
+		}
+
+		InsertFreeBlock(offset, size);
+	}
+
+	uint64 RangeAllocator::GetLargestFreeBlock() const
+	{
+		return m_FreeBySize.empty() ? 0 : m_FreeBySize.rbegin()->first;
+	}
+
+	void RangeAllocator::InsertFreeBlock(uint64 offset, uint64 size)
+	{
+		m_FreeByOffset[offset] = size;
+		m_FreeBySize.insert({ size, offset });
+	}
+
+	void RangeAllocator::RemoveFreeBlock(OffsetMap::iterator it)
+	{
+		auto [begin, end] = m_FreeBySize.equal_range(it->second);
+		for (auto sizeIt = begin; sizeIt != end; sizeIt++)
+		{
+			if (sizeIt->second == it->first)
+			{
+				m_FreeBySize.erase(sizeIt);
+				break;
+			}
+		}
+
+		m_FreeByOffset.erase(it);
+	}
+}
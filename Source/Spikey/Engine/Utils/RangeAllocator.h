@@ -0,0 +1,40 @@
+#pragma once
+#include <Engine/Core/Common.h>
+
+namespace Spikey {
+
+	// best-fit free list allocator over an abstract [0, capacity) range,
+	// does not own any memory, adjacent free blocks are coalesced on release
+	class RangeAllocator
+	{
+	public:
+		static constexpr uint64 INVALID_OFFSET = ~0ull;
+
+		RangeAllocator() = default;
+		RangeAllocator(uint64 capacity);
+
+		void   Reset(uint64 capacity);
+		uint64 Allocate(uint64 size, uint64 alignment = 1);
+		void   Free(uint64 offset);
+
+		uint64 GetCapacity() const { return m_Capacity; }
+		uint64 GetUsedSize() const { return m_UsedSize; }
+		uint32 GetNumFreeBlocks() const { return (uint32)m_FreeByOffset.size(); }
+		uint64 GetLargestFreeBlock() const;
+
+	private:
+		using OffsetMap = std::map<uint64, uint64>;
+		using SizeMap = std::multimap<uint64, uint64>;
+
+		void InsertFreeBlock(uint64 offset, uint64 size);
+		void RemoveFreeBlock(OffsetMap::iterator it);
+
+	private:
+		uint64 m_Capacity = 0;
+		uint64 m_UsedSize = 0;
+
+		OffsetMap                          m_FreeByOffset; // offset -> size
+		SizeMap                            m_FreeBySize;   // size -> offset
+		std::unordered_map<uint64, uint64> m_Allocations;  // offset -> size
+	};
+}
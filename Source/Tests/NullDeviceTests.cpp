@@ -0,0 +1,105 @@
+#include <TestFramework.h>
+#include <Backend/Null/NullBackend.h>
+
+using namespace Spikey;
+
+static TextureDesc MakeTextureDesc()
+{
+	TextureDesc desc{};
+	desc.Width = 64;
+	desc.Height = 64;
+	desc.MipLevels = 2;
+	desc.Format = ETextureFormat::RGBA8U;
+	desc.Flags = ETextureFlags::Sampled | ETextureFlags::CopySrc | ETextureFlags::CopyDst;
+
+	return desc;
+}
+
+// copies mip 0 of src into dst, with the barriers the engine tracks
+static void RecordCopy(RHICommandList* cmd, RHITexture* src, RHITexture* dst)
+{
+	TextureSubresourceSet mip0{ 0, 1, 0, 1 };
+	src->Barrier(cmd, mip0, ERHIAccess::CopySrc);
+	dst->Barrier(cmd, mip0, ERHIAccess::CopyDst);
+
+	TextureSlice slice{};
+	cmd->CopyTexture(src, slice, dst, slice);
+
+	dst->Barrier(cmd, mip0, ERHIAccess::SRV);
+}
+
+TEST_CASE(NullDevice, ValidListCountsItsCommands)
+{
+	NullDevice device(true);
+	device.SetCaptureEnabled(true);
+
+	TextureRHIRef src = device.CreateTexture(MakeTextureDesc());
+	TextureRHIRef dst = device.CreateTexture(MakeTextureDesc());
+
+	RHICommandList* cmd = device.BeginCommandList();
+	RecordCopy(cmd, src, dst);
+	device.SubmitCommandList(cmd);
+
+	NullDeviceStats stats = device.GetStats();
+	EXPECT_EQ(stats.ValidationErrors, 0u);
+	EXPECT_EQ(stats.CommandListsSubmitted, 1u);
+	EXPECT_EQ(stats.TexturesCreated, 2u);
+	EXPECT_EQ(stats.LiveTextures, 2u);
+	EXPECT_EQ(stats.Commands[(size_t)ENullCommand::CopyTexture], 1u);
+	EXPECT_EQ(stats.Commands[(size_t)ENullCommand::BarrierTexture], 3u);
+
+	// the copy flushes the two barriers before it, the submit the one after
+	EXPECT_EQ(stats.Commands[(size_t)ENullCommand::FlushBarriers], 2u);
+	EXPECT_EQ(stats.BarrierBatches, 2u);
+
+	// the capture is exactly the submitted stream
+	std::vector<uint8> capture = device.TakeCapture();
+	EXPECT_EQ(capture.size(), stats.StreamBytes);
+	REQUIRE(!capture.empty());
+	EXPECT_EQ(capture[0], (uint8)ENullCommand::BarrierTexture);
+}
+
+TEST_CASE(NullDevice, CopyWithoutBarrierIsReported)
+{
+	NullDevice device(true);
+
+	TextureRHIRef src = device.CreateTexture(MakeTextureDesc());
+	TextureRHIRef dst = device.CreateTexture(MakeTextureDesc());
+
+	RHICommandList* cmd = device.BeginCommandList();
+
+	TextureSlice slice{};
+	cmd->CopyTexture(src, slice, dst, slice);
+	device.SubmitCommandList(cmd);
+
+	// source and destination are both still in None
+	EXPECT_EQ(device.GetStats().ValidationErrors, 2u);
+}
+
+TEST_CASE(NullDevice, ScriptedListsCaptureTheSameStream)
+{
+	std::vector<uint8> captures[2];
+
+	for (std::vector<uint8>& capture : captures)
+	{
+		NullDevice device(true);
+		device.SetCaptureEnabled(true);
+
+		TextureRHIRef src = device.CreateTexture(MakeTextureDesc());
+		TextureRHIRef dst = device.CreateTexture(MakeTextureDesc());
+
+		for (uint32 i = 0; i < 3; i++)
+		{
+			RHICommandList* cmd = device.BeginCommandList();
+			RecordCopy(cmd, i % 2 ? dst : src, i % 2 ? src : dst);
+			device.SubmitCommandList(cmd);
+		}
+
+		EXPECT_EQ(device.GetStats().ValidationErrors, 0u);
+		capture = device.TakeCapture();
+	}
+
+	// resources are written as ids, so nothing in the stream depends on the run
+	EXPECT(!captures[0].empty());
+	EXPECT(captures[0] == captures[1]);
+}
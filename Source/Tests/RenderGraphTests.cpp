@@ -0,0 +1,377 @@
+#include <TestFramework.h>
+#include <Engine/Renderer/RenderGraph.h>
+
+using namespace Spikey;
+
+// stands in for a buffer owned outside the graph, compiling never touches the gpu
+class TestBuffer : public RHIBuffer
+{
+public:
+	TestBuffer(uint64 size)
+		: RHIBuffer(size, EBufferFlags::Storage)
+	{
+	}
+
+	virtual void*  GetMappedData() const override { return nullptr; }
+	virtual uint64 GetGPUAddress() const override { return 0; }
+};
+
+static TextureDesc MakeTextureDesc(uint32 numMips = 1)
+{
+	TextureDesc desc{};
+	desc.Width = 64;
+	desc.Height = 64;
+	desc.MipLevels = numMips;
+	desc.Format = ETextureFormat::RGBA8U;
+
+	return desc;
+}
+
+static bool IsExecuted(const RenderGraph& graph, uint32 pass)
+{
+	const std::vector<uint32>& order = graph.GetExecutionOrder();
+	return std::find(order.begin(), order.end(), pass) != order.end();
+}
+
+static const RGTransientLifetime* FindLifetime(const RenderGraph& graph, RGHandle resource)
+{
+	for (const RGTransientLifetime& lifetime : graph.GetTransientLifetimes())
+	{
+		if (lifetime.Resource.Index == resource.Index)
+			return &lifetime;
+	}
+
+	return nullptr;
+}
+
+// resources sharing an alias slot must never be alive in the same pass
+static bool AliasSlotsAreDisjoint(const RenderGraph& graph)
+{
+	const std::vector<RGTransientLifetime>& lifetimes = graph.GetTransientLifetimes();
+
+	for (uint32 i = 0; i < (uint32)lifetimes.size(); i++)
+	{
+		for (uint32 j = i + 1; j < (uint32)lifetimes.size(); j++)
+		{
+			const RGTransientLifetime& a = lifetimes[i];
+			const RGTransientLifetime& b = lifetimes[j];
+
+			if (a.AliasSlot == b.AliasSlot && a.FirstPass <= b.LastPass && b.FirstPass <= a.LastPass)
+				return false;
+		}
+	}
+
+	return true;
+}
+
+TEST_CASE(RenderGraph, CullsPassesNobodyReads)
+{
+	RenderGraph graph{};
+	RGHandle color = graph.CreateTexture("Color", MakeTextureDesc());
+	RGHandle unused = graph.CreateTexture("Unused", MakeTextureDesc());
+	RGHandle result = graph.CreateTexture("Result", MakeTextureDesc());
+	graph.MarkOutput(result);
+
+	graph.AddPass("Producer", ERGPassFlags::Raster, {}).Write(color, ERHIAccess::ColorTarget);
+	graph.AddPass("Unused", ERGPassFlags::Raster, {}).Write(unused, ERHIAccess::ColorTarget);
+	graph.AddPass("Consumer", ERGPassFlags::Compute, {}).Read(color, ERHIAccess::SRVCompute).Write(result, ERHIAccess::UAVCompute);
+	graph.Compile();
+
+	EXPECT(!graph.IsPassCulled(0));
+	EXPECT(graph.IsPassCulled(1));
+	EXPECT(!graph.IsPassCulled(2));
+	EXPECT(graph.GetExecutionOrder() == (std::vector<uint32>{ 0, 2 }));
+	EXPECT_EQ(graph.GetStats().NumPasses, 3u);
+	EXPECT_EQ(graph.GetStats().NumCulledPasses, 1u);
+}
+
+TEST_CASE(RenderGraph, CullingWalksBackThroughProducers)
+{
+	RenderGraph graph{};
+	RGHandle a = graph.CreateTexture("A", MakeTextureDesc());
+	RGHandle b = graph.CreateTexture("B", MakeTextureDesc());
+
+	// b is never read, so the pass writing it goes and a loses its only reader
+	graph.AddPass("WriteA", ERGPassFlags::Raster, {}).Write(a, ERHIAccess::ColorTarget);
+	graph.AddPass("AToB", ERGPassFlags::Compute, {}).Read(a, ERHIAccess::SRVCompute).Write(b, ERHIAccess::UAVCompute);
+	graph.Compile();
+
+	EXPECT(graph.IsPassCulled(0));
+	EXPECT(graph.IsPassCulled(1));
+	EXPECT(graph.GetExecutionOrder().empty());
+	EXPECT(graph.GetTransientLifetimes().empty());
+}
+
+TEST_CASE(RenderGraph, NeverCullKeepsThePassAndItsInputs)
+{
+	RenderGraph graph{};
+	RGHandle a = graph.CreateTexture("A", MakeTextureDesc());
+
+	graph.AddPass("WriteA", ERGPassFlags::Raster, {}).Write(a, ERHIAccess::ColorTarget);
+	graph.AddPass("Readback", ERGPassFlags::Copy | ERGPassFlags::NeverCull, {}).Read(a, ERHIAccess::CopySrc);
+	graph.Compile();
+
+	EXPECT(IsExecuted(graph, 0));
+	EXPECT(IsExecuted(graph, 1));
+	EXPECT_EQ(graph.GetStats().NumCulledPasses, 0u);
+}
+
+TEST_CASE(RenderGraph, WritesToImportedResourcesAreKept)
+{
+	TestBuffer buffer(256);
+
+	RenderGraph graph{};
+	RGHandle imported = graph.ImportBuffer("Imported", &buffer, ERHIAccess::None);
+	graph.AddPass("Fill", ERGPassFlags::Compute, {}).Write(imported, ERHIAccess::UAVCompute);
+	graph.Compile();
+
+	EXPECT(IsExecuted(graph, 0));
+
+	// imported resources outlive the frame, they are not aliased
+	EXPECT(FindLifetime(graph, imported) == nullptr);
+}
+
+TEST_CASE(RenderGraph, TextureBarriersFollowTheAccesses)
+{
+	RenderGraph graph{};
+	RGHandle color = graph.CreateTexture("Color", MakeTextureDesc());
+	RGHandle result = graph.CreateTexture("Result", MakeTextureDesc());
+	graph.MarkOutput(result);
+
+	graph.AddPass("Draw", ERGPassFlags::Raster, {}).Write(color, ERHIAccess::ColorTarget);
+	graph.AddPass("Post", ERGPassFlags::Raster, {}).Read(color, ERHIAccess::SRVGraphics).Write(result, ERHIAccess::ColorTarget);
+	graph.Compile();
+
+	std::span<const RenderGraph::TextureBarrier> draw = graph.GetTextureBarriers(0);
+	REQUIRE(draw.size() == 1);
+	EXPECT_EQ(draw[0].Resource, color.Index);
+	EXPECT_EQ(draw[0].Region.LastAccess, ERHIAccess::None);
+	EXPECT_EQ(draw[0].Region.NewAccess, ERHIAccess::ColorTarget);
+	EXPECT(draw[0].Region.EntireTexture);
+
+	std::span<const RenderGraph::TextureBarrier> post = graph.GetTextureBarriers(1);
+	REQUIRE(post.size() == 2);
+	EXPECT_EQ(post[0].Resource, color.Index);
+	EXPECT_EQ(post[0].Region.LastAccess, ERHIAccess::ColorTarget);
+	EXPECT_EQ(post[0].Region.NewAccess, ERHIAccess::SRVGraphics);
+	EXPECT_EQ(post[1].Resource, result.Index);
+
+	EXPECT_EQ(graph.GetFinalAccess(color), ERHIAccess::SRVGraphics);
+	EXPECT_EQ(graph.GetStats().NumBarriers, 3u);
+}
+
+TEST_CASE(RenderGraph, ReadsOfOnePassCombine)
+{
+	RenderGraph graph{};
+	RGHandle color = graph.CreateTexture("Color", MakeTextureDesc());
+	RGHandle result = graph.CreateTexture("Result", MakeTextureDesc());
+	RGHandle blurred = graph.CreateTexture("Blurred", MakeTextureDesc());
+	graph.MarkOutput(blurred);
+
+	graph.AddPass("Draw", ERGPassFlags::Raster, {}).Write(color, ERHIAccess::ColorTarget);
+	graph.AddPass("Resolve", ERGPassFlags::Copy, {})
+		.Read(color, ERHIAccess::SRVCompute)
+		.Read(color, ERHIAccess::CopySrc)
+		.Write(result, ERHIAccess::CopyDst);
+	graph.AddPass("Blur", ERGPassFlags::Compute, {})
+		.Read(result, ERHIAccess::SRVCompute)
+		.Read(result, ERHIAccess::SRVGraphics)
+		.Write(blurred, ERHIAccess::UAVCompute);
+	graph.Compile();
+
+	// one transition to the combined read state, not two conflicting ones. shader reads and copies need
+	// different layouts, so together they end up in General
+	uint32 numColorBarriers = 0;
+	for (const RenderGraph::TextureBarrier& barrier : graph.GetTextureBarriers(1))
+	{
+		if (barrier.Resource != color.Index)
+			continue;
+
+		numColorBarriers++;
+		EXPECT_EQ(barrier.Region.NewAccess, ERHIAccess::SRVCompute | ERHIAccess::CopySrc | ERHIAccess::General);
+	}
+
+	EXPECT_EQ(numColorBarriers, 1u);
+
+	// shader reads of both kinds share their layout
+	uint32 numResultBarriers = 0;
+	for (const RenderGraph::TextureBarrier& barrier : graph.GetTextureBarriers(2))
+	{
+		if (barrier.Resource != result.Index)
+			continue;
+
+		numResultBarriers++;
+		EXPECT_EQ(barrier.Region.NewAccess, ERHIAccess::SRV);
+	}
+
+	EXPECT_EQ(numResultBarriers, 1u);
+}
+
+TEST_CASE(RenderGraph, SubresourceWritesAreTransitionedTogether)
+{
+	RenderGraph graph{};
+	RGHandle chain = graph.CreateTexture("Chain", MakeTextureDesc(2));
+	RGHandle result = graph.CreateTexture("Result", MakeTextureDesc());
+	graph.MarkOutput(result);
+
+	graph.AddPass("Mip0", ERGPassFlags::Copy, {}).Write(chain, ERHIAccess::CopyDst, TextureSubresourceSet{ 0, 1, 0, 1 });
+	graph.AddPass("Mip1", ERGPassFlags::Compute, {}).Write(chain, ERHIAccess::UAVCompute, TextureSubresourceSet{ 1, 1, 0, 1 });
+	graph.AddPass("Sample", ERGPassFlags::Raster, {}).Read(chain, ERHIAccess::SRVGraphics).Write(result, ERHIAccess::ColorTarget);
+	graph.Compile();
+
+	// the two mips arrive in different states, each keeps its own previous state
+	uint32 numChainBarriers = 0;
+	for (const RenderGraph::TextureBarrier& barrier : graph.GetTextureBarriers(2))
+	{
+		if (barrier.Resource != chain.Index)
+			continue;
+
+		numChainBarriers++;
+		EXPECT_EQ(barrier.Region.NewAccess, ERHIAccess::SRVGraphics);
+		EXPECT_EQ(barrier.Region.Range.NumMips, 1u);
+		EXPECT_EQ(barrier.Region.LastAccess, barrier.Region.Range.BaseMip == 0 ? ERHIAccess::CopyDst : ERHIAccess::UAVCompute);
+	}
+
+	EXPECT_EQ(numChainBarriers, 2u);
+	EXPECT_EQ(graph.GetFinalAccess(chain), ERHIAccess::SRVGraphics);
+}
+
+TEST_CASE(RenderGraph, BufferBarriersSkipReadAfterRead)
+{
+	TestBuffer imported(1024);
+
+	RenderGraph graph{};
+	RGHandle buffer = graph.ImportBuffer("Particles", &imported, ERHIAccess::SRVCompute);
+	RGHandle a = graph.CreateBuffer("A", 64, EBufferFlags::Storage);
+	RGHandle b = graph.CreateBuffer("B", 64, EBufferFlags::Storage);
+	graph.MarkOutput(a);
+	graph.MarkOutput(b);
+
+	graph.AddPass("Simulate", ERGPassFlags::Compute, {}).Write(buffer, ERHIAccess::UAVCompute);
+	graph.AddPass("ReadA", ERGPassFlags::Compute, {}).Read(buffer, ERHIAccess::SRVCompute).Write(a, ERHIAccess::UAVCompute);
+	graph.AddPass("ReadB", ERGPassFlags::Compute, {}).Read(buffer, ERHIAccess::SRVCompute).Write(b, ERHIAccess::UAVCompute);
+	graph.Compile();
+
+	auto findBarrier = [&](uint32 pass) -> const RenderGraph::BufferBarrier* {
+		for (const RenderGraph::BufferBarrier& barrier : graph.GetBufferBarriers(pass))
+		{
+			if (barrier.Resource == buffer.Index)
+				return &barrier;
+		}
+		return nullptr;
+		};
+
+	// the import starts in the state it was handed over in
+	const RenderGraph::BufferBarrier* simulate = findBarrier(0);
+	REQUIRE(simulate);
+	EXPECT_EQ(simulate->LastAccess, ERHIAccess::SRVCompute);
+	EXPECT_EQ(simulate->NewAccess, ERHIAccess::UAVCompute);
+
+	const RenderGraph::BufferBarrier* readA = findBarrier(1);
+	REQUIRE(readA);
+	EXPECT_EQ(readA->LastAccess, ERHIAccess::UAVCompute);
+
+	EXPECT(findBarrier(2) == nullptr);
+	EXPECT_EQ(graph.GetFinalAccess(buffer), ERHIAccess::SRVCompute);
+}
+
+TEST_CASE(RenderGraph, CulledPassesDoNotAffectBarriers)
+{
+	RenderGraph graph{};
+	RGHandle color = graph.CreateTexture("Color", MakeTextureDesc());
+	RGHandle unused = graph.CreateTexture("Unused", MakeTextureDesc());
+	RGHandle result = graph.CreateTexture("Result", MakeTextureDesc());
+	graph.MarkOutput(result);
+
+	graph.AddPass("Draw", ERGPassFlags::Raster, {}).Write(color, ERHIAccess::ColorTarget);
+	// copies color somewhere nobody looks, culled with its barriers
+	graph.AddPass("Debug", ERGPassFlags::Copy, {}).Read(color, ERHIAccess::CopySrc).Write(unused, ERHIAccess::CopyDst);
+	graph.AddPass("Post", ERGPassFlags::Raster, {}).Read(color, ERHIAccess::SRVGraphics).Write(result, ERHIAccess::ColorTarget);
+	graph.Compile();
+
+	EXPECT(graph.IsPassCulled(1));
+	EXPECT(graph.GetTextureBarriers(1).empty());
+
+	std::span<const RenderGraph::TextureBarrier> post = graph.GetTextureBarriers(2);
+	REQUIRE(!post.empty());
+	EXPECT_EQ(post[0].Resource, color.Index);
+	EXPECT_EQ(post[0].Region.LastAccess, ERHIAccess::ColorTarget);
+}
+
+TEST_CASE(RenderGraph, DisjointLifetimesShareAnAliasSlot)
+{
+	RenderGraph graph{};
+	RGHandle a = graph.CreateBuffer("A", 1024, EBufferFlags::Storage);
+	RGHandle b = graph.CreateBuffer("B", 1024, EBufferFlags::Storage);
+	RGHandle c = graph.CreateBuffer("C", 512, EBufferFlags::Storage);
+	graph.MarkOutput(c);
+
+	graph.AddPass("WriteA", ERGPassFlags::Compute, {}).Write(a, ERHIAccess::UAVCompute);
+	graph.AddPass("AToB", ERGPassFlags::Compute, {}).Read(a, ERHIAccess::SRVCompute).Write(b, ERHIAccess::UAVCompute);
+	graph.AddPass("BToC", ERGPassFlags::Compute, {}).Read(b, ERHIAccess::SRVCompute).Write(c, ERHIAccess::UAVCompute);
+	graph.Compile();
+
+	const RGTransientLifetime* lifetimeA = FindLifetime(graph, a);
+	const RGTransientLifetime* lifetimeB = FindLifetime(graph, b);
+	const RGTransientLifetime* lifetimeC = FindLifetime(graph, c);
+	REQUIRE(lifetimeA && lifetimeB && lifetimeC);
+
+	EXPECT_EQ(lifetimeA->FirstPass, 0u);
+	EXPECT_EQ(lifetimeA->LastPass, 1u);
+	EXPECT_EQ(lifetimeB->FirstPass, 1u);
+	EXPECT_EQ(lifetimeB->LastPass, 2u);
+
+	// outputs stay alive past the last pass
+	EXPECT_EQ(lifetimeC->LastPass, 3u);
+
+	// a is dead by the time c is written, b overlaps both
+	EXPECT_EQ(lifetimeA->AliasSlot, lifetimeC->AliasSlot);
+	EXPECT(lifetimeA->AliasSlot != lifetimeB->AliasSlot);
+	EXPECT(AliasSlotsAreDisjoint(graph));
+
+	EXPECT_EQ(graph.GetStats().NumTransientResources, 3u);
+	EXPECT_EQ(graph.GetStats().TransientMemory, 2560ull);
+	EXPECT_EQ(graph.GetStats().AliasedMemory, 2048ull);
+}
+
+TEST_CASE(RenderGraph, ConcurrentResourcesNeverAlias)
+{
+	RenderGraph graph{};
+	std::vector<RGHandle> inputs{};
+	RGHandle result = graph.CreateBuffer("Result", 64, EBufferFlags::Storage);
+	graph.MarkOutput(result);
+
+	// every input is written early and read by the last pass, so all of them are alive at once
+	for (uint32 i = 0; i < 6; i++)
+	{
+		RGHandle input = graph.CreateBuffer("Input", 256 * (i + 1), EBufferFlags::Storage);
+		graph.AddPass("Write", ERGPassFlags::Compute, {}).Write(input, ERHIAccess::UAVCompute);
+		inputs.push_back(input);
+	}
+
+	RGPassBuilder gather = graph.AddPass("Gather", ERGPassFlags::Compute, {});
+	for (RGHandle input : inputs)
+		gather.Read(input, ERHIAccess::SRVCompute);
+	gather.Write(result, ERHIAccess::UAVCompute);
+
+	graph.Compile();
+
+	EXPECT(AliasSlotsAreDisjoint(graph));
+	EXPECT_EQ(graph.GetStats().AliasedMemory, graph.GetStats().TransientMemory);
+}
+
+TEST_CASE(RenderGraph, ResetClearsTheGraph)
+{
+	RenderGraph graph{};
+	RGHandle a = graph.CreateBuffer("A", 64, EBufferFlags::Storage);
+	graph.MarkOutput(a);
+	graph.AddPass("WriteA", ERGPassFlags::Compute, {}).Write(a, ERHIAccess::UAVCompute);
+	graph.Compile();
+
+	graph.Reset();
+	graph.Compile();
+
+	EXPECT(graph.GetExecutionOrder().empty());
+	EXPECT(graph.GetTransientLifetimes().empty());
+	EXPECT_EQ(graph.GetStats().NumPasses, 0u);
+}
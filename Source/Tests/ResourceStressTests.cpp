@@ -0,0 +1,113 @@
+#ifdef BUILD_VULKAN_RHI
+
+#include <TestFramework.h>
+#include <Backend/Vulkan/VulkanBackend.h>
+#include <thread>
+
+using namespace Spikey;
+
+constexpr uint32 STRESS_THREADS = 8;
+constexpr uint32 STRESS_ITERATIONS = 512;
+
+// resources a thread keeps alive at once, so releases interleave with creates of other threads
+constexpr uint32 STRESS_LIVE_RESOURCES = 4;
+
+// the device aborts without a usable gpu, machines without a driver skip the suite instead
+static bool HasVulkanDevice()
+{
+	VkApplicationInfo appInfo{ .sType = VK_STRUCTURE_TYPE_APPLICATION_INFO };
+	appInfo.apiVersion = VK_API_VERSION_1_3;
+
+	VkInstanceCreateInfo instanceInfo{ .sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO };
+	instanceInfo.pApplicationInfo = &appInfo;
+
+	VkInstance instance = VK_NULL_HANDLE;
+	if (vkCreateInstance(&instanceInfo, nullptr, &instance) != VK_SUCCESS)
+		return false;
+
+	uint32 count = 0;
+	vkEnumeratePhysicalDevices(instance, &count, nullptr);
+
+	std::vector<VkPhysicalDevice> devices(count);
+	vkEnumeratePhysicalDevices(instance, &count, devices.data());
+
+	bool found = false;
+	for (VkPhysicalDevice device : devices)
+	{
+		VkPhysicalDeviceProperties props;
+		vkGetPhysicalDeviceProperties(device, &props);
+
+		found |= props.apiVersion >= VK_API_VERSION_1_3;
+	}
+
+	vkDestroyInstance(instance, nullptr);
+	return found;
+}
+
+static void CreateAndRelease(VulkanDevice& device, uint32 thread)
+{
+	TextureRHIRef textures[STRESS_LIVE_RESOURCES];
+	BufferRHIRef  buffers[STRESS_LIVE_RESOURCES];
+
+	for (uint32 i = 0; i < STRESS_ITERATIONS; i++)
+	{
+		uint32 slot = (i + thread) % STRESS_LIVE_RESOURCES;
+
+		// sampled and storage textures also take bindless slots and views, host visible buffers are mapped
+		TextureDesc desc{};
+		desc.Width = 16u << (i % 3);
+		desc.Height = 16;
+		desc.MipLevels = 1 + i % 2;
+		desc.Format = ETextureFormat::RGBA8U;
+		desc.Flags = (i % 2) ? ETextureFlags::Sampled : (ETextureFlags::Sampled | ETextureFlags::Storage);
+
+		EBufferFlags flags = (i % 3 == 0) ? EBufferFlags::Upload : (EBufferFlags::Storage | EBufferFlags::GPUAddress);
+
+		// overwriting the slot releases the previous resource on this thread
+		textures[slot] = device.CreateTexture(desc);
+		buffers[slot] = device.CreateBuffer(256 + 64 * (i % 7), flags);
+	}
+}
+
+TEST_CASE(ResourceStress, CreateAndDestroyFromManyThreads)
+{
+	if (!HasVulkanDevice())
+	{
+		printf("    no Vulkan 1.3 device, skipped\n");
+		return;
+	}
+
+	VulkanDevice device(nullptr, false);
+
+	std::atomic<bool> done{ false };
+	std::vector<std::thread> threads{};
+
+	for (uint32 t = 0; t < STRESS_THREADS; t++)
+	{
+		threads.emplace_back([&device, t]() { CreateAndRelease(device, t); });
+	}
+
+	// frames keep retiring the shards while the loaders release into them
+	std::thread frames([&]() {
+		while (!done.load(std::memory_order_acquire))
+		{
+			device.BeginFrame();
+			device.EndFrame();
+		}
+		});
+
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+
+	done.store(true, std::memory_order_release);
+	frames.join();
+
+	// nothing was submitted, so everything released is destroyed by the next frame
+	device.BeginFrame();
+	EXPECT_EQ(device.GetNumPendingDestructions(), 0u);
+	device.EndFrame();
+}
+
+#endif
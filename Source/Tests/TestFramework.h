@@ -0,0 +1,38 @@
+#pragma once
+#include <Engine/Core/Common.h>
+
+namespace Spikey::Tests {
+
+	struct TestCase
+	{
+		const char* Suite;
+		const char* Name;
+		void      (*Func)();
+	};
+
+	std::vector<TestCase>& GetTestCases();
+	void                   ReportFailure(const char* file, uint32 line, const char* expr);
+
+	struct TestRegistrar
+	{
+		TestRegistrar(const char* suite, const char* name, void (*func)())
+		{
+			GetTestCases().push_back(TestCase{ suite, name, func });
+		}
+	};
+}
+
+#define TEST_CASE(suite, name) \
+	static void suite##_##name(); \
+	static ::Spikey::Tests::TestRegistrar suite##_##name##_Registrar(#suite, #name, &suite##_##name); \
+	static void suite##_##name()
+
+// a failed expectation is reported and the test goes on, so one run shows everything that broke
+#define EXPECT(expr) \
+	do { if (!(expr)) ::Spikey::Tests::ReportFailure(__FILE__, __LINE__, #expr); } while (0)
+
+#define EXPECT_EQ(a, b) EXPECT((a) == (b))
+
+// for checks the rest of the test depends on, like the size of a list indexed afterwards
+#define REQUIRE(expr) \
+	do { if (!(expr)) { ::Spikey::Tests::ReportFailure(__FILE__, __LINE__, #expr); return; } } while (0)
@@ -0,0 +1,51 @@
+#include <TestFramework.h>
+
+namespace Spikey::Tests {
+
+	static uint32 s_NumFailures = 0;
+
+	std::vector<TestCase>& GetTestCases()
+	{
+		static std::vector<TestCase> cases;
+		return cases;
+	}
+
+	void ReportFailure(const char* file, uint32 line, const char* expr)
+	{
+		s_NumFailures++;
+		printf("    %s(%u): expected %s\n", file, line, expr);
+	}
+}
+
+using namespace Spikey;
+using namespace Spikey::Tests;
+
+// runs the suite named by the first argument, every suite without one
+int main(int argc, char* argv[])
+{
+	const char* suite = argc > 1 ? argv[1] : nullptr;
+	Log::Init();
+
+	uint32 numRun = 0;
+	uint32 numFailed = 0;
+
+	for (const TestCase& test : GetTestCases())
+	{
+		if (suite && strcmp(suite, test.Suite) != 0)
+			continue;
+
+		uint32 failuresBefore = s_NumFailures;
+		test.Func();
+
+		bool failed = s_NumFailures != failuresBefore;
+		numFailed += failed ? 1 : 0;
+		numRun++;
+
+		printf("[%s] %s.%s\n", failed ? "FAIL" : " OK ", test.Suite, test.Name);
+	}
+
+	printf("%u tests, %u failed\n", numRun, numFailed);
+
+	// a suite without tests is a typo in the ctest setup, not a pass
+	return numRun > 0 && numFailed == 0 ? 0 : 1;
+}
@@ -0,0 +1,198 @@
+#include <TestFramework.h>
+#include <Engine/Graphics/TextureState.h>
+
+using namespace Spikey;
+
+static TextureState MakeState(uint32 numMips, uint32 numLayers, ERHIAccess initialState)
+{
+	TextureState state{};
+	state.Initialize(numMips, numLayers, initialState, true);
+
+	return state;
+}
+
+TEST_CASE(TextureState, InitializeIsOneRun)
+{
+	TextureState state = MakeState(4, 3, ERHIAccess::SRV);
+
+	EXPECT(state.PerSubresourceTracking);
+	EXPECT(state.AllSubresourcesSame());
+	EXPECT_EQ(state.GetState(), ERHIAccess::SRV);
+	EXPECT_EQ(state.GetSubresourceState(3, 2), ERHIAccess::SRV);
+}
+
+TEST_CASE(TextureState, SingleSubresourceIsNotTrackedPerSubresource)
+{
+	TextureState state = MakeState(1, 1, ERHIAccess::None);
+	EXPECT(!state.PerSubresourceTracking);
+
+	state.SetSubresourceState(0, 0, ERHIAccess::CopyDst);
+	EXPECT(state.AllSubresourcesSame());
+	EXPECT_EQ(state.GetState(), ERHIAccess::CopyDst);
+}
+
+TEST_CASE(TextureState, SplitRunsMergeBack)
+{
+	TextureState state = MakeState(4, 2, ERHIAccess::SRV);
+
+	state.SetSubresourceState(1, 0, ERHIAccess::CopyDst);
+	REQUIRE(state.Ranges.size() == 3);
+	EXPECT_EQ(state.GetSubresourceState(0, 0), ERHIAccess::SRV);
+	EXPECT_EQ(state.GetSubresourceState(1, 0), ERHIAccess::CopyDst);
+	EXPECT_EQ(state.GetSubresourceState(2, 0), ERHIAccess::SRV);
+
+	// neighbouring runs never share a state, putting the mip back leaves a single run again
+	state.SetSubresourceState(1, 0, ERHIAccess::SRV);
+	EXPECT(state.AllSubresourcesSame());
+	EXPECT_EQ(state.GetState(), ERHIAccess::SRV);
+}
+
+TEST_CASE(TextureState, AdjacentRunsInTheSameStateMerge)
+{
+	TextureState state = MakeState(4, 1, ERHIAccess::None);
+
+	state.SetSubresourceState(0, 0, ERHIAccess::CopyDst);
+	state.SetSubresourceState(1, 0, ERHIAccess::CopyDst);
+	REQUIRE(state.Ranges.size() == 2);
+	EXPECT_EQ(state.Ranges[0].Begin, 0u);
+	EXPECT_EQ(state.Ranges[0].End, 2u);
+	EXPECT_EQ(state.Ranges[0].State, ERHIAccess::CopyDst);
+	EXPECT_EQ(state.Ranges[1].State, ERHIAccess::None);
+}
+
+TEST_CASE(TextureState, FullMipChainsOfNeighbouringLayersAreOneRun)
+{
+	TextureState state = MakeState(3, 4, ERHIAccess::SRV);
+
+	TextureSubresourceSet layers{ 0, ~0u, 1, 2 };
+	state.SetSubresourcesState(layers, ERHIAccess::ColorTarget);
+
+	REQUIRE(state.Ranges.size() == 3);
+	EXPECT_EQ(state.Ranges[1].Begin, 3u);
+	EXPECT_EQ(state.Ranges[1].End, 9u);
+	EXPECT_EQ(state.Ranges[1].State, ERHIAccess::ColorTarget);
+}
+
+TEST_CASE(TextureState, ResolveClampsToTheTexture)
+{
+	TextureState state = MakeState(5, 6, ERHIAccess::None);
+	TextureSubresourceSet set = state.Resolve(TextureSubresourceSet{ 2, ~0u, 4, ~0u });
+
+	EXPECT_EQ(set.BaseMip, 2u);
+	EXPECT_EQ(set.NumMips, 3u);
+	EXPECT_EQ(set.BaseLayer, 4u);
+	EXPECT_EQ(set.NumLayers, 2u);
+}
+
+TEST_CASE(TextureState, UniformTransitionIsOneEntireRegion)
+{
+	TextureState state = MakeState(4, 3, ERHIAccess::SRV);
+	std::vector<TextureBarrierRegion> regions{};
+
+	uint32 added = TextureBarrierBuilder::Transition(state, TextureSubresourceSet::AllTexture(), ERHIAccess::ColorTarget, regions);
+
+	REQUIRE(added == 1 && regions.size() == 1);
+	EXPECT(regions[0].EntireTexture);
+	EXPECT_EQ(regions[0].LastAccess, ERHIAccess::SRV);
+	EXPECT_EQ(regions[0].NewAccess, ERHIAccess::ColorTarget);
+	EXPECT(state.AllSubresourcesSame());
+	EXPECT_EQ(state.GetState(), ERHIAccess::ColorTarget);
+}
+
+TEST_CASE(TextureState, RedundantTransitionIsDropped)
+{
+	TextureState state = MakeState(4, 1, ERHIAccess::SRV);
+	std::vector<TextureBarrierRegion> regions{};
+
+	EXPECT_EQ(TextureBarrierBuilder::Transition(state, TextureSubresourceSet::AllTexture(), ERHIAccess::SRV, regions), 0u);
+	EXPECT_EQ(TextureBarrierBuilder::Transition(state, TextureSubresourceSet{ 1, 2, 0, 1 }, ERHIAccess::SRV, regions), 0u);
+	EXPECT(regions.empty());
+}
+
+TEST_CASE(TextureState, UnorderedAccessAlwaysGetsABarrier)
+{
+	TextureState state = MakeState(1, 1, ERHIAccess::UAVCompute);
+	std::vector<TextureBarrierRegion> regions{};
+
+	// writes after writes have to be ordered even though the state does not change
+	TextureBarrierBuilder::Transition(state, TextureSubresourceSet::AllTexture(), ERHIAccess::UAVCompute, regions);
+
+	REQUIRE(regions.size() == 1);
+	EXPECT_EQ(regions[0].LastAccess, ERHIAccess::UAVCompute);
+	EXPECT_EQ(regions[0].NewAccess, ERHIAccess::UAVCompute);
+}
+
+TEST_CASE(TextureState, PartialTransitionOnlyTouchesItsRange)
+{
+	TextureState state = MakeState(4, 3, ERHIAccess::SRV);
+	std::vector<TextureBarrierRegion> regions{};
+
+	TextureSubresourceSet range{ 1, 2, 1, 1 };
+	TextureBarrierBuilder::Transition(state, range, ERHIAccess::CopyDst, regions);
+
+	REQUIRE(regions.size() == 1);
+	EXPECT(!regions[0].EntireTexture);
+	EXPECT(regions[0].Range == range);
+	EXPECT_EQ(regions[0].LastAccess, ERHIAccess::SRV);
+
+	for (uint32 layer = 0; layer < 3; layer++)
+	{
+		for (uint32 mip = 0; mip < 4; mip++)
+		{
+			bool inside = layer == 1 && mip >= 1 && mip <= 2;
+			EXPECT_EQ(state.GetSubresourceState(mip, layer), inside ? ERHIAccess::CopyDst : ERHIAccess::SRV);
+		}
+	}
+}
+
+TEST_CASE(TextureState, RunsCoalesceAcrossLayers)
+{
+	// mip 0 of every layer was written by a copy, the rest is sampled
+	TextureState state = MakeState(4, 3, ERHIAccess::SRV);
+	state.SetSubresourcesState(TextureSubresourceSet{ 0, 1, 0, ~0u }, ERHIAccess::CopyDst);
+
+	std::vector<TextureBarrierRegion> regions{};
+	TextureBarrierBuilder::Transition(state, TextureSubresourceSet::AllTexture(), ERHIAccess::ColorTarget, regions);
+
+	// one rectangle per previous state instead of one region per layer and run
+	REQUIRE(regions.size() == 2);
+
+	const TextureBarrierRegion& copied = regions[0].LastAccess == ERHIAccess::CopyDst ? regions[0] : regions[1];
+	const TextureBarrierRegion& sampled = regions[0].LastAccess == ERHIAccess::CopyDst ? regions[1] : regions[0];
+
+	EXPECT(copied.Range == (TextureSubresourceSet{ 0, 1, 0, 3 }));
+	EXPECT(sampled.Range == (TextureSubresourceSet{ 1, 3, 0, 3 }));
+	EXPECT_EQ(sampled.LastAccess, ERHIAccess::SRV);
+	EXPECT(!copied.EntireTexture && !sampled.EntireTexture);
+
+	EXPECT(state.AllSubresourcesSame());
+	EXPECT_EQ(state.GetState(), ERHIAccess::ColorTarget);
+}
+
+TEST_CASE(TextureState, DifferingLayersStartNewRectangles)
+{
+	TextureState state = MakeState(2, 3, ERHIAccess::SRV);
+	state.SetSubresourceState(0, 1, ERHIAccess::CopyDst);
+
+	std::vector<TextureBarrierRegion> regions{};
+	TextureBarrierBuilder::Transition(state, TextureSubresourceSet::AllTexture(), ERHIAccess::CopySrc, regions);
+
+	// every region keeps the state its subresources were really in
+	uint32 numSubresources = 0;
+	for (const TextureBarrierRegion& region : regions)
+	{
+		for (uint32 layer = region.Range.BaseLayer; layer < region.Range.BaseLayer + region.Range.NumLayers; layer++)
+		{
+			for (uint32 mip = region.Range.BaseMip; mip < region.Range.BaseMip + region.Range.NumMips; mip++)
+			{
+				bool copied = mip == 0 && layer == 1;
+				EXPECT_EQ(region.LastAccess, copied ? ERHIAccess::CopyDst : ERHIAccess::SRV);
+				numSubresources++;
+			}
+		}
+	}
+
+	// and no subresource is transitioned twice
+	EXPECT_EQ(numSubresources, 6u);
+	EXPECT_EQ(state.GetState(), ERHIAccess::CopySrc);
+}